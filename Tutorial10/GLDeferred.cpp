@@ -4,6 +4,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
 
 //Main.cpp
 extern int g_iWindowWidth;
@@ -11,7 +12,7 @@ extern int g_iWindowHeight;
 extern GLuint g_uiMainProgram;
 extern GLuint g_uiDeferredProgram2;
 extern SceneData g_SceneData;
-extern void GL_RenderObjects(ObjectData * p_Object = NULL);
+extern void GL_RenderObjects(unsigned uiSkipObject = -1);
 
 // Deferred rendering data
 GLuint g_uiFBODeferred;
@@ -30,8 +31,9 @@ GLuint g_uiQuadIBO;
 // Inverse resolution UBO
 GLuint g_uiInverseResUBO;
 
-void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTextureTarget)
+void GL_RenderDeferred(unsigned uiSkipObject, GLuint uiAccumBuffer, GLenum uiTextureTarget)
 {
+    GL_TRACE_ZONE("GL_RenderDeferred");
     // Bind deferred frame buffer
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBODeferred);
 
@@ -43,7 +45,7 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
     glUseProgram(g_uiMainProgram);
 
     // Render all objects
-    GL_RenderObjects(p_Object);
+    GL_RenderObjects(uiSkipObject);
 
     // Disable depth checks
     glDisable(GL_DEPTH_TEST);
@@ -5,12 +5,18 @@
 
 using namespace glm;
 
+#include "GLTrace.h"
+
 //Main.cpp
 extern int g_iWindowWidth;
 extern int g_iWindowHeight;
 extern GLuint g_uiPostProcProgram;
 extern GLuint g_uiPostProcInitProgram;
 extern GLuint g_uiGaussProgram;
+//UniformRing.cpp
+extern GLuint g_uiUniformRing;
+extern void GL_ReserveUniformRing(unsigned uiSize, unsigned uiCount);
+extern GLintptr GL_WriteUniformRing(const void * p_Data, unsigned uiSize);
 //Deferred.cpp
 extern GLuint g_uiAccumulation;
 extern GLuint g_uiQuadVAO;
@@ -26,6 +32,7 @@ GLuint g_uiBlur;
 
 void GL_RenderPostProcess()
 {
+    GL_TRACE_ZONE("GL_RenderPostProcess");
     // Bind initialisation program
     glUseProgram(g_uiPostProcInitProgram);
 
@@ -50,8 +57,7 @@ void GL_RenderPostProcess()
     // Half viewport
     glViewport(0, 0, g_iWindowWidth / 2, g_iWindowHeight / 2);
     vec2 v2InverseRes = 1.0f / vec2((float)(g_iWindowWidth / 2), (float)(g_iWindowHeight / 2));
-    glBindBuffer(GL_UNIFORM_BUFFER, g_uiInverseResUBO);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(vec2), &v2InverseRes, GL_STATIC_DRAW);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 7, g_uiUniformRing, GL_WriteUniformRing(&v2InverseRes, sizeof(vec2)), sizeof(vec2));
 
     // Bind blur frame buffer and program
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOBlur);
@@ -96,8 +102,7 @@ void GL_RenderPostProcess()
 
     // Reset viewport
     glViewport(0, 0, g_iWindowWidth, g_iWindowHeight);
-    v2InverseRes = 1.0f / vec2((float)g_iWindowWidth, (float)g_iWindowHeight);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(vec2), &v2InverseRes, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 7, g_uiInverseResUBO);
 
     // Bind default frame buffer
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
@@ -116,6 +121,9 @@ void GL_RenderPostProcess()
 
 bool GL_InitPostProcess()
 {
+    // Post-processing writes its inverse resolution once a frame
+    GL_ReserveUniformRing(sizeof(vec2), 1);
+
     // Create post-process frame buffer
     glGenFramebuffers(1, &g_uiFBOPostProc);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOPostProc);
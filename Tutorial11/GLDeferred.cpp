@@ -4,6 +4,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLProfiler.h"
+#include "GLTrace.h"
 
 //Main.cpp
 extern int g_iWindowWidth;
@@ -16,7 +18,16 @@ extern GLuint g_uiSpotSSVLProgram;
 extern GLuint g_uiSpotSSVLProgram2;
 extern GLuint g_uiGaussProgram;
 extern SceneData g_SceneData;
-extern void GL_RenderObjects(ObjectData * p_Object = NULL);
+extern void GL_RenderObjects(unsigned uiSkipObject = -1);
+extern void GL_RenderHiZObjects();
+//HiZ.cpp
+extern bool GL_HiZFrameActive();
+extern void GL_BuildHiZ();
+extern void GL_TestHiZObjects();
+//UniformRing.cpp
+extern GLuint g_uiUniformRing;
+extern void GL_ReserveUniformRing(unsigned uiSize, unsigned uiCount);
+extern GLintptr GL_WriteUniformRing(const void * p_Data, unsigned uiSize);
 //PostProcess.cpp
 extern GLuint g_uiFBOBlur;
 extern GLuint g_uiBlur;
@@ -46,8 +57,9 @@ GLuint g_uiAmbientOcclusion;
 GLuint g_uiFBOVolLight;
 GLuint g_uiVolumeLight;
 
-void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTextureTarget)
+void GL_RenderDeferred(unsigned uiSkipObject, GLuint uiAccumBuffer, GLenum uiTextureTarget)
 {
+    GL_TRACE_ZONE("GL_RenderDeferred");
     // Bind deferred frame buffer
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBODeferred);
 
@@ -59,7 +71,20 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
     glUseProgram(g_uiMainProgram);
 
     // Render all objects
-    GL_RenderObjects(p_Object);
+    GL_ProfileBegin(PROFILE_GBUFFER);
+    GL_RenderObjects(uiSkipObject);
+    GL_ProfileEnd();
+
+    // Occlusion test objects left out above against the depth of those drawn, then draw the ones still visible
+    if (GL_HiZFrameActive()) {
+        GL_ProfileBegin(PROFILE_HIZ);
+        GL_BuildHiZ();
+        GL_TestHiZObjects();
+        GL_ProfileEnd();
+        GL_ProfileBegin(PROFILE_GBUFFER);
+        GL_RenderHiZObjects();
+        GL_ProfileEnd();
+    }
 
     // Disable depth checks
     glDisable(GL_DEPTH_TEST);
@@ -76,7 +101,9 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
     glClear(GL_COLOR_BUFFER_BIT);
 
     // Draw full screen quad
+    GL_ProfileBegin(PROFILE_SSAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+    GL_ProfileEnd();
 
     // Bind volume light program
     glUseProgram(g_uiSpotSSVLProgram);
@@ -84,15 +111,16 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
     // Half viewport
     glViewport(0, 0, g_iWindowWidth / 2, g_iWindowHeight / 2);
     vec2 v2InverseRes = 1.0f / vec2((float)(g_iWindowWidth / 2), (float)(g_iWindowHeight / 2));
-    glBindBuffer(GL_UNIFORM_BUFFER, g_uiInverseResUBO);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(vec2), &v2InverseRes, GL_STATIC_DRAW);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 7, g_uiUniformRing, GL_WriteUniformRing(&v2InverseRes, sizeof(vec2)), sizeof(vec2));
 
     // Bind frame buffer
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOVolLight);
     glClear(GL_COLOR_BUFFER_BIT);
 
     // Draw full screen quad
+    GL_ProfileBegin(PROFILE_VOLUMETRIC);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+    GL_ProfileEnd();
 
     // Bind blur frame buffer and program
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOBlur);
@@ -105,20 +133,23 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
     // Perform horizontal blur
     GLuint uiSubRoutines[2] = {0, 1};
     glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &uiSubRoutines[0]);
+    GL_ProfileBegin(PROFILE_VOLUMETRIC_BLUR_H);
     glClear(GL_COLOR_BUFFER_BIT);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+    GL_ProfileEnd();
 
     // Perform vertical blur
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOVolLight);
     glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 1, &uiSubRoutines[1]);
     glBindTexture(GL_TEXTURE_2D, g_uiBlur);
+    GL_ProfileBegin(PROFILE_VOLUMETRIC_BLUR_V);
     glClear(GL_COLOR_BUFFER_BIT);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+    GL_ProfileEnd();
 
     // Reset viewport
     glViewport(0, 0, g_iWindowWidth, g_iWindowHeight);
-    v2InverseRes = 1.0f / vec2((float)g_iWindowWidth, (float)g_iWindowHeight);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(vec2), &v2InverseRes, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 7, g_uiInverseResUBO);
 
     // Bind second deferred frame buffer
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBODeferred2);
@@ -137,7 +168,9 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
     glUseProgram(g_uiSSAOProgram2);
 
     // Draw full screen quad
+    GL_ProfileBegin(PROFILE_AO_COMPOSITE);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+    GL_ProfileEnd();
 
     // Reset blending parameters
     glBlendFunc(GL_ONE, GL_ONE);
@@ -146,13 +179,17 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
     glUseProgram(g_uiDeferredProgram2);
 
     // Draw full screen quad
+    GL_ProfileBegin(PROFILE_LIGHTING);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+    GL_ProfileEnd();
 
     // Bind second volume light program
     glUseProgram(g_uiSpotSSVLProgram2);
 
     // Draw full screen quad
+    GL_ProfileBegin(PROFILE_VOLUMETRIC_COMPOSITE);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+    GL_ProfileEnd();
 
     // Disable blending
     glDisablei(GL_BLEND, 0);
@@ -171,6 +208,9 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
 
 bool GL_InitDeferred()
 {
+    // Each deferred pass writes its inverse resolution, at most one per planar reflection and cube face in a frame
+    GL_ReserveUniformRing(sizeof(vec2), g_SceneData.m_uiNumReflecObjects + 6);
+
     // Get light uniform location and set
     glProgramUniform1i(g_uiDeferredProgram2, 0, g_SceneData.m_uiNumPointLights);
     glProgramUniform1i(g_uiDeferredProgram2, 2, g_SceneData.m_uiNumSpotLights);
@@ -0,0 +1,277 @@
+// Using SDL, GLEW
+#include <math.h>
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#ifndef _WIN32
+// Using EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "GLTrace.h"
+
+//Main.cpp
+extern int g_iWindowWidth;
+extern int g_iWindowHeight;
+extern void GL_Update(float fElapsedTime);
+extern void GL_Render();
+//TextureStream.cpp
+extern void GL_FinishTextureStream();
+extern void GL_GetTextureResidency(Uint64 & ui64Resident, Uint64 & ui64Wanted, Uint64 & ui64Budget);
+//PostProcess.cpp
+extern GLuint g_uiFBOOutput;
+
+// Headless context data
+#ifdef _WIN32
+SDL_Window * gp_HeadlessWindow = NULL;
+SDL_GLContext g_HeadlessContext = NULL;
+#else
+EGLDisplay g_EGLDisplay = EGL_NO_DISPLAY;
+EGLSurface g_EGLSurface = EGL_NO_SURFACE;
+EGLContext g_EGLContext = EGL_NO_CONTEXT;
+#endif
+
+// Headless output frame buffer
+GLuint g_uiFBOHeadless;
+GLuint g_uiHeadlessColour;
+
+bool GL_CreateHeadlessContext()
+{
+#ifdef _WIN32
+    // No EGL available so fall back to a hidden SDL window
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // Use OpenGL 4.3 core profile
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+#ifdef _DEBUG
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+#endif
+
+    // Create a hidden window only to own the context
+    gp_HeadlessWindow = SDL_CreateWindow("AGT Tutorial", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                         1, 1, SDL_WINDOW_HIDDEN | SDL_WINDOW_OPENGL);
+    if (gp_HeadlessWindow == NULL) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to create hidden OpenGL window: %s\n", SDL_GetError());
+        SDL_Quit();
+        return false;
+    }
+    g_HeadlessContext = SDL_GL_CreateContext(gp_HeadlessWindow);
+    if (g_HeadlessContext == NULL) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to create OpenGL context: %s\n", SDL_GetError());
+        SDL_DestroyWindow(gp_HeadlessWindow);
+        SDL_Quit();
+        return false;
+    }
+    return true;
+#else
+    // Prefer the Mesa surfaceless platform as it needs no display server or GPU
+    const char * p_cClientExts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if ((eglGetPlatformDisplayEXT != NULL) && (p_cClientExts != NULL) && (strstr(p_cClientExts, "EGL_MESA_platform_surfaceless") != NULL))
+        g_EGLDisplay = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (g_EGLDisplay == EGL_NO_DISPLAY)
+        g_EGLDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint iMajor, iMinor;
+    if ((g_EGLDisplay == EGL_NO_DISPLAY) || !eglInitialize(g_EGLDisplay, &iMajor, &iMinor)) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize EGL display: 0x%x\n", eglGetError());
+        return false;
+    }
+
+    // Only need a pbuffer if surfaceless contexts are unsupported
+    const char * p_cDisplayExts = eglQueryString(g_EGLDisplay, EGL_EXTENSIONS);
+    bool bSurfaceless = (p_cDisplayExts != NULL) && (strstr(p_cDisplayExts, "EGL_KHR_surfaceless_context") != NULL);
+
+    // Find a desktop OpenGL capable config
+    const EGLint iConfigAttribs[] = {
+        EGL_SURFACE_TYPE, bSurfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig Config;
+    EGLint iNumConfigs = 0;
+    if (!eglChooseConfig(g_EGLDisplay, iConfigAttribs, &Config, 1, &iNumConfigs) || (iNumConfigs == 0)) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to find EGL config: 0x%x\n", eglGetError());
+        eglTerminate(g_EGLDisplay);
+        return false;
+    }
+
+    // Use OpenGL 4.3 core profile
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint iContextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifdef _DEBUG
+        EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+        EGL_NONE
+    };
+    g_EGLContext = eglCreateContext(g_EGLDisplay, Config, EGL_NO_CONTEXT, iContextAttribs);
+    if (g_EGLContext == EGL_NO_CONTEXT) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to create OpenGL context: 0x%x\n", eglGetError());
+        eglTerminate(g_EGLDisplay);
+        return false;
+    }
+
+    // Create a minimal pbuffer if required
+    if (!bSurfaceless) {
+        const EGLint iPbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        g_EGLSurface = eglCreatePbufferSurface(g_EGLDisplay, Config, iPbufferAttribs);
+    }
+    if (!eglMakeCurrent(g_EGLDisplay, g_EGLSurface, g_EGLSurface, g_EGLContext)) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to make OpenGL context current: 0x%x\n", eglGetError());
+        eglDestroyContext(g_EGLDisplay, g_EGLContext);
+        eglTerminate(g_EGLDisplay);
+        return false;
+    }
+    return true;
+#endif
+}
+
+void GL_DestroyHeadlessContext()
+{
+#ifdef _WIN32
+    SDL_GL_DeleteContext(g_HeadlessContext);
+    SDL_DestroyWindow(gp_HeadlessWindow);
+    SDL_Quit();
+#else
+    eglMakeCurrent(g_EGLDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (g_EGLSurface != EGL_NO_SURFACE)
+        eglDestroySurface(g_EGLDisplay, g_EGLSurface);
+    eglDestroyContext(g_EGLDisplay, g_EGLContext);
+    eglTerminate(g_EGLDisplay);
+#endif
+}
+
+bool GL_InitHeadless()
+{
+    // Create output frame buffer to replace the missing window back buffer
+    glGenFramebuffers(1, &g_uiFBOHeadless);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOHeadless);
+
+    // Setup colour attachment
+    glGenRenderbuffers(1, &g_uiHeadlessColour);
+    glBindRenderbuffer(GL_RENDERBUFFER, g_uiHeadlessColour);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, g_iWindowWidth, g_iWindowHeight);
+    glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, g_uiHeadlessColour);
+    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to create headless frame buffer\n");
+        return false;
+    }
+
+    // Redirect final post-process output
+    g_uiFBOOutput = g_uiFBOHeadless;
+    return true;
+}
+
+void GL_QuitHeadless()
+{
+    // Release output FBO data
+    g_uiFBOOutput = 0;
+    glDeleteFramebuffers(1, &g_uiFBOHeadless);
+    glDeleteRenderbuffers(1, &g_uiHeadlessColour);
+}
+
+bool GL_SaveHeadlessFrame(const char * p_cFileName)
+{
+    // Read back the final frame
+    const int iRowSize = g_iWindowWidth * 4;
+    GLubyte * p_Pixels = (GLubyte *)malloc(iRowSize * g_iWindowHeight);
+    GLubyte * p_Flipped = (GLubyte *)malloc(iRowSize * g_iWindowHeight);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, g_uiFBOHeadless);
+    glReadPixels(0, 0, g_iWindowWidth, g_iWindowHeight, GL_RGBA, GL_UNSIGNED_BYTE, p_Pixels);
+
+    // Correctly flip image data
+    for (int i = 0; i < g_iWindowHeight; i++) {
+        memcpy(&p_Flipped[i * iRowSize], &p_Pixels[(g_iWindowHeight - 1 - i) * iRowSize], iRowSize);
+    }
+
+    // Write out as bitmap
+    SDL_Surface * p_Surface = SDL_CreateRGBSurfaceFrom(p_Flipped, g_iWindowWidth, g_iWindowHeight, 32, iRowSize,
+                                                       0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+    bool bReturn = (p_Surface != NULL) && (SDL_SaveBMP(p_Surface, p_cFileName) == 0);
+    if (!bReturn)
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to write frame file: %s (%s)\n", p_cFileName, SDL_GetError());
+    SDL_FreeSurface(p_Surface);
+    free(p_Pixels);
+    free(p_Flipped);
+    return bReturn;
+}
+
+int GL_CompareFrameTimes(const void * p_A, const void * p_B)
+{
+    float fA = *(const float *)p_A;
+    float fB = *(const float *)p_B;
+    return (fA > fB) - (fA < fB);
+}
+
+float GL_GetPercentile(const float * p_fSorted, unsigned uiNumFrames, float fPercentile)
+{
+    // Use nearest-rank percentile
+    unsigned uiRank = (unsigned)ceilf(fPercentile / 100.0f * (float)uiNumFrames);
+    uiRank = (uiRank > 0) ? uiRank - 1 : 0;
+    return p_fSorted[(uiRank < uiNumFrames) ? uiRank : uiNumFrames - 1];
+}
+
+void GL_RunHeadless(unsigned uiNumFrames, const char * p_cOutputFile)
+{
+    // Ignore the first few frames as they include driver shader compilation
+    const unsigned uiWarmupFrames = (uiNumFrames > 10) ? 5 : 0;
+    // Use a fixed time step so runs are repeatable
+    const float fElapsedTime = 1.0f / 60.0f;
+
+    float * p_fFrameTimes = (float *)malloc(uiNumFrames * sizeof(float));
+    const double dTicksToMS = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    // Make all textures resident first so every run renders the same frames, rendering once to find the detail needed
+    GL_FinishTextureStream();
+    GL_Update(0.0f);
+    GL_Render();
+    GL_FinishTextureStream();
+    for (unsigned i = 0; i < uiNumFrames; i++) {
+        GL_TRACE_FRAME(i);
+        Uint64 uiStart = SDL_GetPerformanceCounter();
+
+        // Update and render the scene
+        GL_Update(fElapsedTime);
+        GL_Render();
+
+        // Wait for the GPU so each time covers the whole frame
+        glFinish();
+
+        p_fFrameTimes[i] = (float)((double)(SDL_GetPerformanceCounter() - uiStart) * dTicksToMS);
+        SDL_Log("Frame %u: %.3f ms%s\n", i, p_fFrameTimes[i], (i < uiWarmupFrames) ? " (warm-up)" : "");
+    }
+
+    // Save final frame for image comparison
+    if (p_cOutputFile != NULL)
+        GL_SaveHeadlessFrame(p_cOutputFile);
+
+    // Calculate statistics over the timed frames
+    const unsigned uiTimedFrames = uiNumFrames - uiWarmupFrames;
+    if (uiTimedFrames > 0) {
+        float * p_fSorted = &p_fFrameTimes[uiWarmupFrames];
+        qsort(p_fSorted, uiTimedFrames, sizeof(float), GL_CompareFrameTimes);
+        double dTotal = 0.0;
+        for (unsigned i = 0; i < uiTimedFrames; i++) {
+            dTotal += p_fSorted[i];
+        }
+        const GLubyte * p_cRenderer = glGetString(GL_RENDERER);
+        SDL_Log("Renderer: %s, %dx%d, %u frames\n", p_cRenderer, g_iWindowWidth, g_iWindowHeight, uiTimedFrames);
+        SDL_Log("min %.3f ms, avg %.3f ms, p50 %.3f ms, p90 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                p_fSorted[0], (float)(dTotal / uiTimedFrames),
+                GL_GetPercentile(p_fSorted, uiTimedFrames, 50.0f), GL_GetPercentile(p_fSorted, uiTimedFrames, 90.0f),
+                GL_GetPercentile(p_fSorted, uiTimedFrames, 95.0f), GL_GetPercentile(p_fSorted, uiTimedFrames, 99.0f),
+                p_fSorted[uiTimedFrames - 1]);
+    }
+    Uint64 ui64Resident, ui64Wanted, ui64Budget;
+    GL_GetTextureResidency(ui64Resident, ui64Wanted, ui64Budget);
+    SDL_Log("Textures resident %.2f MB, wanted %.2f MB, budget %.2f MB\n", (double)ui64Resident / (1024.0 * 1024.0),
+            (double)ui64Wanted / (1024.0 * 1024.0), (double)ui64Budget / (1024.0 * 1024.0));
+    free(p_fFrameTimes);
+}
\ No newline at end of file
@@ -0,0 +1,322 @@
+// Using GLM and math headers
+#include <math.h>
+#include <glm/glm.hpp>
+// Using SDL, GLEW
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
+
+//Main.cpp
+extern int g_iWindowWidth;
+extern int g_iWindowHeight;
+extern SceneData g_SceneData;
+//Shader.cpp
+extern bool GL_LoadComputeProgram(GLuint & uiProgram, const char * p_cFileName, int iFileID);
+//Cluster.cpp
+extern unsigned GL_GetNumClusterRanges();
+extern unsigned GL_WriteObjectClusterCommands(DrawIndirectData * p_Commands, unsigned uiBaseInstance);
+//Deferred.cpp
+extern GLuint g_uiDepth;
+
+// Per object bounds read by the test shader, must match its std430 layout
+struct HiZObjectData
+{
+    vec4 m_v4Min;
+    vec4 m_v4Max;
+    GLuint m_uiObject;
+    GLuint m_uiFirstCommand;
+    GLuint m_uiNumCommands;
+    GLuint m_uiNumPatches;
+};
+
+// Results are read back once the GPU has finished with them, a frame later
+const unsigned g_uiHiZFrames = 2;
+const unsigned g_uiHiZTextureUnit = 20;
+
+// Hierarchical depth occlusion culling of the main camera pass
+bool g_bHiZCulling = true;
+bool g_bHiZFrameActive = false;
+GLuint g_uiHiZBuildProgram = 0;
+GLuint g_uiHiZTestProgram = 0;
+GLuint g_uiHiZPyramid = 0;
+unsigned g_uiHiZLevels = 0;
+mat4 g_m4HiZViewProjection;
+// Objects tested this frame and the indirect draws of those drawn after the test
+GLuint g_uiHiZObjectBuffer = 0;
+GLuint g_uiHiZCommandBuffer = 0;
+HiZObjectData * gp_HiZObjects = NULL;
+unsigned g_uiNumHiZObjects = 0;
+unsigned g_uiMaxHiZObjects = 0;
+DrawIndirectData * gp_HiZCommands = NULL;
+unsigned g_uiNumHiZCommands = 0;
+unsigned g_uiMaxHiZCommands = 0;
+unsigned * gp_uiHiZObjectCommands = NULL;
+// Objects left for the occlusion tested pass
+unsigned * gp_uiHiZDeferred = NULL;
+unsigned g_uiNumHiZDeferred = 0;
+// Visibility results of each frame in flight and the last results read back
+GLuint g_uiHiZVisibleBuffers[g_uiHiZFrames];
+GLsync g_HiZFences[g_uiHiZFrames];
+Uint64 g_ui64HiZFrameDraws[g_uiHiZFrames];
+Uint64 g_ui64HiZFramePatches[g_uiHiZFrames];
+unsigned g_uiHiZFrame = 0;
+GLuint * gp_uiHiZVisible = NULL;
+// Culling statistics
+Uint64 g_ui64HiZDraws = 0;
+Uint64 g_ui64HiZPatches = 0;
+Uint64 g_ui64HiZCulledDraws = 0;
+Uint64 g_ui64HiZCulledPatches = 0;
+
+bool GL_InitHiZ()
+{
+    if (!g_bHiZCulling)
+        return false;
+
+    // Load pyramid build and test shaders
+    if (!GL_LoadComputeProgram(g_uiHiZBuildProgram, "HiZBuildComp.glsl", 2400) ||
+        !GL_LoadComputeProgram(g_uiHiZTestProgram, "HiZTestComp.glsl", 2500)) {
+        g_bHiZCulling = false;
+        return false;
+    }
+
+    // Create pyramid starting at half the depth buffer size
+    const int iWidth = SDL_max((g_iWindowWidth + 1) / 2, 1);
+    const int iHeight = SDL_max((g_iWindowHeight + 1) / 2, 1);
+    g_uiHiZLevels = 1;
+    while ((iWidth >> g_uiHiZLevels) > 0 || (iHeight >> g_uiHiZLevels) > 0) {
+        ++g_uiHiZLevels;
+    }
+    glGenTextures(1, &g_uiHiZPyramid);
+    glBindTexture(GL_TEXTURE_2D, g_uiHiZPyramid);
+    glTexStorage2D(GL_TEXTURE_2D, g_uiHiZLevels, GL_RG32F, iWidth, iHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Create a visibility buffer per frame in flight with room for the hidden draw and patch counts, starting with nothing visible
+    const unsigned uiNumObjects = g_SceneData.m_uiNumObjects;
+    glGenBuffers(g_uiHiZFrames, g_uiHiZVisibleBuffers);
+    for (unsigned i = 0; i < g_uiHiZFrames; i++) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiHiZVisibleBuffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, (uiNumObjects + 2) * sizeof(GLuint), NULL, GL_DYNAMIC_READ);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+        g_HiZFences[i] = NULL;
+        g_ui64HiZFrameDraws[i] = 0;
+        g_ui64HiZFramePatches[i] = 0;
+    }
+    gp_uiHiZVisible = (GLuint *)calloc(uiNumObjects + 2, sizeof(GLuint));
+    gp_uiHiZDeferred = (unsigned *)malloc(SDL_max(uiNumObjects, 1u) * sizeof(unsigned));
+    gp_uiHiZObjectCommands = (unsigned *)malloc(SDL_max(uiNumObjects, 1u) * sizeof(unsigned));
+    glGenBuffers(1, &g_uiHiZObjectBuffer);
+    glGenBuffers(1, &g_uiHiZCommandBuffer);
+    g_uiHiZFrame = 0;
+    return true;
+}
+
+void GL_QuitHiZ()
+{
+    // Output how many draws and patches were removed
+    if (g_ui64HiZDraws > 0)
+        SDL_Log("Hi-Z culling removed %.1f%% of %llu draws and %.1f%% of %llu patches\n",
+                (double)g_ui64HiZCulledDraws * 100.0 / (double)g_ui64HiZDraws, (unsigned long long)g_ui64HiZDraws,
+                (double)g_ui64HiZCulledPatches * 100.0 / (double)SDL_max(g_ui64HiZPatches, (Uint64)1), (unsigned long long)g_ui64HiZPatches);
+    g_ui64HiZDraws = 0;
+    g_ui64HiZPatches = 0;
+    g_ui64HiZCulledDraws = 0;
+    g_ui64HiZCulledPatches = 0;
+
+    // Release culling data
+    for (unsigned i = 0; i < g_uiHiZFrames; i++) {
+        if (g_HiZFences[i] != NULL)
+            glDeleteSync(g_HiZFences[i]);
+        g_HiZFences[i] = NULL;
+    }
+    if (g_uiHiZPyramid != 0) {
+        glDeleteBuffers(g_uiHiZFrames, g_uiHiZVisibleBuffers);
+        glDeleteBuffers(1, &g_uiHiZObjectBuffer);
+        glDeleteBuffers(1, &g_uiHiZCommandBuffer);
+        glDeleteTextures(1, &g_uiHiZPyramid);
+    }
+    glDeleteProgram(g_uiHiZBuildProgram);
+    glDeleteProgram(g_uiHiZTestProgram);
+    g_uiHiZBuildProgram = 0;
+    g_uiHiZTestProgram = 0;
+    g_uiHiZPyramid = 0;
+    g_uiHiZObjectBuffer = 0;
+    g_uiHiZCommandBuffer = 0;
+    free(gp_HiZObjects);
+    free(gp_HiZCommands);
+    free(gp_uiHiZObjectCommands);
+    free(gp_uiHiZDeferred);
+    free(gp_uiHiZVisible);
+    gp_HiZObjects = NULL;
+    gp_HiZCommands = NULL;
+    gp_uiHiZObjectCommands = NULL;
+    gp_uiHiZDeferred = NULL;
+    gp_uiHiZVisible = NULL;
+    g_uiMaxHiZObjects = 0;
+    g_uiMaxHiZCommands = 0;
+}
+
+void GL_BeginHiZFrame(const mat4 & m4ViewProjection)
+{
+    if (!g_bHiZCulling)
+        return;
+    GL_TRACE_ZONE("GL_BeginHiZFrame");
+
+    // Wait until the GPU has finished with the oldest frames results, then read them back
+    const unsigned uiFrame = g_uiHiZFrame;
+    if (g_HiZFences[uiFrame] != NULL) {
+        GLbitfield Flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(g_HiZFences[uiFrame], Flags, 1000000) == GL_TIMEOUT_EXPIRED)
+            Flags = 0;
+        glDeleteSync(g_HiZFences[uiFrame]);
+        g_HiZFences[uiFrame] = NULL;
+
+        const unsigned uiNumObjects = g_SceneData.m_uiNumObjects;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiHiZVisibleBuffers[uiFrame]);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (uiNumObjects + 2) * sizeof(GLuint), gp_uiHiZVisible);
+        g_ui64HiZDraws += g_ui64HiZFrameDraws[uiFrame];
+        g_ui64HiZPatches += g_ui64HiZFramePatches[uiFrame];
+        g_ui64HiZCulledDraws += gp_uiHiZVisible[uiNumObjects];
+        g_ui64HiZCulledPatches += gp_uiHiZVisible[uiNumObjects + 1];
+    }
+
+    // Clear the results for this frame to write
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiHiZVisibleBuffers[uiFrame]);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+
+    // Start the frame with no objects tested
+    g_m4HiZViewProjection = m4ViewProjection;
+    g_uiNumHiZObjects = 0;
+    g_uiNumHiZCommands = 0;
+    g_uiNumHiZDeferred = 0;
+    g_ui64HiZFrameDraws[uiFrame] = 0;
+    g_ui64HiZFramePatches[uiFrame] = 0;
+    g_bHiZFrameActive = true;
+}
+
+void GL_EndHiZFrame()
+{
+    if (!g_bHiZFrameActive)
+        return;
+
+    // Protect this frames results until they are read back and move to the next frame
+    g_HiZFences[g_uiHiZFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    g_uiHiZFrame = (g_uiHiZFrame + 1) % g_uiHiZFrames;
+    g_bHiZFrameActive = false;
+}
+
+bool GL_HiZFrameActive()
+{
+    return g_bHiZFrameActive;
+}
+
+bool GL_HiZWasVisible(unsigned uiObject)
+{
+    return (gp_uiHiZVisible[uiObject] != 0);
+}
+
+void GL_DeferHiZObject(unsigned uiObject)
+{
+    // Leave until after the depth pyramid has been built
+    gp_uiHiZDeferred[g_uiNumHiZDeferred++] = uiObject;
+}
+
+const unsigned * GL_GetHiZDeferred(unsigned & uiNumObjects)
+{
+    uiNumObjects = g_uiNumHiZDeferred;
+    return gp_uiHiZDeferred;
+}
+
+void GL_AddHiZObject(unsigned uiObject, unsigned uiNumPatches, bool bDeferred)
+{
+    // Increase object storage as needed
+    if (g_uiNumHiZObjects >= g_uiMaxHiZObjects) {
+        g_uiMaxHiZObjects = SDL_max(g_uiMaxHiZObjects * 2, 256u);
+        gp_HiZObjects = (HiZObjectData *)realloc(gp_HiZObjects, g_uiMaxHiZObjects * sizeof(HiZObjectData));
+    }
+    HiZObjectData * p_Object = &gp_HiZObjects[g_uiNumHiZObjects++];
+    const AABBData * p_AABB = &g_SceneData.mp_ObjectAABBs[uiObject];
+    p_Object->m_v4Min = vec4(p_AABB->m_v3Min, 0.0f);
+    p_Object->m_v4Max = vec4(p_AABB->m_v3Max, 0.0f);
+    p_Object->m_uiObject = uiObject;
+    p_Object->m_uiFirstCommand = g_uiNumHiZCommands;
+    p_Object->m_uiNumCommands = 0;
+    p_Object->m_uiNumPatches = uiNumPatches;
+    ++g_ui64HiZFrameDraws[g_uiHiZFrame];
+    g_ui64HiZFramePatches[g_uiHiZFrame] += p_Object->m_uiNumPatches;
+    if (!bDeferred)
+        return;
+
+    // Deferred objects are drawn indirectly so the test can remove them
+    const unsigned uiNumRanges = GL_GetNumClusterRanges();
+    if (g_uiNumHiZCommands + uiNumRanges > g_uiMaxHiZCommands) {
+        g_uiMaxHiZCommands = SDL_max(g_uiMaxHiZCommands * 2, g_uiNumHiZCommands + uiNumRanges);
+        gp_HiZCommands = (DrawIndirectData *)realloc(gp_HiZCommands, g_uiMaxHiZCommands * sizeof(DrawIndirectData));
+    }
+    p_Object->m_uiNumCommands = GL_WriteObjectClusterCommands(&gp_HiZCommands[g_uiNumHiZCommands], 0);
+    for (unsigned i = 0; i < p_Object->m_uiNumCommands; i++) {
+        gp_HiZCommands[g_uiNumHiZCommands + i].m_uiBaseInstance = 0;
+    }
+    gp_uiHiZObjectCommands[uiObject] = g_uiNumHiZObjects - 1;
+    g_uiNumHiZCommands += p_Object->m_uiNumCommands;
+}
+
+void GL_BuildHiZ()
+{
+    GL_TRACE_ZONE("GL_BuildHiZ");
+    // Reduce the depth buffer into the first level then each level into the next
+    glUseProgram(g_uiHiZBuildProgram);
+    glActiveTexture(GL_TEXTURE0 + g_uiHiZTextureUnit);
+    for (unsigned i = 0; i < g_uiHiZLevels; i++) {
+        glBindTexture(GL_TEXTURE_2D, (i == 0) ? g_uiDepth : g_uiHiZPyramid);
+        glUniform1i(0, (i == 0) ? 0 : (GLint)(i - 1));
+        glUniform1ui(1, (i == 0) ? 1 : 0);
+        glBindImageTexture(0, g_uiHiZPyramid, i, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+        const int iWidth = SDL_max(((g_iWindowWidth + 1) / 2) >> i, 1);
+        const int iHeight = SDL_max(((g_iWindowHeight + 1) / 2) >> i, 1);
+        glDispatchCompute((iWidth + 7) / 8, (iHeight + 7) / 8, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+    glBindTexture(GL_TEXTURE_2D, g_uiHiZPyramid);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void GL_TestHiZObjects()
+{
+    GL_TRACE_ZONE("GL_TestHiZObjects");
+    if (g_uiNumHiZObjects == 0)
+        return;
+
+    // Upload objects and the indirect draws of deferred objects
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiHiZObjectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, g_uiNumHiZObjects * sizeof(HiZObjectData), gp_HiZObjects, GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiHiZCommandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, SDL_max(g_uiNumHiZCommands, 1u) * sizeof(DrawIndirectData), gp_HiZCommands, GL_STREAM_DRAW);
+
+    // Test every object against the pyramid
+    glUseProgram(g_uiHiZTestProgram);
+    glUniformMatrix4fv(0, 1, GL_FALSE, &g_m4HiZViewProjection[0][0]);
+    glUniform1ui(4, g_uiNumHiZObjects);
+    glUniform1ui(5, g_SceneData.m_uiNumObjects);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, g_uiHiZObjectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, g_uiHiZCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, g_uiHiZVisibleBuffers[g_uiHiZFrame]);
+    glDispatchCompute((g_uiNumHiZObjects + 63) / 64, 1, 1);
+
+    // Make the edited draws visible to indirect draws and the results to read back
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_uiHiZCommandBuffer);
+}
+
+void GL_DrawHiZObject(GLenum Mode, unsigned uiObject)
+{
+    // Draw the objects ranges, any removed by the test have no instances
+    const HiZObjectData * p_Object = &gp_HiZObjects[gp_uiHiZObjectCommands[uiObject]];
+    glMultiDrawElementsIndirect(Mode, GL_UNSIGNED_INT, (const GLvoid *)(p_Object->m_uiFirstCommand * sizeof(DrawIndirectData)),
+                                p_Object->m_uiNumCommands, 0);
+}
\ No newline at end of file
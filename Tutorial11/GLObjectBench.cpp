@@ -0,0 +1,183 @@
+// Using GLM and math headers
+#include <math.h>
+#include <stdlib.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+// Using SDL
+#include <SDL2/SDL.h>
+
+#include <GLScene.h> //Need '<' to enforce loading of project local header
+
+//Cluster.cpp
+extern void GL_AddClusterView(const mat4 & m4ViewProjection, const vec3 & v3Position, unsigned uiHeight);
+extern void GL_EndClusterViews();
+extern bool GL_ClusterSphereVisible(const vec3 & v3Centre, float fRadius);
+extern void GL_QuitClusters();
+
+// Object layout from before the scene was split into streams, with its world bounds cached so only the layout differs
+struct BenchObjectData
+{
+    unsigned m_uiFirstIndex;
+    unsigned m_uiNumIndices;
+    GLint m_iBaseVertex;
+    unsigned m_uiFirstMeshlet;
+    unsigned m_uiNumMeshlets;
+    unsigned m_uiMesh;
+    GLuint m_uiDiffuse;
+    GLuint m_uiSpecular;
+    GLuint m_uiRough;
+    GLuint m_uiNormal;
+    GLuint m_uiBump;
+    float m_fEmissive;
+    bool m_bTransparent;
+    unsigned m_uiReflective;
+    mat4 m_4Transform;
+    unsigned m_uiTransformOffset;
+    GLuint m_uiReflect;
+    GLintptr m_iReflectVPOffset;
+    float m_fBumpScale;
+    vec4 m_v4Bounds;
+};
+
+// Benchmark settings
+const unsigned g_uiObjectBenchMeshes = 64;
+const unsigned g_uiObjectBenchRepeats = 20;
+
+float GL_ObjectBenchRandom()
+{
+    return (float)rand() / (float)RAND_MAX;
+}
+
+double GL_ObjectBenchAoS(const BenchObjectData * p_Objects, const MaterialData * p_Materials, unsigned uiNumObjects, bool bOpaque, Uint64 & ui64Check)
+{
+    const Uint64 ui64Start = SDL_GetPerformanceCounter();
+    for (unsigned i = 0; i < uiNumObjects; i++) {
+        const BenchObjectData * p_Object = &p_Objects[i];
+        if (bOpaque && p_Object->m_bTransparent)
+            continue;
+
+        // Check the world space bounds stored in the object
+        const vec4 & v4Bounds = p_Object->m_v4Bounds;
+        if (!GL_ClusterSphereVisible(vec3(v4Bounds), v4Bounds.w))
+            continue;
+
+        // Read what a draw would be submitted with, materials are shared per mesh and looked up the same way in both layouts
+        ui64Check += p_Object->m_uiTransformOffset + p_Materials[p_Object->m_uiMesh].m_uiDiffuse;
+    }
+    return (double)(SDL_GetPerformanceCounter() - ui64Start);
+}
+
+double GL_ObjectBenchSoA(const SceneData & Scene, const unsigned * p_uiList, unsigned uiNumList, Uint64 & ui64Check)
+{
+    const Uint64 ui64Start = SDL_GetPerformanceCounter();
+    for (unsigned i = 0; i < uiNumList; i++) {
+        const unsigned uiObject = (p_uiList != NULL) ? p_uiList[i] : i;
+
+        // Check the world space bounds stream
+        const vec4 & v4Bounds = Scene.mp_ObjectBounds[uiObject];
+        if (!GL_ClusterSphereVisible(vec3(v4Bounds), v4Bounds.w))
+            continue;
+
+        // Read what a draw would be submitted with
+        ui64Check += Scene.mp_ObjectDraws[uiObject].m_uiTransformOffset + Scene.mp_Materials[Scene.mp_uiObjectMaterials[uiObject]].m_uiDiffuse;
+    }
+    return (double)(SDL_GetPerformanceCounter() - ui64Start);
+}
+
+void GL_RunObjectBench(unsigned uiNumObjects)
+{
+    // Create random meshes and materials, one in five materials is transparent
+    srand(1);
+    vec4 v4Spheres[g_uiObjectBenchMeshes];
+    MaterialData Materials[g_uiObjectBenchMeshes];
+    for (unsigned i = 0; i < g_uiObjectBenchMeshes; i++) {
+        v4Spheres[i] = vec4(GL_ObjectBenchRandom() - 0.5f, GL_ObjectBenchRandom() - 0.5f, GL_ObjectBenchRandom() - 0.5f, 0.5f + GL_ObjectBenchRandom() * 2.0f);
+        Materials[i] = MaterialData();
+        Materials[i].m_uiDiffuse = i + 1;
+        Materials[i].m_bTransparent = ((i % 5) == 0);
+    }
+
+    // Scatter objects through the scene in both layouts
+    BenchObjectData * p_Objects = (BenchObjectData *)malloc(uiNumObjects * sizeof(BenchObjectData));
+    SceneData Scene = {};
+    Scene.mp_Materials = Materials;
+    Scene.mp_ObjectDraws = (ObjectDrawData *)malloc(uiNumObjects * sizeof(ObjectDrawData));
+    Scene.mp_ObjectTransforms = (mat4 *)malloc(uiNumObjects * sizeof(mat4));
+    Scene.mp_ObjectBounds = (vec4 *)malloc(uiNumObjects * sizeof(vec4));
+    Scene.mp_uiObjectMaterials = (unsigned *)malloc(uiNumObjects * sizeof(unsigned));
+    Scene.mp_ucObjectFlags = (unsigned char *)malloc(uiNumObjects * sizeof(unsigned char));
+    Scene.mp_uiOpaqueObjects = (unsigned *)malloc(uiNumObjects * sizeof(unsigned));
+    for (unsigned i = 0; i < uiNumObjects; i++) {
+        const unsigned uiMesh = (unsigned)rand() % g_uiObjectBenchMeshes;
+        const vec3 v3Position = (vec3(GL_ObjectBenchRandom(), GL_ObjectBenchRandom(), GL_ObjectBenchRandom()) - 0.5f) * 2000.0f;
+        mat4 m4Transform = translate(mat4(1.0f), v3Position);
+        m4Transform = rotate(m4Transform, GL_ObjectBenchRandom() * 6.283f, vec3(0.0f, 1.0f, 0.0f));
+        m4Transform = scale(m4Transform, vec3(0.5f + GL_ObjectBenchRandom() * 4.0f));
+
+        const float fScale = max(length(vec3(m4Transform[0])), max(length(vec3(m4Transform[1])), length(vec3(m4Transform[2]))));
+        const vec4 v4Bounds = vec4(vec3(m4Transform * vec4(vec3(v4Spheres[uiMesh]), 1.0f)), v4Spheres[uiMesh].w * fScale);
+
+        BenchObjectData * p_Object = &p_Objects[i];
+        *p_Object = BenchObjectData();
+        p_Object->m_uiMesh = uiMesh;
+        p_Object->m_uiDiffuse = Materials[uiMesh].m_uiDiffuse;
+        p_Object->m_bTransparent = Materials[uiMesh].m_bTransparent;
+        p_Object->m_4Transform = m4Transform;
+        p_Object->m_uiTransformOffset = i * 256;
+        p_Object->m_v4Bounds = v4Bounds;
+
+        Scene.mp_ObjectDraws[i] = ObjectDrawData();
+        Scene.mp_ObjectDraws[i].m_uiMesh = uiMesh;
+        Scene.mp_ObjectDraws[i].m_uiTransformOffset = i * 256;
+        Scene.mp_ObjectTransforms[i] = m4Transform;
+        Scene.mp_ObjectBounds[i] = v4Bounds;
+        Scene.mp_uiObjectMaterials[i] = uiMesh;
+        Scene.mp_ucObjectFlags[i] = (Materials[uiMesh].m_bTransparent) ? g_ucObjectTransparent : 0;
+        if (!Materials[uiMesh].m_bTransparent) {
+            Scene.mp_uiOpaqueObjects[Scene.m_uiNumOpaqueObjects] = i;
+            ++Scene.m_uiNumOpaqueObjects;
+        }
+    }
+    Scene.m_uiNumObjects = uiNumObjects;
+
+    // Cull against a single camera looking into the scene
+    GL_EndClusterViews();
+    const vec3 v3Position = vec3(0.0f, 0.0f, -1000.0f);
+    const mat4 m4View = lookAt(v3Position, vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    GL_AddClusterView(perspective(radians(60.0f), 1.25f, 1.0f, 3000.0f) * m4View, v3Position, 720);
+
+    // Time each pass several times and keep the fastest
+    double dTimes[4] = {1e30, 1e30, 1e30, 1e30};
+    Uint64 ui64Checks[4] = {0, 0, 0, 0};
+    for (unsigned i = 0; i < g_uiObjectBenchRepeats; i++) {
+        Uint64 ui64Check[4] = {0, 0, 0, 0};
+        dTimes[0] = SDL_min(dTimes[0], GL_ObjectBenchAoS(p_Objects, Materials, uiNumObjects, false, ui64Check[0]));
+        dTimes[1] = SDL_min(dTimes[1], GL_ObjectBenchSoA(Scene, NULL, Scene.m_uiNumObjects, ui64Check[1]));
+        dTimes[2] = SDL_min(dTimes[2], GL_ObjectBenchAoS(p_Objects, Materials, uiNumObjects, true, ui64Check[2]));
+        dTimes[3] = SDL_min(dTimes[3], GL_ObjectBenchSoA(Scene, Scene.mp_uiOpaqueObjects, Scene.m_uiNumOpaqueObjects, ui64Check[3]));
+        for (unsigned j = 0; j < 4; j++) {
+            ui64Checks[j] = ui64Check[j];
+        }
+    }
+    GL_EndClusterViews();
+    GL_QuitClusters();
+
+    // Output results, both layouts must have read the same objects
+    const double dTicksToMS = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    SDL_Log("Object bench: %u objects, %u opaque, %u bytes per object before, %u after\n", uiNumObjects, Scene.m_uiNumOpaqueObjects,
+            (unsigned)sizeof(BenchObjectData),
+            (unsigned)(sizeof(ObjectDrawData) + sizeof(mat4) + sizeof(vec4) + sizeof(unsigned) + sizeof(unsigned char)));
+    SDL_Log("All objects: AoS %.3f ms, SoA %.3f ms (%.2fx)\n", dTimes[0] * dTicksToMS, dTimes[1] * dTicksToMS, dTimes[0] / SDL_max(dTimes[1], 1.0));
+    SDL_Log("Opaque objects: AoS %.3f ms, SoA %.3f ms (%.2fx)\n", dTimes[2] * dTicksToMS, dTimes[3] * dTicksToMS, dTimes[2] / SDL_max(dTimes[3], 1.0));
+    if ((ui64Checks[0] != ui64Checks[1]) || (ui64Checks[2] != ui64Checks[3]))
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Object bench layouts visited different objects\n");
+
+    // Cleanup
+    free(p_Objects);
+    free(Scene.mp_ObjectDraws);
+    free(Scene.mp_ObjectTransforms);
+    free(Scene.mp_ObjectBounds);
+    free(Scene.mp_uiObjectMaterials);
+    free(Scene.mp_ucObjectFlags);
+    free(Scene.mp_uiOpaqueObjects);
+}
\ No newline at end of file
@@ -0,0 +1,268 @@
+// Using SDL, GLEW
+#include <math.h>
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include "GLProfiler.h"
+
+// Number of frames in flight before query results are read back
+const unsigned g_uiProfileBuffers = 2;
+// Maximum times a pass can run each frame (reflections re-run the deferred passes)
+const unsigned g_uiProfileMaxSamples = 16;
+// Number of frames kept for the rolling statistics
+const unsigned g_uiProfileHistory = 256;
+
+const char * gp_cProfilePassNames[PROFILE_NUM_PASSES] = {
+    "Shadows",
+    "G-Buffer",
+    "Hi-Z",
+    "SSAO",
+    "Volumetric",
+    "Volumetric Blur H",
+    "Volumetric Blur V",
+    "AO Composite",
+    "Lighting",
+    "Volumetric Composite",
+    "Luminance",
+    "Bloom",
+    "Tone Map"
+};
+
+struct ProfilePassData
+{
+    GLuint m_uiQueries[g_uiProfileBuffers][g_uiProfileMaxSamples];
+    unsigned m_uiNumIssued[g_uiProfileBuffers];
+    float m_fHistory[g_uiProfileHistory];
+    unsigned m_uiNumFrames;
+    unsigned m_uiNumDropped;
+};
+
+// Profiler data
+bool g_bProfilerEnabled = false;
+const char * gp_cProfileCSVFile = NULL;
+ProfilePassData * gp_ProfilePasses = NULL;
+unsigned g_uiProfileFrame = 0;
+int g_iProfileActivePass = -1;
+// Whole frame CPU time and vertex shader invocations, used to compare vertex formats
+float g_fProfileFrameHistory[g_uiProfileHistory];
+unsigned g_uiProfileFrameTimes = 0;
+Uint64 g_ui64ProfileFrameStart = 0;
+GLuint g_uiProfileVertexQueries[g_uiProfileBuffers];
+bool g_bProfileVertexIssued[g_uiProfileBuffers];
+bool g_bProfileVertices = false;
+unsigned g_uiProfileVertexSize = 0;
+double g_dProfileVertexTotal = 0.0;
+unsigned g_uiProfileVertexFrames = 0;
+
+void GL_ProfileBegin(ProfilePass Pass)
+{
+    if (!g_bProfilerEnabled)
+        return;
+
+    // Elapsed time queries cannot nest, so a pass started inside another is not timed
+    if (g_iProfileActivePass >= 0) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Profile pass '%s' started while '%s' is still active\n", gp_cProfilePassNames[Pass],
+                        gp_cProfilePassNames[g_iProfileActivePass]);
+        return;
+    }
+
+    // Start timing the next free query for this pass
+    ProfilePassData * p_Pass = &gp_ProfilePasses[Pass];
+    const unsigned uiBuffer = g_uiProfileFrame % g_uiProfileBuffers;
+    if (p_Pass->m_uiNumIssued[uiBuffer] < g_uiProfileMaxSamples) {
+        glBeginQuery(GL_TIME_ELAPSED, p_Pass->m_uiQueries[uiBuffer][p_Pass->m_uiNumIssued[uiBuffer]]);
+        g_iProfileActivePass = Pass;
+    }
+}
+
+void GL_ProfileEnd()
+{
+    if (g_iProfileActivePass < 0)
+        return;
+
+    // Finish the active query
+    glEndQuery(GL_TIME_ELAPSED);
+    ++gp_ProfilePasses[g_iProfileActivePass].m_uiNumIssued[g_uiProfileFrame % g_uiProfileBuffers];
+    g_iProfileActivePass = -1;
+}
+
+void GL_ProfileFrame()
+{
+    if (!g_bProfilerEnabled)
+        return;
+
+    // Time the whole frame on the CPU and end its vertex count
+    const Uint64 ui64Now = SDL_GetPerformanceCounter();
+    g_fProfileFrameHistory[g_uiProfileFrameTimes % g_uiProfileHistory] =
+        (float)((double)(ui64Now - g_ui64ProfileFrameStart) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    ++g_uiProfileFrameTimes;
+    g_ui64ProfileFrameStart = ui64Now;
+    if (g_bProfileVertices)
+        glEndQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB);
+
+    // Move to the oldest buffer, its queries were issued a full frame ago so should not stall
+    ++g_uiProfileFrame;
+    const unsigned uiBuffer = g_uiProfileFrame % g_uiProfileBuffers;
+    if (g_bProfileVertices) {
+        // Collect the oldest frames vertex count if ready, then count this frame into it
+        if (g_bProfileVertexIssued[uiBuffer]) {
+            GLint iAvailable = GL_FALSE;
+            glGetQueryObjectiv(g_uiProfileVertexQueries[uiBuffer], GL_QUERY_RESULT_AVAILABLE, &iAvailable);
+            if (iAvailable != GL_FALSE) {
+                GLuint64 ui64Vertices = 0;
+                glGetQueryObjectui64v(g_uiProfileVertexQueries[uiBuffer], GL_QUERY_RESULT, &ui64Vertices);
+                g_dProfileVertexTotal += (double)ui64Vertices;
+                ++g_uiProfileVertexFrames;
+            }
+        }
+        glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB, g_uiProfileVertexQueries[uiBuffer]);
+        g_bProfileVertexIssued[uiBuffer] = true;
+    }
+    for (unsigned i = 0; i < PROFILE_NUM_PASSES; i++) {
+        ProfilePassData * p_Pass = &gp_ProfilePasses[i];
+        const unsigned uiNumIssued = p_Pass->m_uiNumIssued[uiBuffer];
+        p_Pass->m_uiNumIssued[uiBuffer] = 0;
+        if (uiNumIssued == 0)
+            continue;
+
+        // Drop the sample rather than wait if the GPU has not caught up
+        GLint iAvailable = GL_FALSE;
+        glGetQueryObjectiv(p_Pass->m_uiQueries[uiBuffer][uiNumIssued - 1], GL_QUERY_RESULT_AVAILABLE, &iAvailable);
+        if (iAvailable == GL_FALSE) {
+            ++p_Pass->m_uiNumDropped;
+            continue;
+        }
+
+        // Sum all runs of the pass within the frame
+        GLuint64 ui64Total = 0;
+        for (unsigned j = 0; j < uiNumIssued; j++) {
+            GLuint64 ui64Elapsed = 0;
+            glGetQueryObjectui64v(p_Pass->m_uiQueries[uiBuffer][j], GL_QUERY_RESULT, &ui64Elapsed);
+            ui64Total += ui64Elapsed;
+        }
+        p_Pass->m_fHistory[p_Pass->m_uiNumFrames % g_uiProfileHistory] = (float)((double)ui64Total / 1000000.0);
+        ++p_Pass->m_uiNumFrames;
+    }
+}
+
+int GL_CompareProfileTimes(const void * p_A, const void * p_B)
+{
+    float fA = *(const float *)p_A;
+    float fB = *(const float *)p_B;
+    return (fA > fB) - (fA < fB);
+}
+
+bool GL_InitProfiler(const char * p_cCSVFile, unsigned uiVertexSize)
+{
+    // Check timer queries are usable
+    GLint iBits = 0;
+    glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &iBits);
+    if (iBits == 0) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "GPU timer queries are not supported\n");
+        return false;
+    }
+
+    // Generate queries for each pass
+    gp_ProfilePasses = (ProfilePassData *)calloc(PROFILE_NUM_PASSES, sizeof(ProfilePassData));
+    for (unsigned i = 0; i < PROFILE_NUM_PASSES; i++) {
+        glGenQueries(g_uiProfileBuffers * g_uiProfileMaxSamples, &gp_ProfilePasses[i].m_uiQueries[0][0]);
+    }
+    gp_cProfileCSVFile = p_cCSVFile;
+    g_uiProfileFrame = 0;
+    g_bProfilerEnabled = true;
+
+    // Count vertex shader invocations each frame to estimate vertex fetch, this needs pipeline statistics
+    g_uiProfileVertexSize = uiVertexSize;
+    g_uiProfileFrameTimes = 0;
+    g_ui64ProfileFrameStart = SDL_GetPerformanceCounter();
+    g_dProfileVertexTotal = 0.0;
+    g_uiProfileVertexFrames = 0;
+    g_bProfileVertices = GLEW_ARB_pipeline_statistics_query;
+    if (g_bProfileVertices) {
+        glGenQueries(g_uiProfileBuffers, g_uiProfileVertexQueries);
+        memset(g_bProfileVertexIssued, 0, sizeof(g_bProfileVertexIssued));
+        glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB, g_uiProfileVertexQueries[0]);
+        g_bProfileVertexIssued[0] = true;
+    } else
+        SDL_Log("Pipeline statistics queries are not supported, vertex fetch will not be measured\n");
+    return true;
+}
+
+void GL_QuitProfiler()
+{
+    if (!g_bProfilerEnabled)
+        return;
+
+    // Open optional CSV output
+    SDL_RWops * p_File = NULL;
+    if (gp_cProfileCSVFile != NULL) {
+        p_File = SDL_RWFromFile(gp_cProfileCSVFile, "w");
+        if (p_File == NULL)
+            SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to open profile file: %s\n", gp_cProfileCSVFile);
+    }
+    char cLine[256];
+    if (p_File != NULL) {
+        int iLength = SDL_snprintf(cLine, sizeof(cLine), "pass,min_ms,avg_ms,p99_ms,frames,dropped\n");
+        SDL_RWwrite(p_File, cLine, iLength, 1);
+    }
+
+    // Output rolling statistics for each pass
+    SDL_Log("%-22s %9s %9s %9s %7s %7s\n", "Pass", "min ms", "avg ms", "p99 ms", "frames", "dropped");
+    float fSorted[g_uiProfileHistory];
+    float fTotalAverage = 0.0f;
+    for (unsigned i = 0; i < PROFILE_NUM_PASSES; i++) {
+        ProfilePassData * p_Pass = &gp_ProfilePasses[i];
+        const unsigned uiNumSamples = (p_Pass->m_uiNumFrames < g_uiProfileHistory) ? p_Pass->m_uiNumFrames : g_uiProfileHistory;
+        float fMin = 0.0f, fAverage = 0.0f, fP99 = 0.0f;
+        if (uiNumSamples > 0) {
+            memcpy(fSorted, p_Pass->m_fHistory, uiNumSamples * sizeof(float));
+            qsort(fSorted, uiNumSamples, sizeof(float), GL_CompareProfileTimes);
+            for (unsigned j = 0; j < uiNumSamples; j++) {
+                fAverage += fSorted[j];
+            }
+            fAverage /= (float)uiNumSamples;
+            fMin = fSorted[0];
+            fP99 = fSorted[(unsigned)ceilf(0.99f * (float)uiNumSamples) - 1];
+        }
+        fTotalAverage += fAverage;
+        SDL_Log("%-22s %9.3f %9.3f %9.3f %7u %7u\n", gp_cProfilePassNames[i], fMin, fAverage, fP99,
+                p_Pass->m_uiNumFrames, p_Pass->m_uiNumDropped);
+        if (p_File != NULL) {
+            int iLength = SDL_snprintf(cLine, sizeof(cLine), "%s,%.4f,%.4f,%.4f,%u,%u\n", gp_cProfilePassNames[i],
+                                       fMin, fAverage, fP99, p_Pass->m_uiNumFrames, p_Pass->m_uiNumDropped);
+            SDL_RWwrite(p_File, cLine, iLength, 1);
+        }
+    }
+    SDL_Log("%-22s %9s %9.3f\n", "Total", "", fTotalAverage);
+
+    // Output the CPU frame time and vertex fetch, run with and without packed vertices to compare the formats
+    const unsigned uiNumFrames = (g_uiProfileFrameTimes < g_uiProfileHistory) ? g_uiProfileFrameTimes : g_uiProfileHistory;
+    float fFrameAverage = 0.0f;
+    for (unsigned i = 0; i < uiNumFrames; i++) {
+        fFrameAverage += g_fProfileFrameHistory[i];
+    }
+    fFrameAverage = (uiNumFrames > 0) ? fFrameAverage / (float)uiNumFrames : 0.0f;
+    const double dVertices = (g_uiProfileVertexFrames > 0) ? g_dProfileVertexTotal / (double)g_uiProfileVertexFrames : 0.0;
+    const double dFetchMB = dVertices * (double)g_uiProfileVertexSize / (1024.0 * 1024.0);
+    SDL_Log("Frame %.3f ms average over %u frames, %u byte vertices, %.0f vertex shader invocations and about %.2f MB vertex fetch per frame\n",
+            fFrameAverage, uiNumFrames, g_uiProfileVertexSize, dVertices, dFetchMB);
+    if (p_File != NULL) {
+        int iLength = SDL_snprintf(cLine, sizeof(cLine), "frame_cpu,%.4f\nvertex_size,%u\nvertices_per_frame,%.0f\nvertex_fetch_mb,%.4f\n", fFrameAverage,
+                                   g_uiProfileVertexSize, dVertices, dFetchMB);
+        SDL_RWwrite(p_File, cLine, iLength, 1);
+        SDL_RWclose(p_File);
+    }
+    if (g_bProfileVertices) {
+        glEndQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB);
+        glDeleteQueries(g_uiProfileBuffers, g_uiProfileVertexQueries);
+        g_bProfileVertices = false;
+    }
+
+    // Release queries
+    for (unsigned i = 0; i < PROFILE_NUM_PASSES; i++) {
+        glDeleteQueries(g_uiProfileBuffers * g_uiProfileMaxSamples, &gp_ProfilePasses[i].m_uiQueries[0][0]);
+    }
+    free(gp_ProfilePasses);
+    gp_ProfilePasses = NULL;
+    g_bProfilerEnabled = false;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef _GLPROFILER_H_
+#define _GLPROFILER_H_
+
+// Using GLEW
+#include <GL/glew.h>
+
+enum ProfilePass
+{
+    PROFILE_SHADOWS,
+    PROFILE_GBUFFER,
+    PROFILE_HIZ,
+    PROFILE_SSAO,
+    PROFILE_VOLUMETRIC,
+    PROFILE_VOLUMETRIC_BLUR_H,
+    PROFILE_VOLUMETRIC_BLUR_V,
+    PROFILE_AO_COMPOSITE,
+    PROFILE_LIGHTING,
+    PROFILE_VOLUMETRIC_COMPOSITE,
+    PROFILE_LUMINANCE,
+    PROFILE_BLOOM,
+    PROFILE_TONE_MAP,
+    PROFILE_NUM_PASSES
+};
+
+bool GL_InitProfiler(const char * p_cCSVFile, unsigned uiVertexSize);
+
+void GL_QuitProfiler();
+
+void GL_ProfileBegin(ProfilePass Pass);
+
+void GL_ProfileEnd();
+
+void GL_ProfileFrame();
+
+#endif
\ No newline at end of file
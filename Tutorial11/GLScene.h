@@ -9,12 +9,41 @@
 
 using namespace glm;
 
+// Maximum number of detail levels per mesh, including the full detail mesh
+const unsigned g_uiMaxMeshLODs = 4;
+
+struct MeshLODData
+{
+    unsigned m_uiFirstIndex;
+    unsigned m_uiNumIndices;
+    // Simplification error in mesh space
+    float m_fError;
+};
+
 struct MeshData
 {
-    GLuint m_uiVAO;
-    GLuint m_uiVBO;
-    GLuint m_uiIBO;
+    unsigned m_uiFirstIndex;
+    unsigned m_uiNumIndices;
+    GLint m_iBaseVertex;
+    unsigned m_uiFirstMeshlet;
+    unsigned m_uiNumMeshlets;
+    // Bounding sphere and box in mesh space
+    vec4 m_v4Sphere;
+    vec3 m_v3AABBMin;
+    vec3 m_v3AABBMax;
+    MeshLODData m_LODs[g_uiMaxMeshLODs];
+    unsigned m_uiNumLODs;
+};
+
+struct MeshletData
+{
+    // Bounding sphere and normal cone in mesh space
+    vec4 m_v4Sphere;
+    vec4 m_v4Cone;
+    unsigned m_uiFirstIndex;
     unsigned m_uiNumIndices;
+    GLint m_iBaseVertex;
+    unsigned m_uiMesh;
 };
 
 struct MaterialData
@@ -30,23 +59,37 @@ struct MaterialData
     float m_fBumpScale;
 };
 
-struct ObjectData
+// Object flags, the reflection type is held in the low bits
+const unsigned char g_ucObjectPlanarReflect = 0x1;
+const unsigned char g_ucObjectCubeReflect = 0x2;
+const unsigned char g_ucObjectReflectMask = 0x3;
+const unsigned char g_ucObjectTransparent = 0x4;
+
+struct AABBData
 {
-    GLuint m_uiVAO;
+    vec3 m_v3Min;
+    vec3 m_v3Max;
+};
+
+struct ObjectDrawData
+{
+    unsigned m_uiFirstIndex;
     unsigned m_uiNumIndices;
-    GLuint m_uiDiffuse;
-    GLuint m_uiSpecular;
-    GLuint m_uiRough;
-    GLuint m_uiNormal;
-    GLuint m_uiBump;
-    float m_fEmissive;
-    bool m_bTransparent;
-    unsigned m_uiReflective;
-    mat4 m_4Transform;
-    GLuint m_uiTransformUBO;
-    GLuint m_uiReflect;
-    GLuint m_uiReflectVPUBO;
-    float m_fBumpScale;
+    GLint m_iBaseVertex;
+    unsigned m_uiFirstMeshlet;
+    unsigned m_uiNumMeshlets;
+    unsigned m_uiMesh;
+    unsigned m_uiTransformOffset;
+};
+
+// Layout of a single glMultiDrawElementsIndirect command
+struct DrawIndirectData
+{
+    GLuint m_uiCount;
+    GLuint m_uiInstanceCount;
+    GLuint m_uiFirstIndex;
+    GLint m_iBaseVertex;
+    GLuint m_uiBaseInstance;
 };
 
 struct ReflectObjectData
@@ -54,6 +97,8 @@ struct ReflectObjectData
     unsigned m_uiObjectPos;
     // Reflection data
     vec4 m_v4PlaneOrPosition;
+    GLuint m_uiReflect;
+    GLintptr m_iReflectVPOffset;
 };
 
 struct PointLightData
@@ -62,6 +107,8 @@ struct PointLightData
     aligned_vec3 m_v3Colour;
     aligned_vec3 m_v3Falloff;
     aligned_vec2 m_v2NearFar;
+    // Shadow atlas tile of the first cube face, the rest follow 3 across and 2 down
+    aligned_vec4 m_v4ShadowTile;
 };
 
 struct SpotLightData
@@ -72,6 +119,8 @@ struct SpotLightData
     aligned_vec3 m_v3Colour;
     aligned_vec3 m_v3Falloff;
     float m_fFalloffDist;
+    // Shadow atlas tile as offset and size in texture coordinates
+    aligned_vec4 m_v4ShadowTile;
 };
 
 struct LocalCameraData
@@ -93,11 +142,36 @@ struct SceneData
 {
     MeshData * mp_Meshes;
     unsigned m_uiNumMeshes;
+    GLuint m_uiVAO;
+    GLuint m_uiVBO;
+    GLuint m_uiIBO;
+    bool m_bPackedVertices;
+    unsigned m_uiVertexSize;
+    MeshletData * mp_Meshlets;
+    unsigned m_uiNumMeshlets;
+    GLuint m_uiMeshletSSBO;
+    GLuint * mp_Textures;
+    unsigned m_uiNumTextures;
     MaterialData * mp_Materials;
     unsigned m_uiNumMaterials;
-    ObjectData * mp_Objects;
+    // Objects are stored as parallel streams indexed by object
+    ObjectDrawData * mp_ObjectDraws;
+    mat4 * mp_ObjectTransforms;
+    // Bounding sphere and box in world space
+    vec4 * mp_ObjectBounds;
+    AABBData * mp_ObjectAABBs;
+    unsigned * mp_uiObjectMaterials;
+    unsigned char * mp_ucObjectFlags;
+    unsigned * mp_uiObjectReflects;
     unsigned m_uiNumObjects;
-    ObjectData * mp_TransObjects;
+    unsigned char * mp_Transforms;
+    GLuint m_uiTransformUBO;
+    unsigned m_uiTransformSize;
+    unsigned m_uiTransformStride;
+    // Index lists of objects for each pass
+    unsigned * mp_uiOpaqueObjects;
+    unsigned m_uiNumOpaqueObjects;
+    unsigned * mp_uiTransObjects;
     unsigned m_uiNumTransObjects;
     ReflectObjectData * mp_ReflecObjects;
     unsigned m_uiNumReflecObjects;
@@ -113,6 +187,8 @@ struct SceneData
 
 bool GL_LoadScene(const char * p_cSceneFile, SceneData & SceneInfo);
 
+void GL_UpdateObjectTransform(SceneData & SceneInfo, unsigned uiObject, const mat4 & m4Transform);
+
 void GL_UnloadScene(SceneData & SceneInfo);
 
 #endif
\ No newline at end of file
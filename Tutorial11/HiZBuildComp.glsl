@@ -0,0 +1,34 @@
+#version 430 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// Depth buffer for the first level, otherwise the pyramid itself
+layout(binding = 20) uniform sampler2D s2Source;
+layout(binding = 0, rg32f) uniform writeonly image2D i2Dest;
+
+layout(location = 0) uniform int iSourceLevel;
+layout(location = 1) uniform uint uiFirstLevel;
+
+void main()
+{
+    ivec2 i2Texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 i2DestSize = imageSize(i2Dest);
+    if (any(greaterThanEqual(i2Texel, i2DestSize)))
+        return;
+
+    // Cover every source texel under this one, with odd sizes some cover three
+    ivec2 i2SourceSize = textureSize(s2Source, iSourceLevel);
+    ivec2 i2Start = (i2Texel * i2SourceSize) / i2DestSize;
+    ivec2 i2End = min((((i2Texel + 1) * i2SourceSize) + i2DestSize - 1) / i2DestSize, i2SourceSize);
+
+    // Keep the nearest and furthest depth
+    vec2 v2MinMax = vec2(1.0f, 0.0f);
+    for (int y = i2Start.y; y < i2End.y; y++) {
+        for (int x = i2Start.x; x < i2End.x; x++) {
+            vec2 v2Depth = texelFetch(s2Source, ivec2(x, y), iSourceLevel).rg;
+            v2Depth = (uiFirstLevel != 0) ? v2Depth.rr : v2Depth;
+            v2MinMax = vec2(min(v2MinMax.x, v2Depth.x), max(v2MinMax.y, v2Depth.y));
+        }
+    }
+    imageStore(i2Dest, i2Texel, vec4(v2MinMax, 0.0f, 0.0f));
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+struct HiZObject {
+    vec4 v4Min;
+    vec4 v4Max;
+    uint uiObject;
+    // Indirect draws to remove when hidden, none for objects that were already drawn
+    uint uiFirstCommand;
+    uint uiNumCommands;
+    uint uiNumPatches;
+};
+struct DrawCommand {
+    uint uiCount;
+    uint uiInstanceCount;
+    uint uiFirstIndex;
+    int iBaseVertex;
+    uint uiBaseInstance;
+};
+
+layout(std430, binding = 2) readonly buffer HiZObjectData {
+    HiZObject Objects[];
+};
+layout(std430, binding = 3) buffer DrawCommandData {
+    DrawCommand Commands[];
+};
+// Visibility of each scene object followed by the hidden draw and patch counts
+layout(std430, binding = 4) buffer HiZVisibleData {
+    uint uiVisible[];
+};
+
+// Nearest and furthest depth pyramid
+layout(binding = 20) uniform sampler2D s2HiZ;
+
+layout(location = 0) uniform mat4 m4ViewProjection;
+layout(location = 4) uniform uint uiNumObjects;
+layout(location = 5) uniform uint uiStatsOffset;
+
+bool HiZVisible(vec3 v3Min, vec3 v3Max)
+{
+    // Project each corner of the bounds, anything crossing the near plane is kept
+    vec3 v3NDCMin = vec3(1.0f);
+    vec3 v3NDCMax = vec3(-1.0f);
+    for (uint i = 0; i < 8; i++) {
+        vec3 v3Corner = vec3(((i & 1) != 0) ? v3Max.x : v3Min.x, ((i & 2) != 0) ? v3Max.y : v3Min.y, ((i & 4) != 0) ? v3Max.z : v3Min.z);
+        vec4 v4Clip = m4ViewProjection * vec4(v3Corner, 1.0f);
+        if (v4Clip.w <= 0.0001f)
+            return true;
+        vec3 v3NDC = v4Clip.xyz / v4Clip.w;
+        v3NDCMin = min(v3NDCMin, v3NDC);
+        v3NDCMax = max(v3NDCMax, v3NDC);
+    }
+    vec2 v2UVMin = clamp((v3NDCMin.xy * 0.5f) + 0.5f, 0.0f, 1.0f);
+    vec2 v2UVMax = clamp((v3NDCMax.xy * 0.5f) + 0.5f, 0.0f, 1.0f);
+    float fDepth = (v3NDCMin.z * 0.5f) + 0.5f;
+
+    // Use the level where the bounds cover at most two texels in each direction
+    int iLevels = textureQueryLevels(s2HiZ);
+    vec2 v2Size = (v2UVMax - v2UVMin) * vec2(textureSize(s2HiZ, 0));
+    int iLevel = clamp(int(ceil(log2(max(max(v2Size.x, v2Size.y), 1.0f)))), 0, iLevels - 1);
+    ivec2 i2LevelSize = textureSize(s2HiZ, iLevel);
+    ivec2 i2Min = clamp(ivec2(v2UVMin * vec2(i2LevelSize)), ivec2(0), i2LevelSize - 1);
+    ivec2 i2Max = clamp(ivec2(v2UVMax * vec2(i2LevelSize)), ivec2(0), i2LevelSize - 1);
+    if (any(greaterThan(i2Max - i2Min, ivec2(1))) && (iLevel + 1 < iLevels)) {
+        ++iLevel;
+        i2LevelSize = textureSize(s2HiZ, iLevel);
+        i2Min = clamp(ivec2(v2UVMin * vec2(i2LevelSize)), ivec2(0), i2LevelSize - 1);
+        i2Max = clamp(ivec2(v2UVMax * vec2(i2LevelSize)), ivec2(0), i2LevelSize - 1);
+    }
+
+    // Hidden if its nearest point is behind the furthest depth under it
+    float fMaxDepth = 0.0f;
+    for (int y = i2Min.y; y <= i2Max.y; y++) {
+        for (int x = i2Min.x; x <= i2Max.x; x++) {
+            fMaxDepth = max(fMaxDepth, texelFetch(s2HiZ, ivec2(x, y), iLevel).g);
+        }
+    }
+    return (fDepth <= fMaxDepth);
+}
+
+void main()
+{
+    uint uiIndex = gl_GlobalInvocationID.x;
+    if (uiIndex >= uiNumObjects)
+        return;
+    HiZObject Object = Objects[uiIndex];
+
+    // Mark visible objects so next frame draws them before the pyramid is built
+    if (HiZVisible(Object.v4Min.xyz, Object.v4Max.xyz)) {
+        uiVisible[Object.uiObject] = 1;
+        return;
+    }
+
+    // Remove the draws of hidden objects that have not been drawn yet
+    if (Object.uiNumCommands > 0) {
+        for (uint i = 0; i < Object.uiNumCommands; i++) {
+            Commands[Object.uiFirstCommand + i].uiInstanceCount = 0;
+        }
+        atomicAdd(uiVisible[uiStatsOffset], 1);
+        atomicAdd(uiVisible[uiStatsOffset + 1], Object.uiNumPatches);
+    }
+}
\ No newline at end of file
@@ -13,38 +13,124 @@
 using namespace glm;
 
 #include "GLScene.h"
+#include "GLTrace.h"
+#include "GLProfiler.h"
 
 //Debug.cpp
 extern void GLDebug_Init();
 //Shaders.cpp
-extern bool GL_LoadShader(GLuint & uiShader, GLenum ShaderType, const GLchar * p_cShader);
+extern bool GL_LoadShader(GLuint & uiShader, GLenum ShaderType, const GLchar * p_cShader, const GLchar * p_cDefines = NULL);
 extern bool GL_LoadShaders(GLuint & uiShader, GLuint uiVertexShader, GLuint uiFragmentShader, GLuint uiGeometryShader = -1, GLuint uiTessControlShader = -1, GLuint uiTessEvalShader = -1);
-extern bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char * p_cFileName, int iFileID);
+extern bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char * p_cFileName, int iFileID, const GLchar * p_cDefines = NULL);
 //Textures.cpp
 extern bool GL_LoadTextureKTX(GLuint uiTexture, const char * p_cTextureFile);
 //Reflection.cpp
+extern void GL_ReserveReflectionUniforms();
 extern bool GL_InitReflection();
 extern void GL_QuitReflection();
-extern void GL_RenderPlanarReflection(ReflectObjectData * p_RObject, ObjectData * p_Object, const vec3 & v3Direction, const vec3 & v3Up,
+extern void GL_RenderPlanarReflection(ReflectObjectData * p_RObject, const vec3 & v3Direction, const vec3 & v3Up,
                                       const vec3 & v3Position, float fFOV, float fAspect, const vec2 & v2NearFar);
-extern void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject, ObjectData * p_Object);
+extern void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject);
+extern bool GL_UpdateEnvironmentReflections();
 //Shadow.cpp
+extern void GL_ReserveShadowUniforms();
 extern bool GL_InitShadow();
 extern void GL_QuitShadow();
-extern void GL_RenderShadows();
+extern unsigned g_uiShadowLayerBudget;
+extern bool g_bShadowDepth16;
+extern void GL_UpdateShadows();
+//Cluster.cpp
+extern bool g_bClusterCulling;
+extern bool g_bMeshLODs;
+extern void GL_BeginClusterViews(const char * p_cPass, GLenum CullFace, float fLODBias);
+extern void GL_AddClusterView(const mat4 & m4ViewProjection, const vec3 & v3Position, unsigned uiHeight);
+extern void GL_EndClusterViews();
+extern bool GL_CullObjectClusters(unsigned uiObject);
+extern void GL_DrawObjectClusters(GLenum Mode, unsigned uiObject);
+extern unsigned GL_GetNumClusterTriangles();
+extern unsigned GL_GetObjectLODTriangles(unsigned uiObject);
+extern float GL_GetObjectPixelSize(unsigned uiObject);
+extern vec3 GL_GetClusterViewPosition();
+extern void GL_QuitClusters();
+//BVH.cpp
+extern bool g_bObjectBVH;
+extern bool GL_InitObjectBVH();
+extern const unsigned * GL_CullObjectBVH(unsigned char ucFlagMask, unsigned char ucFlags, unsigned & uiNumVisible);
+extern void GL_QuitObjectBVH();
+//RenderQueue.cpp
+extern Uint64 GL_MakeRenderKey(unsigned uiPass, unsigned uiSubroutines, unsigned uiMaterial, unsigned uiVAO, float fDepth);
+extern void GL_ClearRenderQueue();
+extern void GL_PushRenderQueue(Uint64 ui64Key, unsigned uiObject);
+extern const unsigned * GL_SortRenderQueue(unsigned & uiNumObjects);
+extern void GL_BindQueueTexture(unsigned uiUnit, GLenum Target, GLuint uiTexture);
+extern void GL_BindQueueBufferRange(GLuint uiIndex, GLuint uiBuffer, GLintptr iOffset, GLsizeiptr iSize);
+extern void GL_SetQueueSubroutines(const GLuint * p_uiSubroutines, unsigned uiNumSubroutines);
+extern void GL_SetQueueUniform1f(GLint iLocation, float fValue);
+extern void GL_SetQueueUniform1ui(GLint iLocation, GLuint uiValue);
+extern void GL_BindQueueVertexArray(GLuint uiVAO);
+extern void GL_QuitRenderQueue();
+//Material.cpp
+extern bool g_bBindlessMaterials;
+extern bool GL_InitMaterials();
+extern void GL_UpdateMaterials();
+extern void GL_QuitMaterials();
+//GPUCulling.cpp
+extern bool g_bGPUCulling;
+extern bool GL_InitGPUCulling();
+extern void GL_QuitGPUCulling();
+extern bool GL_BeginObjectBucketsGPU();
+extern void GL_AddObjectBucketGPU(unsigned uiObject, bool bNewBucket);
+extern void GL_CullCameraObjectsGPU();
+extern bool GL_HasObjectDrawGPU(unsigned uiObject);
+extern bool GL_IsObjectBucketStartGPU(unsigned uiObject);
+extern void GL_DrawObjectBucketGPU(GLenum Mode, unsigned uiObject);
+//UniformRing.cpp
+extern GLuint g_uiUniformRing;
+extern void GL_ReserveUniformRing(unsigned uiSize, unsigned uiCount);
+extern bool GL_InitUniformRing();
+extern void GL_QuitUniformRing();
+extern void GL_BeginUniformRingFrame();
+extern GLintptr GL_WriteUniformRing(const void * p_Data, unsigned uiSize);
+//TextureStream.cpp
+extern Uint64 g_ui64TextureBudget;
+extern void GL_UpdateTextureStream();
+extern void GL_RequestTextureLevels(const GLuint * p_uiTextures, unsigned uiNumTextures, float fPixels);
 //Deferred.cpp
 extern bool GL_InitDeferred();
 extern void GL_QuitDeferred();
-extern void GL_RenderDeferred(ObjectData * p_Object = NULL, GLuint uiAccumBuffer = 0, GLenum uiTextureTarget = GL_TEXTURE_2D);
+extern void GL_RenderDeferred(unsigned uiSkipObject = -1, GLuint uiAccumBuffer = 0, GLenum uiTextureTarget = GL_TEXTURE_2D);
+//HiZ.cpp
+extern bool g_bHiZCulling;
+extern bool GL_InitHiZ();
+extern void GL_QuitHiZ();
+extern void GL_BeginHiZFrame(const mat4 & m4ViewProjection);
+extern void GL_EndHiZFrame();
+extern bool GL_HiZFrameActive();
+extern bool GL_HiZWasVisible(unsigned uiObject);
+extern void GL_DeferHiZObject(unsigned uiObject);
+extern const unsigned * GL_GetHiZDeferred(unsigned & uiNumObjects);
+extern void GL_AddHiZObject(unsigned uiObject, unsigned uiNumPatches, bool bDeferred);
+extern void GL_DrawHiZObject(GLenum Mode, unsigned uiObject);
 //PostProc.cpp
 extern bool GL_InitPostProcess();
 extern void GL_QuitPostProcess();
 extern void GL_RenderPostProcess();
+//Headless.cpp
+extern bool GL_CreateHeadlessContext();
+extern void GL_DestroyHeadlessContext();
+extern bool GL_InitHeadless();
+extern void GL_QuitHeadless();
+extern void GL_RunHeadless(unsigned uiNumFrames, const char * p_cOutputFile);
+//ObjectBench.cpp
+extern void GL_RunObjectBench(unsigned uiNumObjects);
 
 // Declare window variables
 int g_iWindowWidth = 1280;
 int g_iWindowHeight = 1024;
 bool g_bWindowFullscreen = false;
+bool g_bHeadless = false;
+bool g_bProfile = false;
+const char * gp_cProfileFile = NULL;
 // Declare OpenGL variables
 GLuint g_uiMainProgram;
 GLuint g_uiShadowProgram;
@@ -59,6 +145,14 @@ GLuint g_uiSpotSSVLProgram;
 GLuint g_uiSpotSSVLProgram2;
 SceneData g_SceneData = {}; // Init to 0
 GLuint g_uiSkyBox;
+mat4 g_m4CameraViewProjection;
+// Offset of this frames camera data in the uniform ring buffer
+GLintptr g_iCameraRingOffset = 0;
+// Objects moved each frame to exercise dynamic transforms
+unsigned g_uiNumMovingObjects = 0;
+unsigned * gp_uiMovingObjects = NULL;
+mat4 * gp_m4MovingStart = NULL;
+float g_fMovingTime = 0.0f;
 
 struct CameraData
 {
@@ -66,12 +160,53 @@ struct CameraData
     aligned_vec3 m_v3Position;
     aligned_mat4 m_m4InvViewProjection;
 };
+// Kept so the camera can be written again if the frame restarts its ring section
+CameraData g_CameraData;
+
+void GL_InitMovingObjects()
+{
+    // Spread the requested number of moving objects through the opaque objects, reflective objects stay put as their maps are static
+    const unsigned uiNumOpaque = g_SceneData.m_uiNumOpaqueObjects;
+    g_uiNumMovingObjects = SDL_min(g_uiNumMovingObjects, uiNumOpaque);
+    if (g_uiNumMovingObjects == 0)
+        return;
+    gp_uiMovingObjects = (unsigned *)malloc(g_uiNumMovingObjects * sizeof(unsigned));
+    gp_m4MovingStart = (mat4 *)malloc(g_uiNumMovingObjects * sizeof(mat4));
+    unsigned uiNumMoving = 0;
+    for (unsigned i = 0; (i < uiNumOpaque) && (uiNumMoving < g_uiNumMovingObjects); i += SDL_max(uiNumOpaque / g_uiNumMovingObjects, 1u)) {
+        const unsigned uiObject = g_SceneData.mp_uiOpaqueObjects[i];
+        if ((g_SceneData.mp_ucObjectFlags[uiObject] & g_ucObjectReflectMask) != 0)
+            continue;
+        gp_uiMovingObjects[uiNumMoving] = uiObject;
+        gp_m4MovingStart[uiNumMoving] = g_SceneData.mp_ObjectTransforms[uiObject];
+        ++uiNumMoving;
+    }
+    g_uiNumMovingObjects = uiNumMoving;
+    SDL_Log("Moving %u objects each frame\n", g_uiNumMovingObjects);
+}
+
+void GL_UpdateMovingObjects(float fElapsedTime)
+{
+    // Bob each object up and down by half its bounds, offset so they do not all move together
+    g_fMovingTime += fElapsedTime;
+    for (unsigned i = 0; i < g_uiNumMovingObjects; i++) {
+        const unsigned uiObject = gp_uiMovingObjects[i];
+        const float fHeight = sinf(g_fMovingTime + (float)i) * g_SceneData.mp_ObjectBounds[uiObject].w * 0.5f;
+        GL_UpdateObjectTransform(g_SceneData, uiObject, translate(mat4(1.0f), vec3(0.0f, fHeight, 0.0f)) * gp_m4MovingStart[i]);
+    }
+}
 
 bool GL_Init()
 {
+    GL_TRACE_ZONE("GL_Init");
     // Initialize GLEW
     glewExperimental = GL_TRUE; // Allow experimental or pre-release drivers to return all supported extensions
     GLenum GlewError = glewInit();
+#ifndef _WIN32
+    // GLX builds of GLEW have no display to query when using a headless EGL context
+    if (g_bHeadless && (GlewError == GLEW_ERROR_NO_GLX_DISPLAY))
+        GlewError = glewContextInit();
+#endif
     if (GlewError != GLEW_OK) {
         SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize GLEW: %s\n", glewGetErrorString(GlewError));
         return false;
@@ -95,14 +230,25 @@ bool GL_Init()
         return false;
     }
 
-    // Create vertex shader
+    // Build object hierarchy used for culling
+    GL_InitObjectBVH();
+
+    // Pick any objects that move each frame
+    GL_InitMovingObjects();
+
+    // Use bindless material textures where supported, before any texture data has been streamed in
+    GL_InitMaterials();
+    const GLchar * p_cMaterialDefines = g_bBindlessMaterials ? "#define BINDLESS_MATERIALS\n" : NULL;
+
+    // Create vertex shader matching the scenes vertex format
+    const bool bPacked = g_SceneData.m_bPackedVertices;
     GLuint uiVertexShader;
-    if (!GL_LoadShaderFile(uiVertexShader, GL_VERTEX_SHADER, "MainPNUTVert.glsl", 100))
+    if (!GL_LoadShaderFile(uiVertexShader, GL_VERTEX_SHADER, bPacked ? "MainPNUTPackedVert.glsl" : "MainPNUTVert.glsl", bPacked ? 2000 : 100))
         return false;
 
     // Create deferred fragment shader
     GLuint uiFragmentShader;
-    if (!GL_LoadShaderFile(uiFragmentShader, GL_FRAGMENT_SHADER, "Deferred1stFrag.glsl", 200))
+    if (!GL_LoadShaderFile(uiFragmentShader, GL_FRAGMENT_SHADER, "Deferred1stFrag.glsl", 200, p_cMaterialDefines))
         return false;
 
     // Create tessellation shader
@@ -200,9 +346,9 @@ bool GL_Init()
 
     // Load in shadow map shader
     GLuint uiGeometryShader;
-    if (!GL_LoadShaderFile(uiVertexShader, GL_VERTEX_SHADER, "ShadowVert.glsl", 500))
+    if (!GL_LoadShaderFile(uiVertexShader, GL_VERTEX_SHADER, bPacked ? "ShadowPackedVert.glsl" : "ShadowVert.glsl", bPacked ? 2100 : 500))
         return false;
-    if (!GL_LoadShaderFile(uiGeometryShader, GL_GEOMETRY_SHADER, "ShadowGeom.glsl", 600))
+    if (!GL_LoadShaderFile(uiGeometryShader, GL_GEOMETRY_SHADER, "ShadowGeom2.glsl", 600))
         return false;
     if (!GL_LoadShaderFile(uiFragmentShader, GL_FRAGMENT_SHADER, "ShadowFrag.glsl", 700))
         return false;
@@ -215,9 +361,9 @@ bool GL_Init()
     glDeleteShader(uiFragmentShader);
 
     // Load in shadow map transparency shader
-    if (!GL_LoadShaderFile(uiVertexShader, GL_VERTEX_SHADER, "ShadowTransVert.glsl", 800))
+    if (!GL_LoadShaderFile(uiVertexShader, GL_VERTEX_SHADER, bPacked ? "ShadowTransPackedVert.glsl" : "ShadowTransVert.glsl", bPacked ? 2200 : 800))
         return false;
-    if (!GL_LoadShaderFile(uiGeometryShader, GL_GEOMETRY_SHADER, "ShadowTransGeom.glsl", 900))
+    if (!GL_LoadShaderFile(uiGeometryShader, GL_GEOMETRY_SHADER, "ShadowTransGeom2.glsl", 900))
         return false;
     if (!GL_LoadShaderFile(uiFragmentShader, GL_FRAGMENT_SHADER, "ShadowTransFrag.glsl", 1000))
         return false;
@@ -250,24 +396,46 @@ bool GL_Init()
     // Initialise deferred rendering
     GL_InitDeferred();
 
+    // Initialise occlusion culling against the deferred depth buffer
+    GL_InitHiZ();
+
     // Initialise post-process
     GL_InitPostProcess();
 
+    // Initialise per-frame uniform ring buffer sized for the camera, shadows and reflections along with the passes above
+    GL_ReserveUniformRing(sizeof(CameraData), 1);
+    GL_ReserveShadowUniforms();
+    GL_ReserveReflectionUniforms();
+    if (!GL_InitUniformRing())
+        return false;
+
+    // Initialise GPU culling used by the shadow passes
+    GL_InitGPUCulling();
+
     // Initialise shadows
     GL_InitShadow();
 
     // Initialise reflections
     GL_InitReflection();
 
+    // Initialise GPU pass timing
+    if (g_bProfile)
+        GL_InitProfiler(gp_cProfileFile, g_SceneData.m_uiVertexSize);
+
     // Set Mouse capture and hide cursor
-    SDL_ShowCursor(0);
-    SDL_SetRelativeMouseMode(SDL_TRUE);
+    if (!g_bHeadless) {
+        SDL_ShowCursor(0);
+        SDL_SetRelativeMouseMode(SDL_TRUE);
+    }
 
     return true;
 }
 
 void GL_Quit()
 {
+    // Output and release GPU pass timing
+    GL_QuitProfiler();
+
     // Release the shader programs
     glDeleteProgram(g_uiMainProgram);
     glDeleteProgram(g_uiShadowProgram);
@@ -282,6 +450,7 @@ void GL_Quit()
     glDeleteProgram(g_uiSpotSSVLProgram2);
 
     // Release deferred data
+    GL_QuitHiZ();
     GL_QuitDeferred();
 
     // Release post-process data
@@ -290,108 +459,251 @@ void GL_Quit()
     // Release shadow data
     GL_QuitShadow();
 
+    // Release GPU culling data
+    GL_QuitGPUCulling();
+
     // Release reflection data
     GL_QuitReflection();
 
+    // Release cluster culling data
+    GL_QuitClusters();
+    GL_QuitObjectBVH();
+
+    // Release render queue
+    GL_QuitRenderQueue();
+
+    // Release uniform ring buffer
+    GL_QuitUniformRing();
+
+    // Release material data
+    GL_QuitMaterials();
+
+    // Release moving objects
+    free(gp_uiMovingObjects);
+    free(gp_m4MovingStart);
+    gp_uiMovingObjects = NULL;
+    gp_m4MovingStart = NULL;
+
     // Release Scene data
     GL_UnloadScene(g_SceneData);
 }
 
-void GL_RenderObjects(ObjectData * p_SkipObject = NULL)
+void GL_QueueObject(unsigned i, const vec3 & v3ViewPosition)
 {
-    // Clear the render output and depth buffer
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Request the texture detail needed for the objects size on screen
+    const unsigned uiMaterial = g_SceneData.mp_uiObjectMaterials[i];
+    const MaterialData * p_Material = &g_SceneData.mp_Materials[uiMaterial];
+    const GLuint uiTextures[] = {p_Material->m_uiDiffuse, p_Material->m_uiSpecular, p_Material->m_uiRough, p_Material->m_uiNormal, p_Material->m_uiBump};
+    GL_RequestTextureLevels(uiTextures, 5, GL_GetObjectPixelSize(i));
+
+    // Subroutine set is packed as emissive, transparent then reflection type
+    const unsigned char ucFlags = g_SceneData.mp_ucObjectFlags[i];
+    const bool bTransparent = (ucFlags & g_ucObjectTransparent) != 0;
+    const unsigned uiSubroutines = (p_Material->m_fEmissive != 0.0f) | (bTransparent << 1) | ((ucFlags & g_ucObjectReflectMask) << 2);
+    const float fDepth = length(vec3(g_SceneData.mp_ObjectBounds[i]) - v3ViewPosition);
+    GL_PushRenderQueue(GL_MakeRenderKey(bTransparent, uiSubroutines, uiMaterial, 0, fDepth), i);
+}
 
+void GL_SetObjectState(unsigned i, bool bDrawTransforms)
+{
     // Initialise sub routine selectors
     const GLuint uiEmissiveSubs[] = {0, 1};
     const GLuint uiRefractSubs[] = {2, 3};
     const GLuint uiReflectSubs[] = {4, 5, 6};
 
-    // Loop through each object
-    for (unsigned i = 0; i < g_SceneData.m_uiNumObjects; i++) {
-        const ObjectData * p_Object = &g_SceneData.mp_Objects[i];
+    // Get the objects material and flags
+    const MaterialData * p_Material = &g_SceneData.mp_Materials[g_SceneData.mp_uiObjectMaterials[i]];
+    const unsigned uiReflective = g_SceneData.mp_ucObjectFlags[i] & g_ucObjectReflectMask;
+    const bool bTransparent = (g_SceneData.mp_ucObjectFlags[i] & g_ucObjectTransparent) != 0;
+
+    // Set subroutines
+    GLuint uiSubRoutines[3] = {uiEmissiveSubs[p_Material->m_fEmissive != 0.0f],
+        uiRefractSubs[bTransparent],
+        uiReflectSubs[uiReflective]};
+    GL_SetQueueSubroutines(uiSubRoutines, 3);
+
+    // Bind the shared scene VAO and the objects range of the Transform UBO, buckets read each draws transform instead
+    GL_BindQueueVertexArray(g_SceneData.m_uiVAO);
+    GL_SetQueueUniform1ui(6, bDrawTransforms);
+    if (!bDrawTransforms)
+        GL_BindQueueBufferRange(0, g_SceneData.m_uiTransformUBO, g_SceneData.mp_ObjectDraws[i].m_uiTransformOffset, g_SceneData.m_uiTransformSize);
+
+    if (g_bBindlessMaterials) {
+        // Material textures and values are read from the material SSBO
+        GL_SetQueueUniform1ui(5, g_SceneData.mp_uiObjectMaterials[i]);
+    } else {
+        // Bind the textures to texture units
+        GL_BindQueueTexture(0, GL_TEXTURE_2D, p_Material->m_uiDiffuse);
+        GL_BindQueueTexture(1, GL_TEXTURE_2D, p_Material->m_uiSpecular);
+        GL_BindQueueTexture(2, GL_TEXTURE_2D, p_Material->m_uiRough);
+        GL_BindQueueTexture(9, GL_TEXTURE_2D, p_Material->m_uiNormal);
+        GL_BindQueueTexture(10, GL_TEXTURE_2D, p_Material->m_uiBump);
 
-        // Check if this object should be rendered
-        if (p_Object == p_SkipObject)
-            continue;
+        // If emissive then update uniform
+        if (p_Material->m_fEmissive != 0.0f) {
+            GL_SetQueueUniform1f(1, p_Material->m_fEmissive);
+        }
 
-        // Set subroutines
-        GLuint uiSubRoutines[3] = {uiEmissiveSubs[p_Object->m_fEmissive != 0.0f],
-            uiRefractSubs[p_Object->m_bTransparent],
-            uiReflectSubs[p_Object->m_uiReflective]};
-        glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 3, uiSubRoutines);
+        //Set the parallax map scaling
+        GL_SetQueueUniform1f(3, p_Material->m_fBumpScale);
+    }
 
-        // Bind VAO
-        glBindVertexArray(p_Object->m_uiVAO);
+    // If transparent then update texture
+    if (bTransparent) {
+        GL_BindQueueTexture(3, GL_TEXTURE_CUBE_MAP, g_uiSkyBox);
+    }
 
-        // Bind the Transform UBO
-        glBindBufferBase(GL_UNIFORM_BUFFER, 0, p_Object->m_uiTransformUBO);
+    // If reflective then update texture and uniform
+    if (uiReflective == g_ucObjectPlanarReflect) {
+        const ReflectObjectData * p_RObject = &g_SceneData.mp_ReflecObjects[g_SceneData.mp_uiObjectReflects[i]];
+        GL_BindQueueTexture(4, GL_TEXTURE_2D, p_RObject->m_uiReflect);
 
-        // Bind the textures to texture units
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiDiffuse);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiSpecular);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiRough);
-        glActiveTexture(GL_TEXTURE9);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiNormal);
-        glActiveTexture(GL_TEXTURE10);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiBump);
+        GL_BindQueueBufferRange(3, g_uiUniformRing, p_RObject->m_iReflectVPOffset, sizeof(mat4));
+    } else if (uiReflective == g_ucObjectCubeReflect) {
+        const ReflectObjectData * p_RObject = &g_SceneData.mp_ReflecObjects[g_SceneData.mp_uiObjectReflects[i]];
+        GL_BindQueueTexture(5, GL_TEXTURE_CUBE_MAP, p_RObject->m_uiReflect);
+    }
+}
 
-        // If emissive then update uniform
-        if (p_Object->m_fEmissive != 0.0f) {
-            glUniform1f(1, p_Object->m_fEmissive);
+void GL_RenderObjects(unsigned uiSkipObject = -1)
+{
+    GL_TRACE_ZONE("GL_RenderObjects");
+    // Clear the render output and depth buffer
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Queue each visible object keyed by the state it needs, nearest first within matching state
+    GL_ClearRenderQueue();
+    const vec3 v3ViewPosition = GL_GetClusterViewPosition();
+    const bool bHiZ = GL_HiZFrameActive();
+    unsigned uiNumVisible;
+    const unsigned * p_uiVisible = GL_CullObjectBVH(0, 0, uiNumVisible);
+    for (unsigned j = 0; j < uiNumVisible; j++) {
+        const unsigned i = p_uiVisible[j];
+
+        // Check if this object should be rendered
+        if (i == uiSkipObject)
+            continue;
+
+        // Leave objects hidden last frame, and transparent objects that must follow them, for the occlusion tested pass
+        if (bHiZ && (((g_SceneData.mp_ucObjectFlags[i] & g_ucObjectTransparent) != 0) || !GL_HiZWasVisible(i))) {
+            GL_DeferHiZObject(i);
+            continue;
         }
+        GL_QueueObject(i, v3ViewPosition);
+    }
 
-        // If transparent then update texture
-        if (p_Object->m_bTransparent) {
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, g_uiSkyBox);
+    // Sort so matching state is adjacent
+    unsigned uiNumQueued;
+    const unsigned * p_uiQueued = GL_SortRenderQueue(uiNumQueued);
+
+    // Group runs of opaque objects sharing state into buckets, reflective objects bind their own reflection so are drawn alone
+    const bool bGPUCull = GL_BeginObjectBucketsGPU();
+    if (bGPUCull) {
+        unsigned uiLastMaterial = -1;
+        unsigned char ucLastFlags = 0;
+        for (unsigned j = 0; j < uiNumQueued; j++) {
+            const unsigned i = p_uiQueued[j];
+            if (!GL_HasObjectDrawGPU(i)) {
+                uiLastMaterial = -1;
+                continue;
+            }
+            const unsigned uiMaterial = g_SceneData.mp_uiObjectMaterials[i];
+            const unsigned char ucFlags = g_SceneData.mp_ucObjectFlags[i];
+            GL_AddObjectBucketGPU(i, (uiMaterial != uiLastMaterial) || (ucFlags != ucLastFlags) || ((ucFlags & g_ucObjectReflectMask) != 0));
+            uiLastMaterial = uiMaterial;
+            ucLastFlags = ucFlags;
+
+            // Test every bucketed object so next frame knows if it is still visible
+            if (bHiZ)
+                GL_AddHiZObject(i, GL_GetObjectLODTriangles(i), false);
         }
 
-        // If reflective then update texture and uniform
-        if (p_Object->m_uiReflective == 1) {
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, p_Object->m_uiReflect);
+        // Cull the bucketed objects against the camera on the GPU, this changes program so must come before any queued state
+        GL_CullCameraObjectsGPU();
+    }
 
-            glBindBufferBase(GL_UNIFORM_BUFFER, 3, p_Object->m_uiReflectVPUBO);
-        } else if (p_Object->m_uiReflective == 2) {
-            glActiveTexture(GL_TEXTURE5);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, p_Object->m_uiReflect);
-        }
+    // Draw in sorted order only changing state that differs from the previous object
+    for (unsigned j = 0; j < uiNumQueued; j++) {
+        const unsigned i = p_uiQueued[j];
 
-        //Set the parallax map scaling
-        glUniform1f(3, p_Object->m_fBumpScale);
+        // Skip if no clusters are visible, objects with GPU draws are skipped by the GPU instead and drawn with the rest of their bucket
+        const bool bGPUDraw = bGPUCull && GL_HasObjectDrawGPU(i);
+        if (bGPUDraw ? !GL_IsObjectBucketStartGPU(i) : !GL_CullObjectClusters(i))
+            continue;
 
-        // Draw the Object
-        glDrawElements(GL_PATCHES, p_Object->m_uiNumIndices, GL_UNSIGNED_INT, 0);
+        // Draw the Object, also testing it so next frame knows if it is still visible
+        if (bHiZ && !bGPUDraw)
+            GL_AddHiZObject(i, GL_GetNumClusterTriangles(), false);
+        GL_SetObjectState(i, bGPUDraw);
+        if (bGPUDraw)
+            GL_DrawObjectBucketGPU(GL_PATCHES, i);
+        else
+            GL_DrawObjectClusters(GL_PATCHES, i);
+    }
+    if (!bHiZ)
+        return;
+
+    // Queue the remaining objects with indirect draws the occlusion test can remove
+    GL_ClearRenderQueue();
+    unsigned uiNumDeferred;
+    const unsigned * p_uiDeferred = GL_GetHiZDeferred(uiNumDeferred);
+    for (unsigned j = 0; j < uiNumDeferred; j++) {
+        const unsigned i = p_uiDeferred[j];
+        if (!GL_CullObjectClusters(i))
+            continue;
+        GL_AddHiZObject(i, GL_GetNumClusterTriangles(), true);
+        GL_QueueObject(i, v3ViewPosition);
+    }
+}
+
+void GL_RenderHiZObjects()
+{
+    GL_TRACE_ZONE("GL_RenderHiZObjects");
+    // Draw the objects queued for the occlusion test, those found hidden have no instances
+    glUseProgram(g_uiMainProgram);
+    unsigned uiNumQueued;
+    const unsigned * p_uiQueued = GL_SortRenderQueue(uiNumQueued);
+    for (unsigned j = 0; j < uiNumQueued; j++) {
+        const unsigned i = p_uiQueued[j];
+        GL_SetObjectState(i, false);
+        GL_DrawHiZObject(GL_PATCHES, i);
     }
 }
 
 void GL_Render()
 {
-    // Generate shadows
-    //GL_RenderShadows();
+    GL_TRACE_ZONE("GL_Render");
+    // Upload any streamed textures that are ready
+    GL_UpdateTextureStream();
+    GL_UpdateMaterials();
+
+    // Redraw environment maps once streamed textures are resident, they use their own sections of the uniform ring so the camera is written again after
+    if (GL_UpdateEnvironmentReflections()) {
+        GL_BeginUniformRingFrame();
+        g_iCameraRingOffset = GL_WriteUniformRing(&g_CameraData, sizeof(CameraData));
+    }
+
+    // Update shadow layers whose light or casters have changed
+    GL_ProfileBegin(PROFILE_SHADOWS);
+    GL_UpdateShadows();
+    GL_ProfileEnd();
 
     // Generate reflection maps
     //for (unsigned i = 0; i < g_SceneData.m_uiNumReflecObjects; i++) {
     //    ReflectObjectData * p_RObject = &g_SceneData.mp_ReflecObjects[i];
-    //    ObjectData * p_Object = &g_SceneData.mp_Objects[p_RObject->m_uiObjectPos];
     //
     //    // Check if cube reflection
-    //    if (p_Object->m_uiReflective == 2) {
+    //    if ((g_SceneData.mp_ucObjectFlags[p_RObject->m_uiObjectPos] & g_ucObjectReflectMask) == g_ucObjectCubeReflect) {
     //        // Calculate cube maps first as they recalculate planar reflections as well
-    //        GL_RenderEnvironmentReflection(p_RObject, p_Object);
+    //        GL_RenderEnvironmentReflection(p_RObject);
     //    }
     //}
     for (unsigned i = 0; i < g_SceneData.m_uiNumReflecObjects; i++) {
         ReflectObjectData * p_RObject = &g_SceneData.mp_ReflecObjects[i];
-        ObjectData * p_Object = &g_SceneData.mp_Objects[p_RObject->m_uiObjectPos];
 
         // Check if planar or cube reflection
-        if (p_Object->m_uiReflective == 1) {
-            GL_RenderPlanarReflection(p_RObject, p_Object,
+        if ((g_SceneData.mp_ucObjectFlags[p_RObject->m_uiObjectPos] & g_ucObjectReflectMask) == g_ucObjectPlanarReflect) {
+            GL_RenderPlanarReflection(p_RObject,
                                       g_SceneData.m_LocalCamera.m_v3Direction, cross(g_SceneData.m_LocalCamera.m_v3Right, g_SceneData.m_LocalCamera.m_v3Direction),
                                       g_SceneData.m_LocalCamera.m_v3Position, g_SceneData.m_LocalCamera.m_fFOV, g_SceneData.m_LocalCamera.m_fAspect,
                                       vec2(g_SceneData.m_LocalCamera.m_fNear, g_SceneData.m_LocalCamera.m_fFar));
@@ -399,17 +711,34 @@ void GL_Render()
     }
 
     // Bind default camera
-    glBindBufferBase(GL_UNIFORM_BUFFER, 1, g_SceneData.m_uiCameraUBO);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 1, g_uiUniformRing, g_iCameraRingOffset, sizeof(CameraData));
+
+    // Cull clusters and select LODs against the camera
+    GL_BeginClusterViews("Main", GL_BACK, 1.0f);
+    GL_AddClusterView(g_m4CameraViewProjection, g_SceneData.m_LocalCamera.m_v3Position, g_iWindowHeight);
 
-    // Perform deferred render pass
+    // Perform deferred render pass, occlusion culling objects against the depth of those visible last frame
+    GL_BeginHiZFrame(g_m4CameraViewProjection);
     GL_RenderDeferred();
+    GL_EndHiZFrame();
+    GL_EndClusterViews();
 
     // Perform final pass
     GL_RenderPostProcess();
+
+    // Collect GPU pass timings
+    GL_ProfileFrame();
 }
 
 void GL_Update(float fElapsedTime)
 {
+    GL_TRACE_ZONE("GL_Update");
+    // Start a new frame in the uniform ring buffer
+    GL_BeginUniformRingFrame();
+
+    // Move any dynamic objects, invalidating the shadows and culling data they affect
+    GL_UpdateMovingObjects(fElapsedTime);
+
     // Update the cameras position
     g_SceneData.m_LocalCamera.m_v3Position += g_SceneData.m_LocalCamera.m_fMoveZ * fElapsedTime * g_SceneData.m_LocalCamera.m_v3Direction;
     g_SceneData.m_LocalCamera.m_v3Position += g_SceneData.m_LocalCamera.m_fMoveX * fElapsedTime * g_SceneData.m_LocalCamera.m_v3Right;
@@ -438,6 +767,7 @@ void GL_Update(float fElapsedTime)
 
 // Create updated ViewProjection matrix
     mat4 m4ViewProjection = m4Projection * m4View;
+    g_m4CameraViewProjection = m4ViewProjection;
 
     // Calculate inverse view projection
     mat4 m4InvViewProjection = inverse(m4ViewProjection);
@@ -448,9 +778,9 @@ void GL_Update(float fElapsedTime)
         g_SceneData.m_LocalCamera.m_v3Position,
         m4InvViewProjection};
 
-    // Update the camera buffer
-    glBindBuffer(GL_UNIFORM_BUFFER, g_SceneData.m_uiCameraUBO);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraData), &Camera, GL_DYNAMIC_DRAW);
+    // Write the camera data into this frames section of the ring buffer
+    g_CameraData = Camera;
+    g_iCameraRingOffset = GL_WriteUniformRing(&g_CameraData, sizeof(CameraData));
 }
 
 #ifdef _WIN32
@@ -459,6 +789,107 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 int main(int argc, char **argv)
 #endif
 {
+#ifdef _WIN32
+    int argc = __argc;
+    char ** argv = __argv;
+#endif
+    // Check for headless benchmark and profiling modes
+    unsigned uiHeadlessFrames = 500;
+    const char * p_cOutputFile = NULL;
+    const char * p_cTraceFile = NULL;
+    unsigned uiBenchObjects = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            g_bHeadless = true;
+            if ((i + 1 < argc) && (atoi(argv[i + 1]) > 0))
+                uiHeadlessFrames = (unsigned)atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc)) {
+            p_cOutputFile = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            // Optional CSV file for the GPU pass timings
+            g_bProfile = true;
+            if ((i + 1 < argc) && (strncmp(argv[i + 1], "--", 2) != 0))
+                gp_cProfileFile = argv[++i];
+        } else if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc)) {
+            p_cTraceFile = argv[++i];
+        } else if (strcmp(argv[i], "--packed-vertices") == 0) {
+            // Use the compact quantised vertex format
+            g_SceneData.m_bPackedVertices = true;
+        } else if (strcmp(argv[i], "--no-cluster-culling") == 0) {
+            // Draw whole objects for comparison
+            g_bClusterCulling = false;
+        } else if (strcmp(argv[i], "--no-lod") == 0) {
+            // Draw full detail meshes for comparison
+            g_bMeshLODs = false;
+        } else if (strcmp(argv[i], "--no-bindless") == 0) {
+            // Bind material textures per draw for comparison
+            g_bBindlessMaterials = false;
+        } else if (strcmp(argv[i], "--no-gpu-culling") == 0) {
+            // Cull shadow casters on the CPU for comparison
+            g_bGPUCulling = false;
+        } else if (strcmp(argv[i], "--no-bvh") == 0) {
+            // Test every objects bounds for comparison
+            g_bObjectBVH = false;
+        } else if (strcmp(argv[i], "--no-hiz") == 0) {
+            // Draw objects without occlusion culling for comparison
+            g_bHiZCulling = false;
+        } else if ((strcmp(argv[i], "--shadow-budget") == 0) && (i + 1 < argc)) {
+            // Limit shadow layers re-rendered each frame
+            g_uiShadowLayerBudget = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shadow-depth16") == 0) {
+            // Store shadow atlases with 16 bit depth
+            g_bShadowDepth16 = true;
+        } else if ((strcmp(argv[i], "--texture-budget") == 0) && (i + 1 < argc)) {
+            // Limit resident texture memory in MB
+            g_ui64TextureBudget = (Uint64)atoi(argv[++i]) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--move-objects") == 0) {
+            // Move some objects each frame to exercise dynamic transforms
+            g_uiNumMovingObjects = 8;
+            if ((i + 1 < argc) && (atoi(argv[i + 1]) > 0))
+                g_uiNumMovingObjects = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--object-bench") == 0) {
+            // CPU only comparison of scene object layouts
+            uiBenchObjects = 100000;
+            if ((i + 1 < argc) && (atoi(argv[i + 1]) > 0))
+                uiBenchObjects = (unsigned)atoi(argv[++i]);
+        }
+    }
+
+    if (uiBenchObjects > 0) {
+        // Run without a window or OpenGL context
+        GL_RunObjectBench(uiBenchObjects);
+        return 0;
+    }
+
+    // Start CPU tracing if requested or GL_TRACE_FILE is set
+    GL_InitTrace(p_cTraceFile);
+
+    if (g_bHeadless) {
+        // Create an offscreen OpenGL context
+        if (!GL_CreateHeadlessContext())
+            return 1;
+
+        //Initialize OpenGL and render the requested frames
+        int iReturn = 1;
+        if (GL_Init()) {
+            if (GL_InitHeadless()) {
+                GL_RunHeadless(uiHeadlessFrames, p_cOutputFile);
+                iReturn = 0;
+            }
+            GL_QuitHeadless();
+
+            // Delete any created GL resources
+            GL_Quit();
+        }
+
+        // Write out any CPU trace
+        GL_QuitTrace();
+
+        // Delete the OpenGL context
+        GL_DestroyHeadlessContext();
+        return iReturn;
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL: %s\n", SDL_GetError());
@@ -518,13 +949,19 @@ int main(int argc, char **argv)
         // Start the program message pump
         SDL_Event Event;
         bool bQuit = false;
+        unsigned uiFrame = 0;
         while (!bQuit) {
+            // Time the whole frame
+            GL_TRACE_FRAME(uiFrame);
+            ++uiFrame;
+
             // Update elapsed frame time
             uiOldTime = uiCurrentTime;
             uiCurrentTime = SDL_GetTicks();
             float fElapsedTime = (float)(uiCurrentTime - uiOldTime) / 1000.0f;
 
             // Poll SDL for buffered events
+            GL_TRACE_BEGIN("Events");
             while (SDL_PollEvent(&Event)) {
                 if (Event.type == SDL_QUIT)
                     bQuit = true;
@@ -574,6 +1011,7 @@ int main(int argc, char **argv)
                         g_SceneData.m_LocalCamera.m_fFOV = ((float)M_PI * 0.9f);
                 }
             }
+            GL_TRACE_END("Events");
 
             // Update the Scene
             GL_Update(fElapsedTime);
@@ -582,13 +1020,18 @@ int main(int argc, char **argv)
             GL_Render();
 
             // Swap the back-buffer and present the render
+            GL_TRACE_BEGIN("Swap");
             SDL_GL_SwapWindow(Window);
+            GL_TRACE_END("Swap");
         }
 
         // Delete any created GL resources
         GL_Quit();
     }
 
+    // Write out any CPU trace
+    GL_QuitTrace();
+
     // Delete the OpenGL context, SDL window and shutdown SDL
     SDL_GL_DeleteContext(Context);
     SDL_DestroyWindow(Window);
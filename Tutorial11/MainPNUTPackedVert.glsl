@@ -0,0 +1,58 @@
+#version 430 core
+
+layout(binding = 0) uniform TransformData {
+    mat4 m4Transform;
+    mat4 m4PositionDecode;
+};
+// Transforms of every object, read through the draw index when drawing GPU culled buckets
+layout(std430, binding = 0) readonly buffer TransformDrawData {
+    mat4 m4Transforms[];
+};
+layout(binding = 1) uniform CameraData {
+    mat4 m4ViewProjection;
+    vec3 v3CameraPosition;
+};
+
+layout(location = 0) in vec4 v4VertexPos;
+layout(location = 1) in vec2 v2VertexNormal;
+layout(location = 2) in vec2 v2VertexUV;
+layout(location = 3) in vec2 v2VertexTangent;
+// Per draw index of the objects transform, sourced through the draws base instance
+layout(location = 4) in uint uiTransformIndex;
+// Read the transform through the draw index instead of the transform block
+layout(location = 6) uniform bool bDrawTransforms;
+
+layout(location = 0) smooth out vec3 v3PositionOut;
+layout(location = 1) smooth out vec3 v3NormalOut;
+layout(location = 2) smooth out vec2 v2UVOut;
+layout(location = 3) smooth out vec3 v3TangentOut;
+
+vec3 octDecode(in vec2 v2Oct)
+{
+    // Unfold the octahedron back onto the sphere
+    vec3 v3Dir = vec3(v2Oct, 1.0f - abs(v2Oct.x) - abs(v2Oct.y));
+    float fFold = max(-v3Dir.z, 0.0f);
+    v3Dir.xy += vec2((v3Dir.x >= 0.0f) ? -fFold : fFold, (v3Dir.y >= 0.0f) ? -fFold : fFold);
+    return normalize(v3Dir);
+}
+
+void main()
+{
+    // Decode and transform vertex, in the transform buffer the decode matrix follows the transform
+    mat4 m4Object = (bDrawTransforms) ? m4Transforms[uiTransformIndex] : m4Transform;
+    mat4 m4Decode = (bDrawTransforms) ? m4Transforms[uiTransformIndex + 1] : m4PositionDecode;
+    vec4 v4Position = m4Object * (m4Decode * vec4(v4VertexPos.xyz, 1.0f));
+    gl_Position = m4ViewProjection * v4Position;
+    v3PositionOut = v4Position.xyz;
+
+    // Decode and transform normal
+    vec4 v4Normal = m4Object * vec4(octDecode(v2VertexNormal), 0.0f);
+    v3NormalOut = v4Normal.xyz;
+
+    //Pass-through UV coordinates
+    v2UVOut = v2VertexUV;
+
+    // Decode and transform tangent
+    vec4 v4Tangent = m4Object * vec4(octDecode(v2VertexTangent), 0.0f);
+    v3TangentOut = v4Tangent.xyz;
+}
\ No newline at end of file
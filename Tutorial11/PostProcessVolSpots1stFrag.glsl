@@ -7,6 +7,7 @@ struct SpotLight {
     vec3 v3LightIntensity;
     vec3 v3Falloff;
     float fFalloffDist;
+    vec4 v4ShadowTile;
 };
 #define MAX_LIGHTS 16
 layout(std140, binding = 1) uniform CameraData {
@@ -26,8 +27,8 @@ layout(binding = 7) uniform InvResolution {
 
 layout(location = 2) uniform int iNumSpotLights;
 
-layout(binding = 6) uniform sampler2DArrayShadow s2aShadowTexture;
-layout(binding = 8) uniform sampler2DArray s2aTransparencyTexture;
+layout(binding = 6) uniform sampler2DShadow s2ShadowTexture;
+layout(binding = 8) uniform sampler2D s2TransparencyTexture;
 layout(binding = 11) uniform sampler2D s2DepthTexture;
 
 #define M_RCP4PI 0.07957747154594766788444188168626f
@@ -49,6 +50,13 @@ vec3 lightFalloff(in vec3 v3LightIntensity, in vec3 v3Falloff, in vec3 v3LightPo
     return v3LightIntensity / fFalloff;
 }
 
+vec2 shadowTileUV(in vec2 v2UV, in vec4 v4Tile, in vec2 v2AtlasSize)
+{
+    // Move into the lights tile and keep filtering from reading neighbouring tiles
+    vec2 v2HalfTexel = 0.5f / v2AtlasSize;
+    return clamp(v4Tile.xy + (v2UV * v4Tile.zw), v4Tile.xy + v2HalfTexel, v4Tile.xy + v4Tile.zw - v2HalfTexel);
+}
+
 vec3 volumeSpotLight(in int iLight, in vec3 v3Position)
 {
     // Get ray from the camera to first object intersection
@@ -127,7 +135,8 @@ vec3 volumeSpotLight(in int iLight, in vec3 v3Position)
         float fOffset = fSampleOffsets[ (i2SamplePos.y * 4) + i2SamplePos.x ];
         fOffset *= fUsedStepSize;
 
-        // Loop through each step and check shadow map
+        // Loop through each step and check shadow map within the lights tile of the atlas
+        vec2 v2AtlasSize = vec2(textureSize(s2ShadowTexture, 0));
         vec3 v3CurrPosition = v3CameraPosition + ((v2TRange.x + fOffset) * v3RayDirection);
         for (int i = 0; i < iNumSteps; i++) {
             // Get position in shadow texture
@@ -136,7 +145,8 @@ vec3 volumeSpotLight(in int iLight, in vec3 v3Position)
             v3SVPPosition = (v3SVPPosition + 1.0f) * 0.5f;
 
             // Get texture value
-            float fText = texture(s2aShadowTexture, vec4(v3SVPPosition.xy, iLight, v3SVPPosition.z));
+            vec2 v2TileUV = shadowTileUV(v3SVPPosition.xy, SpotLights[iLight].v4ShadowTile, v2AtlasSize);
+            float fText = texture(s2ShadowTexture, vec3(v2TileUV, min(v3SVPPosition.z, 1.0f)));
 
             // Calculate phase function
             float fPhase = M_RCP4PI * (1.0f - (fPhaseK * fPhaseK));
@@ -150,7 +160,7 @@ vec3 volumeSpotLight(in int iLight, in vec3 v3Position)
             v3LightVolume *= fPhase * fText;
 
             // Get transparency information
-            vec3 v3Trans = texture(s2aTransparencyTexture, vec3(v3SVPPosition.xy, iLight)).rgb;
+            vec3 v3Trans = texture(s2TransparencyTexture, v2TileUV).rgb;
             v3LightVolume *= v3Trans;
 
             // Add to current lighting
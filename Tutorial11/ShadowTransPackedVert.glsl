@@ -0,0 +1,22 @@
+#version 430 core
+
+layout(binding = 0) uniform TransformData {
+    mat4 m4Transform;
+    mat4 m4PositionDecode;
+};
+
+layout(location = 0) in vec4 v4VertexPos;
+layout(location = 2) in vec2 v2VertexUV;
+
+layout(location = 0) smooth out vec3 v3PositionOut;
+layout(location = 1) smooth out vec2 v2UVOut;
+
+void main()
+{
+    // Decode and transform vertex
+    vec4 v4Position = m4Transform * (m4PositionDecode * vec4(v4VertexPos.xyz, 1.0f));
+    v3PositionOut = v4Position.xyz;
+
+    //Pass-through UV coordinates
+    v2UVOut = v2VertexUV;
+}
\ No newline at end of file
@@ -0,0 +1,650 @@
+// Using GLM and math headers
+#include <math.h>
+#include <glm/glm.hpp>
+using namespace glm;
+// Using SDL, GLEW
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+// Forsyth vertex cache optimisation parameters
+const unsigned g_uiMeshOptCacheSize = 32;
+const float g_fMeshOptCacheDecayPower = 1.5f;
+const float g_fMeshOptLastTriScore = 0.75f;
+const float g_fMeshOptValenceBoostScale = 2.0f;
+const float g_fMeshOptValenceBoostPower = 0.5f;
+// FIFO cache size used for overdraw clustering and reporting
+const unsigned g_uiMeshOptFIFOSize = 16;
+// Maximum number of edge collapse passes when simplifying
+const unsigned g_uiMeshOptMaxSimplifyPasses = 64;
+// Weight of the planes keeping attribute seams in place relative to the surface
+const float g_fMeshOptSeamWeight = 10.0f;
+
+struct MeshOptClusterData
+{
+    unsigned m_uiFirstIndex;
+    unsigned m_uiNumIndices;
+    float m_fSortKey;
+};
+
+struct MeshOptQuadric
+{
+    float m_fA00, m_fA11, m_fA22;
+    float m_fA01, m_fA02, m_fA12;
+    float m_fB0, m_fB1, m_fB2;
+    float m_fC;
+    float m_fWeight;
+};
+
+struct MeshOptCollapseData
+{
+    unsigned m_uiFrom;
+    unsigned m_uiTo;
+    float m_fError;
+};
+
+float GL_ForsythVertexScore(int iCachePosition, unsigned uiLiveTriangles)
+{
+    // Vertices with no triangles left are never used again
+    if (uiLiveTriangles == 0)
+        return -1.0f;
+
+    float fScore = 0.0f;
+    if (iCachePosition >= 0) {
+        if (iCachePosition < 3) {
+            // Vertices used by the last triangle get a fixed score so they are not favoured too much
+            fScore = g_fMeshOptLastTriScore;
+        } else {
+            // Score falls off with position in cache
+            const float fScaler = 1.0f / (float)(g_uiMeshOptCacheSize - 3);
+            fScore = powf(1.0f - ((float)(iCachePosition - 3) * fScaler), g_fMeshOptCacheDecayPower);
+        }
+    }
+
+    // Boost vertices with few triangles left so they get finished off
+    fScore += g_fMeshOptValenceBoostScale * powf((float)uiLiveTriangles, -g_fMeshOptValenceBoostPower);
+    return fScore;
+}
+
+void GL_OptimizeVertexCache(GLuint * p_Indices, unsigned uiNumIndices, unsigned uiNumVertices)
+{
+    const unsigned uiNumTriangles = uiNumIndices / 3;
+    if (uiNumTriangles == 0)
+        return;
+
+    // Build list of triangles using each vertex
+    unsigned * p_uiLive = (unsigned *)calloc(uiNumVertices, sizeof(unsigned));
+    unsigned * p_uiOffsets = (unsigned *)malloc((uiNumVertices + 1) * sizeof(unsigned));
+    unsigned * p_uiAdjacency = (unsigned *)malloc(uiNumTriangles * 3 * sizeof(unsigned));
+    for (unsigned i = 0; i < uiNumTriangles * 3; i++) {
+        ++p_uiLive[p_Indices[i]];
+    }
+    p_uiOffsets[0] = 0;
+    for (unsigned i = 0; i < uiNumVertices; i++) {
+        p_uiOffsets[i + 1] = p_uiOffsets[i] + p_uiLive[i];
+        p_uiLive[i] = 0;
+    }
+    for (unsigned i = 0; i < uiNumTriangles * 3; i++) {
+        const GLuint uiVertex = p_Indices[i];
+        p_uiAdjacency[p_uiOffsets[uiVertex] + p_uiLive[uiVertex]] = i / 3;
+        ++p_uiLive[uiVertex];
+    }
+
+    // Calculate initial vertex scores
+    float * p_fScores = (float *)malloc(uiNumVertices * sizeof(float));
+    int * p_iCachePositions = (int *)malloc(uiNumVertices * sizeof(int));
+    for (unsigned i = 0; i < uiNumVertices; i++) {
+        p_iCachePositions[i] = -1;
+        p_fScores[i] = GL_ForsythVertexScore(-1, p_uiLive[i]);
+    }
+
+    // Add triangles one at a time always picking the highest scoring one touching the cache
+    unsigned char * p_bAdded = (unsigned char *)calloc(uiNumTriangles, sizeof(unsigned char));
+    GLuint * p_Output = (GLuint *)malloc(uiNumTriangles * 3 * sizeof(GLuint));
+    unsigned uiCache[g_uiMeshOptCacheSize + 3];
+    unsigned uiNewCache[g_uiMeshOptCacheSize + 3];
+    unsigned uiCacheSize = 0;
+    unsigned uiNextTriangle = 0;
+    int iBest = -1;
+    for (unsigned i = 0; i < uiNumTriangles; i++) {
+        // Start a new region with the next unused triangle if nothing in the cache helps
+        if (iBest < 0) {
+            while (p_bAdded[uiNextTriangle])
+                ++uiNextTriangle;
+            iBest = (int)uiNextTriangle;
+        }
+
+        // Output the triangle
+        const GLuint * p_Triangle = &p_Indices[iBest * 3];
+        p_bAdded[iBest] = 1;
+        p_Output[(i * 3) + 0] = p_Triangle[0];
+        p_Output[(i * 3) + 1] = p_Triangle[1];
+        p_Output[(i * 3) + 2] = p_Triangle[2];
+
+        // Remove the triangle from each of its vertices live lists
+        for (unsigned j = 0; j < 3; j++) {
+            const GLuint uiVertex = p_Triangle[j];
+            unsigned * p_uiList = &p_uiAdjacency[p_uiOffsets[uiVertex]];
+            for (unsigned k = 0; k < p_uiLive[uiVertex]; k++) {
+                if (p_uiList[k] == (unsigned)iBest) {
+                    p_uiList[k] = p_uiList[p_uiLive[uiVertex] - 1];
+                    --p_uiLive[uiVertex];
+                    break;
+                }
+            }
+        }
+
+        // Move the triangles vertices to the front of the cache
+        unsigned uiNewSize = 0;
+        for (unsigned j = 0; j < 3; j++) {
+            bool bDuplicate = false;
+            for (unsigned k = 0; k < uiNewSize; k++) {
+                bDuplicate |= (uiNewCache[k] == p_Triangle[j]);
+            }
+            if (!bDuplicate)
+                uiNewCache[uiNewSize++] = p_Triangle[j];
+        }
+        for (unsigned j = 0; j < uiCacheSize; j++) {
+            const unsigned uiVertex = uiCache[j];
+            if ((uiVertex != p_Triangle[0]) && (uiVertex != p_Triangle[1]) && (uiVertex != p_Triangle[2]))
+                uiNewCache[uiNewSize++] = uiVertex;
+        }
+
+        // Update vertices pushed out of the cache
+        for (unsigned j = g_uiMeshOptCacheSize; j < uiNewSize; j++) {
+            p_iCachePositions[uiNewCache[j]] = -1;
+            p_fScores[uiNewCache[j]] = GL_ForsythVertexScore(-1, p_uiLive[uiNewCache[j]]);
+        }
+        uiCacheSize = min(uiNewSize, g_uiMeshOptCacheSize);
+        for (unsigned j = 0; j < uiCacheSize; j++) {
+            const unsigned uiVertex = uiNewCache[j];
+            uiCache[j] = uiVertex;
+            p_iCachePositions[uiVertex] = (int)j;
+            p_fScores[uiVertex] = GL_ForsythVertexScore((int)j, p_uiLive[uiVertex]);
+        }
+
+        // Find best remaining triangle that uses a cached vertex
+        float fBestScore = -1.0f;
+        iBest = -1;
+        for (unsigned j = 0; j < uiCacheSize; j++) {
+            const unsigned uiVertex = uiCache[j];
+            const unsigned * p_uiList = &p_uiAdjacency[p_uiOffsets[uiVertex]];
+            for (unsigned k = 0; k < p_uiLive[uiVertex]; k++) {
+                const GLuint * p_Candidate = &p_Indices[p_uiList[k] * 3];
+                const float fScore = p_fScores[p_Candidate[0]] + p_fScores[p_Candidate[1]] + p_fScores[p_Candidate[2]];
+                if (fScore > fBestScore) {
+                    fBestScore = fScore;
+                    iBest = (int)p_uiList[k];
+                }
+            }
+        }
+    }
+    memcpy(p_Indices, p_Output, uiNumTriangles * 3 * sizeof(GLuint));
+
+    // Cleanup allocated data
+    free(p_uiLive);
+    free(p_uiOffsets);
+    free(p_uiAdjacency);
+    free(p_fScores);
+    free(p_iCachePositions);
+    free(p_bAdded);
+    free(p_Output);
+}
+
+int GL_CompareClusters(const void * p_A, const void * p_B)
+{
+    // Sort highest key first
+    float fA = ((const MeshOptClusterData *)p_A)->m_fSortKey;
+    float fB = ((const MeshOptClusterData *)p_B)->m_fSortKey;
+    return (fA < fB) - (fA > fB);
+}
+
+void GL_OptimizeOverdraw(GLuint * p_Indices, unsigned uiNumIndices, const void * p_Vertices, unsigned uiStride, unsigned uiNumVertices)
+{
+    // Positions are expected to be the first member of each vertex
+    const unsigned uiNumTriangles = uiNumIndices / 3;
+    if (uiNumTriangles < 2)
+        return;
+    const unsigned char * p_VertexData = (const unsigned char *)p_Vertices;
+
+    // Split into clusters wherever a triangle misses the cache on every vertex, so reordering costs little
+    MeshOptClusterData * p_Clusters = (MeshOptClusterData *)malloc(uiNumTriangles * sizeof(MeshOptClusterData));
+    unsigned * p_uiCacheTime = (unsigned *)calloc(uiNumVertices, sizeof(unsigned));
+    unsigned uiTime = g_uiMeshOptFIFOSize + 1;
+    unsigned uiNumClusters = 0;
+    for (unsigned i = 0; i < uiNumTriangles; i++) {
+        unsigned uiMisses = 0;
+        for (unsigned j = 0; j < 3; j++) {
+            const GLuint uiVertex = p_Indices[(i * 3) + j];
+            if (uiTime - p_uiCacheTime[uiVertex] > g_uiMeshOptFIFOSize) {
+                p_uiCacheTime[uiVertex] = uiTime++;
+                ++uiMisses;
+            }
+        }
+        if ((i == 0) || (uiMisses == 3)) {
+            p_Clusters[uiNumClusters].m_uiFirstIndex = i * 3;
+            p_Clusters[uiNumClusters].m_uiNumIndices = 0;
+            ++uiNumClusters;
+        }
+        p_Clusters[uiNumClusters - 1].m_uiNumIndices += 3;
+    }
+    free(p_uiCacheTime);
+
+    // Find area weighted centre of the mesh
+    vec3 v3MeshCentre = vec3(0.0f);
+    float fMeshArea = 0.0f;
+    for (unsigned i = 0; i < uiNumIndices; i += 3) {
+        const vec3 & v3A = *(const vec3 *)&p_VertexData[p_Indices[i] * uiStride];
+        const vec3 & v3B = *(const vec3 *)&p_VertexData[p_Indices[i + 1] * uiStride];
+        const vec3 & v3C = *(const vec3 *)&p_VertexData[p_Indices[i + 2] * uiStride];
+        const float fArea = length(cross(v3B - v3A, v3C - v3A));
+        v3MeshCentre += (v3A + v3B + v3C) * (fArea / 3.0f);
+        fMeshArea += fArea;
+    }
+    v3MeshCentre = (fMeshArea > 0.0f) ? v3MeshCentre / fMeshArea : vec3(0.0f);
+
+    // Clusters facing away from the centre are most likely to occlude others so should be drawn first
+    for (unsigned i = 0; i < uiNumClusters; i++) {
+        MeshOptClusterData * p_Cluster = &p_Clusters[i];
+        vec3 v3Centre = vec3(0.0f);
+        vec3 v3Normal = vec3(0.0f);
+        float fArea = 0.0f;
+        for (unsigned j = p_Cluster->m_uiFirstIndex; j < p_Cluster->m_uiFirstIndex + p_Cluster->m_uiNumIndices; j += 3) {
+            const vec3 & v3A = *(const vec3 *)&p_VertexData[p_Indices[j] * uiStride];
+            const vec3 & v3B = *(const vec3 *)&p_VertexData[p_Indices[j + 1] * uiStride];
+            const vec3 & v3C = *(const vec3 *)&p_VertexData[p_Indices[j + 2] * uiStride];
+            const vec3 v3Cross = cross(v3B - v3A, v3C - v3A);
+            const float fTriArea = length(v3Cross);
+            v3Centre += (v3A + v3B + v3C) * (fTriArea / 3.0f);
+            v3Normal += v3Cross;
+            fArea += fTriArea;
+        }
+        const float fNormalLength = length(v3Normal);
+        p_Cluster->m_fSortKey = ((fArea > 0.0f) && (fNormalLength > 0.0f)) ?
+            dot((v3Centre / fArea) - v3MeshCentre, v3Normal / fNormalLength) : 0.0f;
+    }
+    qsort(p_Clusters, uiNumClusters, sizeof(MeshOptClusterData), GL_CompareClusters);
+
+    // Rebuild index buffer in cluster order
+    GLuint * p_Output = (GLuint *)malloc(uiNumTriangles * 3 * sizeof(GLuint));
+    GLuint * p_oBuffer = p_Output;
+    for (unsigned i = 0; i < uiNumClusters; i++) {
+        memcpy(p_oBuffer, &p_Indices[p_Clusters[i].m_uiFirstIndex], p_Clusters[i].m_uiNumIndices * sizeof(GLuint));
+        p_oBuffer += p_Clusters[i].m_uiNumIndices;
+    }
+    memcpy(p_Indices, p_Output, uiNumTriangles * 3 * sizeof(GLuint));
+
+    // Cleanup allocated data
+    free(p_Clusters);
+    free(p_Output);
+}
+
+void GL_OptimizeVertexFetch(void * p_Vertices, unsigned uiStride, unsigned uiNumVertices, GLuint * p_Indices, unsigned uiNumIndices)
+{
+    // Number vertices in the order they are first used
+    unsigned * p_uiRemap = (unsigned *)malloc(uiNumVertices * sizeof(unsigned));
+    memset(p_uiRemap, 0xFF, uiNumVertices * sizeof(unsigned));
+    unsigned uiNext = 0;
+    for (unsigned i = 0; i < uiNumIndices; i++) {
+        const GLuint uiVertex = p_Indices[i];
+        if (p_uiRemap[uiVertex] == ~0u)
+            p_uiRemap[uiVertex] = uiNext++;
+        p_Indices[i] = p_uiRemap[uiVertex];
+    }
+
+    // Keep any unused vertices at the end so the vertex count is unchanged
+    for (unsigned i = 0; i < uiNumVertices; i++) {
+        if (p_uiRemap[i] == ~0u)
+            p_uiRemap[i] = uiNext++;
+    }
+
+    // Move vertices to their new positions
+    unsigned char * p_VertexData = (unsigned char *)p_Vertices;
+    unsigned char * p_Output = (unsigned char *)malloc(uiNumVertices * uiStride);
+    for (unsigned i = 0; i < uiNumVertices; i++) {
+        memcpy(&p_Output[p_uiRemap[i] * uiStride], &p_VertexData[i * uiStride], uiStride);
+    }
+    memcpy(p_VertexData, p_Output, uiNumVertices * uiStride);
+
+    // Cleanup allocated data
+    free(p_uiRemap);
+    free(p_Output);
+}
+
+void GL_AnalyzeVertexCache(const GLuint * p_Indices, unsigned uiNumIndices, unsigned uiNumVertices, float & fACMR, float & fATVR)
+{
+    // Simulate a FIFO post transform cache
+    unsigned * p_uiCacheTime = (unsigned *)calloc(uiNumVertices, sizeof(unsigned));
+    unsigned uiTime = g_uiMeshOptFIFOSize + 1;
+    unsigned uiMisses = 0;
+    unsigned uiNumUsed = 0;
+    for (unsigned i = 0; i < uiNumIndices; i++) {
+        const GLuint uiVertex = p_Indices[i];
+        uiNumUsed += (p_uiCacheTime[uiVertex] == 0);
+        if (uiTime - p_uiCacheTime[uiVertex] > g_uiMeshOptFIFOSize) {
+            p_uiCacheTime[uiVertex] = uiTime++;
+            ++uiMisses;
+        }
+    }
+    free(p_uiCacheTime);
+
+    // Average transforms per triangle and per used vertex, the best possible ATVR is 1
+    fACMR = (uiNumIndices >= 3) ? (float)uiMisses / (float)(uiNumIndices / 3) : 0.0f;
+    fATVR = (uiNumUsed > 0) ? (float)uiMisses / (float)uiNumUsed : 0.0f;
+}
+
+void GL_OptimizeMesh(void * p_Vertices, unsigned uiStride, unsigned uiNumVertices, GLuint * p_Indices, unsigned uiNumIndices, const char * p_cName)
+{
+    // Measure the original ordering
+    float fACMRBefore, fATVRBefore;
+    GL_AnalyzeVertexCache(p_Indices, uiNumIndices, uiNumVertices, fACMRBefore, fATVRBefore);
+
+    // Reorder triangles for the vertex cache, then for overdraw, then reorder vertices to match
+    GL_OptimizeVertexCache(p_Indices, uiNumIndices, uiNumVertices);
+    GL_OptimizeOverdraw(p_Indices, uiNumIndices, p_Vertices, uiStride, uiNumVertices);
+    GL_OptimizeVertexFetch(p_Vertices, uiStride, uiNumVertices, p_Indices, uiNumIndices);
+
+    // Report the improvement
+    float fACMRAfter, fATVRAfter;
+    GL_AnalyzeVertexCache(p_Indices, uiNumIndices, uiNumVertices, fACMRAfter, fATVRAfter);
+    SDL_Log("Mesh '%s' (%u triangles): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", p_cName, uiNumIndices / 3,
+            fACMRBefore, fACMRAfter, fATVRBefore, fATVRAfter);
+}
+
+int GL_CompareCollapses(const void * p_A, const void * p_B)
+{
+    // Sort lowest error first
+    float fA = ((const MeshOptCollapseData *)p_A)->m_fError;
+    float fB = ((const MeshOptCollapseData *)p_B)->m_fError;
+    return (fA > fB) - (fA < fB);
+}
+
+void GL_AddQuadric(MeshOptQuadric & Quadric, const MeshOptQuadric & Other)
+{
+    Quadric.m_fA00 += Other.m_fA00;
+    Quadric.m_fA11 += Other.m_fA11;
+    Quadric.m_fA22 += Other.m_fA22;
+    Quadric.m_fA01 += Other.m_fA01;
+    Quadric.m_fA02 += Other.m_fA02;
+    Quadric.m_fA12 += Other.m_fA12;
+    Quadric.m_fB0 += Other.m_fB0;
+    Quadric.m_fB1 += Other.m_fB1;
+    Quadric.m_fB2 += Other.m_fB2;
+    Quadric.m_fC += Other.m_fC;
+    Quadric.m_fWeight += Other.m_fWeight;
+}
+
+void GL_AddPlaneQuadric(MeshOptQuadric & Quadric, const vec3 & v3Normal, float fDistance, float fWeight, float fArea)
+{
+    // Squared distance to the plane, weighted by triangle area, only surface area counts towards the mean so constraint planes add error
+    Quadric.m_fA00 += fWeight * v3Normal.x * v3Normal.x;
+    Quadric.m_fA11 += fWeight * v3Normal.y * v3Normal.y;
+    Quadric.m_fA22 += fWeight * v3Normal.z * v3Normal.z;
+    Quadric.m_fA01 += fWeight * v3Normal.x * v3Normal.y;
+    Quadric.m_fA02 += fWeight * v3Normal.x * v3Normal.z;
+    Quadric.m_fA12 += fWeight * v3Normal.y * v3Normal.z;
+    Quadric.m_fB0 += fWeight * v3Normal.x * fDistance;
+    Quadric.m_fB1 += fWeight * v3Normal.y * fDistance;
+    Quadric.m_fB2 += fWeight * v3Normal.z * fDistance;
+    Quadric.m_fC += fWeight * fDistance * fDistance;
+    Quadric.m_fWeight += fArea;
+}
+
+float GL_QuadricError(const MeshOptQuadric & Quadric, const vec3 & v3Position)
+{
+    // Mean squared distance from the position to every accumulated plane
+    const vec3 v3B = vec3(Quadric.m_fB0, Quadric.m_fB1, Quadric.m_fB2);
+    const vec3 v3AP = vec3(Quadric.m_fA00 * v3Position.x + Quadric.m_fA01 * v3Position.y + Quadric.m_fA02 * v3Position.z,
+                           Quadric.m_fA01 * v3Position.x + Quadric.m_fA11 * v3Position.y + Quadric.m_fA12 * v3Position.z,
+                           Quadric.m_fA02 * v3Position.x + Quadric.m_fA12 * v3Position.y + Quadric.m_fA22 * v3Position.z);
+    const float fError = dot(v3Position, v3AP) + (2.0f * dot(v3Position, v3B)) + Quadric.m_fC;
+    return (Quadric.m_fWeight > 0.0f) ? fabsf(fError) / Quadric.m_fWeight : 0.0f;
+}
+
+void GL_BuildVertexTriangles(const GLuint * p_Indices, unsigned uiNumIndices, unsigned uiNumVertices, unsigned * p_uiCounts,
+                             unsigned * p_uiOffsets, unsigned * p_uiAdjacency)
+{
+    // Build list of triangles using each vertex
+    memset(p_uiCounts, 0, uiNumVertices * sizeof(unsigned));
+    for (unsigned i = 0; i < uiNumIndices; i++) {
+        ++p_uiCounts[p_Indices[i]];
+    }
+    p_uiOffsets[0] = 0;
+    for (unsigned i = 0; i < uiNumVertices; i++) {
+        p_uiOffsets[i + 1] = p_uiOffsets[i] + p_uiCounts[i];
+        p_uiCounts[i] = 0;
+    }
+    for (unsigned i = 0; i < uiNumIndices; i++) {
+        const GLuint uiVertex = p_Indices[i];
+        p_uiAdjacency[p_uiOffsets[uiVertex] + p_uiCounts[uiVertex]] = i / 3;
+        ++p_uiCounts[uiVertex];
+    }
+}
+
+unsigned GL_SimplifyMesh(const void * p_Vertices, unsigned uiStride, unsigned uiNumVertices, const GLuint * p_Indices, unsigned uiNumIndices,
+                         GLuint * p_Output, unsigned uiTargetIndices, float fMaxError, float & fError)
+{
+    // Positions are expected to be the first member of each vertex
+    const unsigned char * p_VertexData = (const unsigned char *)p_Vertices;
+    memcpy(p_Output, p_Indices, uiNumIndices * sizeof(GLuint));
+    unsigned uiCount = uiNumIndices;
+    fError = 0.0f;
+    if ((uiNumIndices < 3) || (uiTargetIndices >= uiNumIndices))
+        return uiCount;
+
+    // Find vertices sharing a position, these lie on attribute seams and are linked so every copy moves together
+    unsigned uiTableSize = 1;
+    while (uiTableSize < uiNumVertices * 2)
+        uiTableSize *= 2;
+    unsigned * p_uiTable = (unsigned *)malloc(uiTableSize * sizeof(unsigned));
+    memset(p_uiTable, 0xFF, uiTableSize * sizeof(unsigned));
+    unsigned * p_uiPositions = (unsigned *)malloc(uiNumVertices * sizeof(unsigned));
+    unsigned * p_uiNextCopy = (unsigned *)malloc(uiNumVertices * sizeof(unsigned));
+    unsigned char * p_bLocked = (unsigned char *)calloc(uiNumVertices, sizeof(unsigned char));
+    for (unsigned i = 0; i < uiNumVertices; i++) {
+        const vec3 & v3Position = *(const vec3 *)&p_VertexData[i * uiStride];
+        const unsigned * p_uiBits = (const unsigned *)&v3Position;
+        unsigned uiSlot = ((p_uiBits[0] * 73856093u) ^ (p_uiBits[1] * 19349663u) ^ (p_uiBits[2] * 83492791u)) & (uiTableSize - 1);
+        while ((p_uiTable[uiSlot] != ~0u) && (*(const vec3 *)&p_VertexData[p_uiTable[uiSlot] * uiStride] != v3Position))
+            uiSlot = (uiSlot + 1) & (uiTableSize - 1);
+        if (p_uiTable[uiSlot] == ~0u) {
+            p_uiTable[uiSlot] = i;
+            p_uiNextCopy[i] = i;
+        } else {
+            p_uiNextCopy[i] = p_uiNextCopy[p_uiTable[uiSlot]];
+            p_uiNextCopy[p_uiTable[uiSlot]] = i;
+        }
+        p_uiPositions[i] = p_uiTable[uiSlot];
+    }
+    free(p_uiTable);
+
+    // Find edges used by only one triangle, first between vertices then between positions
+    unsigned * p_uiCounts = (unsigned *)malloc(uiNumVertices * sizeof(unsigned));
+    unsigned * p_uiOffsets = (unsigned *)malloc((uiNumVertices + 1) * sizeof(unsigned));
+    unsigned * p_uiAdjacency = (unsigned *)malloc(uiNumIndices * sizeof(unsigned));
+    GLuint * p_uiPositionIndices = (GLuint *)malloc(uiNumIndices * sizeof(GLuint));
+    unsigned char * p_bOpenEdges = (unsigned char *)malloc(uiNumIndices * sizeof(unsigned char));
+    for (unsigned i = 0; i < uiNumIndices; i++) {
+        p_uiPositionIndices[i] = p_uiPositions[p_Indices[i]];
+    }
+    for (unsigned uiSpace = 0; uiSpace < 2; uiSpace++) {
+        const GLuint * p_uiEdgeIndices = (uiSpace == 0) ? p_Indices : p_uiPositionIndices;
+        GL_BuildVertexTriangles(p_uiEdgeIndices, uiNumIndices, uiNumVertices, p_uiCounts, p_uiOffsets, p_uiAdjacency);
+        for (unsigned i = 0; i < uiNumIndices; i++) {
+            const unsigned uiNext = (i % 3 == 2) ? i - 2 : i + 1;
+            const GLuint uiA = p_uiEdgeIndices[i];
+            const GLuint uiB = p_uiEdgeIndices[uiNext];
+            unsigned uiShared = 0;
+            for (unsigned j = p_uiOffsets[uiA]; j < p_uiOffsets[uiA + 1]; j++) {
+                const GLuint * p_Triangle = &p_uiEdgeIndices[p_uiAdjacency[j] * 3];
+                uiShared += ((p_Triangle[0] == uiB) || (p_Triangle[1] == uiB) || (p_Triangle[2] == uiB));
+            }
+            if (uiSpace == 0) {
+                p_bOpenEdges[i] = (uiShared == 1);
+            } else if (uiShared == 1) {
+                // Open between positions is a true boundary, these are locked so holes keep their outline
+                p_bLocked[uiA] = 1;
+                p_bLocked[uiB] = 1;
+                p_bOpenEdges[i] = 0;
+            }
+        }
+    }
+    free(p_uiPositionIndices);
+
+    // Accumulate the plane of each triangle onto its position, remaining open vertex edges are attribute seams so also get a plane
+    // through the edge that makes moving off the seam costly
+    MeshOptQuadric * p_Quadrics = (MeshOptQuadric *)calloc(uiNumVertices, sizeof(MeshOptQuadric));
+    for (unsigned i = 0; i < uiNumIndices; i += 3) {
+        const vec3 & v3A = *(const vec3 *)&p_VertexData[p_Indices[i] * uiStride];
+        const vec3 & v3B = *(const vec3 *)&p_VertexData[p_Indices[i + 1] * uiStride];
+        const vec3 & v3C = *(const vec3 *)&p_VertexData[p_Indices[i + 2] * uiStride];
+        vec3 v3Normal = cross(v3B - v3A, v3C - v3A);
+        const float fLength = length(v3Normal);
+        if (fLength == 0.0f)
+            continue;
+        v3Normal /= fLength;
+        for (unsigned j = 0; j < 3; j++) {
+            GL_AddPlaneQuadric(p_Quadrics[p_uiPositions[p_Indices[i + j]]], v3Normal, -dot(v3Normal, v3A), fLength * 0.5f, fLength * 0.5f);
+        }
+        for (unsigned j = 0; j < 3; j++) {
+            if (!p_bOpenEdges[i + j])
+                continue;
+            const vec3 & v3Start = *(const vec3 *)&p_VertexData[p_Indices[i + j] * uiStride];
+            const vec3 & v3End = *(const vec3 *)&p_VertexData[p_Indices[i + ((j + 1) % 3)] * uiStride];
+            const vec3 v3SeamNormal = normalize(cross(v3End - v3Start, v3Normal));
+            const float fWeight = fLength * 0.5f * g_fMeshOptSeamWeight;
+            GL_AddPlaneQuadric(p_Quadrics[p_uiPositions[p_Indices[i + j]]], v3SeamNormal, -dot(v3SeamNormal, v3Start), fWeight, 0.0f);
+            GL_AddPlaneQuadric(p_Quadrics[p_uiPositions[p_Indices[i + ((j + 1) % 3)]]], v3SeamNormal, -dot(v3SeamNormal, v3Start), fWeight, 0.0f);
+        }
+    }
+    free(p_bOpenEdges);
+
+    // Collapse edges in passes, each position may only change once per pass
+    MeshOptCollapseData * p_Collapses = (MeshOptCollapseData *)malloc(uiNumIndices * 2 * sizeof(MeshOptCollapseData));
+    unsigned * p_uiRemap = (unsigned *)malloc(uiNumVertices * sizeof(unsigned));
+    unsigned char * p_bTouched = (unsigned char *)malloc(uiNumVertices * sizeof(unsigned char));
+    const float fMaxErrorSq = fMaxError * fMaxError;
+    for (unsigned uiPass = 0; (uiPass < g_uiMeshOptMaxSimplifyPasses) && (uiCount > uiTargetIndices); uiPass++) {
+        GL_BuildVertexTriangles(p_Output, uiCount, uiNumVertices, p_uiCounts, p_uiOffsets, p_uiAdjacency);
+
+        // Find the cost of collapsing each edge in both directions
+        unsigned uiNumCollapses = 0;
+        for (unsigned i = 0; i < uiCount; i++) {
+            const GLuint uiA = p_Output[i];
+            const GLuint uiB = p_Output[(i % 3 == 2) ? i - 2 : i + 1];
+            for (unsigned j = 0; j < 2; j++) {
+                const GLuint uiFrom = (j == 0) ? uiA : uiB;
+                const GLuint uiTo = (j == 0) ? uiB : uiA;
+                if (p_bLocked[p_uiPositions[uiFrom]])
+                    continue;
+                MeshOptQuadric Quadric = p_Quadrics[p_uiPositions[uiFrom]];
+                GL_AddQuadric(Quadric, p_Quadrics[p_uiPositions[uiTo]]);
+                MeshOptCollapseData * p_Collapse = &p_Collapses[uiNumCollapses++];
+                p_Collapse->m_uiFrom = uiFrom;
+                p_Collapse->m_uiTo = uiTo;
+                p_Collapse->m_fError = GL_QuadricError(Quadric, *(const vec3 *)&p_VertexData[uiTo * uiStride]);
+            }
+        }
+        if (uiNumCollapses == 0)
+            break;
+        qsort(p_Collapses, uiNumCollapses, sizeof(MeshOptCollapseData), GL_CompareCollapses);
+
+        // Only take the cheapest third each pass so later passes can use the updated errors
+        const float fPassError = p_Collapses[uiNumCollapses / 3].m_fError;
+        for (unsigned i = 0; i < uiNumVertices; i++) {
+            p_uiRemap[i] = i;
+        }
+        memset(p_bTouched, 0, uiNumVertices * sizeof(unsigned char));
+        unsigned uiTriangles = uiCount / 3;
+        unsigned uiCollapsed = 0;
+        for (unsigned i = 0; (i < uiNumCollapses) && (uiTriangles * 3 > uiTargetIndices); i++) {
+            const MeshOptCollapseData * p_Collapse = &p_Collapses[i];
+            if ((p_Collapse->m_fError > fMaxErrorSq) || ((p_Collapse->m_fError > fPassError) && (uiCollapsed > 0)))
+                break;
+            const unsigned uiFromPosition = p_uiPositions[p_Collapse->m_uiFrom];
+            const unsigned uiToPosition = p_uiPositions[p_Collapse->m_uiTo];
+            if (p_bTouched[uiFromPosition] || p_bTouched[uiToPosition])
+                continue;
+
+            // Every copy of the position must move along one of its own edges onto the other position or the seam would tear,
+            // and no remaining triangle around it may flip or turn too far
+            const vec3 & v3To = *(const vec3 *)&p_VertexData[p_Collapse->m_uiTo * uiStride];
+            bool bReject = false;
+            unsigned uiRemoved = 0;
+            unsigned uiCopy = p_Collapse->m_uiFrom;
+            do {
+                unsigned uiTarget = (uiCopy == p_Collapse->m_uiFrom) ? p_Collapse->m_uiTo : ~0u;
+                for (unsigned j = p_uiOffsets[uiCopy]; (j < p_uiOffsets[uiCopy + 1]) && !bReject; j++) {
+                    const GLuint * p_Triangle = &p_Output[p_uiAdjacency[j] * 3];
+                    vec3 v3Before[3];
+                    vec3 v3After[3];
+                    bool bRemoved = false;
+                    for (unsigned k = 0; k < 3; k++) {
+                        const unsigned uiVertex = p_uiRemap[p_Triangle[k]];
+                        if (p_uiPositions[uiVertex] == uiToPosition) {
+                            uiTarget = (uiTarget == ~0u) ? uiVertex : uiTarget;
+                            bRemoved = true;
+                        }
+                        v3Before[k] = *(const vec3 *)&p_VertexData[uiVertex * uiStride];
+                        v3After[k] = (uiVertex == uiCopy) ? v3To : v3Before[k];
+                    }
+                    if (bRemoved) {
+                        ++uiRemoved;
+                        continue;
+                    }
+                    const vec3 v3NormalBefore = cross(v3Before[1] - v3Before[0], v3Before[2] - v3Before[0]);
+                    const vec3 v3NormalAfter = cross(v3After[1] - v3After[0], v3After[2] - v3After[0]);
+                    bReject = (dot(v3NormalBefore, v3NormalAfter) < 0.25f * length(v3NormalBefore) * length(v3NormalAfter));
+                }
+                bReject |= (uiTarget == ~0u) && (p_uiOffsets[uiCopy] != p_uiOffsets[uiCopy + 1]);
+                p_uiRemap[uiCopy] = (uiTarget == ~0u) ? uiCopy : uiTarget;
+                uiCopy = p_uiNextCopy[uiCopy];
+            } while ((uiCopy != p_Collapse->m_uiFrom) && !bReject);
+            if (bReject) {
+                // Undo any copies already moved
+                uiCopy = p_Collapse->m_uiFrom;
+                do {
+                    p_uiRemap[uiCopy] = uiCopy;
+                    uiCopy = p_uiNextCopy[uiCopy];
+                } while (uiCopy != p_Collapse->m_uiFrom);
+                continue;
+            }
+
+            // Move the position onto the other end of the edge
+            p_bTouched[uiFromPosition] = 1;
+            p_bTouched[uiToPosition] = 1;
+            GL_AddQuadric(p_Quadrics[uiToPosition], p_Quadrics[uiFromPosition]);
+            fError = max(fError, sqrtf(p_Collapse->m_fError));
+            uiTriangles -= min(uiRemoved, uiTriangles);
+            ++uiCollapsed;
+        }
+        if (uiCollapsed == 0)
+            break;
+
+        // Apply the collapses and remove triangles that have become degenerate, including those joining copies of a position
+        unsigned uiNewCount = 0;
+        for (unsigned i = 0; i < uiCount; i += 3) {
+            const GLuint uiA = p_uiRemap[p_Output[i]];
+            const GLuint uiB = p_uiRemap[p_Output[i + 1]];
+            const GLuint uiC = p_uiRemap[p_Output[i + 2]];
+            if ((p_uiPositions[uiA] != p_uiPositions[uiB]) && (p_uiPositions[uiB] != p_uiPositions[uiC]) && (p_uiPositions[uiA] != p_uiPositions[uiC])) {
+                p_Output[uiNewCount++] = uiA;
+                p_Output[uiNewCount++] = uiB;
+                p_Output[uiNewCount++] = uiC;
+            }
+        }
+        uiCount = uiNewCount;
+    }
+
+    // Cleanup allocated data
+    free(p_bLocked);
+    free(p_uiPositions);
+    free(p_uiNextCopy);
+    free(p_uiCounts);
+    free(p_uiOffsets);
+    free(p_uiAdjacency);
+    free(p_Quadrics);
+    free(p_Collapses);
+    free(p_uiRemap);
+    free(p_bTouched);
+    return uiCount;
+}
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <glm/glm.hpp>
 using namespace glm;
 
+//MeshOptimize.cpp
+extern void GL_OptimizeMesh(void * p_Vertices, unsigned uiStride, unsigned uiNumVertices, GLuint * p_Indices, unsigned uiNumIndices, const char * p_cName);
+
 struct CustomVertex
 {
     vec3 v3Position;
@@ -173,6 +176,9 @@ GLsizei GL_GenerateSphere(uint32_t uiTessU, uint32_t uiTessV, GLuint uiVBO, GLui
     //    *p_iBuffer++ = uiNumVertices - 1;
     //}
 
+    // Reorder for vertex cache, overdraw and vertex fetch
+    GL_OptimizeMesh(p_VBuffer, sizeof(CustomVertex), uiNumVertices, p_IBuffer, uiNumIndices, "Sphere");
+
     // Fill Vertex Buffer Object
     glBindBuffer(GL_ARRAY_BUFFER, uiVBO);
     glBufferData(GL_ARRAY_BUFFER, uiNumVertices * sizeof(CustomVertex), p_VBuffer, GL_STATIC_DRAW);
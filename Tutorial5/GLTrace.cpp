@@ -0,0 +1,169 @@
+// Using SDL
+#include <SDL2/SDL.h>
+
+#include "GLTrace.h"
+
+// Maximum events recorded by each thread
+const unsigned g_uiTraceMaxEvents = 1 << 18;
+
+struct TraceEventData
+{
+    const char * mp_cName;
+    char m_cPhase;
+    int m_iArg;
+    Uint64 m_ui64Start;
+    Uint64 m_ui64End;
+};
+
+struct TraceBufferData
+{
+    TraceEventData * mp_Events;
+    volatile unsigned m_uiNumEvents;
+    unsigned m_uiNumDropped;
+    SDL_threadID m_ThreadID;
+    TraceBufferData * mp_Next;
+};
+
+// Trace data
+bool g_bTraceEnabled = false;
+const char * gp_cTraceFile = NULL;
+Uint64 g_ui64TraceStart;
+// List of every threads buffer, only ever pushed to while tracing
+void * volatile gp_TraceBuffers = NULL;
+// Events being written, quitting waits for these to finish before freeing the buffers
+SDL_atomic_t g_TraceWriters;
+// Changed on each quit so buffers freed since a thread last wrote are never used again
+volatile unsigned g_uiTraceGeneration = 0;
+// Each thread only writes to its own buffer so no locking is needed
+thread_local TraceBufferData * tp_TraceBuffer = NULL;
+thread_local unsigned t_uiTraceGeneration = 0;
+
+void GL_WriteTraceEvent(const char * p_cName, char cPhase, Uint64 ui64Start, Uint64 ui64End, int iArg)
+{
+    TraceBufferData * p_Buffer = (t_uiTraceGeneration == g_uiTraceGeneration) ? tp_TraceBuffer : NULL;
+    if (p_Buffer == NULL) {
+        // First event on this thread so create its buffer
+        p_Buffer = (TraceBufferData *)malloc(sizeof(TraceBufferData));
+        p_Buffer->mp_Events = (TraceEventData *)malloc(g_uiTraceMaxEvents * sizeof(TraceEventData));
+        p_Buffer->m_uiNumEvents = 0;
+        p_Buffer->m_uiNumDropped = 0;
+        p_Buffer->m_ThreadID = SDL_ThreadID();
+
+        // Add to global list
+        do {
+            p_Buffer->mp_Next = (TraceBufferData *)gp_TraceBuffers;
+        } while (!SDL_AtomicCASPtr((void **)&gp_TraceBuffers, p_Buffer->mp_Next, p_Buffer));
+        tp_TraceBuffer = p_Buffer;
+        t_uiTraceGeneration = g_uiTraceGeneration;
+    }
+
+    // Drop events once full rather than allocate in the hot path
+    const unsigned uiEvent = p_Buffer->m_uiNumEvents;
+    if (uiEvent >= g_uiTraceMaxEvents) {
+        ++p_Buffer->m_uiNumDropped;
+        return;
+    }
+    TraceEventData * p_Event = &p_Buffer->mp_Events[uiEvent];
+    p_Event->mp_cName = p_cName;
+    p_Event->m_cPhase = cPhase;
+    p_Event->m_iArg = iArg;
+    p_Event->m_ui64Start = ui64Start;
+    p_Event->m_ui64End = ui64End;
+
+    // Publish the event
+    SDL_MemoryBarrierRelease();
+    p_Buffer->m_uiNumEvents = uiEvent + 1;
+}
+
+void GL_TraceEvent(const char * p_cName, char cPhase, Uint64 ui64Start, Uint64 ui64End, int iArg)
+{
+    // Only write while tracing, zones can end after it has stopped
+    SDL_AtomicAdd(&g_TraceWriters, 1);
+    if (g_bTraceEnabled)
+        GL_WriteTraceEvent(p_cName, cPhase, ui64Start, ui64End, iArg);
+    SDL_AtomicAdd(&g_TraceWriters, -1);
+}
+
+void GL_EscapeTraceName(const char * p_cName, char * p_cEscaped, unsigned uiSize)
+{
+    // Escape quotes and backslashes so the name is a valid JSON string
+    unsigned j = 0;
+    for (unsigned i = 0; (p_cName[i] != '\0') && (j + 2 < uiSize); i++) {
+        if ((p_cName[i] == '"') || (p_cName[i] == '\\'))
+            p_cEscaped[j++] = '\\';
+        p_cEscaped[j++] = p_cName[i];
+    }
+    p_cEscaped[j] = '\0';
+}
+
+void GL_InitTrace(const char * p_cTraceFile)
+{
+    // Use environment variable if no file specified
+    gp_cTraceFile = (p_cTraceFile != NULL) ? p_cTraceFile : SDL_getenv("GL_TRACE_FILE");
+    if (gp_cTraceFile == NULL)
+        return;
+    g_ui64TraceStart = SDL_GetPerformanceCounter();
+    g_bTraceEnabled = true;
+}
+
+void GL_QuitTrace()
+{
+    if (!g_bTraceEnabled)
+        return;
+
+    // Stop new events then wait for any other thread still writing one
+    g_bTraceEnabled = false;
+    while (!SDL_AtomicCAS(&g_TraceWriters, 0, 0))
+        SDL_Delay(0);
+    SDL_MemoryBarrierAcquire();
+
+    // Write out in Chrome trace event format
+    SDL_RWops * p_File = SDL_RWFromFile(gp_cTraceFile, "w");
+    if (p_File == NULL)
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to open trace file: %s\n", gp_cTraceFile);
+    const double dTicksToUS = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    char cLine[512];
+    char cName[256];
+    int iLength;
+    if (p_File != NULL) {
+        iLength = SDL_snprintf(cLine, sizeof(cLine), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        SDL_RWwrite(p_File, cLine, iLength, 1);
+    }
+    bool bFirst = true;
+    TraceBufferData * p_Buffer = (TraceBufferData *)gp_TraceBuffers;
+    while (p_Buffer != NULL) {
+        for (unsigned i = 0; (p_File != NULL) && (i < p_Buffer->m_uiNumEvents); i++) {
+            const TraceEventData * p_Event = &p_Buffer->mp_Events[i];
+            const double dStart = (double)(p_Event->m_ui64Start - g_ui64TraceStart) * dTicksToUS;
+            GL_EscapeTraceName(p_Event->mp_cName, cName, sizeof(cName));
+            iLength = SDL_snprintf(cLine, sizeof(cLine), "%s{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%lu",
+                                   bFirst ? "" : ",\n", cName, p_Event->m_cPhase, dStart, (unsigned long)p_Buffer->m_ThreadID);
+            if (p_Event->m_cPhase == 'X') {
+                const double dDuration = (double)(p_Event->m_ui64End - p_Event->m_ui64Start) * dTicksToUS;
+                iLength += SDL_snprintf(&cLine[iLength], sizeof(cLine) - iLength, ",\"dur\":%.3f", dDuration);
+            }
+            if (p_Event->m_iArg >= 0)
+                iLength += SDL_snprintf(&cLine[iLength], sizeof(cLine) - iLength, ",\"args\":{\"frame\":%d}", p_Event->m_iArg);
+            iLength += SDL_snprintf(&cLine[iLength], sizeof(cLine) - iLength, "}");
+            SDL_RWwrite(p_File, cLine, iLength, 1);
+            bFirst = false;
+        }
+        if (p_Buffer->m_uiNumDropped > 0)
+            SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Trace buffer full, dropped %u events\n", p_Buffer->m_uiNumDropped);
+
+        // Release the buffer
+        TraceBufferData * p_Next = p_Buffer->mp_Next;
+        free(p_Buffer->mp_Events);
+        free(p_Buffer);
+        p_Buffer = p_Next;
+    }
+    if (p_File != NULL) {
+        iLength = SDL_snprintf(cLine, sizeof(cLine), "\n]}\n");
+        SDL_RWwrite(p_File, cLine, iLength, 1);
+        SDL_RWclose(p_File);
+        SDL_Log("Trace written to %s\n", gp_cTraceFile);
+    }
+    gp_TraceBuffers = NULL;
+    tp_TraceBuffer = NULL;
+    ++g_uiTraceGeneration;
+}
\ No newline at end of file
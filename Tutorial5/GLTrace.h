@@ -0,0 +1,55 @@
+#ifndef _GLTRACE_H_
+#define _GLTRACE_H_
+
+// Using SDL
+#include <SDL2/SDL.h>
+
+extern bool g_bTraceEnabled;
+
+void GL_InitTrace(const char * p_cTraceFile);
+
+void GL_QuitTrace();
+
+void GL_TraceEvent(const char * p_cName, char cPhase, Uint64 ui64Start, Uint64 ui64End, int iArg);
+
+struct TraceZone
+{
+    const char * mp_cName;
+    Uint64 m_ui64Start;
+    int m_iArg;
+
+    TraceZone(const char * p_cName, int iArg = -1)
+    {
+        mp_cName = NULL;
+        if (g_bTraceEnabled) {
+            mp_cName = p_cName;
+            m_iArg = iArg;
+            m_ui64Start = SDL_GetPerformanceCounter();
+        }
+    }
+
+    ~TraceZone()
+    {
+        if (mp_cName != NULL)
+            GL_TraceEvent(mp_cName, 'X', m_ui64Start, SDL_GetPerformanceCounter(), m_iArg);
+    }
+};
+
+#ifndef GL_TRACE_DISABLE
+#define GL_TRACE_CONCAT2(a, b) a##b
+#define GL_TRACE_CONCAT(a, b) GL_TRACE_CONCAT2(a, b)
+// Time the enclosing scope
+#define GL_TRACE_ZONE(p_cName) TraceZone GL_TRACE_CONCAT(TraceZone_, __LINE__)(p_cName)
+// Time the enclosing scope as frame number uiFrame
+#define GL_TRACE_FRAME(uiFrame) TraceZone GL_TRACE_CONCAT(TraceZone_, __LINE__)("Frame", (int)(uiFrame))
+// Time between matching begin and end calls on the same thread
+#define GL_TRACE_BEGIN(p_cName) do { if (g_bTraceEnabled) GL_TraceEvent(p_cName, 'B', SDL_GetPerformanceCounter(), 0, -1); } while (0)
+#define GL_TRACE_END(p_cName) do { if (g_bTraceEnabled) GL_TraceEvent(p_cName, 'E', SDL_GetPerformanceCounter(), 0, -1); } while (0)
+#else
+#define GL_TRACE_ZONE(p_cName) ((void)0)
+#define GL_TRACE_FRAME(uiFrame) ((void)0)
+#define GL_TRACE_BEGIN(p_cName) ((void)0)
+#define GL_TRACE_END(p_cName) ((void)0)
+#endif
+
+#endif
\ No newline at end of file
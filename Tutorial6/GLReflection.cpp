@@ -4,6 +4,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
 
 //Main.cpp
 extern int g_iWindowWidth;
@@ -29,6 +30,7 @@ struct CameraData
 void GL_RenderPlanarReflection(ReflectObjectData * p_RObject, ObjectData * p_Object, const vec3 & v3Direction, const vec3 & v3Up,
                                const vec3 & v3Position, float fFOV, float fAspect, const vec2 & v2NearFar)
 {
+    GL_TRACE_ZONE("GL_RenderPlanarReflection");
     // Transform plane to world space
     vec3 v3PlanePosition = vec3(p_RObject->m_v4PlaneOrPosition) * p_RObject->m_v4PlaneOrPosition.w;
     v3PlanePosition = vec3(p_Object->m_4Transform * vec4(v3PlanePosition, 1.0f));
@@ -149,6 +151,7 @@ void GL_CalculateCubeMapVP(const vec3 & v3Position, mat4 * p_m4CubeViewProjectio
 
 void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject, ObjectData * p_Object)
 {
+    GL_TRACE_ZONE("GL_RenderEnvironmentReflection");
     // Calculate position in world space
     vec3 v3Position = vec3(p_Object->m_4Transform * p_RObject->m_v4PlaneOrPosition);
 
@@ -1,4 +1,5 @@
 #include "GLScene.h"
+#include "GLTrace.h"
 // Using SDL
 #include <SDL2/SDL.h>
 // Using Assimp
@@ -164,6 +165,7 @@ bool GL_FindSceneNode(aiNode * p_Node, const aiString & Name, const aiScene * p_
 
 bool GL_LoadScene(const char * p_cSceneFile, SceneData & SceneInfo)
 {
+    GL_TRACE_ZONE("GL_LoadScene");
     // Load scene from file
     const aiScene * p_Scene = aiImportFile(p_cSceneFile,
                                            aiProcess_GenSmoothNormals |
@@ -7,6 +7,8 @@
 #include <Windows.h>
 #endif
 
+#include "GLTrace.h"
+
 bool GL_LoadShader(GLuint & uiShader, GLenum ShaderType, const GLchar * p_cShader)
 {
     // Build and link the shader program
@@ -55,6 +57,7 @@ bool GL_LoadShaders(GLuint & uiShader, GLuint uiVertexShader, GLuint uiFragmentS
 
 bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char* p_cFileName, int iFileID)
 {
+    GL_TRACE_ZONE(p_cFileName);
 #ifdef _WIN32
     // Can load directly from windows resource file
     HINSTANCE hInst = GetModuleHandle(NULL);
@@ -4,6 +4,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
 
 //Main.cpp
 extern int g_iWindowWidth;
@@ -250,6 +251,7 @@ void GL_RenderSpotTransparency()
 
 void GL_RenderShadows()
 {
+    GL_TRACE_ZONE("GL_RenderShadows");
     // Bind shadow map frame buffer
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOShadow);
 
@@ -13,6 +13,7 @@
 using namespace glm;
 
 #include "GLScene.h"
+#include "GLTrace.h"
 
 //Debug.cpp
 extern void GLDebug_Init();
@@ -53,6 +54,7 @@ struct CameraData
 
 bool GL_Init()
 {
+    GL_TRACE_ZONE("GL_Init");
     // Initialize GLEW
     glewExperimental = GL_TRUE; // Allow experimental or pre-release drivers to return all supported extensions
     GLenum GlewError = glewInit();
@@ -195,6 +197,7 @@ void GL_Quit()
 
 void GL_RenderObjects(ObjectData * p_SkipObject = NULL)
 {
+    GL_TRACE_ZONE("GL_RenderObjects");
     // Clear the render output and depth buffer
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -260,6 +263,7 @@ void GL_RenderObjects(ObjectData * p_SkipObject = NULL)
 
 void GL_Render()
 {
+    GL_TRACE_ZONE("GL_Render");
     // Generate shadows
     //GL_RenderShadows();
 
@@ -297,6 +301,7 @@ void GL_Render()
 
 void GL_Update(float fElapsedTime)
 {
+    GL_TRACE_ZONE("GL_Update");
     // Update the cameras position
     g_SceneData.m_LocalCamera.m_v3Position += g_SceneData.m_LocalCamera.m_fMoveZ * fElapsedTime * g_SceneData.m_LocalCamera.m_v3Direction;
     g_SceneData.m_LocalCamera.m_v3Position += g_SceneData.m_LocalCamera.m_fMoveX * fElapsedTime * g_SceneData.m_LocalCamera.m_v3Right;
@@ -342,6 +347,9 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 int main(int argc, char **argv)
 #endif
 {
+    // Start CPU tracing if GL_TRACE_FILE is set
+    GL_InitTrace(NULL);
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL: %s\n", SDL_GetError());
@@ -398,13 +406,19 @@ int main(int argc, char **argv)
         // Start the program message pump
         SDL_Event Event;
         bool bQuit = false;
+        unsigned uiFrame = 0;
         while (!bQuit) {
+            // Time the whole frame
+            GL_TRACE_FRAME(uiFrame);
+            ++uiFrame;
+
             // Update elapsed frame time
             uiOldTime = uiCurrentTime;
             uiCurrentTime = SDL_GetTicks();
             float fElapsedTime = (float)(uiCurrentTime - uiOldTime) / 1000.0f;
 
             // Poll SDL for buffered events
+            GL_TRACE_BEGIN("Events");
             while (SDL_PollEvent(&Event)) {
                 if (Event.type == SDL_QUIT)
                     bQuit = true;
@@ -454,6 +468,7 @@ int main(int argc, char **argv)
                         g_SceneData.m_LocalCamera.m_fFOV = ((float)M_PI * 0.9f);
                 }
             }
+            GL_TRACE_END("Events");
 
             // Update the Scene
             GL_Update(fElapsedTime);
@@ -462,13 +477,18 @@ int main(int argc, char **argv)
             GL_Render();
 
             // Swap the back-buffer and present the render
+            GL_TRACE_BEGIN("Swap");
             SDL_GL_SwapWindow(Window);
+            GL_TRACE_END("Swap");
         }
 
         // Delete any created GL resources
         GL_Quit();
     }
 
+    // Write out any CPU trace
+    GL_QuitTrace();
+
     // Delete the OpenGL context, SDL window and shutdown SDL
     SDL_GL_DeleteContext(Context);
     SDL_DestroyWindow(Window);
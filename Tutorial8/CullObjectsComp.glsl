@@ -0,0 +1,137 @@
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+struct ObjectDraw {
+    // First index, index count and simplification error relative to the mesh radius of each LOD
+    uvec4 u4LODFirstIndex;
+    uvec4 u4LODNumIndices;
+    vec4 v4LODError;
+    int iBaseVertex;
+    uint uiNumLODs;
+    uint uiObject;
+    uint uiTransformIndex;
+};
+struct CullView {
+    vec4 v4Planes[6];
+    // Position and pixels per world unit at distance one, or at any distance for orthographic views
+    vec4 v4PositionScale;
+    // Distance the view reaches, the falloff of light views, then one for orthographic views
+    vec4 v4Range;
+};
+struct DrawCommand {
+    uint uiCount;
+    uint uiInstanceCount;
+    uint uiFirstIndex;
+    int iBaseVertex;
+    uint uiBaseInstance;
+};
+
+layout(std430, binding = 2) readonly buffer ObjectBoundsData {
+    vec4 v4ObjectBounds[];
+};
+layout(std430, binding = 3) readonly buffer ObjectDrawData {
+    ObjectDraw Draws[];
+};
+layout(std430, binding = 4) readonly buffer CullViewData {
+    CullView Views[];
+};
+layout(std430, binding = 5) writeonly buffer DrawCommandData {
+    DrawCommand Commands[];
+};
+layout(std430, binding = 6) writeonly buffer DrawIndexData {
+    // Transform index followed by the mask of views the object reaches
+    uvec2 u2DrawIndices[];
+};
+layout(std430, binding = 7) buffer VisibleData {
+    // Visible count of each section, the drawn and possible light layers of each section, then the visible count of each bucket
+    uint uiVisible[];
+};
+// World space minimum then maximum corner of each objects bounding box
+layout(std430, binding = 8) readonly buffer ObjectAABBData {
+    float fObjectAABBs[];
+};
+// First command of the bucket each draw is appended to and the buckets index, all bits set for draws not queued
+layout(std430, binding = 9) readonly buffer DrawBucketData {
+    uvec2 u2DrawBuckets[];
+};
+
+layout(location = 0) uniform uint uiNumDraws;
+layout(location = 1) uniform uint uiNumViews;
+layout(location = 2) uniform uint uiSection;
+layout(location = 3) uniform uint uiFirstCommand;
+// Allowed simplification error in pixels, zero to always use full detail
+layout(location = 4) uniform float fLODPixelError;
+// Append each draw to its bucket instead of the whole section, for passes that draw runs of objects sharing state together
+layout(location = 5) uniform bool bBuckets;
+// Index of the first bucket count in the visible counts
+layout(location = 6) uniform uint uiFirstBucketCount;
+// Mask of the views whose layers are being drawn, and the index of the first light layer count
+layout(location = 7) uniform uint uiLayerMask;
+layout(location = 8) uniform uint uiFirstLayerCount;
+
+void main()
+{
+    uint uiDraw = gl_GlobalInvocationID.x;
+    if (uiDraw >= uiNumDraws)
+        return;
+    uvec2 u2Bucket = u2DrawBuckets[uiDraw];
+    if (bBuckets && (u2Bucket.y == 0xFFFFFFFFu))
+        return;
+    ObjectDraw Draw = Draws[uiDraw];
+    vec4 v4Bounds = v4ObjectBounds[Draw.uiObject];
+    uint uiAABB = Draw.uiObject * 6;
+    vec3 v3Min = vec3(fObjectAABBs[uiAABB], fObjectAABBs[uiAABB + 1], fObjectAABBs[uiAABB + 2]);
+    vec3 v3Max = vec3(fObjectAABBs[uiAABB + 3], fObjectAABBs[uiAABB + 4], fObjectAABBs[uiAABB + 5]);
+
+    // Check bounding box against each views range and frustum, finding the largest size on screen over all views
+    bool bVisible = false;
+    uint uiViewMask = 0;
+    float fPixelScale = 0.0f;
+    for (uint i = 0; i < uiNumViews; i++) {
+        vec3 v3Position = Views[i].v4PositionScale.xyz;
+        float fDistance = length(clamp(v3Position, v3Min, v3Max) - v3Position);
+        bool bInside = (fDistance <= Views[i].v4Range.x);
+        for (uint j = 0; (j < 6) && bInside; j++) {
+            // Test the corner furthest along the planes normal
+            vec4 v4Plane = Views[i].v4Planes[j];
+            vec3 v3Far = mix(v3Min, v3Max, greaterThanEqual(v4Plane.xyz, vec3(0.0f)));
+            bInside = (dot(v4Plane.xyz, v3Far) + v4Plane.w >= 0.0f);
+        }
+        bVisible = bVisible || bInside;
+        if (bInside) {
+            if (i < 32)
+                uiViewMask |= 1u << i;
+            float fViewScale = (Views[i].v4Range.y > 0.0f) ? 1.0f : max(fDistance, 0.0001f);
+            fPixelScale = max(fPixelScale, Views[i].v4PositionScale.w / fViewScale);
+        }
+    }
+    if (!bVisible)
+        return;
+
+    // Count the light layers the object is drawn to out of those being drawn
+    uint uiLayers = uiViewMask & uiLayerMask;
+    if (uiLayers != 0) {
+        atomicAdd(uiVisible[uiFirstLayerCount + (uiSection * 2)], uint(bitCount(uiLayers)));
+        atomicAdd(uiVisible[uiFirstLayerCount + (uiSection * 2) + 1], uint(bitCount(uiLayerMask)));
+    }
+
+    // Use the coarsest level whose error stays below the allowed size on screen
+    uint uiLOD = 0;
+    if (fLODPixelError > 0.0f) {
+        for (uint i = Draw.uiNumLODs - 1; i > 0; i--) {
+            if (Draw.v4LODError[i] * v4Bounds.w * fPixelScale <= fLODPixelError) {
+                uiLOD = i;
+                break;
+            }
+        }
+    }
+
+    // Append to this passes draws, or to the objects bucket so each buckets visible draws stay contiguous
+    uint uiSlot = atomicAdd(uiVisible[uiSection], 1);
+    if (bBuckets)
+        uiSlot = u2Bucket.x + atomicAdd(uiVisible[uiFirstBucketCount + u2Bucket.y], 1);
+    uint uiCommand = uiFirstCommand + uiSlot;
+    Commands[uiCommand] = DrawCommand(Draw.u4LODNumIndices[uiLOD], 1, Draw.u4LODFirstIndex[uiLOD], Draw.iBaseVertex, uiCommand);
+    u2DrawIndices[uiCommand] = uvec2(Draw.uiTransformIndex, uiViewMask);
+}
\ No newline at end of file
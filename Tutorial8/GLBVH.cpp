@@ -0,0 +1,292 @@
+// Using GLM and math headers
+#include <math.h>
+#include <float.h>
+#include <glm/glm.hpp>
+// Using SDL
+#include <SDL2/SDL.h>
+
+#include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
+
+//Main.cpp
+extern SceneData g_SceneData;
+//Cluster.cpp
+extern unsigned g_uiNumClusterViews;
+extern bool GL_ClusterAABBVisible(const vec3 & v3Min, const vec3 & v3Max, bool & bInside);
+extern bool GL_CullObjectBounds(unsigned uiObject);
+extern void GL_CountClusterObjects(unsigned uiVisible, unsigned uiCulled);
+
+struct BVHNodeData
+{
+    vec3 m_v3Min;
+    // First child for inner nodes, first entry in the object list for leaves
+    unsigned m_uiFirst;
+    vec3 m_v3Max;
+    // Number of objects, zero for inner nodes whose children are stored next to each other
+    unsigned m_uiNumObjects;
+};
+
+// Build settings
+const unsigned g_uiBVHBins = 12;
+const unsigned g_uiBVHLeafObjects = 4;
+const unsigned g_uiBVHMaxDepth = 48;
+// Relative cost of visiting a node compared to testing an object
+const float g_fBVHTraversalCost = 1.0f;
+
+// Object bounding volume hierarchy
+bool g_bObjectBVH = true;
+BVHNodeData * gp_BVHNodes = NULL;
+unsigned g_uiNumBVHNodes = 0;
+unsigned * gp_uiBVHObjects = NULL;
+bool g_bBVHDirty = false;
+// Objects found by the last cull
+unsigned * gp_uiBVHVisible = NULL;
+
+float GL_BVHSurfaceArea(const vec3 & v3Min, const vec3 & v3Max)
+{
+    const vec3 v3Size = max(v3Max - v3Min, vec3(0.0f));
+    return 2.0f * ((v3Size.x * v3Size.y) + (v3Size.y * v3Size.z) + (v3Size.z * v3Size.x));
+}
+
+void GL_FitBVHNode(BVHNodeData * p_Node)
+{
+    // Grow bounds to contain each object in the leaf
+    p_Node->m_v3Min = vec3(FLT_MAX);
+    p_Node->m_v3Max = vec3(-FLT_MAX);
+    for (unsigned i = 0; i < p_Node->m_uiNumObjects; i++) {
+        const AABBData * p_AABB = &g_SceneData.mp_ObjectAABBs[gp_uiBVHObjects[p_Node->m_uiFirst + i]];
+        p_Node->m_v3Min = min(p_Node->m_v3Min, p_AABB->m_v3Min);
+        p_Node->m_v3Max = max(p_Node->m_v3Max, p_AABB->m_v3Max);
+    }
+}
+
+void GL_SplitBVHNode(unsigned uiNode, unsigned uiDepth)
+{
+    BVHNodeData * p_Node = &gp_BVHNodes[uiNode];
+    GL_FitBVHNode(p_Node);
+    if ((p_Node->m_uiNumObjects <= g_uiBVHLeafObjects) || (uiDepth >= g_uiBVHMaxDepth))
+        return;
+
+    // Split along the longest axis of the object centres
+    vec3 v3CentreMin = vec3(FLT_MAX);
+    vec3 v3CentreMax = vec3(-FLT_MAX);
+    for (unsigned i = 0; i < p_Node->m_uiNumObjects; i++) {
+        const AABBData * p_AABB = &g_SceneData.mp_ObjectAABBs[gp_uiBVHObjects[p_Node->m_uiFirst + i]];
+        const vec3 v3Centre = (p_AABB->m_v3Min + p_AABB->m_v3Max) * 0.5f;
+        v3CentreMin = min(v3CentreMin, v3Centre);
+        v3CentreMax = max(v3CentreMax, v3Centre);
+    }
+    const vec3 v3CentreSize = v3CentreMax - v3CentreMin;
+    const unsigned uiAxis = (v3CentreSize.x > v3CentreSize.y) ? ((v3CentreSize.x > v3CentreSize.z) ? 0 : 2) : ((v3CentreSize.y > v3CentreSize.z) ? 1 : 2);
+    if (v3CentreSize[uiAxis] <= 0.0f)
+        return;
+
+    // Bin objects by their centre
+    vec3 v3BinMin[g_uiBVHBins];
+    vec3 v3BinMax[g_uiBVHBins];
+    unsigned uiBinCounts[g_uiBVHBins];
+    for (unsigned i = 0; i < g_uiBVHBins; i++) {
+        v3BinMin[i] = vec3(FLT_MAX);
+        v3BinMax[i] = vec3(-FLT_MAX);
+        uiBinCounts[i] = 0;
+    }
+    const float fBinScale = (float)g_uiBVHBins / v3CentreSize[uiAxis];
+    for (unsigned i = 0; i < p_Node->m_uiNumObjects; i++) {
+        const AABBData * p_AABB = &g_SceneData.mp_ObjectAABBs[gp_uiBVHObjects[p_Node->m_uiFirst + i]];
+        const float fCentre = (p_AABB->m_v3Min[uiAxis] + p_AABB->m_v3Max[uiAxis]) * 0.5f;
+        const unsigned uiBin = min((unsigned)((fCentre - v3CentreMin[uiAxis]) * fBinScale), g_uiBVHBins - 1);
+        v3BinMin[uiBin] = min(v3BinMin[uiBin], p_AABB->m_v3Min);
+        v3BinMax[uiBin] = max(v3BinMax[uiBin], p_AABB->m_v3Max);
+        ++uiBinCounts[uiBin];
+    }
+
+    // Sweep from the right to get the area and count on that side of each split
+    float fRightAreas[g_uiBVHBins];
+    unsigned uiRightCounts[g_uiBVHBins];
+    vec3 v3Min = vec3(FLT_MAX);
+    vec3 v3Max = vec3(-FLT_MAX);
+    unsigned uiCount = 0;
+    for (unsigned i = g_uiBVHBins - 1; i > 0; i--) {
+        v3Min = min(v3Min, v3BinMin[i]);
+        v3Max = max(v3Max, v3BinMax[i]);
+        uiCount += uiBinCounts[i];
+        fRightAreas[i] = GL_BVHSurfaceArea(v3Min, v3Max);
+        uiRightCounts[i] = uiCount;
+    }
+
+    // Sweep from the left finding the split with the lowest surface area heuristic cost
+    float fBestCost = FLT_MAX;
+    unsigned uiBestSplit = 0;
+    v3Min = vec3(FLT_MAX);
+    v3Max = vec3(-FLT_MAX);
+    uiCount = 0;
+    for (unsigned i = 1; i < g_uiBVHBins; i++) {
+        v3Min = min(v3Min, v3BinMin[i - 1]);
+        v3Max = max(v3Max, v3BinMax[i - 1]);
+        uiCount += uiBinCounts[i - 1];
+        if ((uiCount == 0) || (uiRightCounts[i] == 0))
+            continue;
+        const float fCost = (GL_BVHSurfaceArea(v3Min, v3Max) * (float)uiCount) + (fRightAreas[i] * (float)uiRightCounts[i]);
+        if (fCost < fBestCost) {
+            fBestCost = fCost;
+            uiBestSplit = i;
+        }
+    }
+
+    // Keep as a leaf if splitting costs more than testing every object
+    const float fNodeArea = GL_BVHSurfaceArea(p_Node->m_v3Min, p_Node->m_v3Max);
+    const float fLeafCost = fNodeArea * (float)p_Node->m_uiNumObjects;
+    if ((uiBestSplit == 0) || ((fNodeArea * g_fBVHTraversalCost) + fBestCost >= fLeafCost))
+        return;
+
+    // Partition the objects either side of the split
+    unsigned * p_uiObjects = &gp_uiBVHObjects[p_Node->m_uiFirst];
+    unsigned uiLeft = 0;
+    unsigned uiRight = p_Node->m_uiNumObjects;
+    while (uiLeft < uiRight) {
+        const AABBData * p_AABB = &g_SceneData.mp_ObjectAABBs[p_uiObjects[uiLeft]];
+        const float fCentre = (p_AABB->m_v3Min[uiAxis] + p_AABB->m_v3Max[uiAxis]) * 0.5f;
+        const unsigned uiBin = min((unsigned)((fCentre - v3CentreMin[uiAxis]) * fBinScale), g_uiBVHBins - 1);
+        if (uiBin < uiBestSplit)
+            ++uiLeft;
+        else {
+            const unsigned uiSwap = p_uiObjects[uiLeft];
+            p_uiObjects[uiLeft] = p_uiObjects[--uiRight];
+            p_uiObjects[uiRight] = uiSwap;
+        }
+    }
+
+    // Add both children after all existing nodes and split them in turn
+    const unsigned uiChild = g_uiNumBVHNodes;
+    g_uiNumBVHNodes += 2;
+    BVHNodeData * p_Left = &gp_BVHNodes[uiChild];
+    BVHNodeData * p_Right = &gp_BVHNodes[uiChild + 1];
+    p_Left->m_uiFirst = p_Node->m_uiFirst;
+    p_Left->m_uiNumObjects = uiLeft;
+    p_Right->m_uiFirst = p_Node->m_uiFirst + uiLeft;
+    p_Right->m_uiNumObjects = p_Node->m_uiNumObjects - uiLeft;
+    p_Node->m_uiFirst = uiChild;
+    p_Node->m_uiNumObjects = 0;
+    GL_SplitBVHNode(uiChild, uiDepth + 1);
+    GL_SplitBVHNode(uiChild + 1, uiDepth + 1);
+}
+
+void GL_QuitObjectBVH()
+{
+    free(gp_BVHNodes);
+    free(gp_uiBVHObjects);
+    free(gp_uiBVHVisible);
+    gp_BVHNodes = NULL;
+    gp_uiBVHObjects = NULL;
+    gp_uiBVHVisible = NULL;
+    g_uiNumBVHNodes = 0;
+    g_bBVHDirty = false;
+}
+
+bool GL_InitObjectBVH()
+{
+    GL_TRACE_ZONE("GL_InitObjectBVH");
+    GL_QuitObjectBVH();
+    const unsigned uiNumObjects = g_SceneData.m_uiNumObjects;
+    gp_uiBVHVisible = (unsigned *)malloc(max(uiNumObjects, 1u) * sizeof(unsigned));
+    if (!g_bObjectBVH || (uiNumObjects == 0))
+        return false;
+
+    // A binary tree with single object leaves is the most nodes that can be needed
+    gp_BVHNodes = (BVHNodeData *)malloc(((2 * uiNumObjects) - 1) * sizeof(BVHNodeData));
+    gp_uiBVHObjects = (unsigned *)malloc(uiNumObjects * sizeof(unsigned));
+    for (unsigned i = 0; i < uiNumObjects; i++) {
+        gp_uiBVHObjects[i] = i;
+    }
+
+    // Recursively split from a root containing every object
+    const Uint64 ui64Start = SDL_GetPerformanceCounter();
+    g_uiNumBVHNodes = 1;
+    gp_BVHNodes[0].m_uiFirst = 0;
+    gp_BVHNodes[0].m_uiNumObjects = uiNumObjects;
+    GL_SplitBVHNode(0, 0);
+    SDL_Log("Object BVH built %u nodes for %u objects in %.2fms\n", g_uiNumBVHNodes, uiNumObjects,
+            (double)(SDL_GetPerformanceCounter() - ui64Start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    return true;
+}
+
+void GL_InvalidateObjectBVH()
+{
+    // Object bounds have moved so the tree needs refitting before it is next used
+    g_bBVHDirty = true;
+}
+
+void GL_RefitObjectBVH()
+{
+    // Children always come after their parent so refit in reverse order
+    for (unsigned i = g_uiNumBVHNodes; i-- > 0;) {
+        BVHNodeData * p_Node = &gp_BVHNodes[i];
+        if (p_Node->m_uiNumObjects > 0)
+            GL_FitBVHNode(p_Node);
+        else {
+            const BVHNodeData * p_Left = &gp_BVHNodes[p_Node->m_uiFirst];
+            p_Node->m_v3Min = min(p_Left->m_v3Min, p_Left[1].m_v3Min);
+            p_Node->m_v3Max = max(p_Left->m_v3Max, p_Left[1].m_v3Max);
+        }
+    }
+    g_bBVHDirty = false;
+}
+
+const unsigned * GL_CullObjectBVH(unsigned char ucFlagMask, unsigned char ucFlags, unsigned & uiNumVisible)
+{
+    GL_TRACE_ZONE("GL_CullObjectBVH");
+    // Get every object whose flags match that is inside any of the current cluster views
+    uiNumVisible = 0;
+    unsigned uiNumInside = 0;
+    if ((gp_BVHNodes == NULL) || (g_uiNumClusterViews == 0)) {
+        // Test each object in turn when there is no tree or nothing to cull against
+        for (unsigned i = 0; i < g_SceneData.m_uiNumObjects; i++) {
+            if (!GL_CullObjectBounds(i))
+                continue;
+            ++uiNumInside;
+            if ((g_SceneData.mp_ucObjectFlags[i] & ucFlagMask) == ucFlags)
+                gp_uiBVHVisible[uiNumVisible++] = i;
+        }
+    } else {
+        if (g_bBVHDirty)
+            GL_RefitObjectBVH();
+
+        // Walk the tree skipping any node outside every view, and testing nothing below a node inside a view
+        unsigned uiStack[(g_uiBVHMaxDepth + 1) * 2];
+        bool bStackInside[(g_uiBVHMaxDepth + 1) * 2];
+        unsigned uiStackSize = 1;
+        uiStack[0] = 0;
+        bStackInside[0] = false;
+        while (uiStackSize > 0) {
+            --uiStackSize;
+            const BVHNodeData * p_Node = &gp_BVHNodes[uiStack[uiStackSize]];
+            bool bInside = bStackInside[uiStackSize];
+            if (!bInside && !GL_ClusterAABBVisible(p_Node->m_v3Min, p_Node->m_v3Max, bInside))
+                continue;
+
+            if (p_Node->m_uiNumObjects == 0) {
+                uiStack[uiStackSize] = p_Node->m_uiFirst;
+                bStackInside[uiStackSize++] = bInside;
+                uiStack[uiStackSize] = p_Node->m_uiFirst + 1;
+                bStackInside[uiStackSize++] = bInside;
+                continue;
+            }
+
+            // Check each object in the leaf
+            for (unsigned i = 0; i < p_Node->m_uiNumObjects; i++) {
+                const unsigned uiObject = gp_uiBVHObjects[p_Node->m_uiFirst + i];
+                if (!bInside && (p_Node->m_uiNumObjects > 1)) {
+                    bool bObjectInside;
+                    const AABBData * p_AABB = &g_SceneData.mp_ObjectAABBs[uiObject];
+                    if (!GL_ClusterAABBVisible(p_AABB->m_v3Min, p_AABB->m_v3Max, bObjectInside))
+                        continue;
+                }
+                ++uiNumInside;
+                if ((g_SceneData.mp_ucObjectFlags[uiObject] & ucFlagMask) == ucFlags)
+                    gp_uiBVHVisible[uiNumVisible++] = uiObject;
+            }
+        }
+    }
+    GL_CountClusterObjects(uiNumInside, g_SceneData.m_uiNumObjects - uiNumInside);
+    return gp_uiBVHVisible;
+}
\ No newline at end of file
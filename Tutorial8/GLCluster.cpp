@@ -0,0 +1,454 @@
+// Using GLM and math headers
+#include <math.h>
+#include <float.h>
+#include <glm/glm.hpp>
+// Using SDL
+#include <SDL2/SDL.h>
+
+#include <GLScene.h> //Need '<' to enforce loading of project local header
+
+//Main.cpp
+extern SceneData g_SceneData;
+
+struct ClusterViewData
+{
+    vec4 m_v4Planes[6];
+    vec3 m_v3Position;
+    // Pixels per world unit at distance one, or at any distance for orthographic views
+    float m_fPixelScale;
+    bool m_bOrthographic;
+    // Distance past which a light no longer reaches, unlimited for cameras
+    float m_fRange;
+};
+
+struct ClusterPassData
+{
+    const char * mp_cName;
+    Uint64 m_ui64Triangles;
+    Uint64 m_ui64ObjectsVisible;
+    Uint64 m_ui64ObjectsCulled;
+    unsigned m_uiNumPasses;
+};
+
+// Cluster culling views
+bool g_bClusterCulling = true;
+ClusterViewData * gp_ClusterViews = NULL;
+unsigned g_uiNumClusterViews = 0;
+unsigned g_uiMaxClusterViews = 0;
+float g_fClusterConeSign = 0.0f;
+// LOD selection, largest simplification error in pixels allowed before a more detailed level is used
+bool g_bMeshLODs = true;
+const float g_fLODPixelError = 1.0f;
+float g_fClusterLODBias = 1.0f;
+// Triangles submitted by each named pass
+const unsigned g_uiMaxClusterPasses = 8;
+ClusterPassData g_ClusterPasses[g_uiMaxClusterPasses];
+unsigned g_uiNumClusterPasses = 0;
+ClusterPassData * gp_ClusterPass = NULL;
+// Visible index ranges of the last culled object
+GLsizei * gp_ClusterCounts = NULL;
+const GLvoid ** gp_ClusterOffsets = NULL;
+GLint * gp_ClusterBaseVertices = NULL;
+unsigned g_uiNumClusterRanges = 0;
+unsigned g_uiMaxClusterRanges = 0;
+unsigned g_uiClusterRangeEnd = 0;
+// Culling statistics
+Uint64 g_ui64ClustersTested = 0;
+Uint64 g_ui64ClustersDrawn = 0;
+
+void GL_BeginClusterViews(const char * p_cPass, GLenum CullFace, float fLODBias)
+{
+    // Remove any previous views and set which faces are culled by the pipeline
+    g_uiNumClusterViews = 0;
+    g_fClusterConeSign = (CullFace == GL_BACK) ? 1.0f : ((CullFace == GL_FRONT) ? -1.0f : 0.0f);
+    g_fClusterLODBias = fLODBias;
+
+    // Find the statistics for this pass
+    gp_ClusterPass = NULL;
+    for (unsigned i = 0; (i < g_uiNumClusterPasses) && (gp_ClusterPass == NULL); i++) {
+        if (strcmp(g_ClusterPasses[i].mp_cName, p_cPass) == 0)
+            gp_ClusterPass = &g_ClusterPasses[i];
+    }
+    if ((gp_ClusterPass == NULL) && (g_uiNumClusterPasses < g_uiMaxClusterPasses)) {
+        gp_ClusterPass = &g_ClusterPasses[g_uiNumClusterPasses++];
+        gp_ClusterPass->mp_cName = p_cPass;
+        gp_ClusterPass->m_ui64Triangles = 0;
+        gp_ClusterPass->m_ui64ObjectsVisible = 0;
+        gp_ClusterPass->m_ui64ObjectsCulled = 0;
+        gp_ClusterPass->m_uiNumPasses = 0;
+    }
+    if (gp_ClusterPass != NULL)
+        ++gp_ClusterPass->m_uiNumPasses;
+}
+
+void GL_AddClusterView(const mat4 & m4ViewProjection, const vec3 & v3Position, unsigned uiHeight)
+{
+    // Increase view storage as needed
+    if (g_uiNumClusterViews >= g_uiMaxClusterViews) {
+        g_uiMaxClusterViews = max(g_uiMaxClusterViews * 2, 8u);
+        gp_ClusterViews = (ClusterViewData *)realloc(gp_ClusterViews, g_uiMaxClusterViews * sizeof(ClusterViewData));
+    }
+    ClusterViewData * p_View = &gp_ClusterViews[g_uiNumClusterViews];
+
+    // Extract normalised frustum planes from the view projection rows
+    for (unsigned i = 0; i < 3; i++) {
+        vec4 v4Row = vec4(m4ViewProjection[0][i], m4ViewProjection[1][i], m4ViewProjection[2][i], m4ViewProjection[3][i]);
+        vec4 v4RowW = vec4(m4ViewProjection[0][3], m4ViewProjection[1][3], m4ViewProjection[2][3], m4ViewProjection[3][3]);
+        p_View->m_v4Planes[i * 2] = v4RowW + v4Row;
+        p_View->m_v4Planes[(i * 2) + 1] = v4RowW - v4Row;
+    }
+    for (unsigned i = 0; i < 6; i++) {
+        p_View->m_v4Planes[i] = p_View->m_v4Planes[i] / length(vec3(p_View->m_v4Planes[i]));
+    }
+    p_View->m_v3Position = v3Position;
+
+    // Scale the projected height by the targets, orthographic views have no perspective divide
+    p_View->m_fPixelScale = length(vec3(m4ViewProjection[0][1], m4ViewProjection[1][1], m4ViewProjection[2][1])) * (float)uiHeight * 0.5f;
+    p_View->m_bOrthographic = (m4ViewProjection[0][3] == 0.0f) && (m4ViewProjection[1][3] == 0.0f) && (m4ViewProjection[2][3] == 0.0f);
+    p_View->m_fRange = FLT_MAX;
+    ++g_uiNumClusterViews;
+}
+
+void GL_AddClusterLightView(const mat4 & m4ViewProjection, const vec3 & v3Position, unsigned uiHeight, float fFalloff)
+{
+    // Light views also reject anything outside the lights falloff sphere
+    GL_AddClusterView(m4ViewProjection, v3Position, uiHeight);
+    gp_ClusterViews[g_uiNumClusterViews - 1].m_fRange = fFalloff;
+}
+
+void GL_EndClusterViews()
+{
+    // Stop culling so objects are drawn whole
+    g_uiNumClusterViews = 0;
+    gp_ClusterPass = NULL;
+}
+
+bool GL_ClusterSphereVisible(const vec3 & v3Centre, float fRadius)
+{
+    // Check bounding sphere against each views frustum
+    for (unsigned i = 0; i < g_uiNumClusterViews; i++) {
+        const ClusterViewData * p_View = &gp_ClusterViews[i];
+        bool bInside = true;
+        for (unsigned j = 0; (j < 6) && bInside; j++) {
+            bInside = (dot(vec3(p_View->m_v4Planes[j]), v3Centre) + p_View->m_v4Planes[j].w >= -fRadius);
+        }
+        if (bInside)
+            return true;
+    }
+    return false;
+}
+
+bool GL_ClusterAABBVisible(const vec3 & v3Min, const vec3 & v3Max, bool & bInside)
+{
+    // Check bounding box against each views frustum, also finding if it is completely inside any view
+    bool bVisible = false;
+    bInside = false;
+    for (unsigned i = 0; (i < g_uiNumClusterViews) && !bInside; i++) {
+        const ClusterViewData * p_View = &gp_ClusterViews[i];
+        bool bViewVisible = true;
+        bool bViewInside = true;
+        for (unsigned j = 0; (j < 6) && bViewVisible; j++) {
+            // Test the corners furthest along and against the planes normal
+            const vec4 & v4Plane = p_View->m_v4Planes[j];
+            const vec3 v3Far = vec3((v4Plane.x >= 0.0f) ? v3Max.x : v3Min.x, (v4Plane.y >= 0.0f) ? v3Max.y : v3Min.y,
+                (v4Plane.z >= 0.0f) ? v3Max.z : v3Min.z);
+            const vec3 v3Near = vec3((v4Plane.x >= 0.0f) ? v3Min.x : v3Max.x, (v4Plane.y >= 0.0f) ? v3Min.y : v3Max.y,
+                (v4Plane.z >= 0.0f) ? v3Min.z : v3Max.z);
+            bViewVisible = (dot(vec3(v4Plane), v3Far) + v4Plane.w >= 0.0f);
+            bViewInside = bViewInside && (dot(vec3(v4Plane), v3Near) + v4Plane.w >= 0.0f);
+        }
+        bVisible = bVisible || bViewVisible;
+        bInside = bViewVisible && bViewInside;
+    }
+    return bVisible;
+}
+
+void GL_CountClusterObjects(unsigned uiVisible, unsigned uiCulled)
+{
+    // Count objects kept and removed by object culling for the current pass
+    if (gp_ClusterPass != NULL) {
+        gp_ClusterPass->m_ui64ObjectsVisible += uiVisible;
+        gp_ClusterPass->m_ui64ObjectsCulled += uiCulled;
+    }
+}
+
+unsigned GL_GetClusterViewMask(unsigned uiObject)
+{
+    // Set a bit for each of the first 32 views the objects bounds reach, all views without any
+    if (g_uiNumClusterViews == 0)
+        return ~0u;
+    const vec4 & v4Bounds = g_SceneData.mp_ObjectBounds[uiObject];
+    const vec3 v3Centre = vec3(v4Bounds);
+    unsigned uiMask = 0;
+    for (unsigned i = 0; i < min(g_uiNumClusterViews, 32u); i++) {
+        const ClusterViewData * p_View = &gp_ClusterViews[i];
+        bool bInside = (length(v3Centre - p_View->m_v3Position) - v4Bounds.w <= p_View->m_fRange);
+        for (unsigned j = 0; (j < 6) && bInside; j++) {
+            bInside = (dot(vec3(p_View->m_v4Planes[j]), v3Centre) + p_View->m_v4Planes[j].w >= -v4Bounds.w);
+        }
+        if (bInside)
+            uiMask |= 1u << i;
+    }
+    return uiMask;
+}
+
+bool GL_CullObjectBounds(unsigned uiObject)
+{
+    // Check the objects world space bounds, everything is visible without views
+    if (g_uiNumClusterViews == 0)
+        return true;
+    const vec4 & v4Bounds = g_SceneData.mp_ObjectBounds[uiObject];
+    return GL_ClusterSphereVisible(vec3(v4Bounds), v4Bounds.w);
+}
+
+vec3 GL_GetClusterViewPosition()
+{
+    // Use the first view to order objects by distance
+    return (g_uiNumClusterViews > 0) ? gp_ClusterViews[0].m_v3Position : vec3(0.0f);
+}
+
+unsigned GL_WriteClusterViews(vec4 * p_v4Views)
+{
+    // Write each views planes followed by its position and pixel scale then its range and if it is orthographic, NULL just gets the count
+    for (unsigned i = 0; (p_v4Views != NULL) && (i < g_uiNumClusterViews); i++) {
+        const ClusterViewData * p_View = &gp_ClusterViews[i];
+        for (unsigned j = 0; j < 6; j++) {
+            p_v4Views[(i * 8) + j] = p_View->m_v4Planes[j];
+        }
+        p_v4Views[(i * 8) + 6] = vec4(p_View->m_v3Position, p_View->m_fPixelScale);
+        p_v4Views[(i * 8) + 7] = vec4(p_View->m_fRange, (p_View->m_bOrthographic) ? 1.0f : 0.0f, 0.0f, 0.0f);
+    }
+    return g_uiNumClusterViews;
+}
+
+float GL_GetClusterLODPixelError()
+{
+    // Zero keeps full detail
+    return (g_bMeshLODs) ? g_fLODPixelError * g_fClusterLODBias : 0.0f;
+}
+
+float GL_ClusterPixelScale(const vec3 & v3Centre, float fRadius)
+{
+    // Find pixels per world unit at the closest point of the bounds, using whichever view sees it largest
+    float fPixelScale = 0.0f;
+    for (unsigned i = 0; i < g_uiNumClusterViews; i++) {
+        const ClusterViewData * p_View = &gp_ClusterViews[i];
+        if (p_View->m_bOrthographic) {
+            fPixelScale = max(fPixelScale, p_View->m_fPixelScale);
+            continue;
+        }
+        float fDistance = max(length(v3Centre - p_View->m_v3Position) - fRadius, 0.0001f);
+        fPixelScale = max(fPixelScale, p_View->m_fPixelScale / fDistance);
+    }
+    return fPixelScale;
+}
+
+float GL_GetObjectPixelSize(unsigned uiObject)
+{
+    // Get projected diameter of the objects bounds in the current views
+    const vec4 & v4Bounds = g_SceneData.mp_ObjectBounds[uiObject];
+    return 2.0f * v4Bounds.w * GL_ClusterPixelScale(vec3(v4Bounds), v4Bounds.w);
+}
+
+unsigned GL_SelectObjectLOD(const MeshData * p_Mesh, const vec3 & v3Centre, float fRadius, float fScale)
+{
+    if (!g_bMeshLODs || (p_Mesh->m_uiNumLODs <= 1))
+        return 0;
+    const float fPixelScale = GL_ClusterPixelScale(v3Centre, fRadius);
+
+    // Use the coarsest level whose error stays below the allowed size on screen
+    const float fMaxError = g_fLODPixelError * g_fClusterLODBias / (fPixelScale * fScale);
+    for (unsigned i = p_Mesh->m_uiNumLODs - 1; i > 0; i--) {
+        if (p_Mesh->m_LODs[i].m_fError <= fMaxError)
+            return i;
+    }
+    return 0;
+}
+
+void GL_AddClusterRange(const ObjectDrawData * p_Draw, unsigned uiFirstIndex, unsigned uiNumIndices)
+{
+    // Merge with previous range if contiguous
+    if ((g_uiNumClusterRanges > 0) && (uiFirstIndex == g_uiClusterRangeEnd)) {
+        gp_ClusterCounts[g_uiNumClusterRanges - 1] += uiNumIndices;
+    } else {
+        gp_ClusterCounts[g_uiNumClusterRanges] = uiNumIndices;
+        gp_ClusterOffsets[g_uiNumClusterRanges] = (const GLvoid *)(uiFirstIndex * sizeof(GLuint));
+        gp_ClusterBaseVertices[g_uiNumClusterRanges] = p_Draw->m_iBaseVertex;
+        ++g_uiNumClusterRanges;
+    }
+    g_uiClusterRangeEnd = uiFirstIndex + uiNumIndices;
+}
+
+bool GL_CullObjectClusters(unsigned uiObject)
+{
+    // Increase range storage as needed
+    const ObjectDrawData * p_Draw = &g_SceneData.mp_ObjectDraws[uiObject];
+    const unsigned uiNumMeshlets = max(p_Draw->m_uiNumMeshlets, 1u);
+    if (uiNumMeshlets > g_uiMaxClusterRanges) {
+        g_uiMaxClusterRanges = max(uiNumMeshlets, g_uiMaxClusterRanges * 2);
+        gp_ClusterCounts = (GLsizei *)realloc(gp_ClusterCounts, g_uiMaxClusterRanges * sizeof(GLsizei));
+        gp_ClusterOffsets = (const GLvoid **)realloc(gp_ClusterOffsets, g_uiMaxClusterRanges * sizeof(const GLvoid *));
+        gp_ClusterBaseVertices = (GLint *)realloc(gp_ClusterBaseVertices, g_uiMaxClusterRanges * sizeof(GLint));
+    }
+    g_uiNumClusterRanges = 0;
+
+    // Draw the whole object if there is nothing to cull against
+    if (g_uiNumClusterViews == 0) {
+        GL_AddClusterRange(p_Draw, p_Draw->m_uiFirstIndex, p_Draw->m_uiNumIndices);
+        return true;
+    }
+
+    // Check the whole object first using its world space bounds
+    const vec4 & v4Bounds = g_SceneData.mp_ObjectBounds[uiObject];
+    const vec3 v3ObjectCentre = vec3(v4Bounds);
+    const float fObjectRadius = v4Bounds.w;
+    if (!GL_ClusterSphereVisible(v3ObjectCentre, fObjectRadius))
+        return false;
+
+    // Get scale to move mesh bounds into world space
+    const MeshData * p_Mesh = &g_SceneData.mp_Meshes[p_Draw->m_uiMesh];
+    const float fScale = (p_Mesh->m_v4Sphere.w > 0.0f) ? fObjectRadius / p_Mesh->m_v4Sphere.w : 1.0f;
+
+    // Simplified levels have no meshlets so are drawn whole
+    const unsigned uiLOD = GL_SelectObjectLOD(p_Mesh, v3ObjectCentre, fObjectRadius, fScale);
+    if ((uiLOD > 0) || !g_bClusterCulling || (p_Draw->m_uiNumMeshlets == 0)) {
+        GL_AddClusterRange(p_Draw, p_Mesh->m_LODs[uiLOD].m_uiFirstIndex, p_Mesh->m_LODs[uiLOD].m_uiNumIndices);
+        return true;
+    }
+
+    // Get normal matrix to move cones into world space
+    const mat4 & m4Transform = g_SceneData.mp_ObjectTransforms[uiObject];
+    const mat3 m3Normal = transpose(inverse(mat3(m4Transform)));
+
+    // Loop through each meshlet
+    for (unsigned i = 0; i < p_Draw->m_uiNumMeshlets; i++) {
+        const MeshletData * p_Meshlet = &g_SceneData.mp_Meshlets[p_Draw->m_uiFirstMeshlet + i];
+        vec3 v3Centre = vec3(m4Transform * vec4(vec3(p_Meshlet->m_v4Sphere), 1.0f));
+        float fRadius = p_Meshlet->m_v4Sphere.w * fScale;
+        float fCutoff = p_Meshlet->m_v4Cone.w;
+        bool bCone = (g_fClusterConeSign != 0.0f) && (fCutoff < 1.0f);
+        vec3 v3Axis = (bCone) ? normalize(m3Normal * vec3(p_Meshlet->m_v4Cone)) * g_fClusterConeSign : vec3(0.0f);
+
+        // Check if visible in any view
+        bool bVisible = false;
+        for (unsigned j = 0; (j < g_uiNumClusterViews) && !bVisible; j++) {
+            const ClusterViewData * p_View = &gp_ClusterViews[j];
+
+            // Check bounding sphere against frustum
+            bool bInside = true;
+            for (unsigned k = 0; (k < 6) && bInside; k++) {
+                bInside = (dot(vec3(p_View->m_v4Planes[k]), v3Centre) + p_View->m_v4Planes[k].w >= -fRadius);
+            }
+            if (!bInside)
+                continue;
+
+            // Check if every triangle faces the culled direction
+            if (bCone) {
+                vec3 v3View = v3Centre - p_View->m_v3Position;
+                if (dot(v3View, v3Axis) >= (fCutoff * length(v3View)) + fRadius)
+                    continue;
+            }
+            bVisible = true;
+        }
+
+        // Add to list of ranges to draw
+        if (bVisible) {
+            GL_AddClusterRange(p_Draw, p_Meshlet->m_uiFirstIndex, p_Meshlet->m_uiNumIndices);
+            ++g_ui64ClustersDrawn;
+        }
+    }
+    g_ui64ClustersTested += p_Draw->m_uiNumMeshlets;
+    return (g_uiNumClusterRanges > 0);
+}
+
+void GL_CountClusterTriangles()
+{
+    // Count submitted triangles for the current pass
+    if (gp_ClusterPass != NULL) {
+        for (unsigned i = 0; i < g_uiNumClusterRanges; i++) {
+            gp_ClusterPass->m_ui64Triangles += (Uint64)(gp_ClusterCounts[i] / 3);
+        }
+    }
+}
+
+void GL_DrawObjectClusters(GLenum Mode, unsigned uiObject)
+{
+    GL_CountClusterTriangles();
+
+    // Draw all visible ranges of the last culled object
+    if (g_uiNumClusterRanges == 1)
+        glDrawElementsBaseVertex(Mode, gp_ClusterCounts[0], GL_UNSIGNED_INT, gp_ClusterOffsets[0], g_SceneData.mp_ObjectDraws[uiObject].m_iBaseVertex);
+    else if (g_uiNumClusterRanges > 1)
+        glMultiDrawElementsBaseVertex(Mode, gp_ClusterCounts, GL_UNSIGNED_INT, gp_ClusterOffsets, g_uiNumClusterRanges, gp_ClusterBaseVertices);
+}
+
+unsigned GL_GetNumClusterRanges()
+{
+    return g_uiNumClusterRanges;
+}
+
+unsigned GL_GetNumClusterTriangles()
+{
+    // Count triangles in the visible ranges of the last culled object
+    unsigned uiTriangles = 0;
+    for (unsigned i = 0; i < g_uiNumClusterRanges; i++) {
+        uiTriangles += (unsigned)(gp_ClusterCounts[i] / 3);
+    }
+    return uiTriangles;
+}
+
+unsigned GL_GetObjectLODTriangles(unsigned uiObject)
+{
+    // Count triangles in the level selected for the whole object, as drawn without meshlet culling
+    const ObjectDrawData * p_Draw = &g_SceneData.mp_ObjectDraws[uiObject];
+    const MeshData * p_Mesh = &g_SceneData.mp_Meshes[p_Draw->m_uiMesh];
+    const vec4 & v4Bounds = g_SceneData.mp_ObjectBounds[uiObject];
+    const float fScale = (p_Mesh->m_v4Sphere.w > 0.0f) ? v4Bounds.w / p_Mesh->m_v4Sphere.w : 1.0f;
+    const unsigned uiLOD = GL_SelectObjectLOD(p_Mesh, vec3(v4Bounds), v4Bounds.w, fScale);
+    return p_Mesh->m_LODs[uiLOD].m_uiNumIndices / 3;
+}
+
+unsigned GL_WriteObjectClusterCommands(DrawIndirectData * p_Commands, unsigned uiBaseInstance)
+{
+    GL_CountClusterTriangles();
+
+    // Write an indirect draw for each visible range of the last culled object
+    for (unsigned i = 0; i < g_uiNumClusterRanges; i++) {
+        p_Commands[i].m_uiCount = (GLuint)gp_ClusterCounts[i];
+        p_Commands[i].m_uiInstanceCount = 1;
+        p_Commands[i].m_uiFirstIndex = (GLuint)((uintptr_t)gp_ClusterOffsets[i] / sizeof(GLuint));
+        p_Commands[i].m_iBaseVertex = gp_ClusterBaseVertices[i];
+        p_Commands[i].m_uiBaseInstance = uiBaseInstance + i;
+    }
+    return g_uiNumClusterRanges;
+}
+
+void GL_QuitClusters()
+{
+    // Output how effective culling was
+    if (g_ui64ClustersTested > 0)
+        SDL_Log("Cluster culling drew %.1f%% of %llu tested clusters\n", (double)g_ui64ClustersDrawn * 100.0 / (double)g_ui64ClustersTested,
+                (unsigned long long)g_ui64ClustersTested);
+    for (unsigned i = 0; i < g_uiNumClusterPasses; i++) {
+        const ClusterPassData * p_Pass = &g_ClusterPasses[i];
+        const double dNumPasses = (double)max(p_Pass->m_uiNumPasses, 1u);
+        SDL_Log("%s pass submitted %.0f triangles on average over %u passes\n", p_Pass->mp_cName,
+                (double)p_Pass->m_ui64Triangles / dNumPasses, p_Pass->m_uiNumPasses);
+        if ((p_Pass->m_ui64ObjectsVisible + p_Pass->m_ui64ObjectsCulled) > 0)
+            SDL_Log("%s pass kept %.0f objects and culled %.0f on average\n", p_Pass->mp_cName,
+                    (double)p_Pass->m_ui64ObjectsVisible / dNumPasses, (double)p_Pass->m_ui64ObjectsCulled / dNumPasses);
+    }
+    g_uiNumClusterPasses = 0;
+
+    // Release view and range storage
+    free(gp_ClusterViews);
+    free(gp_ClusterCounts);
+    free(gp_ClusterOffsets);
+    free(gp_ClusterBaseVertices);
+    gp_ClusterViews = NULL;
+    gp_ClusterCounts = NULL;
+    gp_ClusterOffsets = NULL;
+    gp_ClusterBaseVertices = NULL;
+    g_uiMaxClusterViews = 0;
+    g_uiMaxClusterRanges = 0;
+}
\ No newline at end of file
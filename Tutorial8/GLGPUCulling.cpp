@@ -0,0 +1,350 @@
+// Using SDL, GLEW
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
+
+//Main.cpp
+extern SceneData g_SceneData;
+//Shader.cpp
+extern bool GL_LoadComputeProgram(GLuint & uiProgram, const char * p_cFileName, int iFileID);
+//Cluster.cpp
+extern unsigned GL_WriteClusterViews(vec4 * p_v4Views);
+extern float GL_GetClusterLODPixelError();
+
+// Per object draw data read by the cull shader, must match its std430 layout
+struct GPUCullDrawData
+{
+    GLuint m_uiLODFirstIndex[g_uiMaxMeshLODs];
+    GLuint m_uiLODNumIndices[g_uiMaxMeshLODs];
+    float m_fLODError[g_uiMaxMeshLODs];
+    GLint m_iBaseVertex;
+    GLuint m_uiNumLODs;
+    GLuint m_uiObject;
+    GLuint m_uiTransformIndex;
+};
+
+// Culled draws are kept in one section per pass so passes can be in flight together, the camera section is split into state buckets
+const unsigned g_uiGPUCullSections = 3;
+const unsigned g_uiGPUCullCameraSection = 2;
+// Visible counts of each section are followed by the drawn and possible light layers of each section, then the visible counts of each bucket
+const unsigned g_uiGPUCullFirstLayerCount = g_uiGPUCullSections;
+const unsigned g_uiGPUCullFirstBucketCount = g_uiGPUCullFirstLayerCount + (g_uiGPUCullSections * 2);
+const unsigned g_uiGPUCullGroupSize = 64;
+const unsigned g_uiGPUCullViewSize = 8 * sizeof(vec4);
+
+// Compute culling of opaque objects into indirect draws
+bool g_bGPUCulling = true;
+GLuint g_uiGPUCullProgram = 0;
+GLuint g_uiGPUCullBoundsSSBO = 0;
+GLuint g_uiGPUCullAABBSSBO = 0;
+GLuint g_uiGPUCullDrawSSBO = 0;
+GLuint g_uiGPUCullViewSSBO = 0;
+GLuint g_uiGPUCullCommandBuffer = 0;
+GLuint g_uiGPUCullDrawIndexBuffer = 0;
+GLuint g_uiGPUCullVisibleBuffer = 0;
+GLuint g_uiGPUCullBucketSSBO = 0;
+unsigned g_uiGPUCullDraws = 0;
+unsigned g_uiGPUCullMaxViews = 0;
+vec4 * gp_v4GPUCullViews = NULL;
+// Draw of each object in the camera section, -1 for transparent objects
+int * gp_iGPUCullObjectDraws = NULL;
+// First command and bucket of each draw in the camera section, runs of queued objects sharing state are drawn as one bucket
+GLuint * gp_uiGPUCullDrawBuckets = NULL;
+unsigned * gp_uiGPUCullBucketObjects = NULL;
+unsigned * gp_uiGPUCullBucketSizes = NULL;
+unsigned g_uiGPUCullBuckets = 0;
+unsigned g_uiGPUCullBucketed = 0;
+// Culling statistics
+Uint64 g_ui64GPUCullTested = 0;
+Uint64 g_ui64GPUCullBucketDraws = 0;
+unsigned g_uiGPUCullPasses = 0;
+
+bool GL_InitGPUCulling()
+{
+    if (!g_bGPUCulling || (g_SceneData.m_uiNumOpaqueObjects == 0)) {
+        g_bGPUCulling = false;
+        return false;
+    }
+
+    // Load cull shader, falling back to CPU culling on failure
+    if (!GL_LoadComputeProgram(g_uiGPUCullProgram, "CullObjectsComp.glsl", 2300)) {
+        g_bGPUCulling = false;
+        return false;
+    }
+
+    // Gather the draw of every LOD of each opaque object
+    g_uiGPUCullDraws = g_SceneData.m_uiNumOpaqueObjects;
+    GPUCullDrawData * p_Draws = (GPUCullDrawData *)malloc(g_uiGPUCullDraws * sizeof(GPUCullDrawData));
+    gp_iGPUCullObjectDraws = (int *)malloc(g_SceneData.m_uiNumObjects * sizeof(int));
+    memset(gp_iGPUCullObjectDraws, 0xFF, g_SceneData.m_uiNumObjects * sizeof(int));
+    for (unsigned i = 0; i < g_uiGPUCullDraws; i++) {
+        const unsigned uiObject = g_SceneData.mp_uiOpaqueObjects[i];
+        gp_iGPUCullObjectDraws[uiObject] = (int)i;
+        const ObjectDrawData * p_Draw = &g_SceneData.mp_ObjectDraws[uiObject];
+        const MeshData * p_Mesh = &g_SceneData.mp_Meshes[p_Draw->m_uiMesh];
+        GPUCullDrawData * p_CullDraw = &p_Draws[i];
+        memset(p_CullDraw, 0, sizeof(GPUCullDrawData));
+        p_CullDraw->m_uiLODFirstIndex[0] = p_Draw->m_uiFirstIndex;
+        p_CullDraw->m_uiLODNumIndices[0] = p_Draw->m_uiNumIndices;
+        p_CullDraw->m_uiNumLODs = SDL_max(SDL_min(p_Mesh->m_uiNumLODs, g_uiMaxMeshLODs), 1u);
+        for (unsigned j = 1; j < p_CullDraw->m_uiNumLODs; j++) {
+            // Error is stored relative to the mesh bounds so it scales with the objects world bounds
+            p_CullDraw->m_uiLODFirstIndex[j] = p_Mesh->m_LODs[j].m_uiFirstIndex;
+            p_CullDraw->m_uiLODNumIndices[j] = p_Mesh->m_LODs[j].m_uiNumIndices;
+            p_CullDraw->m_fLODError[j] = (p_Mesh->m_v4Sphere.w > 0.0f) ? p_Mesh->m_LODs[j].m_fError / p_Mesh->m_v4Sphere.w : p_Mesh->m_LODs[j].m_fError;
+        }
+        p_CullDraw->m_iBaseVertex = p_Draw->m_iBaseVertex;
+        p_CullDraw->m_uiObject = uiObject;
+        p_CullDraw->m_uiTransformIndex = p_Draw->m_uiTransformOffset / sizeof(mat4);
+    }
+
+    // Create object SSBOs, bounds are refreshed before each cull
+    glGenBuffers(1, &g_uiGPUCullDrawSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullDrawSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullDraws * sizeof(GPUCullDrawData), p_Draws, GL_STATIC_DRAW);
+    free(p_Draws);
+    glGenBuffers(1, &g_uiGPUCullBoundsSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullBoundsSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, g_SceneData.m_uiNumObjects * sizeof(vec4), NULL, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &g_uiGPUCullAABBSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullAABBSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, g_SceneData.m_uiNumObjects * sizeof(AABBData), NULL, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &g_uiGPUCullViewSSBO);
+    glGenBuffers(1, &g_uiGPUCullBucketSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullBucketSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullDraws * 2 * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+    gp_uiGPUCullDrawBuckets = (GLuint *)malloc(g_uiGPUCullDraws * 2 * sizeof(GLuint));
+    gp_uiGPUCullBucketObjects = (unsigned *)malloc(g_uiGPUCullDraws * sizeof(unsigned));
+    gp_uiGPUCullBucketSizes = (unsigned *)malloc(g_uiGPUCullDraws * sizeof(unsigned));
+
+    // Create output buffers with room for every object in each section
+    glGenBuffers(1, &g_uiGPUCullCommandBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullCommandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullSections * g_uiGPUCullDraws * sizeof(DrawIndirectData), NULL, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &g_uiGPUCullDrawIndexBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullDrawIndexBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullSections * g_uiGPUCullDraws * 2 * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &g_uiGPUCullVisibleBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullVisibleBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (g_uiGPUCullFirstBucketCount + g_uiGPUCullDraws) * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    return true;
+}
+
+void GL_CullObjectsGPU(unsigned uiSection, GLuint uiLayerMask)
+{
+    GL_TRACE_ZONE("GL_CullObjectsGPU");
+    // Upload the current cluster views
+    const unsigned uiNumViews = GL_WriteClusterViews(NULL);
+    if (uiNumViews > g_uiGPUCullMaxViews) {
+        g_uiGPUCullMaxViews = SDL_max(uiNumViews, g_uiGPUCullMaxViews * 2);
+        gp_v4GPUCullViews = (vec4 *)realloc(gp_v4GPUCullViews, g_uiGPUCullMaxViews * g_uiGPUCullViewSize);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullViewSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullMaxViews * g_uiGPUCullViewSize, NULL, GL_DYNAMIC_DRAW);
+    }
+    GL_WriteClusterViews(gp_v4GPUCullViews);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullViewSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, uiNumViews * g_uiGPUCullViewSize, gp_v4GPUCullViews);
+
+    // Upload the world bounds of every object as they may have moved, boxes are tested and spheres scale the LOD error
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullBoundsSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, g_SceneData.m_uiNumObjects * sizeof(vec4), g_SceneData.mp_ObjectBounds);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullAABBSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, g_SceneData.m_uiNumObjects * sizeof(AABBData), g_SceneData.mp_ObjectAABBs);
+
+    // Clear the sections draws so the unused entries draw nothing, and its visible count
+    const GLintptr iFirstCommand = uiSection * g_uiGPUCullDraws;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullCommandBuffer);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, iFirstCommand * sizeof(DrawIndirectData), g_uiGPUCullDraws * sizeof(DrawIndirectData),
+                         GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullVisibleBuffer);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, uiSection * sizeof(GLuint), sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    const bool bBuckets = (uiSection == g_uiGPUCullCameraSection);
+    if (bBuckets && (g_uiGPUCullBuckets > 0)) {
+        glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, g_uiGPUCullFirstBucketCount * sizeof(GLuint), g_uiGPUCullBuckets * sizeof(GLuint),
+                             GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    }
+
+    // Cull each object against every view
+    glUseProgram(g_uiGPUCullProgram);
+    glUniform1ui(0, g_uiGPUCullDraws);
+    glUniform1ui(1, uiNumViews);
+    glUniform1ui(2, uiSection);
+    glUniform1ui(3, (GLuint)iFirstCommand);
+    glUniform1f(4, GL_GetClusterLODPixelError());
+    glUniform1i(5, bBuckets);
+    glUniform1ui(6, g_uiGPUCullFirstBucketCount);
+    glUniform1ui(7, uiLayerMask);
+    glUniform1ui(8, g_uiGPUCullFirstLayerCount);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, g_uiGPUCullBoundsSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, g_uiGPUCullDrawSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, g_uiGPUCullViewSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, g_uiGPUCullCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, g_uiGPUCullDrawIndexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, g_uiGPUCullVisibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, g_uiGPUCullAABBSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, g_uiGPUCullBucketSSBO);
+    glDispatchCompute((g_uiGPUCullDraws + g_uiGPUCullGroupSize - 1) / g_uiGPUCullGroupSize, 1, 1);
+
+    // Make the written draws visible to indirect draws and vertex fetch
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    g_ui64GPUCullTested += g_uiGPUCullDraws;
+    ++g_uiGPUCullPasses;
+}
+
+void GL_DrawCulledObjectsGPU(GLenum Mode, unsigned uiSection)
+{
+    // Bind the shared scene VAO with this passes draw indices and view masks and all object transforms
+    glBindVertexArray(g_SceneData.m_uiVAO);
+    glBindVertexBuffer(4, g_uiGPUCullDrawIndexBuffer, 0, 2 * sizeof(GLuint));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_SceneData.m_uiTransformUBO);
+
+    // Draw the visible objects, without a GPU draw count the cleared entries are empty draws
+    const GLvoid * p_Offset = (const GLvoid *)(uiSection * g_uiGPUCullDraws * sizeof(DrawIndirectData));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_uiGPUCullCommandBuffer);
+    if (GLEW_ARB_indirect_parameters) {
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, g_uiGPUCullVisibleBuffer);
+        glMultiDrawElementsIndirectCountARB(Mode, GL_UNSIGNED_INT, p_Offset, uiSection * sizeof(GLuint), g_uiGPUCullDraws, 0);
+    } else
+        glMultiDrawElementsIndirect(Mode, GL_UNSIGNED_INT, p_Offset, g_uiGPUCullDraws, 0);
+}
+
+bool GL_BeginObjectBucketsGPU()
+{
+    // Start grouping the sorted camera queue, draws not added to a bucket are skipped by the cull
+    if (!g_bGPUCulling || (GL_WriteClusterViews(NULL) == 0))
+        return false;
+    memset(gp_uiGPUCullDrawBuckets, 0xFF, g_uiGPUCullDraws * 2 * sizeof(GLuint));
+    g_uiGPUCullBuckets = 0;
+    g_uiGPUCullBucketed = 0;
+    return true;
+}
+
+void GL_AddObjectBucketGPU(unsigned uiObject, bool bNewBucket)
+{
+    // Objects are added in draw order so each bucket is a contiguous run of commands
+    if (bNewBucket || (g_uiGPUCullBuckets == 0)) {
+        gp_uiGPUCullBucketObjects[g_uiGPUCullBuckets] = uiObject;
+        gp_uiGPUCullBucketSizes[g_uiGPUCullBuckets] = 0;
+        ++g_uiGPUCullBuckets;
+    }
+    GLuint * p_uiBucket = &gp_uiGPUCullDrawBuckets[gp_iGPUCullObjectDraws[uiObject] * 2];
+    p_uiBucket[0] = g_uiGPUCullBucketed - gp_uiGPUCullBucketSizes[g_uiGPUCullBuckets - 1];
+    p_uiBucket[1] = g_uiGPUCullBuckets - 1;
+    ++gp_uiGPUCullBucketSizes[g_uiGPUCullBuckets - 1];
+    ++g_uiGPUCullBucketed;
+}
+
+void GL_CullCameraObjectsGPU()
+{
+    // Cull the bucketed objects against the current views into their buckets draws, keeping the callers program
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullBucketSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, g_uiGPUCullDraws * 2 * sizeof(GLuint), gp_uiGPUCullDrawBuckets);
+    GLint iProgram;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &iProgram);
+    GL_CullObjectsGPU(g_uiGPUCullCameraSection, 0);
+    glUseProgram((GLuint)iProgram);
+}
+
+bool GL_HasObjectDrawGPU(unsigned uiObject)
+{
+    return (gp_iGPUCullObjectDraws != NULL) && (gp_iGPUCullObjectDraws[uiObject] >= 0);
+}
+
+bool GL_IsObjectBucketStartGPU(unsigned uiObject)
+{
+    // Only the first object of a bucket draws, the rest are drawn with it
+    const unsigned uiBucket = gp_uiGPUCullDrawBuckets[gp_iGPUCullObjectDraws[uiObject] * 2 + 1];
+    return (uiBucket < g_uiGPUCullBuckets) && (gp_uiGPUCullBucketObjects[uiBucket] == uiObject);
+}
+
+void GL_DrawObjectBucketGPU(GLenum Mode, unsigned uiObject)
+{
+    // Bind this passes draw indices and all object transforms for the vertex shader
+    const GLuint * p_uiBucket = &gp_uiGPUCullDrawBuckets[gp_iGPUCullObjectDraws[uiObject] * 2];
+    glBindVertexBuffer(4, g_uiGPUCullDrawIndexBuffer, 0, 2 * sizeof(GLuint));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_SceneData.m_uiTransformUBO);
+
+    // Draw the buckets visible objects, without a GPU draw count the cleared entries after them are empty draws
+    const unsigned uiCommand = (g_uiGPUCullCameraSection * g_uiGPUCullDraws) + p_uiBucket[0];
+    const GLvoid * p_Offset = (const GLvoid *)(uiCommand * sizeof(DrawIndirectData));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_uiGPUCullCommandBuffer);
+    if (GLEW_ARB_indirect_parameters) {
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, g_uiGPUCullVisibleBuffer);
+        glMultiDrawElementsIndirectCountARB(Mode, GL_UNSIGNED_INT, p_Offset, (g_uiGPUCullFirstBucketCount + p_uiBucket[1]) * sizeof(GLuint),
+                                            gp_uiGPUCullBucketSizes[p_uiBucket[1]], 0);
+    } else
+        glMultiDrawElementsIndirect(Mode, GL_UNSIGNED_INT, p_Offset, gp_uiGPUCullBucketSizes[p_uiBucket[1]], 0);
+    ++g_ui64GPUCullBucketDraws;
+}
+
+unsigned GL_GetGPUVisibleObjects(unsigned uiSection)
+{
+    // Reading back waits for the GPU so this is only for statistics
+    GLuint uiVisible = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullVisibleBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, uiSection * sizeof(GLuint), sizeof(GLuint), &uiVisible);
+    return uiVisible;
+}
+
+void GL_GetGPUCullLayers(unsigned uiSection, Uint64 & ui64Drawn, Uint64 & ui64Total)
+{
+    // Light layers are counted over every pass, reading back waits for the GPU so this is only for statistics
+    GLuint uiLayers[2] = {0, 0};
+    if (g_uiGPUCullVisibleBuffer != 0) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiGPUCullVisibleBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, (g_uiGPUCullFirstLayerCount + (uiSection * 2)) * sizeof(GLuint), sizeof(uiLayers), uiLayers);
+    }
+    ui64Drawn = uiLayers[0];
+    ui64Total = uiLayers[1];
+}
+
+void GL_QuitGPUCulling()
+{
+    // Output the last visible count of each section
+    if (g_uiGPUCullPasses > 0) {
+        SDL_Log("GPU culling tested %llu objects over %u passes, last passes kept %u point shadow, %u spot shadow and %u camera objects of %u\n",
+                (unsigned long long)g_ui64GPUCullTested, g_uiGPUCullPasses, GL_GetGPUVisibleObjects(0), GL_GetGPUVisibleObjects(1),
+                GL_GetGPUVisibleObjects(g_uiGPUCullCameraSection), g_uiGPUCullDraws);
+        SDL_Log("GPU culled camera objects were drawn with %llu multi draws, the last pass used %u buckets for %u objects\n",
+                (unsigned long long)g_ui64GPUCullBucketDraws, g_uiGPUCullBuckets, g_uiGPUCullBucketed);
+    }
+    g_ui64GPUCullTested = 0;
+    g_ui64GPUCullBucketDraws = 0;
+    g_uiGPUCullPasses = 0;
+
+    // Release culling data
+    glDeleteProgram(g_uiGPUCullProgram);
+    glDeleteBuffers(1, &g_uiGPUCullBoundsSSBO);
+    glDeleteBuffers(1, &g_uiGPUCullAABBSSBO);
+    glDeleteBuffers(1, &g_uiGPUCullDrawSSBO);
+    glDeleteBuffers(1, &g_uiGPUCullViewSSBO);
+    glDeleteBuffers(1, &g_uiGPUCullCommandBuffer);
+    glDeleteBuffers(1, &g_uiGPUCullDrawIndexBuffer);
+    glDeleteBuffers(1, &g_uiGPUCullVisibleBuffer);
+    glDeleteBuffers(1, &g_uiGPUCullBucketSSBO);
+    g_uiGPUCullProgram = 0;
+    g_uiGPUCullBoundsSSBO = 0;
+    g_uiGPUCullAABBSSBO = 0;
+    g_uiGPUCullDrawSSBO = 0;
+    g_uiGPUCullViewSSBO = 0;
+    g_uiGPUCullCommandBuffer = 0;
+    g_uiGPUCullDrawIndexBuffer = 0;
+    g_uiGPUCullVisibleBuffer = 0;
+    g_uiGPUCullBucketSSBO = 0;
+    g_uiGPUCullMaxViews = 0;
+    g_uiGPUCullBuckets = 0;
+    g_uiGPUCullBucketed = 0;
+    free(gp_v4GPUCullViews);
+    free(gp_iGPUCullObjectDraws);
+    free(gp_uiGPUCullDrawBuckets);
+    free(gp_uiGPUCullBucketObjects);
+    free(gp_uiGPUCullBucketSizes);
+    gp_v4GPUCullViews = NULL;
+    gp_iGPUCullObjectDraws = NULL;
+    gp_uiGPUCullDrawBuckets = NULL;
+    gp_uiGPUCullBucketObjects = NULL;
+    gp_uiGPUCullBucketSizes = NULL;
+}
\ No newline at end of file
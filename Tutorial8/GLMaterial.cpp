@@ -0,0 +1,84 @@
+// Using SDL, GLEW
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
+
+//Main.cpp
+extern SceneData g_SceneData;
+//TextureStream.cpp
+extern bool GL_EnableTextureHandles();
+extern unsigned GL_GetTextureHandleVersion();
+extern GLuint64 GL_GetTextureHandle(GLuint uiTexture);
+
+// Material layout in the material SSBO, must match the shaders std430 layout
+struct MaterialBufferData
+{
+    GLuint64 m_ui64Textures[5];
+    float m_fEmissive;
+    float m_fBumpScale;
+};
+
+// Bindless material buffer, draws then only need their material index
+bool g_bBindlessMaterials = true;
+GLuint g_uiMaterialSSBO = 0;
+MaterialBufferData * gp_MaterialBuffer = NULL;
+unsigned g_uiMaterialHandleVersion = 0;
+
+void GL_UpdateMaterials()
+{
+    // Only needed when streaming has moved a texture to a new handle
+    if ((g_uiMaterialSSBO == 0) || (g_uiMaterialHandleVersion == GL_GetTextureHandleVersion()))
+        return;
+    GL_TRACE_ZONE("GL_UpdateMaterials");
+    for (unsigned i = 0; i < g_SceneData.m_uiNumMaterials; i++) {
+        // Textures are stored in order diffuse, specular, rough, normal, bump
+        const MaterialData * p_Material = &g_SceneData.mp_Materials[i];
+        const GLuint uiTextures[] = {p_Material->m_uiDiffuse, p_Material->m_uiSpecular, p_Material->m_uiRough, p_Material->m_uiNormal, p_Material->m_uiBump};
+        for (unsigned j = 0; j < 5; j++) {
+            gp_MaterialBuffer[i].m_ui64Textures[j] = GL_GetTextureHandle(uiTextures[j]);
+        }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiMaterialSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, g_SceneData.m_uiNumMaterials * sizeof(MaterialBufferData), gp_MaterialBuffer);
+    g_uiMaterialHandleVersion = GL_GetTextureHandleVersion();
+}
+
+bool GL_InitMaterials()
+{
+    // Fall back to binding textures per draw if handles are unavailable
+    if (!g_bBindlessMaterials || (g_SceneData.m_uiNumMaterials == 0) || !GL_EnableTextureHandles()) {
+        g_bBindlessMaterials = false;
+        SDL_Log("Bindless materials disabled, binding material textures per draw\n");
+        return false;
+    }
+
+    // Fill in the constant parts of each material
+    gp_MaterialBuffer = (MaterialBufferData *)malloc(g_SceneData.m_uiNumMaterials * sizeof(MaterialBufferData));
+    for (unsigned i = 0; i < g_SceneData.m_uiNumMaterials; i++) {
+        gp_MaterialBuffer[i].m_fEmissive = g_SceneData.mp_Materials[i].m_fEmissive;
+        gp_MaterialBuffer[i].m_fBumpScale = g_SceneData.mp_Materials[i].m_fBumpScale;
+    }
+
+    // Create material SSBO, handles are written by the first update
+    glGenBuffers(1, &g_uiMaterialSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_uiMaterialSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, g_SceneData.m_uiNumMaterials * sizeof(MaterialBufferData), NULL, GL_DYNAMIC_DRAW);
+    g_uiMaterialHandleVersion = GL_GetTextureHandleVersion() - 1;
+    GL_UpdateMaterials();
+
+    // Bind material SSBO
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, g_uiMaterialSSBO);
+    SDL_Log("Bindless materials enabled for %u materials\n", g_SceneData.m_uiNumMaterials);
+    return true;
+}
+
+void GL_QuitMaterials()
+{
+    // Release material data
+    glDeleteBuffers(1, &g_uiMaterialSSBO);
+    g_uiMaterialSSBO = 0;
+    free(gp_MaterialBuffer);
+    gp_MaterialBuffer = NULL;
+}
\ No newline at end of file
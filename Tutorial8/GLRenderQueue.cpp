@@ -0,0 +1,249 @@
+// Using SDL, GLEW
+#include <string.h>
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include "GLTrace.h"
+
+// Key layout from most to least significant bits
+const unsigned g_uiRenderKeyPassShift = 62;
+const unsigned g_uiRenderKeySubroutineShift = 56;
+const unsigned g_uiRenderKeyMaterialShift = 40;
+const unsigned g_uiRenderKeyVAOShift = 32;
+
+// Sorted queue of objects to draw
+Uint64 * gp_ui64RenderKeys = NULL;
+unsigned * gp_uiRenderObjects = NULL;
+Uint64 * gp_ui64RenderSortKeys = NULL;
+unsigned * gp_uiRenderSortObjects = NULL;
+unsigned g_uiNumRenderItems = 0;
+unsigned g_uiMaxRenderItems = 0;
+
+// Currently bound state, used to skip redundant changes
+const unsigned g_uiMaxQueueTextureUnits = 16;
+const unsigned g_uiMaxQueueBufferBindings = 8;
+const unsigned g_uiMaxQueueUniforms = 8;
+const unsigned g_uiMaxQueueSubroutines = 4;
+struct RenderQueueBufferData
+{
+    GLuint m_uiBuffer;
+    GLintptr m_iOffset;
+    GLsizeiptr m_iSize;
+};
+GLuint g_uiQueueTextures[g_uiMaxQueueTextureUnits];
+RenderQueueBufferData g_QueueBuffers[g_uiMaxQueueBufferBindings];
+Uint32 g_uiQueueUniforms[g_uiMaxQueueUniforms];
+bool g_bQueueUniformsValid[g_uiMaxQueueUniforms];
+GLuint g_uiQueueSubroutines[g_uiMaxQueueSubroutines];
+unsigned g_uiNumQueueSubroutines = 0;
+GLuint g_uiQueueVAO = -1;
+
+// Bind counters
+enum RenderQueueStat
+{
+    QUEUE_STAT_TEXTURE,
+    QUEUE_STAT_BUFFER,
+    QUEUE_STAT_SUBROUTINE,
+    QUEUE_STAT_UNIFORM,
+    QUEUE_STAT_VAO,
+    QUEUE_STAT_COUNT
+};
+const char * g_cRenderQueueStatNames[QUEUE_STAT_COUNT] = {"texture binds", "buffer binds", "subroutine changes", "uniform updates", "VAO binds"};
+Uint64 g_ui64QueueIssued[QUEUE_STAT_COUNT] = {0};
+Uint64 g_ui64QueueSkipped[QUEUE_STAT_COUNT] = {0};
+
+Uint64 GL_MakeRenderKey(unsigned uiPass, unsigned uiSubroutines, unsigned uiMaterial, unsigned uiVAO, float fDepth)
+{
+    // Non-negative floats sort the same as their bit patterns so depth is stored directly
+    Uint32 uiDepth;
+    fDepth = (fDepth > 0.0f) ? fDepth : 0.0f;
+    memcpy(&uiDepth, &fDepth, sizeof(Uint32));
+    return ((Uint64)(uiPass & 0x3) << g_uiRenderKeyPassShift) | ((Uint64)(uiSubroutines & 0x3F) << g_uiRenderKeySubroutineShift) |
+        ((Uint64)(uiMaterial & 0xFFFF) << g_uiRenderKeyMaterialShift) | ((Uint64)(uiVAO & 0xFF) << g_uiRenderKeyVAOShift) | (Uint64)uiDepth;
+}
+
+void GL_ClearRenderQueue()
+{
+    // Remove previous objects and forget bound state as other passes may have changed it
+    g_uiNumRenderItems = 0;
+    memset(g_uiQueueTextures, 0xFF, sizeof(g_uiQueueTextures));
+    memset(g_QueueBuffers, 0xFF, sizeof(g_QueueBuffers));
+    memset(g_bQueueUniformsValid, 0, sizeof(g_bQueueUniformsValid));
+    g_uiNumQueueSubroutines = 0;
+    g_uiQueueVAO = -1;
+}
+
+void GL_PushRenderQueue(Uint64 ui64Key, unsigned uiObject)
+{
+    // Increase queue storage as needed
+    if (g_uiNumRenderItems >= g_uiMaxRenderItems) {
+        g_uiMaxRenderItems = SDL_max(g_uiMaxRenderItems * 2, 256u);
+        gp_ui64RenderKeys = (Uint64 *)realloc(gp_ui64RenderKeys, g_uiMaxRenderItems * sizeof(Uint64));
+        gp_uiRenderObjects = (unsigned *)realloc(gp_uiRenderObjects, g_uiMaxRenderItems * sizeof(unsigned));
+        gp_ui64RenderSortKeys = (Uint64 *)realloc(gp_ui64RenderSortKeys, g_uiMaxRenderItems * sizeof(Uint64));
+        gp_uiRenderSortObjects = (unsigned *)realloc(gp_uiRenderSortObjects, g_uiMaxRenderItems * sizeof(unsigned));
+    }
+    gp_ui64RenderKeys[g_uiNumRenderItems] = ui64Key;
+    gp_uiRenderObjects[g_uiNumRenderItems] = uiObject;
+    ++g_uiNumRenderItems;
+}
+
+const unsigned * GL_SortRenderQueue(unsigned & uiNumObjects)
+{
+    GL_TRACE_ZONE("GL_SortRenderQueue");
+    uiNumObjects = g_uiNumRenderItems;
+    if (g_uiNumRenderItems <= 1)
+        return gp_uiRenderObjects;
+
+    // Count every byte of the keys in a single pass
+    static unsigned uiCounts[8][256];
+    memset(uiCounts, 0, sizeof(uiCounts));
+    for (unsigned i = 0; i < g_uiNumRenderItems; i++) {
+        const Uint64 ui64Key = gp_ui64RenderKeys[i];
+        for (unsigned j = 0; j < 8; j++) {
+            ++uiCounts[j][(ui64Key >> (j * 8)) & 0xFF];
+        }
+    }
+
+    // Radix sort one byte at a time from the least significant, skipping bytes every key shares
+    for (unsigned j = 0; j < 8; j++) {
+        if (uiCounts[j][(gp_ui64RenderKeys[0] >> (j * 8)) & 0xFF] == g_uiNumRenderItems)
+            continue;
+        unsigned uiOffset = 0;
+        for (unsigned k = 0; k < 256; k++) {
+            const unsigned uiCount = uiCounts[j][k];
+            uiCounts[j][k] = uiOffset;
+            uiOffset += uiCount;
+        }
+        for (unsigned i = 0; i < g_uiNumRenderItems; i++) {
+            const unsigned uiDest = uiCounts[j][(gp_ui64RenderKeys[i] >> (j * 8)) & 0xFF]++;
+            gp_ui64RenderSortKeys[uiDest] = gp_ui64RenderKeys[i];
+            gp_uiRenderSortObjects[uiDest] = gp_uiRenderObjects[i];
+        }
+
+        // Swap so the sorted data becomes the input of the next pass
+        Uint64 * p_ui64Keys = gp_ui64RenderKeys;
+        gp_ui64RenderKeys = gp_ui64RenderSortKeys;
+        gp_ui64RenderSortKeys = p_ui64Keys;
+        unsigned * p_uiObjects = gp_uiRenderObjects;
+        gp_uiRenderObjects = gp_uiRenderSortObjects;
+        gp_uiRenderSortObjects = p_uiObjects;
+    }
+    return gp_uiRenderObjects;
+}
+
+void GL_BindQueueTexture(unsigned uiUnit, GLenum Target, GLuint uiTexture)
+{
+    // Only bind if the unit holds something else
+    if ((uiUnit < g_uiMaxQueueTextureUnits) && (g_uiQueueTextures[uiUnit] == uiTexture)) {
+        ++g_ui64QueueSkipped[QUEUE_STAT_TEXTURE];
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0 + uiUnit);
+    glBindTexture(Target, uiTexture);
+    if (uiUnit < g_uiMaxQueueTextureUnits)
+        g_uiQueueTextures[uiUnit] = uiTexture;
+    ++g_ui64QueueIssued[QUEUE_STAT_TEXTURE];
+}
+
+void GL_BindQueueBufferRange(GLuint uiIndex, GLuint uiBuffer, GLintptr iOffset, GLsizeiptr iSize)
+{
+    // Only bind if the range has changed
+    if (uiIndex < g_uiMaxQueueBufferBindings) {
+        RenderQueueBufferData * p_Binding = &g_QueueBuffers[uiIndex];
+        if ((p_Binding->m_uiBuffer == uiBuffer) && (p_Binding->m_iOffset == iOffset) && (p_Binding->m_iSize == iSize)) {
+            ++g_ui64QueueSkipped[QUEUE_STAT_BUFFER];
+            return;
+        }
+        p_Binding->m_uiBuffer = uiBuffer;
+        p_Binding->m_iOffset = iOffset;
+        p_Binding->m_iSize = iSize;
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, uiIndex, uiBuffer, iOffset, iSize);
+    ++g_ui64QueueIssued[QUEUE_STAT_BUFFER];
+}
+
+void GL_SetQueueSubroutines(const GLuint * p_uiSubroutines, unsigned uiNumSubroutines)
+{
+    // Only update if any selection has changed
+    if ((uiNumSubroutines == g_uiNumQueueSubroutines) && (memcmp(p_uiSubroutines, g_uiQueueSubroutines, uiNumSubroutines * sizeof(GLuint)) == 0)) {
+        ++g_ui64QueueSkipped[QUEUE_STAT_SUBROUTINE];
+        return;
+    }
+    glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, uiNumSubroutines, p_uiSubroutines);
+    g_uiNumQueueSubroutines = 0;
+    if (uiNumSubroutines <= g_uiMaxQueueSubroutines) {
+        memcpy(g_uiQueueSubroutines, p_uiSubroutines, uiNumSubroutines * sizeof(GLuint));
+        g_uiNumQueueSubroutines = uiNumSubroutines;
+    }
+    ++g_ui64QueueIssued[QUEUE_STAT_SUBROUTINE];
+}
+
+bool GL_QueueUniformChanged(GLint iLocation, Uint32 uiBits)
+{
+    // Compare the raw value so every scalar type shares the same tracking
+    const bool bTracked = (iLocation >= 0) && ((unsigned)iLocation < g_uiMaxQueueUniforms);
+    if (bTracked && g_bQueueUniformsValid[iLocation] && (g_uiQueueUniforms[iLocation] == uiBits)) {
+        ++g_ui64QueueSkipped[QUEUE_STAT_UNIFORM];
+        return false;
+    }
+    if (bTracked) {
+        g_uiQueueUniforms[iLocation] = uiBits;
+        g_bQueueUniformsValid[iLocation] = true;
+    }
+    ++g_ui64QueueIssued[QUEUE_STAT_UNIFORM];
+    return true;
+}
+
+void GL_SetQueueUniform1f(GLint iLocation, float fValue)
+{
+    // Only update if the value has changed
+    Uint32 uiBits;
+    memcpy(&uiBits, &fValue, sizeof(Uint32));
+    if (GL_QueueUniformChanged(iLocation, uiBits))
+        glUniform1f(iLocation, fValue);
+}
+
+void GL_SetQueueUniform1ui(GLint iLocation, GLuint uiValue)
+{
+    // Only update if the value has changed
+    if (GL_QueueUniformChanged(iLocation, uiValue))
+        glUniform1ui(iLocation, uiValue);
+}
+
+void GL_BindQueueVertexArray(GLuint uiVAO)
+{
+    // Only bind if a different VAO is bound
+    if (g_uiQueueVAO == uiVAO) {
+        ++g_ui64QueueSkipped[QUEUE_STAT_VAO];
+        return;
+    }
+    glBindVertexArray(uiVAO);
+    g_uiQueueVAO = uiVAO;
+    ++g_ui64QueueIssued[QUEUE_STAT_VAO];
+}
+
+void GL_QuitRenderQueue()
+{
+    // Output how many state changes were avoided
+    for (unsigned i = 0; i < QUEUE_STAT_COUNT; i++) {
+        const Uint64 ui64Total = g_ui64QueueIssued[i] + g_ui64QueueSkipped[i];
+        if (ui64Total > 0)
+            SDL_Log("Render queue skipped %.1f%% of %llu %s\n", (double)g_ui64QueueSkipped[i] * 100.0 / (double)ui64Total,
+                    (unsigned long long)ui64Total, g_cRenderQueueStatNames[i]);
+        g_ui64QueueIssued[i] = 0;
+        g_ui64QueueSkipped[i] = 0;
+    }
+
+    // Release queue storage
+    free(gp_ui64RenderKeys);
+    free(gp_uiRenderObjects);
+    free(gp_ui64RenderSortKeys);
+    free(gp_uiRenderSortObjects);
+    gp_ui64RenderKeys = NULL;
+    gp_uiRenderObjects = NULL;
+    gp_ui64RenderSortKeys = NULL;
+    gp_uiRenderSortObjects = NULL;
+    g_uiNumRenderItems = 0;
+    g_uiMaxRenderItems = 0;
+}
\ No newline at end of file
@@ -1,14 +1,42 @@
 #include "GLScene.h"
+#include "GLTrace.h"
+// Using GLM packing
+#include <glm/gtc/packing.hpp>
 // Using SDL
 #include <SDL2/SDL.h>
 // Using Assimp
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+// Using file mapping
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 //Texture.cpp
 extern bool GL_LoadTextureKTX(GLuint uiTexture, const char * p_cTextureFile);
 extern bool GL_ConvertDDS2KTX(const char * p_cTextureFile);
+//TextureStream.cpp
+extern void GL_InitTextureStream();
+extern void GL_StreamTexture(GLuint uiTexture, const char * p_cTextureFile, const GLubyte * p_ucPlaceholder);
+extern void GL_StartTextureStream();
+extern bool GL_GetStreamTextureInfo(GLuint uiTexture, bool & bAlpha, Uint64 & ui64Bytes);
+extern void GL_QuitTextureStream();
+//BVH.cpp
+extern void GL_InvalidateObjectBVH();
+//Shadow.cpp
+extern void GL_InvalidateShadowCaster(unsigned uiObject, const vec4 & v4Bounds);
+//MeshOptimize.cpp
+extern void GL_OptimizeMesh(void * p_Vertices, unsigned uiStride, unsigned uiNumVertices, GLuint * p_Indices, unsigned uiNumIndices, const char * p_cName);
+extern void GL_OptimizeVertexCache(GLuint * p_Indices, unsigned uiNumIndices, unsigned uiNumVertices);
+extern unsigned GL_SimplifyMesh(const void * p_Vertices, unsigned uiStride, unsigned uiNumVertices, const GLuint * p_Indices, unsigned uiNumIndices,
+                                GLuint * p_Output, unsigned uiTargetIndices, float fMaxError, float & fError);
 //Main.cpp
 extern int g_iWindowWidth;
 extern int g_iWindowHeight;
@@ -21,129 +49,352 @@ struct CustomVertex
     vec3 v3Tangent;
 };
 
-void GL_LoadSceneNode(aiNode * p_Node, const aiScene * p_Scene, SceneData & SceneInfo, const mat4 & m4Transform, bool bAddObjects)
+struct PackedVertex
+{
+    GLushort usPosition[4];
+    GLshort sNormal[2];
+    GLshort sTangent[2];
+    GLushort usUV[2];
+};
+
+// Cooked scene file identifiers, version must be increased whenever the cooked layout changes
+const char g_cSceneCookMagic[4] = {'A', 'G', 'T', 'S'};
+const unsigned g_uiSceneCookVersion = 3;
+const char * gp_cSceneCookExtension = ".cooked";
+
+// Meshlet size limits
+const unsigned g_uiMeshletMaxVertices = 64;
+const unsigned g_uiMeshletMaxTriangles = 124;
+
+// LOD generation, each level targets a fraction of the previous levels triangles
+const float g_fLODReduction = 0.5f;
+// Largest error allowed for each level as a fraction of the mesh radius
+const float g_fLODMaxError = 0.05f;
+// Stop adding levels once one keeps more than this fraction of the previous level
+const float g_fLODMinReduction = 0.8f;
+
+struct SceneCookHeader
+{
+    char m_cMagic[4];
+    unsigned m_uiVersion;
+    unsigned m_uiVertexSize;
+    unsigned m_uiHasCamera;
+    Uint64 m_ui64SourceHash;
+    Uint64 m_ui64SourceSize;
+    Uint64 m_ui64FileSize;
+    unsigned m_uiNumMeshes;
+    unsigned m_uiNumMaterials;
+    unsigned m_uiNumObjects;
+    unsigned m_uiNumLights;
+    unsigned m_uiNumVertices;
+    unsigned m_uiNumIndices;
+    unsigned m_uiNumLODIndices;
+    Uint64 m_ui64MeshOffset;
+    Uint64 m_ui64MaterialOffset;
+    Uint64 m_ui64ObjectOffset;
+    Uint64 m_ui64LightOffset;
+    Uint64 m_ui64CameraOffset;
+    Uint64 m_ui64VertexOffset;
+    Uint64 m_ui64IndexOffset;
+};
+
+struct SceneCookMesh
+{
+    unsigned m_uiFirstVertex;
+    unsigned m_uiNumVertices;
+    unsigned m_uiFirstIndex;
+    unsigned m_uiNumIndices;
+    vec3 m_v3AABBMin;
+    vec3 m_v3AABBMax;
+    unsigned m_uiNumLODs;
+    unsigned m_uiLODFirstIndex[g_uiMaxMeshLODs];
+    unsigned m_uiLODNumIndices[g_uiMaxMeshLODs];
+    float m_fLODError[g_uiMaxMeshLODs];
+};
+
+struct SceneCookMaterial
+{
+    char m_cTextures[5][256];
+    float m_fEmissive;
+    float m_fBumpScale;
+    unsigned m_uiReflective;
+};
+
+struct SceneCookObject
+{
+    unsigned m_uiMesh;
+    unsigned m_uiMaterial;
+    mat4 m_4Transform;
+};
+
+struct SceneCookLight
+{
+    unsigned m_uiType;
+    float m_fAngle;
+    vec3 m_v3Position;
+    vec3 m_v3Direction;
+    vec3 m_v3Colour;
+    vec3 m_v3Falloff;
+};
+
+struct SceneCookCamera
+{
+    vec3 m_v3Position;
+    vec3 m_v3Direction;
+    vec3 m_v3Right;
+    float m_fFOV;
+    float m_fNear;
+    float m_fFar;
+};
+
+struct SceneTextureCacheData
+{
+    Uint64 m_ui64Hash;
+    char * mp_cPath;
+    GLuint m_uiTexture;
+    unsigned m_uiNumHits;
+    Uint64 m_ui64LoadTicks;
+};
+
+struct SceneTextureCache
+{
+    SceneTextureCacheData * mp_Entries;
+    unsigned m_uiNumEntries;
+    unsigned m_uiNumHits;
+    Uint64 m_ui64SavedBytes;
+    Uint64 m_ui64SavedTicks;
+};
+
+struct MappedFileData
+{
+    const unsigned char * mp_Data;
+    size_t m_uiSize;
+#ifdef _WIN32
+    HANDLE m_hFile;
+    HANDLE m_hMapping;
+#endif
+};
+
+bool GL_MapFile(const char * p_cFileName, MappedFileData & File)
+{
+    // Map the whole file read only
+    File.mp_Data = NULL;
+    File.m_uiSize = 0;
+#ifdef _WIN32
+    File.m_hFile = CreateFileA(p_cFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (File.m_hFile == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER Size;
+    if (!GetFileSizeEx(File.m_hFile, &Size) || (Size.QuadPart == 0)) {
+        CloseHandle(File.m_hFile);
+        return false;
+    }
+    File.m_hMapping = CreateFileMappingA(File.m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (File.m_hMapping == NULL) {
+        CloseHandle(File.m_hFile);
+        return false;
+    }
+    File.mp_Data = (const unsigned char *)MapViewOfFile(File.m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (File.mp_Data == NULL) {
+        CloseHandle(File.m_hMapping);
+        CloseHandle(File.m_hFile);
+        return false;
+    }
+    File.m_uiSize = (size_t)Size.QuadPart;
+#else
+    int iFile = open(p_cFileName, O_RDONLY);
+    if (iFile < 0)
+        return false;
+    struct stat Stat;
+    if ((fstat(iFile, &Stat) != 0) || (Stat.st_size == 0)) {
+        close(iFile);
+        return false;
+    }
+    void * p_Data = mmap(NULL, (size_t)Stat.st_size, PROT_READ, MAP_PRIVATE, iFile, 0);
+    close(iFile);
+    if (p_Data == MAP_FAILED)
+        return false;
+    File.mp_Data = (const unsigned char *)p_Data;
+    File.m_uiSize = (size_t)Stat.st_size;
+#endif
+    return true;
+}
+
+void GL_UnmapFile(MappedFileData & File)
+{
+    if (File.mp_Data == NULL)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(File.mp_Data);
+    CloseHandle(File.m_hMapping);
+    CloseHandle(File.m_hFile);
+#else
+    munmap((void *)File.mp_Data, File.m_uiSize);
+#endif
+    File.mp_Data = NULL;
+    File.m_uiSize = 0;
+}
+
+Uint64 GL_HashData(const unsigned char * p_Data, size_t uiSize)
+{
+    // FNV-1a over 8 byte words with the remainder done per byte
+    Uint64 ui64Hash = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + sizeof(Uint64) <= uiSize; i += sizeof(Uint64)) {
+        Uint64 ui64Word;
+        memcpy(&ui64Word, &p_Data[i], sizeof(Uint64));
+        ui64Hash = (ui64Hash ^ ui64Word) * 1099511628211ULL;
+    }
+    for (; i < uiSize; i++) {
+        ui64Hash = (ui64Hash ^ p_Data[i]) * 1099511628211ULL;
+    }
+    return ui64Hash;
+}
+
+void GL_CookSceneNode(aiNode * p_Node, const aiScene * p_Scene, SceneCookObject * p_Objects, unsigned & uiNumObjects, const mat4 & m4Transform)
 {
     // Update current transform
     mat4 m4CurrentTransform = transpose(*(mat4 *)&p_Node->mTransformation) * m4Transform;
     // Loop over each mesh in the node
     for (unsigned i = 0; i < p_Node->mNumMeshes; i++) {
-        // Load in each nodes mesh as an object
-        if (bAddObjects) {
-            ObjectData * p_Object = &SceneInfo.mp_Objects[SceneInfo.m_uiNumObjects];
-
-            // Get data from corresponding mesh
-            const MeshData * p_Mesh = &SceneInfo.mp_Meshes[p_Node->mMeshes[i]];
-            p_Object->m_uiVAO = p_Mesh->m_uiVAO;
-            p_Object->m_uiNumIndices = p_Mesh->m_uiNumIndices;
-
-            // Get data from corresponding material
-            const MaterialData * p_Material = &SceneInfo.mp_Materials[p_Scene->mMeshes[p_Node->mMeshes[i]]->mMaterialIndex];
-            p_Object->m_uiDiffuse = p_Material->m_uiDiffuse;
-            p_Object->m_uiSpecular = p_Material->m_uiSpecular;
-            p_Object->m_uiRough = p_Material->m_uiRough;
-            p_Object->m_uiNormal = p_Material->m_uiNormal;
-            p_Object->m_uiBump = p_Material->m_uiBump;
-            p_Object->m_fEmissive = p_Material->m_fEmissive;
-            p_Object->m_fBumpScale = p_Material->m_fBumpScale;
-
-            // Generate and fill transform UBO
+        // Flatten each nodes mesh into an object (only counted if no output given)
+        if (p_Objects != NULL) {
+            SceneCookObject * p_Object = &p_Objects[uiNumObjects];
+            p_Object->m_uiMesh = p_Node->mMeshes[i];
+            p_Object->m_uiMaterial = p_Scene->mMeshes[p_Node->mMeshes[i]]->mMaterialIndex;
             p_Object->m_4Transform = m4CurrentTransform;
-            glGenBuffers(1, &p_Object->m_uiTransformUBO);
-            glBindBuffer(GL_UNIFORM_BUFFER, p_Object->m_uiTransformUBO);
-            glBufferData(GL_UNIFORM_BUFFER, sizeof(mat4), &p_Object->m_4Transform, GL_STATIC_DRAW);
-
-            // Add to transparent object list as needed
-            p_Object->m_bTransparent = p_Material->m_bTransparent;
-            if (p_Material->m_bTransparent) {
-                SceneInfo.mp_TransObjects[SceneInfo.m_uiNumTransObjects] = *p_Object;
-                ++SceneInfo.m_uiNumTransObjects;
-            }
-
-            // Add to reflective object list as needed
-            p_Object->m_uiReflective = 0;
-            if (p_Material->m_bReflective) {
-                // Calculate objects bounding box
-                const aiMesh * p_AIMesh = p_Scene->mMeshes[p_Node->mMeshes[i]];
-                vec3 v3AABBMin = vec3(FLT_MAX);
-                vec3 v3AABBMax = vec3(-FLT_MAX);
-                for (unsigned j = 0; j < p_AIMesh->mNumVertices; j++) {
-                    vec3 v3Vert(p_AIMesh->mVertices[j].x,
-                                p_AIMesh->mVertices[j].y,
-                                p_AIMesh->mVertices[j].z);
-                    v3AABBMin = min(v3AABBMin, v3Vert);
-                    v3AABBMax = max(v3AABBMax, v3Vert);
-                }
-
-                // Check if planar or not
-                vec3 v3AABBSize = v3AABBMax - v3AABBMin;
-                if ((v3AABBSize.x < 0.00001f) || (v3AABBSize.y < 0.00001f) || (v3AABBSize.z < 0.00001f)) {
-                    // Set object as planar reflective
-                    p_Object->m_uiReflective = 1;
-                    ReflectObjectData * p_RObject = &SceneInfo.mp_ReflecObjects[SceneInfo.m_uiNumReflecObjects];
-
-                    // Set object position in reflective object
-                    p_RObject->m_uiObjectPos = SceneInfo.m_uiNumObjects;
-
-                    // Generate texture for reflection map
-                    glGenTextures(1, &p_Object->m_uiReflect);
-                    glBindTexture(GL_TEXTURE_2D, p_Object->m_uiReflect);
-                    int iLevels = (int)ceilf(log2f((float)max(g_iWindowWidth, g_iWindowHeight)));
-                    glTexStorage2D(GL_TEXTURE_2D, iLevels, GL_RGB8, g_iWindowWidth, g_iWindowHeight);
-
-                    // Initialise the texture filtering and wrap values
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-                    // Generate a UBO for reflected projection storage
-                    glGenBuffers(1, &p_Object->m_uiReflectVPUBO);
-
-                    // Calculate objects plane in model space
-                    vec3 v3PlaneNormal = vec3(p_AIMesh->mNormals[0].x,
-                                              p_AIMesh->mNormals[0].y,
-                                              p_AIMesh->mNormals[0].z);
-                    vec3 v3AABBCentre = v3AABBMin + (v3AABBSize * 0.5f);
-                    p_RObject->m_v4PlaneOrPosition = vec4(v3PlaneNormal,
-                                                          dot(v3PlaneNormal, -v3AABBCentre));
-
-                    ++SceneInfo.m_uiNumReflecObjects;
-                } else {
-                    // Set object as cube reflective
-                    p_Object->m_uiReflective = 2;
-                    ReflectObjectData * p_RObject = &SceneInfo.mp_ReflecObjects[SceneInfo.m_uiNumReflecObjects];
-
-                    // Set object position in reflective object
-                    p_RObject->m_uiObjectPos = SceneInfo.m_uiNumObjects;
-
-                    // Generate texture for reflection map
-                    glGenTextures(1, &p_Object->m_uiReflect);
-                    glBindTexture(GL_TEXTURE_CUBE_MAP, p_Object->m_uiReflect);
-                    int iLevels = (int)ceilf(log2f((float)g_iWindowHeight));
-                    glTexStorage2D(GL_TEXTURE_CUBE_MAP, iLevels, GL_RGB8, g_iWindowHeight, g_iWindowHeight);
-
-                    // Initialise the texture filtering and wrap values
-                    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                    glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4);
-                    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-                    // Calculate AABB centre position in model space
-                    p_RObject->m_v4PlaneOrPosition = vec4(v3AABBMin + (v3AABBSize * 0.5f), 1.0f);
-
-                    ++SceneInfo.m_uiNumReflecObjects;
-                }
-            }
         }
-        ++SceneInfo.m_uiNumObjects;
+        ++uiNumObjects;
     }
 
     // Loop over each child node
     for (unsigned i = 0; i < p_Node->mNumChildren; i++) {
-        GL_LoadSceneNode(p_Node->mChildren[i], p_Scene, SceneInfo, m4CurrentTransform, bAddObjects);
+        GL_CookSceneNode(p_Node->mChildren[i], p_Scene, p_Objects, uiNumObjects, m4CurrentTransform);
+    }
+}
+
+struct SceneCookTaskData
+{
+    const aiScene * mp_Scene;
+    SceneCookMesh * mp_Meshes;
+    CustomVertex * mp_Vertices;
+    GLuint * mp_Indices;
+    GLuint ** mp_LODIndices;
+    SDL_atomic_t m_NextMesh;
+};
+
+void GL_CookMesh(const aiMesh * p_AIMesh, SceneCookMesh * p_Mesh, CustomVertex * p_VBuffer, GLuint * p_IBuffer)
+{
+    CustomVertex * p_vBuffer = p_VBuffer;
+    GLuint * p_iBuffer = p_IBuffer;
+    // Load in vertex data and calculate bounding box
+    p_Mesh->m_v3AABBMin = vec3(FLT_MAX);
+    p_Mesh->m_v3AABBMax = vec3(-FLT_MAX);
+    for (unsigned j = 0; j < p_AIMesh->mNumVertices; j++) {
+        p_vBuffer->v3Position = vec3(p_AIMesh->mVertices[j].x,
+                                     p_AIMesh->mVertices[j].y,
+                                     p_AIMesh->mVertices[j].z);
+        p_vBuffer->v3Normal = vec3(p_AIMesh->mNormals[j].x,
+                                   p_AIMesh->mNormals[j].y,
+                                   p_AIMesh->mNormals[j].z);
+        p_vBuffer->v2UV = vec2(p_AIMesh->mTextureCoords[0][j].x,
+                               p_AIMesh->mTextureCoords[0][j].y);
+        p_vBuffer->v3Tangent = vec3(p_AIMesh->mTangents[j].x,
+                                    p_AIMesh->mTangents[j].y,
+                                    p_AIMesh->mTangents[j].z);
+        p_Mesh->m_v3AABBMin = min(p_Mesh->m_v3AABBMin, p_vBuffer->v3Position);
+        p_Mesh->m_v3AABBMax = max(p_Mesh->m_v3AABBMax, p_vBuffer->v3Position);
+        ++p_vBuffer;
+    }
+
+    // Load in Indexes
+    for (unsigned j = 0; j < p_AIMesh->mNumFaces; j++) {
+        *p_iBuffer++ = p_AIMesh->mFaces[j].mIndices[0];
+        *p_iBuffer++ = p_AIMesh->mFaces[j].mIndices[1];
+        *p_iBuffer++ = p_AIMesh->mFaces[j].mIndices[2];
+    }
+
+    // Reorder for vertex cache, overdraw and vertex fetch
+    GL_OptimizeMesh(p_VBuffer, sizeof(CustomVertex), p_AIMesh->mNumVertices, p_IBuffer, p_AIMesh->mNumFaces * 3, p_AIMesh->mName.data);
+}
+
+GLuint * GL_CookMeshLODs(const CustomVertex * p_Vertices, const GLuint * p_Indices, SceneCookMesh * p_Mesh)
+{
+    // First level is always the full detail mesh
+    p_Mesh->m_uiNumLODs = 1;
+    p_Mesh->m_uiLODFirstIndex[0] = p_Mesh->m_uiFirstIndex;
+    p_Mesh->m_uiLODNumIndices[0] = p_Mesh->m_uiNumIndices;
+    p_Mesh->m_fLODError[0] = 0.0f;
+
+    // Simplify each level from the previous one, indices are relative to the returned buffer until placed in the index arena
+    const float fMaxError = length(p_Mesh->m_v3AABBMax - p_Mesh->m_v3AABBMin) * 0.5f * g_fLODMaxError;
+    GLuint * p_LODIndices = (GLuint *)malloc(max(p_Mesh->m_uiNumIndices, 1u) * (g_uiMaxMeshLODs - 1) * sizeof(GLuint));
+    const GLuint * p_Source = p_Indices;
+    unsigned uiSourceIndices = p_Mesh->m_uiNumIndices;
+    unsigned uiNumLODIndices = 0;
+    float fTotalError = 0.0f;
+    for (unsigned i = 1; i < g_uiMaxMeshLODs; i++) {
+        GLuint * p_Output = &p_LODIndices[uiNumLODIndices];
+        const unsigned uiTarget = ((unsigned)((float)uiSourceIndices * g_fLODReduction) / 3) * 3;
+        float fError;
+        const unsigned uiNumIndices = GL_SimplifyMesh(p_Vertices, sizeof(CustomVertex), p_Mesh->m_uiNumVertices, p_Source, uiSourceIndices,
+                                                      p_Output, uiTarget, fMaxError, fError);
+
+        // Stop once simplification no longer gives a worthwhile reduction
+        if ((uiNumIndices == 0) || ((float)uiNumIndices > (float)uiSourceIndices * g_fLODMinReduction))
+            break;
+        GL_OptimizeVertexCache(p_Output, uiNumIndices, p_Mesh->m_uiNumVertices);
+
+        // Errors add up as each level is built from the one before
+        fTotalError += fError;
+        p_Mesh->m_uiLODFirstIndex[i] = uiNumLODIndices;
+        p_Mesh->m_uiLODNumIndices[i] = uiNumIndices;
+        p_Mesh->m_fLODError[i] = fTotalError;
+        ++p_Mesh->m_uiNumLODs;
+        uiNumLODIndices += uiNumIndices;
+        p_Source = p_Output;
+        uiSourceIndices = uiNumIndices;
+    }
+    if (uiNumLODIndices == 0) {
+        free(p_LODIndices);
+        return NULL;
+    }
+    return p_LODIndices;
+}
+
+int GL_CookMeshThread(void * p_Data)
+{
+    GL_TRACE_ZONE("GL_CookMeshThread");
+    // Keep taking the next unconverted mesh until none are left
+    SceneCookTaskData * p_Task = (SceneCookTaskData *)p_Data;
+    unsigned i;
+    while ((i = (unsigned)SDL_AtomicAdd(&p_Task->m_NextMesh, 1)) < p_Task->mp_Scene->mNumMeshes) {
+        SceneCookMesh * p_Mesh = &p_Task->mp_Meshes[i];
+        GL_CookMesh(p_Task->mp_Scene->mMeshes[i], p_Mesh, &p_Task->mp_Vertices[p_Mesh->m_uiFirstVertex],
+                    &p_Task->mp_Indices[p_Mesh->m_uiFirstIndex]);
+        p_Task->mp_LODIndices[i] = GL_CookMeshLODs(&p_Task->mp_Vertices[p_Mesh->m_uiFirstVertex], &p_Task->mp_Indices[p_Mesh->m_uiFirstIndex],
+                                                   p_Mesh);
+    }
+    return 0;
+}
+
+double GL_RunCookThreads(SceneCookTaskData * p_Task, unsigned uiNumThreads)
+{
+    // Convert every mesh across the requested number of threads, returning the time taken in ms
+    SDL_AtomicSet(&p_Task->m_NextMesh, 0);
+    const Uint64 ui64Start = SDL_GetPerformanceCounter();
+    SDL_Thread ** p_Threads = (SDL_Thread **)malloc(uiNumThreads * sizeof(SDL_Thread *));
+    for (unsigned i = 1; i < uiNumThreads; i++) {
+        p_Threads[i] = SDL_CreateThread(GL_CookMeshThread, "CookMesh", p_Task);
+    }
+    // Main thread also works through the meshes
+    GL_CookMeshThread(p_Task);
+    for (unsigned i = 1; i < uiNumThreads; i++) {
+        if (p_Threads[i] != NULL)
+            SDL_WaitThread(p_Threads[i], NULL);
     }
+    free(p_Threads);
+    return (double)(SDL_GetPerformanceCounter() - ui64Start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
 }
 
 bool GL_FindSceneNode(aiNode * p_Node, const aiString & Name, const aiScene * p_Scene, const mat4 & m4Transform, mat4 & m4RetTransform)
@@ -165,126 +416,147 @@ bool GL_FindSceneNode(aiNode * p_Node, const aiString & Name, const aiScene * p_
     return false;
 }
 
-bool GL_LoadScene(const char * p_cSceneFile, SceneData & SceneInfo)
+Uint64 GL_AlignCookOffset(Uint64 ui64Offset)
 {
+    return (ui64Offset + 15) & ~(Uint64)15;
+}
+
+unsigned char * GL_CookScene(const char * p_cSceneFile, Uint64 ui64SourceHash, Uint64 ui64SourceSize)
+{
+    GL_TRACE_ZONE("GL_CookScene");
     // Load scene from file
     const aiScene * p_Scene = aiImportFile(p_cSceneFile,
                                            aiProcess_GenSmoothNormals |
                                            aiProcess_CalcTangentSpace |
                                            aiProcess_Triangulate |
-                                           aiProcess_ImproveCacheLocality |
                                            aiProcess_SortByPType);
 
-                                       // Check if import failed
+    // Check if import failed
     if (!p_Scene) {
         SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to open scene file: %s\n", aiGetErrorString());
-        return false;
+        return NULL;
     }
 
-    // Get import file base path
-    char * p_cPath = (char *)malloc(255);
-    *p_cPath = '\0';
-    unsigned uiPathLength = 0;
-    const char * p_cDirSlash = strrchr(p_cSceneFile, '/');
-    if (p_cDirSlash != NULL) {
-        uiPathLength = (unsigned)(p_cDirSlash - p_cSceneFile) + 1;
-        strncat(p_cPath, p_cSceneFile, uiPathLength);
+    // Count the data to be cooked
+    SceneCookHeader Header;
+    memset(&Header, 0, sizeof(SceneCookHeader));
+    memcpy(Header.m_cMagic, g_cSceneCookMagic, sizeof(Header.m_cMagic));
+    Header.m_uiVersion = g_uiSceneCookVersion;
+    Header.m_uiVertexSize = sizeof(CustomVertex);
+    Header.m_ui64SourceHash = ui64SourceHash;
+    Header.m_ui64SourceSize = ui64SourceSize;
+    Header.m_uiNumMeshes = p_Scene->mNumMeshes;
+    Header.m_uiNumMaterials = p_Scene->mNumMaterials;
+    GL_CookSceneNode(p_Scene->mRootNode, p_Scene, NULL, Header.m_uiNumObjects, glm::mat4(1.0f));
+    for (unsigned i = 0; i < p_Scene->mNumLights; i++) {
+        if ((p_Scene->mLights[i]->mType == aiLightSource_POINT) || (p_Scene->mLights[i]->mType == aiLightSource_SPOT))
+            ++Header.m_uiNumLights;
     }
-    // Allocate buffers for each mesh
-    SceneInfo.mp_Meshes = (MeshData *)realloc(SceneInfo.mp_Meshes, p_Scene->mNumMeshes * sizeof(MeshData));
-    // Load in each mesh
+    Header.m_uiHasCamera = (p_Scene->mNumCameras > 0);
     for (unsigned i = 0; i < p_Scene->mNumMeshes; i++) {
-        MeshData * p_Mesh = &SceneInfo.mp_Meshes[i];
-        const aiMesh * p_AIMesh = p_Scene->mMeshes[i];
-        // Generate the buffers
-        glGenVertexArrays(1, &p_Mesh->m_uiVAO);
-        glGenBuffers(1, &p_Mesh->m_uiVBO);
-        glGenBuffers(1, &p_Mesh->m_uiIBO);
-
-        // Create the new mesh data
-        p_Mesh->m_uiNumIndices = p_AIMesh->mNumFaces * 3;
-        const unsigned uiSizeVertices = p_AIMesh->mNumVertices * sizeof(CustomVertex);
-        const unsigned uiSizeIndices = p_Mesh->m_uiNumIndices * sizeof(GLuint);
-        CustomVertex * p_VBuffer = (CustomVertex *)malloc(uiSizeVertices);
-        GLuint * p_IBuffer = (GLuint *)malloc(uiSizeIndices);
-
-        // Load in vertex data
-        CustomVertex * p_vBuffer = p_VBuffer;
-        for (unsigned j = 0; j < p_AIMesh->mNumVertices; j++) {
-            p_vBuffer->v3Position = vec3(p_AIMesh->mVertices[j].x,
-                                         p_AIMesh->mVertices[j].y,
-                                         p_AIMesh->mVertices[j].z);
-            p_vBuffer->v3Normal = vec3(p_AIMesh->mNormals[j].x,
-                                       p_AIMesh->mNormals[j].y,
-                                       p_AIMesh->mNormals[j].z);
-            p_vBuffer->v2UV = vec2(p_AIMesh->mTextureCoords[0][j].x,
-                                   p_AIMesh->mTextureCoords[0][j].y);
-            p_vBuffer->v3Tangent = vec3(p_AIMesh->mTangents[j].x,
-                                        p_AIMesh->mTangents[j].y,
-                                        p_AIMesh->mTangents[j].z);
-            ++p_vBuffer;
-        }
-
-        // Load in Indexes
-        GLuint * p_iBuffer = p_IBuffer;
-        for (unsigned j = 0; j < p_AIMesh->mNumFaces; j++) {
-            *p_iBuffer++ = p_AIMesh->mFaces[j].mIndices[0];
-            *p_iBuffer++ = p_AIMesh->mFaces[j].mIndices[1];
-            *p_iBuffer++ = p_AIMesh->mFaces[j].mIndices[2];
-        }
+        Header.m_uiNumVertices += p_Scene->mMeshes[i]->mNumVertices;
+        Header.m_uiNumIndices += p_Scene->mMeshes[i]->mNumFaces * 3;
+    }
 
-        //Bind the VAO
-        glBindVertexArray(p_Mesh->m_uiVAO);
+    // Lay out each section
+    Header.m_ui64MeshOffset = GL_AlignCookOffset(sizeof(SceneCookHeader));
+    Header.m_ui64MaterialOffset = GL_AlignCookOffset(Header.m_ui64MeshOffset + Header.m_uiNumMeshes * sizeof(SceneCookMesh));
+    Header.m_ui64ObjectOffset = GL_AlignCookOffset(Header.m_ui64MaterialOffset + Header.m_uiNumMaterials * sizeof(SceneCookMaterial));
+    Header.m_ui64LightOffset = GL_AlignCookOffset(Header.m_ui64ObjectOffset + Header.m_uiNumObjects * sizeof(SceneCookObject));
+    Header.m_ui64CameraOffset = GL_AlignCookOffset(Header.m_ui64LightOffset + Header.m_uiNumLights * sizeof(SceneCookLight));
+    Header.m_ui64VertexOffset = GL_AlignCookOffset(Header.m_ui64CameraOffset + Header.m_uiHasCamera * sizeof(SceneCookCamera));
+    Header.m_ui64IndexOffset = GL_AlignCookOffset(Header.m_ui64VertexOffset + (Uint64)Header.m_uiNumVertices * sizeof(CustomVertex));
+    Header.m_ui64FileSize = Header.m_ui64IndexOffset + (Uint64)Header.m_uiNumIndices * sizeof(GLuint);
+    unsigned char * p_Cooked = (unsigned char *)calloc(1, (size_t)Header.m_ui64FileSize);
+    memcpy(p_Cooked, &Header, sizeof(SceneCookHeader));
 
-        // Fill Vertex Buffer Object
-        glBindBuffer(GL_ARRAY_BUFFER, p_Mesh->m_uiVBO);
-        glBufferData(GL_ARRAY_BUFFER, uiSizeVertices, p_VBuffer, GL_STATIC_DRAW);
+    // Assign each mesh its range within the vertex and index arenas
+    SceneCookMesh * p_Meshes = (SceneCookMesh *)&p_Cooked[Header.m_ui64MeshOffset];
+    unsigned uiFirstVertex = 0;
+    unsigned uiFirstIndex = 0;
+    for (unsigned i = 0; i < p_Scene->mNumMeshes; i++) {
+        SceneCookMesh * p_Mesh = &p_Meshes[i];
+        p_Mesh->m_uiFirstVertex = uiFirstVertex;
+        p_Mesh->m_uiNumVertices = p_Scene->mMeshes[i]->mNumVertices;
+        p_Mesh->m_uiFirstIndex = uiFirstIndex;
+        p_Mesh->m_uiNumIndices = p_Scene->mMeshes[i]->mNumFaces * 3;
+        uiFirstVertex += p_Mesh->m_uiNumVertices;
+        uiFirstIndex += p_Mesh->m_uiNumIndices;
+    }
 
-        // Fill Index Buffer Object
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, p_Mesh->m_uiIBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, uiSizeIndices, p_IBuffer, GL_STATIC_DRAW);
+    // Convert meshes across worker threads
+    SceneCookTaskData CookTask;
+    CookTask.mp_Scene = p_Scene;
+    CookTask.mp_Meshes = p_Meshes;
+    CookTask.mp_Vertices = (CustomVertex *)&p_Cooked[Header.m_ui64VertexOffset];
+    CookTask.mp_Indices = (GLuint *)&p_Cooked[Header.m_ui64IndexOffset];
+    CookTask.mp_LODIndices = (GLuint **)calloc(max(p_Scene->mNumMeshes, 1u), sizeof(GLuint *));
+    unsigned uiNumThreads = (unsigned)SDL_GetCPUCount();
+    const char * p_cThreads = SDL_getenv("GL_SCENE_THREADS");
+    if ((p_cThreads != NULL) && (atoi(p_cThreads) > 0))
+        uiNumThreads = (unsigned)atoi(p_cThreads);
+    uiNumThreads = max(min(uiNumThreads, p_Scene->mNumMeshes), 1u);
 
-        // Cleanup allocated data
-        free(p_VBuffer);
-        free(p_IBuffer);
+    // Optionally convert first at 1, 2, 4.. threads up to the full count to report how conversion scales, each run writes the same output
+    if (SDL_getenv("GL_SCENE_THREAD_SCALING") != NULL) {
+        double dSingleTime = 0.0;
+        for (unsigned uiThreads = 1; uiThreads < uiNumThreads; uiThreads *= 2) {
+            const double dTime = GL_RunCookThreads(&CookTask, uiThreads);
+            for (unsigned i = 0; i < p_Scene->mNumMeshes; i++) {
+                free(CookTask.mp_LODIndices[i]);
+                CookTask.mp_LODIndices[i] = NULL;
+            }
+            dSingleTime = (uiThreads == 1) ? dTime : dSingleTime;
+            SDL_Log("Scene conversion scaling: %u threads %.2f ms, %.2fx speedup\n", uiThreads, dTime, dSingleTime / SDL_max(dTime, 0.001));
+        }
+        const double dTime = GL_RunCookThreads(&CookTask, uiNumThreads);
+        dSingleTime = (uiNumThreads == 1) ? dTime : dSingleTime;
+        SDL_Log("Scene conversion scaling: %u threads %.2f ms, %.2fx speedup\n", uiNumThreads, dTime, dSingleTime / SDL_max(dTime, 0.001));
+    } else {
+        const double dTime = GL_RunCookThreads(&CookTask, uiNumThreads);
+        SDL_Log("Converted %u meshes (%u vertices) on %u threads in %.2f ms\n", p_Scene->mNumMeshes, Header.m_uiNumVertices, uiNumThreads, dTime);
+    }
 
-        // Specify location of data within buffer
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CustomVertex), (const GLvoid *)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(CustomVertex), (const GLvoid *)offsetof(CustomVertex, v3Normal));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(CustomVertex), (const GLvoid *)offsetof(CustomVertex, v2UV));
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(CustomVertex), (const GLvoid *)offsetof(CustomVertex, v3Tangent));
-        glEnableVertexAttribArray(3);
-        ++SceneInfo.m_uiNumMeshes;
+    // Append the simplified levels after the full detail indices
+    for (unsigned i = 0; i < p_Scene->mNumMeshes; i++) {
+        for (unsigned j = 1; j < p_Meshes[i].m_uiNumLODs; j++) {
+            Header.m_uiNumLODIndices += p_Meshes[i].m_uiLODNumIndices[j];
+        }
+    }
+    Header.m_ui64FileSize += (Uint64)Header.m_uiNumLODIndices * sizeof(GLuint);
+    p_Cooked = (unsigned char *)realloc(p_Cooked, (size_t)Header.m_ui64FileSize);
+    memcpy(p_Cooked, &Header, sizeof(SceneCookHeader));
+    p_Meshes = (SceneCookMesh *)&p_Cooked[Header.m_ui64MeshOffset];
+    GLuint * p_LODBuffer = (GLuint *)&p_Cooked[Header.m_ui64IndexOffset];
+    unsigned uiLODIndex = Header.m_uiNumIndices;
+    for (unsigned i = 0; i < p_Scene->mNumMeshes; i++) {
+        SceneCookMesh * p_Mesh = &p_Meshes[i];
+        unsigned uiNumLODIndices = 0;
+        for (unsigned j = 1; j < p_Mesh->m_uiNumLODs; j++) {
+            p_Mesh->m_uiLODFirstIndex[j] += uiLODIndex;
+            uiNumLODIndices += p_Mesh->m_uiLODNumIndices[j];
+        }
+        if (uiNumLODIndices > 0)
+            memcpy(&p_LODBuffer[uiLODIndex], CookTask.mp_LODIndices[i], uiNumLODIndices * sizeof(GLuint));
+        uiLODIndex += uiNumLODIndices;
+        free(CookTask.mp_LODIndices[i]);
     }
+    free(CookTask.mp_LODIndices);
+    SDL_Log("Generated LODs with %u triangles in addition to %u full detail triangles\n", Header.m_uiNumLODIndices / 3, Header.m_uiNumIndices / 3);
 
-    // Allocate buffers for each material
-    SceneInfo.mp_Materials = (MaterialData *)realloc(SceneInfo.mp_Materials, p_Scene->mNumMaterials * sizeof(MaterialData));
     // Load in each material
+    SceneCookMaterial * p_Materials = (SceneCookMaterial *)&p_Cooked[Header.m_ui64MaterialOffset];
+    const aiTextureType TextureTypes[5] = {aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_SHININESS,
+                                           aiTextureType_NORMALS, aiTextureType_DISPLACEMENT};
     for (unsigned i = 0; i < p_Scene->mNumMaterials; i++) {
-        MaterialData * p_Material = &SceneInfo.mp_Materials[i];
-        // Generate the buffers
-        glGenTextures(5, &p_Material->m_uiDiffuse);
+        SceneCookMaterial * p_Material = &p_Materials[i];
 
-        // Get each texture from scene and load
+        // Get each texture name relative to the scene
         aiString sTexture;
-        aiGetMaterialTexture(p_Scene->mMaterials[i], aiTextureType_DIFFUSE, 0, &sTexture);
-        strcpy(&p_cPath[uiPathLength], sTexture.data);// Add scene path to filename
-        GL_LoadTextureKTX(p_Material->m_uiDiffuse, p_cPath);
-        aiGetMaterialTexture(p_Scene->mMaterials[i], aiTextureType_SPECULAR, 0, &sTexture);
-        strcpy(&p_cPath[uiPathLength], sTexture.data);
-        GL_LoadTextureKTX(p_Material->m_uiSpecular, p_cPath);
-        aiGetMaterialTexture(p_Scene->mMaterials[i], aiTextureType_SHININESS, 0, &sTexture);
-        strcpy(&p_cPath[uiPathLength], sTexture.data);
-        GL_LoadTextureKTX(p_Material->m_uiRough, p_cPath);
-        aiGetMaterialTexture(p_Scene->mMaterials[i], aiTextureType_NORMALS, 0, &sTexture);
-        strcpy(&p_cPath[uiPathLength], sTexture.data);
-        GL_LoadTextureKTX(p_Material->m_uiNormal, p_cPath);
-        aiGetMaterialTexture(p_Scene->mMaterials[i], aiTextureType_DISPLACEMENT, 0, &sTexture);
-        strcpy(&p_cPath[uiPathLength], sTexture.data);
-        GL_LoadTextureKTX(p_Material->m_uiBump, p_cPath);
+        for (unsigned j = 0; j < 5; j++) {
+            aiGetMaterialTexture(p_Scene->mMaterials[i], TextureTypes[j], 0, &sTexture);
+            strncpy(p_Material->m_cTextures[j], sTexture.data, sizeof(p_Material->m_cTextures[j]) - 1);
+        }
 
         // Check for emissive material
         aiColor4D EmissiveColour(0.f, 0.f, 0.f, 0.0f);
@@ -293,78 +565,704 @@ bool GL_LoadScene(const char * p_cSceneFile, SceneData & SceneInfo)
         aiGetMaterialColor(p_Scene->mMaterials[i], AI_MATKEY_COLOR_DIFFUSE, &DiffuseColour);
         p_Material->m_fEmissive = EmissiveColour.r / DiffuseColour.r;
 
-        // Check for transparent material
-        glBindTexture(GL_TEXTURE_2D, p_Material->m_uiDiffuse);
-        GLint iAlpha = 0;
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_ALPHA_SIZE, &iAlpha);
-        p_Material->m_bTransparent = (iAlpha > 0);
-
         // Check for reflective material
         float fReflectivity = 0.0f;
         aiGetMaterialFloat(p_Scene->mMaterials[i], AI_MATKEY_REFLECTIVITY, &fReflectivity);
-        p_Material->m_bReflective = (fReflectivity > 0.0f);
+        p_Material->m_uiReflective = (fReflectivity > 0.0f);
 
         //Get bump scale
         float fBumpScale = 0.2f;
         aiGetMaterialFloat(p_Scene->mMaterials[i], AI_MATKEY_BUMPSCALING, &fBumpScale);
         p_Material->m_fBumpScale = fBumpScale;
-        ++SceneInfo.m_uiNumMaterials;
     }
 
-    // Allocate buffers for each object
-    unsigned uiNumBackup = SceneInfo.m_uiNumObjects;
-    GL_LoadSceneNode(p_Scene->mRootNode, p_Scene, SceneInfo, glm::mat4(1.0f), false);
-    SceneInfo.mp_Objects = (ObjectData *)realloc(SceneInfo.mp_Objects, SceneInfo.m_uiNumObjects * sizeof(ObjectData));
-    SceneInfo.mp_TransObjects = (ObjectData *)realloc(SceneInfo.mp_TransObjects, SceneInfo.m_uiNumObjects * sizeof(ObjectData));
-    SceneInfo.mp_ReflecObjects = (ReflectObjectData *)realloc(SceneInfo.mp_ReflecObjects, SceneInfo.m_uiNumObjects * sizeof(ReflectObjectData));
-    SceneInfo.m_uiNumObjects = uiNumBackup; // Reset
-    // Load in each object
-    GL_LoadSceneNode(p_Scene->mRootNode, p_Scene, SceneInfo, glm::mat4(1.0f), true);
+    // Flatten the node tree into objects
+    unsigned uiNumObjects = 0;
+    GL_CookSceneNode(p_Scene->mRootNode, p_Scene, (SceneCookObject *)&p_Cooked[Header.m_ui64ObjectOffset], uiNumObjects, glm::mat4(1.0f));
 
-    // Allocate buffers for each light
-    SceneInfo.mp_PointLights = (PointLightData *)realloc(SceneInfo.mp_PointLights, p_Scene->mNumLights * sizeof(PointLightData));
-    SceneInfo.mp_SpotLights = (SpotLightData *)realloc(SceneInfo.mp_SpotLights, p_Scene->mNumLights * sizeof(SpotLightData));
     // Load in each light
+    SceneCookLight * p_Light = (SceneCookLight *)&p_Cooked[Header.m_ui64LightOffset];
     for (unsigned i = 0; i < p_Scene->mNumLights; i++) {
         const aiLight * p_AILight = p_Scene->mLights[i];
+        if ((p_AILight->mType != aiLightSource_POINT) && (p_AILight->mType != aiLightSource_SPOT))
+            continue;
         mat4 m4Ret(1.0f);
         GL_FindSceneNode(p_Scene->mRootNode, p_AILight->mName, p_Scene, m4Ret, m4Ret);
-        if (p_AILight->mType == aiLightSource_POINT) {
+        p_Light->m_uiType = p_AILight->mType;
+        vec3 v3Position = vec3(p_AILight->mPosition.x,
+                               p_AILight->mPosition.y,
+                               p_AILight->mPosition.z);
+        p_Light->m_v3Position = (vec3)(m4Ret * vec4(v3Position, 1.0f));
+        vec3 v3Direction = vec3(p_AILight->mDirection.x,
+                                p_AILight->mDirection.y,
+                                p_AILight->mDirection.z);
+        p_Light->m_v3Direction = (p_AILight->mType == aiLightSource_SPOT) ? -normalize(mat3(m4Ret) * v3Direction) : vec3(0.0f);
+        p_Light->m_fAngle = cos(p_AILight->mAngleOuterCone / 2.0f);
+        p_Light->m_v3Colour = vec3(p_AILight->mColorDiffuse.r,
+                                   p_AILight->mColorDiffuse.g,
+                                   p_AILight->mColorDiffuse.b);
+        // Divide linear and quadratic components by 2 to compensate for using a attenuation constant of 1
+        p_Light->m_v3Falloff = vec3(
+            (p_AILight->mAttenuationConstant == 0.0f) ? 1.0f : p_AILight->mAttenuationConstant,
+            p_AILight->mAttenuationLinear / 2.0f,
+            p_AILight->mAttenuationQuadratic / 2.0f);
+        ++p_Light;
+    }
+
+    // Load in camera
+    if (Header.m_uiHasCamera) {
+        SceneCookCamera * p_Camera = (SceneCookCamera *)&p_Cooked[Header.m_ui64CameraOffset];
+        const aiCamera * p_AICamera = p_Scene->mCameras[0];
+        mat4 m4Ret(1.0f);
+        GL_FindSceneNode(p_Scene->mRootNode, p_AICamera->mName, p_Scene, m4Ret, m4Ret);
+        vec4 v4Position = vec4(p_AICamera->mPosition.x,
+                               p_AICamera->mPosition.y,
+                               p_AICamera->mPosition.z, 1.0f);
+        p_Camera->m_v3Position = (vec3)(m4Ret * v4Position);
+        vec3 v3Direction = vec3(p_AICamera->mLookAt.x,
+                                p_AICamera->mLookAt.y,
+                                p_AICamera->mLookAt.z);
+        v3Direction = normalize(mat3(m4Ret) * v3Direction);
+        p_Camera->m_v3Direction = v3Direction;
+        vec3 v3Up = normalize(mat3(m4Ret) * vec3(p_AICamera->mUp.x,
+                                                 p_AICamera->mUp.y,
+                                                 p_AICamera->mUp.z));
+        // Assimp doesn't store a right vector so we calculate from up and direction
+        p_Camera->m_v3Right = cross(v3Direction, v3Up);
+        p_Camera->m_fFOV = p_AICamera->mHorizontalFOV;
+        p_Camera->m_fNear = p_AICamera->mClipPlaneNear;
+        p_Camera->m_fFar = p_AICamera->mClipPlaneFar;
+    }
+
+    // Destroy the scene
+    aiReleaseImport(p_Scene);
+    return p_Cooked;
+}
+
+vec2 GL_OctEncode(const vec3 & v3Dir)
+{
+    // Project onto the octahedron and fold the lower half over the diagonals
+    float fLength = fabsf(v3Dir.x) + fabsf(v3Dir.y) + fabsf(v3Dir.z);
+    if (fLength == 0.0f)
+        return vec2(0.0f);
+    vec3 v3Oct = v3Dir / fLength;
+    if (v3Oct.z >= 0.0f)
+        return vec2(v3Oct);
+    return vec2((1.0f - fabsf(v3Oct.y)) * ((v3Oct.x >= 0.0f) ? 1.0f : -1.0f),
+                (1.0f - fabsf(v3Oct.x)) * ((v3Oct.y >= 0.0f) ? 1.0f : -1.0f));
+}
+
+vec3 GL_OctDecode(const vec2 & v2Oct)
+{
+    // Unfold the octahedron back onto the sphere
+    vec3 v3Dir = vec3(v2Oct, 1.0f - fabsf(v2Oct.x) - fabsf(v2Oct.y));
+    float fFold = max(-v3Dir.z, 0.0f);
+    v3Dir.x += (v3Dir.x >= 0.0f) ? -fFold : fFold;
+    v3Dir.y += (v3Dir.y >= 0.0f) ? -fFold : fFold;
+    return normalize(v3Dir);
+}
+
+mat4 GL_PackedPositionDecode(const SceneCookMesh * p_Mesh)
+{
+    // Scale and offset from the unit cube back to the meshes bounding box
+    mat4 m4Decode(1.0f);
+    vec3 v3Extent = p_Mesh->m_v3AABBMax - p_Mesh->m_v3AABBMin;
+    m4Decode[0][0] = v3Extent.x;
+    m4Decode[1][1] = v3Extent.y;
+    m4Decode[2][2] = v3Extent.z;
+    m4Decode[3] = vec4(p_Mesh->m_v3AABBMin, 1.0f);
+    return m4Decode;
+}
+
+float GL_AngleError(const vec3 & v3Source, const vec3 & v3Decoded)
+{
+    float fLength = length(v3Source);
+    if (fLength == 0.0f)
+        return 0.0f;
+    return degrees(acos(clamp(dot(v3Source / fLength, v3Decoded), -1.0f, 1.0f)));
+}
+
+void GL_PackVertices(const CustomVertex * p_Vertices, const SceneCookMesh * p_Meshes, unsigned uiNumMeshes, PackedVertex * p_Packed)
+{
+    GL_TRACE_ZONE("GL_PackVertices");
+    // Track the largest error between source and decoded attributes
+    float fMaxPosition = 0.0f, fMaxNormal = 0.0f, fMaxTangent = 0.0f, fMaxUV = 0.0f;
+    double dSumNormal = 0.0, dSumTangent = 0.0;
+    unsigned uiNumVertices = 0;
+    for (unsigned i = 0; i < uiNumMeshes; i++) {
+        const SceneCookMesh * p_Mesh = &p_Meshes[i];
+        const mat4 m4Decode = GL_PackedPositionDecode(p_Mesh);
+        const vec3 v3Extent = p_Mesh->m_v3AABBMax - p_Mesh->m_v3AABBMin;
+        const vec3 v3InvExtent = vec3((v3Extent.x > 0.0f) ? 1.0f / v3Extent.x : 0.0f,
+                                      (v3Extent.y > 0.0f) ? 1.0f / v3Extent.y : 0.0f,
+                                      (v3Extent.z > 0.0f) ? 1.0f / v3Extent.z : 0.0f);
+        for (unsigned j = p_Mesh->m_uiFirstVertex; j < p_Mesh->m_uiFirstVertex + p_Mesh->m_uiNumVertices; j++) {
+            const CustomVertex * p_Vertex = &p_Vertices[j];
+            PackedVertex * p_PVertex = &p_Packed[j];
+
+            // Position as 16bit normalised within the bounding box
+            vec3 v3Local = (p_Vertex->v3Position - p_Mesh->m_v3AABBMin) * v3InvExtent;
+            p_PVertex->usPosition[0] = packUnorm1x16(v3Local.x);
+            p_PVertex->usPosition[1] = packUnorm1x16(v3Local.y);
+            p_PVertex->usPosition[2] = packUnorm1x16(v3Local.z);
+            p_PVertex->usPosition[3] = 0;
+
+            // Normal and tangent as 16bit octahedral
+            vec2 v2Normal = GL_OctEncode(p_Vertex->v3Normal);
+            p_PVertex->sNormal[0] = (GLshort)packSnorm1x16(v2Normal.x);
+            p_PVertex->sNormal[1] = (GLshort)packSnorm1x16(v2Normal.y);
+            vec2 v2Tangent = GL_OctEncode(p_Vertex->v3Tangent);
+            p_PVertex->sTangent[0] = (GLshort)packSnorm1x16(v2Tangent.x);
+            p_PVertex->sTangent[1] = (GLshort)packSnorm1x16(v2Tangent.y);
+
+            // UV as half float
+            p_PVertex->usUV[0] = packHalf1x16(p_Vertex->v2UV.x);
+            p_PVertex->usUV[1] = packHalf1x16(p_Vertex->v2UV.y);
+
+            // Decode again to measure the error
+            vec3 v3Position = vec3(m4Decode * vec4(unpackUnorm1x16(p_PVertex->usPosition[0]),
+                                                   unpackUnorm1x16(p_PVertex->usPosition[1]),
+                                                   unpackUnorm1x16(p_PVertex->usPosition[2]), 1.0f));
+            fMaxPosition = max(fMaxPosition, length(v3Position - p_Vertex->v3Position));
+            float fNormal = GL_AngleError(p_Vertex->v3Normal, GL_OctDecode(vec2(unpackSnorm1x16(p_PVertex->sNormal[0]),
+                                                                                unpackSnorm1x16(p_PVertex->sNormal[1]))));
+            fMaxNormal = max(fMaxNormal, fNormal);
+            dSumNormal += fNormal;
+            float fTangent = GL_AngleError(p_Vertex->v3Tangent, GL_OctDecode(vec2(unpackSnorm1x16(p_PVertex->sTangent[0]),
+                                                                                  unpackSnorm1x16(p_PVertex->sTangent[1]))));
+            fMaxTangent = max(fMaxTangent, fTangent);
+            dSumTangent += fTangent;
+            vec2 v2UV = vec2(unpackHalf1x16(p_PVertex->usUV[0]), unpackHalf1x16(p_PVertex->usUV[1]));
+            fMaxUV = max(fMaxUV, max(fabsf(v2UV.x - p_Vertex->v2UV.x), fabsf(v2UV.y - p_Vertex->v2UV.y)));
+            ++uiNumVertices;
+        }
+    }
+    SDL_Log("Packed vertex error: position max %g, normal max %.4f avg %.4f deg, tangent max %.4f avg %.4f deg, UV max %g\n",
+            fMaxPosition, fMaxNormal, (uiNumVertices > 0) ? dSumNormal / uiNumVertices : 0.0,
+            fMaxTangent, (uiNumVertices > 0) ? dSumTangent / uiNumVertices : 0.0, fMaxUV);
+}
+
+void GL_BuildMeshletBounds(const CustomVertex * p_Vertices, const GLuint * p_Indices, unsigned uiNumIndices, MeshletData * p_Meshlet)
+{
+    // Get bounding box of used vertices
+    vec3 v3AABBMin = vec3(FLT_MAX);
+    vec3 v3AABBMax = vec3(-FLT_MAX);
+    for (unsigned i = 0; i < uiNumIndices; i++) {
+        v3AABBMin = min(v3AABBMin, p_Vertices[p_Indices[i]].v3Position);
+        v3AABBMax = max(v3AABBMax, p_Vertices[p_Indices[i]].v3Position);
+    }
+
+    // Calculate bounding sphere around box centre
+    vec3 v3Centre = v3AABBMin + ((v3AABBMax - v3AABBMin) * 0.5f);
+    float fRadius = 0.0f;
+    for (unsigned i = 0; i < uiNumIndices; i++) {
+        fRadius = max(fRadius, length(p_Vertices[p_Indices[i]].v3Position - v3Centre));
+    }
+    p_Meshlet->m_v4Sphere = vec4(v3Centre, fRadius);
+
+    // Average the face normals to get the cone axis
+    vec3 v3Axis = vec3(0.0f);
+    for (unsigned i = 0; i < uiNumIndices; i += 3) {
+        const vec3 & v3A = p_Vertices[p_Indices[i]].v3Position;
+        vec3 v3Normal = cross(p_Vertices[p_Indices[i + 1]].v3Position - v3A, p_Vertices[p_Indices[i + 2]].v3Position - v3A);
+        float fLength = length(v3Normal);
+        if (fLength > 0.0f)
+            v3Axis += v3Normal / fLength;
+    }
+    float fAxisLength = length(v3Axis);
+
+    // Find widest face normal, vertex normals are also included as tessellation curves the surface towards them
+    float fMinDot = 1.0f;
+    if (fAxisLength > 0.0001f) {
+        v3Axis /= fAxisLength;
+        for (unsigned i = 0; i < uiNumIndices; i += 3) {
+            const vec3 & v3A = p_Vertices[p_Indices[i]].v3Position;
+            vec3 v3Normal = cross(p_Vertices[p_Indices[i + 1]].v3Position - v3A, p_Vertices[p_Indices[i + 2]].v3Position - v3A);
+            float fLength = length(v3Normal);
+            if (fLength > 0.0f)
+                fMinDot = min(fMinDot, dot(v3Axis, v3Normal / fLength));
+        }
+        for (unsigned i = 0; i < uiNumIndices; i++) {
+            fMinDot = min(fMinDot, dot(v3Axis, p_Vertices[p_Indices[i]].v3Normal));
+        }
+    } else
+        fMinDot = -1.0f;
+
+    // Store sine of cone angle, a cutoff of 1 can never be culled
+    if (fMinDot <= 0.1f)
+        p_Meshlet->m_v4Cone = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    else
+        p_Meshlet->m_v4Cone = vec4(v3Axis, sqrtf(1.0f - (fMinDot * fMinDot)));
+}
+
+unsigned GL_BuildMeshlets(const CustomVertex * p_Vertices, const GLuint * p_Indices, const SceneCookMesh * p_Mesh, unsigned uiMesh,
+                          unsigned * p_uiStamps, MeshletData * p_Meshlets)
+{
+    // Split triangles in order, these are already cache optimised so neighbours share vertices
+    memset(p_uiStamps, 0, p_Mesh->m_uiNumVertices * sizeof(unsigned));
+    const GLuint * p_MeshIndices = &p_Indices[p_Mesh->m_uiFirstIndex];
+    const CustomVertex * p_MeshVertices = &p_Vertices[p_Mesh->m_uiFirstVertex];
+    unsigned uiNumMeshlets = 0;
+    unsigned uiStart = 0;
+    unsigned uiNumVertices = 0;
+    for (unsigned i = 0; i <= p_Mesh->m_uiNumIndices; i += 3) {
+        // Count vertices not already in the current meshlet
+        unsigned uiNewVertices = 0;
+        if (i < p_Mesh->m_uiNumIndices) {
+            for (unsigned j = 0; j < 3; j++) {
+                uiNewVertices += (p_uiStamps[p_MeshIndices[i + j]] != uiNumMeshlets + 1);
+            }
+        }
+
+        // Close the current meshlet once full or at end of mesh
+        if ((i > uiStart) && ((i == p_Mesh->m_uiNumIndices) ||
+            (uiNumVertices + uiNewVertices > g_uiMeshletMaxVertices) || ((i - uiStart) / 3 >= g_uiMeshletMaxTriangles))) {
+            // Output meshlet if not just counting
+            if (p_Meshlets != NULL) {
+                MeshletData * p_Meshlet = &p_Meshlets[uiNumMeshlets];
+                p_Meshlet->m_uiFirstIndex = p_Mesh->m_uiFirstIndex + uiStart;
+                p_Meshlet->m_uiNumIndices = i - uiStart;
+                p_Meshlet->m_iBaseVertex = (GLint)p_Mesh->m_uiFirstVertex;
+                p_Meshlet->m_uiMesh = uiMesh;
+                GL_BuildMeshletBounds(p_MeshVertices, &p_MeshIndices[uiStart], i - uiStart, p_Meshlet);
+            }
+            ++uiNumMeshlets;
+            uiStart = i;
+            uiNumVertices = 0;
+        }
+        if (i == p_Mesh->m_uiNumIndices)
+            break;
+
+        // Add triangles vertices to current meshlet
+        for (unsigned j = 0; j < 3; j++) {
+            if (p_uiStamps[p_MeshIndices[i + j]] != uiNumMeshlets + 1) {
+                p_uiStamps[p_MeshIndices[i + j]] = uiNumMeshlets + 1;
+                ++uiNumVertices;
+            }
+        }
+    }
+    return uiNumMeshlets;
+}
+
+bool GL_CheckCookedScene(const unsigned char * p_Cooked, size_t uiSize, Uint64 ui64SourceHash, Uint64 ui64SourceSize)
+{
+    // Check cooked data matches both this build and the current source file
+    if (uiSize < sizeof(SceneCookHeader))
+        return false;
+    const SceneCookHeader * p_Header = (const SceneCookHeader *)p_Cooked;
+    return (memcmp(p_Header->m_cMagic, g_cSceneCookMagic, sizeof(p_Header->m_cMagic)) == 0) &&
+           (p_Header->m_uiVersion == g_uiSceneCookVersion) &&
+           (p_Header->m_uiVertexSize == sizeof(CustomVertex)) &&
+           (p_Header->m_ui64SourceHash == ui64SourceHash) &&
+           (p_Header->m_ui64SourceSize == ui64SourceSize) &&
+           (p_Header->m_ui64FileSize == uiSize);
+}
+
+GLuint GL_LoadSceneTexture(SceneTextureCache & Cache, const char * p_cTextureFile, const GLubyte * p_ucPlaceholder, SceneData & SceneInfo)
+{
+    // Reuse the texture if the file has already been loaded
+    const Uint64 ui64Hash = GL_HashData((const unsigned char *)p_cTextureFile, strlen(p_cTextureFile));
+    for (unsigned i = 0; i < Cache.m_uiNumEntries; i++) {
+        SceneTextureCacheData * p_Entry = &Cache.mp_Entries[i];
+        if ((p_Entry->m_ui64Hash == ui64Hash) && (strcmp(p_Entry->mp_cPath, p_cTextureFile) == 0)) {
+            ++Cache.m_uiNumHits;
+            ++p_Entry->m_uiNumHits;
+            Cache.m_ui64SavedTicks += p_Entry->m_ui64LoadTicks;
+            return p_Entry->m_uiTexture;
+        }
+    }
+
+    // Queue the file for streaming into a new texture owned by the scene
+    const Uint64 ui64Start = SDL_GetPerformanceCounter();
+    GLuint uiTexture;
+    glGenTextures(1, &uiTexture);
+    SceneTextureCacheData * p_Entry = &Cache.mp_Entries[Cache.m_uiNumEntries++];
+    GL_StreamTexture(uiTexture, p_cTextureFile, p_ucPlaceholder);
+    p_Entry->m_ui64LoadTicks = SDL_GetPerformanceCounter() - ui64Start;
+    p_Entry->m_uiNumHits = 0;
+    p_Entry->m_ui64Hash = ui64Hash;
+    p_Entry->mp_cPath = (char *)malloc(strlen(p_cTextureFile) + 1);
+    strcpy(p_Entry->mp_cPath, p_cTextureFile);
+    p_Entry->m_uiTexture = uiTexture;
+    SceneInfo.mp_Textures[SceneInfo.m_uiNumTextures++] = uiTexture;
+    return uiTexture;
+}
+
+void GL_SetObjectTransform(SceneData & SceneInfo, unsigned uiObject, const mat4 & m4Transform)
+{
+    // Update the transform stream and its copy in the shared transform buffer
+    SceneInfo.mp_ObjectTransforms[uiObject] = m4Transform;
+    memcpy(&SceneInfo.mp_Transforms[SceneInfo.mp_ObjectDraws[uiObject].m_uiTransformOffset], &m4Transform, sizeof(mat4));
+
+    // Move the meshes bounding sphere into world space
+    const MeshData * p_Mesh = &SceneInfo.mp_Meshes[SceneInfo.mp_ObjectDraws[uiObject].m_uiMesh];
+    const vec4 & v4Sphere = p_Mesh->m_v4Sphere;
+    const float fScale = max(length(vec3(m4Transform[0])), max(length(vec3(m4Transform[1])), length(vec3(m4Transform[2]))));
+    SceneInfo.mp_ObjectBounds[uiObject] = vec4(vec3(m4Transform * vec4(vec3(v4Sphere), 1.0f)), v4Sphere.w * fScale);
+
+    // Move the meshes bounding box into world space keeping it axis aligned
+    const vec3 v3Centre = vec3(m4Transform * vec4((p_Mesh->m_v3AABBMin + p_Mesh->m_v3AABBMax) * 0.5f, 1.0f));
+    const vec3 v3HalfSize = (p_Mesh->m_v3AABBMax - p_Mesh->m_v3AABBMin) * 0.5f;
+    const vec3 v3Extent = (abs(vec3(m4Transform[0])) * v3HalfSize.x) + (abs(vec3(m4Transform[1])) * v3HalfSize.y) +
+        (abs(vec3(m4Transform[2])) * v3HalfSize.z);
+    SceneInfo.mp_ObjectAABBs[uiObject].m_v3Min = v3Centre - v3Extent;
+    SceneInfo.mp_ObjectAABBs[uiObject].m_v3Max = v3Centre + v3Extent;
+}
+
+void GL_LoadCookedScene(const unsigned char * p_Cooked, const char * p_cSceneFile, SceneData & SceneInfo)
+{
+    const SceneCookHeader * p_Header = (const SceneCookHeader *)p_Cooked;
+
+    // Get import file base path
+    char * p_cPath = (char *)malloc(255);
+    *p_cPath = '\0';
+    unsigned uiPathLength = 0;
+    const char * p_cDirSlash = strrchr(p_cSceneFile, '/');
+    if (p_cDirSlash != NULL) {
+        uiPathLength = (unsigned)(p_cDirSlash - p_cSceneFile) + 1;
+        strncat(p_cPath, p_cSceneFile, uiPathLength);
+    }
+    // Generate the shared buffers
+    if (SceneInfo.m_uiVAO == 0) {
+        glGenVertexArrays(1, &SceneInfo.m_uiVAO);
+        glGenBuffers(1, &SceneInfo.m_uiVBO);
+        glGenBuffers(1, &SceneInfo.m_uiIBO);
+    }
+
+    //Bind the VAO
+    glBindVertexArray(SceneInfo.m_uiVAO);
+
+    // Fill Vertex Buffer Object with every mesh
+    const CustomVertex * p_VBuffer = (const CustomVertex *)&p_Cooked[p_Header->m_ui64VertexOffset];
+    const SceneCookMesh * p_CookMeshes = (const SceneCookMesh *)&p_Cooked[p_Header->m_ui64MeshOffset];
+    const unsigned uiVertexSize = (SceneInfo.m_bPackedVertices) ? sizeof(PackedVertex) : sizeof(CustomVertex);
+    SceneInfo.m_uiVertexSize = uiVertexSize;
+    glBindBuffer(GL_ARRAY_BUFFER, SceneInfo.m_uiVBO);
+    if (SceneInfo.m_bPackedVertices) {
+        // Convert to the compact format before upload
+        PackedVertex * p_PBuffer = (PackedVertex *)malloc(p_Header->m_uiNumVertices * sizeof(PackedVertex));
+        GL_PackVertices(p_VBuffer, p_CookMeshes, p_Header->m_uiNumMeshes, p_PBuffer);
+        glBufferData(GL_ARRAY_BUFFER, p_Header->m_uiNumVertices * sizeof(PackedVertex), p_PBuffer, GL_STATIC_DRAW);
+        free(p_PBuffer);
+    } else {
+        // Use directly from the cooked data
+        glBufferData(GL_ARRAY_BUFFER, p_Header->m_uiNumVertices * sizeof(CustomVertex), p_VBuffer, GL_STATIC_DRAW);
+    }
+    SDL_Log("Scene vertex buffer: %u vertices, %u bytes each, %.2f MB\n", p_Header->m_uiNumVertices, uiVertexSize,
+            (double)p_Header->m_uiNumVertices * uiVertexSize / (1024.0 * 1024.0));
+
+    // Fill Index Buffer Object
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, SceneInfo.m_uiIBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (p_Header->m_uiNumIndices + p_Header->m_uiNumLODIndices) * sizeof(GLuint),
+                 &p_Cooked[p_Header->m_ui64IndexOffset], GL_STATIC_DRAW);
+
+    // Specify location of data within buffer
+    if (SceneInfo.m_bPackedVertices) {
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (const GLvoid *)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (const GLvoid *)offsetof(PackedVertex, sNormal));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (const GLvoid *)offsetof(PackedVertex, usUV));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (const GLvoid *)offsetof(PackedVertex, sTangent));
+        glEnableVertexAttribArray(3);
+    } else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CustomVertex), (const GLvoid *)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(CustomVertex), (const GLvoid *)offsetof(CustomVertex, v3Normal));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(CustomVertex), (const GLvoid *)offsetof(CustomVertex, v2UV));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(CustomVertex), (const GLvoid *)offsetof(CustomVertex, v3Tangent));
+        glEnableVertexAttribArray(3);
+    }
+
+    // Allocate buffers for each mesh
+    SceneInfo.mp_Meshes = (MeshData *)realloc(SceneInfo.mp_Meshes, p_Header->m_uiNumMeshes * sizeof(MeshData));
+    // Load in each meshes range within the shared buffers
+    for (unsigned i = 0; i < p_Header->m_uiNumMeshes; i++) {
+        MeshData * p_Mesh = &SceneInfo.mp_Meshes[i];
+        const SceneCookMesh * p_CookMesh = &p_CookMeshes[i];
+        p_Mesh->m_uiFirstIndex = p_CookMesh->m_uiFirstIndex;
+        p_Mesh->m_uiNumIndices = p_CookMesh->m_uiNumIndices;
+        p_Mesh->m_iBaseVertex = (GLint)p_CookMesh->m_uiFirstVertex;
+        p_Mesh->m_v4Sphere = vec4((p_CookMesh->m_v3AABBMin + p_CookMesh->m_v3AABBMax) * 0.5f,
+                                  length(p_CookMesh->m_v3AABBMax - p_CookMesh->m_v3AABBMin) * 0.5f);
+        p_Mesh->m_v3AABBMin = p_CookMesh->m_v3AABBMin;
+        p_Mesh->m_v3AABBMax = p_CookMesh->m_v3AABBMax;
+        p_Mesh->m_uiNumLODs = p_CookMesh->m_uiNumLODs;
+        for (unsigned j = 0; j < p_Mesh->m_uiNumLODs; j++) {
+            p_Mesh->m_LODs[j].m_uiFirstIndex = p_CookMesh->m_uiLODFirstIndex[j];
+            p_Mesh->m_LODs[j].m_uiNumIndices = p_CookMesh->m_uiLODNumIndices[j];
+            p_Mesh->m_LODs[j].m_fError = p_CookMesh->m_fLODError[j];
+        }
+        ++SceneInfo.m_uiNumMeshes;
+    }
+
+    // Split each mesh into meshlets for cluster culling, first pass just counts them
+    const Uint64 ui64MeshletStart = SDL_GetPerformanceCounter();
+    const GLuint * p_IBuffer = (const GLuint *)&p_Cooked[p_Header->m_ui64IndexOffset];
+    unsigned uiMaxVertices = 0;
+    for (unsigned i = 0; i < p_Header->m_uiNumMeshes; i++) {
+        uiMaxVertices = max(uiMaxVertices, p_CookMeshes[i].m_uiNumVertices);
+    }
+    unsigned * p_uiStamps = (unsigned *)malloc(max(uiMaxVertices, 1u) * sizeof(unsigned));
+    SceneInfo.m_uiNumMeshlets = 0;
+    for (unsigned i = 0; i < p_Header->m_uiNumMeshes; i++) {
+        MeshData * p_Mesh = &SceneInfo.mp_Meshes[i];
+        p_Mesh->m_uiFirstMeshlet = SceneInfo.m_uiNumMeshlets;
+        p_Mesh->m_uiNumMeshlets = GL_BuildMeshlets(p_VBuffer, p_IBuffer, &p_CookMeshes[i], i, p_uiStamps, NULL);
+        SceneInfo.m_uiNumMeshlets += p_Mesh->m_uiNumMeshlets;
+    }
+    SceneInfo.mp_Meshlets = (MeshletData *)realloc(SceneInfo.mp_Meshlets, max(SceneInfo.m_uiNumMeshlets, 1u) * sizeof(MeshletData));
+    for (unsigned i = 0; i < p_Header->m_uiNumMeshes; i++) {
+        GL_BuildMeshlets(p_VBuffer, p_IBuffer, &p_CookMeshes[i], i, p_uiStamps, &SceneInfo.mp_Meshlets[SceneInfo.mp_Meshes[i].m_uiFirstMeshlet]);
+    }
+    free(p_uiStamps);
+    SDL_Log("Built %u meshlets in %.2f ms\n", SceneInfo.m_uiNumMeshlets,
+            (double)(SDL_GetPerformanceCounter() - ui64MeshletStart) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+
+    // Fill meshlet SSBO for use in shaders
+    if (SceneInfo.m_uiMeshletSSBO == 0)
+        glGenBuffers(1, &SceneInfo.m_uiMeshletSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, SceneInfo.m_uiMeshletSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, SceneInfo.m_uiNumMeshlets * sizeof(MeshletData), SceneInfo.mp_Meshlets, GL_STATIC_DRAW);
+
+    // Allocate buffers for each material and texture
+    SceneInfo.mp_Materials = (MaterialData *)realloc(SceneInfo.mp_Materials, p_Header->m_uiNumMaterials * sizeof(MaterialData));
+    SceneInfo.mp_Textures = (GLuint *)realloc(SceneInfo.mp_Textures, max(p_Header->m_uiNumMaterials * 5, 1u) * sizeof(GLuint));
+    unsigned * p_uiMaterialRemap = (unsigned *)malloc(max(p_Header->m_uiNumMaterials, 1u) * sizeof(unsigned));
+    Uint64 * p_ui64MaterialHashes = (Uint64 *)malloc(max(p_Header->m_uiNumMaterials, 1u) * sizeof(Uint64));
+    SceneTextureCache TextureCache;
+    memset(&TextureCache, 0, sizeof(SceneTextureCache));
+    TextureCache.mp_Entries = (SceneTextureCacheData *)malloc(max(p_Header->m_uiNumMaterials * 5, 1u) * sizeof(SceneTextureCacheData));
+    unsigned uiSharedMaterials = 0;
+    // Textures show a neutral placeholder for each slot until streamed in
+    const GLubyte ucPlaceholders[5][4] = {{128, 128, 128, 255}, {64, 64, 64, 255}, {128, 128, 128, 255}, {128, 128, 255, 255}, {0, 0, 0, 255}};
+    GL_InitTextureStream();
+    const Uint64 ui64TextureStart = SDL_GetPerformanceCounter();
+    const unsigned uiFirstMaterial = SceneInfo.m_uiNumMaterials;
+    // Load in each material
+    const SceneCookMaterial * p_CookMaterials = (const SceneCookMaterial *)&p_Cooked[p_Header->m_ui64MaterialOffset];
+    for (unsigned i = 0; i < p_Header->m_uiNumMaterials; i++) {
+        const SceneCookMaterial * p_CookMaterial = &p_CookMaterials[i];
+
+        // Share any earlier material with identical contents
+        p_ui64MaterialHashes[i] = GL_HashData((const unsigned char *)p_CookMaterial, sizeof(SceneCookMaterial));
+        unsigned uiMatch = 0;
+        while ((uiMatch < i) && ((p_ui64MaterialHashes[uiMatch] != p_ui64MaterialHashes[i]) ||
+                                 (memcmp(&p_CookMaterials[uiMatch], p_CookMaterial, sizeof(SceneCookMaterial)) != 0)))
+            ++uiMatch;
+        if (uiMatch < i) {
+            p_uiMaterialRemap[i] = p_uiMaterialRemap[uiMatch];
+            ++uiSharedMaterials;
+            // Record the texture loads that were avoided
+            for (unsigned j = 0; j < 5; j++) {
+                strcpy(&p_cPath[uiPathLength], p_CookMaterial->m_cTextures[j]);
+                GL_LoadSceneTexture(TextureCache, p_cPath, ucPlaceholders[j], SceneInfo);
+            }
+            continue;
+        }
+        p_uiMaterialRemap[i] = SceneInfo.m_uiNumMaterials;
+        MaterialData * p_Material = &SceneInfo.mp_Materials[SceneInfo.m_uiNumMaterials];
+
+        // Load each texture in order diffuse, specular, rough, normal, bump
+        GLuint * p_uiTextures[] = {&p_Material->m_uiDiffuse, &p_Material->m_uiSpecular, &p_Material->m_uiRough, &p_Material->m_uiNormal, &p_Material->m_uiBump};
+        for (unsigned j = 0; j < 5; j++) {
+            strcpy(&p_cPath[uiPathLength], p_CookMaterial->m_cTextures[j]);// Add scene path to filename
+            *p_uiTextures[j] = GL_LoadSceneTexture(TextureCache, p_cPath, ucPlaceholders[j], SceneInfo);
+        }
+        p_Material->m_fEmissive = p_CookMaterial->m_fEmissive;
+        p_Material->m_bReflective = (p_CookMaterial->m_uiReflective != 0);
+        p_Material->m_fBumpScale = p_CookMaterial->m_fBumpScale;
+        ++SceneInfo.m_uiNumMaterials;
+    }
+    // Read every queued header then start decoding in the background
+    GL_StartTextureStream();
+
+    // Check for transparent materials using the diffuse texture format
+    for (unsigned i = uiFirstMaterial; i < SceneInfo.m_uiNumMaterials; i++) {
+        Uint64 ui64Bytes;
+        GL_GetStreamTextureInfo(SceneInfo.mp_Materials[i].m_uiDiffuse, SceneInfo.mp_Materials[i].m_bTransparent, ui64Bytes);
+    }
+    for (unsigned i = 0; i < TextureCache.m_uiNumEntries; i++) {
+        bool bAlpha;
+        Uint64 ui64Bytes;
+        GL_GetStreamTextureInfo(TextureCache.mp_Entries[i].m_uiTexture, bAlpha, ui64Bytes);
+        TextureCache.m_ui64SavedBytes += ui64Bytes * TextureCache.mp_Entries[i].m_uiNumHits;
+    }
+    SDL_Log("Queued %u textures for %u materials in %.2f ms, sharing %u materials and %u texture loads saved %.2f MB of VRAM and %.2f ms\n",
+            TextureCache.m_uiNumEntries, SceneInfo.m_uiNumMaterials,
+            (double)(SDL_GetPerformanceCounter() - ui64TextureStart) * 1000.0 / (double)SDL_GetPerformanceFrequency(),
+            uiSharedMaterials, TextureCache.m_uiNumHits, (double)TextureCache.m_ui64SavedBytes / (1024.0 * 1024.0),
+            (double)TextureCache.m_ui64SavedTicks * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    for (unsigned i = 0; i < TextureCache.m_uiNumEntries; i++) {
+        free(TextureCache.mp_Entries[i].mp_cPath);
+    }
+    free(TextureCache.mp_Entries);
+    free(p_ui64MaterialHashes);
+
+    // Allocate buffers for each object
+    const unsigned uiNumObjects = SceneInfo.m_uiNumObjects + p_Header->m_uiNumObjects;
+    SceneInfo.mp_ObjectDraws = (ObjectDrawData *)realloc(SceneInfo.mp_ObjectDraws, uiNumObjects * sizeof(ObjectDrawData));
+    SceneInfo.mp_ObjectTransforms = (mat4 *)realloc(SceneInfo.mp_ObjectTransforms, uiNumObjects * sizeof(mat4));
+    SceneInfo.mp_ObjectBounds = (vec4 *)realloc(SceneInfo.mp_ObjectBounds, uiNumObjects * sizeof(vec4));
+    SceneInfo.mp_ObjectAABBs = (AABBData *)realloc(SceneInfo.mp_ObjectAABBs, uiNumObjects * sizeof(AABBData));
+    SceneInfo.mp_uiObjectMaterials = (unsigned *)realloc(SceneInfo.mp_uiObjectMaterials, uiNumObjects * sizeof(unsigned));
+    SceneInfo.mp_ucObjectFlags = (unsigned char *)realloc(SceneInfo.mp_ucObjectFlags, uiNumObjects * sizeof(unsigned char));
+    SceneInfo.mp_uiObjectReflects = (unsigned *)realloc(SceneInfo.mp_uiObjectReflects, uiNumObjects * sizeof(unsigned));
+    SceneInfo.mp_uiOpaqueObjects = (unsigned *)realloc(SceneInfo.mp_uiOpaqueObjects, uiNumObjects * sizeof(unsigned));
+    SceneInfo.mp_uiTransObjects = (unsigned *)realloc(SceneInfo.mp_uiTransObjects, uiNumObjects * sizeof(unsigned));
+    SceneInfo.mp_ReflecObjects = (ReflectObjectData *)realloc(SceneInfo.mp_ReflecObjects, uiNumObjects * sizeof(ReflectObjectData));
+    // Transforms share one buffer with each aligned so it can be bound as a range
+    GLint iAlignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &iAlignment);
+    iAlignment = max(iAlignment, 1);
+    SceneInfo.m_uiTransformSize = (SceneInfo.m_bPackedVertices) ? 2 * sizeof(mat4) : sizeof(mat4);
+    SceneInfo.m_uiTransformStride = ((SceneInfo.m_uiTransformSize + iAlignment - 1) / iAlignment) * iAlignment;
+    SceneInfo.mp_Transforms = (unsigned char *)realloc(SceneInfo.mp_Transforms, max(uiNumObjects, 1u) * SceneInfo.m_uiTransformStride);
+    // Load in each object
+    const SceneCookObject * p_CookObjects = (const SceneCookObject *)&p_Cooked[p_Header->m_ui64ObjectOffset];
+    for (unsigned i = 0; i < p_Header->m_uiNumObjects; i++) {
+        const SceneCookObject * p_CookObject = &p_CookObjects[i];
+        const unsigned uiObject = SceneInfo.m_uiNumObjects;
+        ObjectDrawData * p_Draw = &SceneInfo.mp_ObjectDraws[uiObject];
+
+        // Get data from corresponding mesh
+        const MeshData * p_Mesh = &SceneInfo.mp_Meshes[p_CookObject->m_uiMesh];
+        p_Draw->m_uiFirstIndex = p_Mesh->m_uiFirstIndex;
+        p_Draw->m_uiNumIndices = p_Mesh->m_uiNumIndices;
+        p_Draw->m_iBaseVertex = p_Mesh->m_iBaseVertex;
+        p_Draw->m_uiFirstMeshlet = p_Mesh->m_uiFirstMeshlet;
+        p_Draw->m_uiNumMeshlets = p_Mesh->m_uiNumMeshlets;
+        p_Draw->m_uiMesh = p_CookObject->m_uiMesh;
+
+        // Textures and constants are read through the material index
+        SceneInfo.mp_uiObjectMaterials[uiObject] = p_uiMaterialRemap[p_CookObject->m_uiMaterial];
+        const MaterialData * p_Material = &SceneInfo.mp_Materials[SceneInfo.mp_uiObjectMaterials[uiObject]];
+
+        // Add transform to the shared transform buffer and update world bounds
+        p_Draw->m_uiTransformOffset = uiObject * SceneInfo.m_uiTransformStride;
+        GL_SetObjectTransform(SceneInfo, uiObject, p_CookObject->m_4Transform);
+        if (SceneInfo.m_bPackedVertices) {
+            // Add the matrix used to decode packed positions
+            mat4 * p_m4Transforms = (mat4 *)&SceneInfo.mp_Transforms[p_Draw->m_uiTransformOffset];
+            p_m4Transforms[1] = GL_PackedPositionDecode(&p_CookMeshes[p_CookObject->m_uiMesh]);
+        }
+
+        // Add to transparent or opaque object list
+        SceneInfo.mp_ucObjectFlags[uiObject] = 0;
+        if (p_Material->m_bTransparent) {
+            SceneInfo.mp_ucObjectFlags[uiObject] |= g_ucObjectTransparent;
+            SceneInfo.mp_uiTransObjects[SceneInfo.m_uiNumTransObjects] = uiObject;
+            ++SceneInfo.m_uiNumTransObjects;
+        } else {
+            SceneInfo.mp_uiOpaqueObjects[SceneInfo.m_uiNumOpaqueObjects] = uiObject;
+            ++SceneInfo.m_uiNumOpaqueObjects;
+        }
+
+        // Add to reflective object list as needed
+        SceneInfo.mp_uiObjectReflects[uiObject] = -1;
+        if (p_Material->m_bReflective) {
+            // Get objects bounding box
+            const SceneCookMesh * p_CookMesh = &p_CookMeshes[p_CookObject->m_uiMesh];
+            vec3 v3AABBMin = p_CookMesh->m_v3AABBMin;
+            vec3 v3AABBMax = p_CookMesh->m_v3AABBMax;
+
+            // Check if planar or not
+            vec3 v3AABBSize = v3AABBMax - v3AABBMin;
+            if ((v3AABBSize.x < 0.00001f) || (v3AABBSize.y < 0.00001f) || (v3AABBSize.z < 0.00001f)) {
+                // Set object as planar reflective
+                SceneInfo.mp_ucObjectFlags[uiObject] |= g_ucObjectPlanarReflect;
+                SceneInfo.mp_uiObjectReflects[uiObject] = SceneInfo.m_uiNumReflecObjects;
+                ReflectObjectData * p_RObject = &SceneInfo.mp_ReflecObjects[SceneInfo.m_uiNumReflecObjects];
+
+                // Set object position in reflective object
+                p_RObject->m_uiObjectPos = uiObject;
+
+                // Generate texture for reflection map
+                glGenTextures(1, &p_RObject->m_uiReflect);
+                glBindTexture(GL_TEXTURE_2D, p_RObject->m_uiReflect);
+                int iLevels = (int)ceilf(log2f((float)max(g_iWindowWidth, g_iWindowHeight)));
+                glTexStorage2D(GL_TEXTURE_2D, iLevels, GL_RGB8, g_iWindowWidth, g_iWindowHeight);
+
+                // Initialise the texture filtering and wrap values
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+                // Reflected projection is written to the uniform ring buffer each frame
+                p_RObject->m_iReflectVPOffset = 0;
+
+                // Calculate objects plane in model space
+                vec3 v3PlaneNormal = p_VBuffer[p_CookMesh->m_uiFirstVertex].v3Normal;
+                vec3 v3AABBCentre = v3AABBMin + (v3AABBSize * 0.5f);
+                p_RObject->m_v4PlaneOrPosition = vec4(v3PlaneNormal,
+                                                      dot(v3PlaneNormal, -v3AABBCentre));
+
+                ++SceneInfo.m_uiNumReflecObjects;
+            } else {
+                // Set object as cube reflective
+                SceneInfo.mp_ucObjectFlags[uiObject] |= g_ucObjectCubeReflect;
+                SceneInfo.mp_uiObjectReflects[uiObject] = SceneInfo.m_uiNumReflecObjects;
+                ReflectObjectData * p_RObject = &SceneInfo.mp_ReflecObjects[SceneInfo.m_uiNumReflecObjects];
+
+                // Set object position in reflective object
+                p_RObject->m_uiObjectPos = uiObject;
+
+                // Generate texture for reflection map
+                glGenTextures(1, &p_RObject->m_uiReflect);
+                glBindTexture(GL_TEXTURE_CUBE_MAP, p_RObject->m_uiReflect);
+                int iLevels = (int)ceilf(log2f((float)g_iWindowHeight));
+                glTexStorage2D(GL_TEXTURE_CUBE_MAP, iLevels, GL_RGB8, g_iWindowHeight, g_iWindowHeight);
+
+                // Initialise the texture filtering and wrap values
+                glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4);
+                glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+                // Calculate AABB centre position in model space
+                p_RObject->m_v4PlaneOrPosition = vec4(v3AABBMin + (v3AABBSize * 0.5f), 1.0f);
+
+                ++SceneInfo.m_uiNumReflecObjects;
+            }
+        }
+        ++SceneInfo.m_uiNumObjects;
+    }
+    free(p_uiMaterialRemap);
+
+    // Add transforms to Transform UBO, dynamic so objects can be moved in place
+    if (SceneInfo.m_uiTransformUBO == 0)
+        glGenBuffers(1, &SceneInfo.m_uiTransformUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, SceneInfo.m_uiTransformUBO);
+    glBufferData(GL_UNIFORM_BUFFER, SceneInfo.m_uiNumObjects * SceneInfo.m_uiTransformStride, SceneInfo.mp_Transforms, GL_DYNAMIC_DRAW);
+
+    // Allocate buffers for each light
+    SceneInfo.mp_PointLights = (PointLightData *)realloc(SceneInfo.mp_PointLights, p_Header->m_uiNumLights * sizeof(PointLightData));
+    SceneInfo.mp_SpotLights = (SpotLightData *)realloc(SceneInfo.mp_SpotLights, p_Header->m_uiNumLights * sizeof(SpotLightData));
+    // Load in each light
+    const SceneCookLight * p_CookLights = (const SceneCookLight *)&p_Cooked[p_Header->m_ui64LightOffset];
+    for (unsigned i = 0; i < p_Header->m_uiNumLights; i++) {
+        const SceneCookLight * p_CookLight = &p_CookLights[i];
+        if (p_CookLight->m_uiType == aiLightSource_POINT) {
             // Get point light
             PointLightData * p_Light = &SceneInfo.mp_PointLights[SceneInfo.m_uiNumPointLights];
-            vec3 v3Position = vec3(p_AILight->mPosition.x,
-                                   p_AILight->mPosition.y,
-                                   p_AILight->mPosition.z);
-            p_Light->m_v3Position = (vec3)(m4Ret * vec4(v3Position, 1.0f));
-            p_Light->m_v3Colour = vec3(p_AILight->mColorDiffuse.r,
-                                       p_AILight->mColorDiffuse.g,
-                                       p_AILight->mColorDiffuse.b);
-            // Divide linear and quadratic components by 2 to compensate for using a attenuation constant of 1
-            p_Light->m_v3Falloff = vec3(
-                (p_AILight->mAttenuationConstant == 0.0f) ? 1.0f : p_AILight->mAttenuationConstant,
-                p_AILight->mAttenuationLinear / 2.0f,
-                p_AILight->mAttenuationQuadratic / 2.0f);
+            p_Light->m_v3Position = p_CookLight->m_v3Position;
+            p_Light->m_v3Colour = p_CookLight->m_v3Colour;
+            p_Light->m_v3Falloff = p_CookLight->m_v3Falloff;
             ++SceneInfo.m_uiNumPointLights;
-        } else if (p_AILight->mType == aiLightSource_SPOT) {
+        } else {
             // Get spot light
             SpotLightData * p_Light = &SceneInfo.mp_SpotLights[SceneInfo.m_uiNumSpotLights];
-            vec3 v3Position = vec3(p_AILight->mPosition.x,
-                                   p_AILight->mPosition.y,
-                                   p_AILight->mPosition.z);
-            p_Light->m_v3Position = (vec3)(m4Ret * vec4(v3Position, 1.0f));
-            vec3 v3Direction = vec3(p_AILight->mDirection.x,
-                                    p_AILight->mDirection.y,
-                                    p_AILight->mDirection.z);
-            p_Light->m_v3Direction = -normalize(mat3(m4Ret) * v3Direction);
-            p_Light->m_fAngle = cos(p_AILight->mAngleOuterCone / 2.0f);
-            p_Light->m_v3Colour = vec3(p_AILight->mColorDiffuse.r,
-                                       p_AILight->mColorDiffuse.g,
-                                       p_AILight->mColorDiffuse.b);
-            // Divide linear and quadratic components by 2 to compensate for using a attenuation constant of 1
-            p_Light->m_v3Falloff = vec3(
-                (p_AILight->mAttenuationConstant == 0.0f) ? 1.0f : p_AILight->mAttenuationConstant,
-                p_AILight->mAttenuationLinear / 2.0f,
-                p_AILight->mAttenuationQuadratic / 2.0f);
+            p_Light->m_v3Position = p_CookLight->m_v3Position;
+            p_Light->m_v3Direction = p_CookLight->m_v3Direction;
+            p_Light->m_fAngle = p_CookLight->m_fAngle;
+            p_Light->m_v3Colour = p_CookLight->m_v3Colour;
+            p_Light->m_v3Falloff = p_CookLight->m_v3Falloff;
             ++SceneInfo.m_uiNumSpotLights;
         }
     }
@@ -373,40 +1271,28 @@ bool GL_LoadScene(const char * p_cSceneFile, SceneData & SceneInfo)
     if (SceneInfo.m_uiPointLightUBO == 0)
         glGenBuffers(1, &SceneInfo.m_uiPointLightUBO);
     glBindBuffer(GL_UNIFORM_BUFFER, SceneInfo.m_uiPointLightUBO);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(PointLightData) * SceneInfo.m_uiNumPointLights, SceneInfo.mp_PointLights, GL_STATIC_DRAW);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(PointLightData) * SceneInfo.m_uiNumPointLights, SceneInfo.mp_PointLights, GL_DYNAMIC_DRAW);
     if (SceneInfo.m_uiSpotLightUBO == 0)
         glGenBuffers(1, &SceneInfo.m_uiSpotLightUBO);
     glBindBuffer(GL_UNIFORM_BUFFER, SceneInfo.m_uiSpotLightUBO);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(SpotLightData) * SceneInfo.m_uiNumSpotLights, SceneInfo.mp_SpotLights, GL_STATIC_DRAW);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(SpotLightData) * SceneInfo.m_uiNumSpotLights, SceneInfo.mp_SpotLights, GL_DYNAMIC_DRAW);
 
     // Load in camera
-    if (p_Scene->mNumCameras > 0) {
-        const aiCamera * p_AICamera = p_Scene->mCameras[0];
-        mat4 m4Ret(1.0f);
-        GL_FindSceneNode(p_Scene->mRootNode, p_AICamera->mName, p_Scene, m4Ret, m4Ret);
-        vec4 v4Position = vec4(p_AICamera->mPosition.x,
-                               p_AICamera->mPosition.y,
-                               p_AICamera->mPosition.z, 1.0f);
-        SceneInfo.m_LocalCamera.m_v3Position = (vec3)(m4Ret * v4Position);
-        vec3 v3Direction = vec3(p_AICamera->mLookAt.x,
-                                p_AICamera->mLookAt.y,
-                                p_AICamera->mLookAt.z);
-        v3Direction = normalize(mat3(m4Ret) * v3Direction);
+    if (p_Header->m_uiHasCamera) {
+        const SceneCookCamera * p_CookCamera = (const SceneCookCamera *)&p_Cooked[p_Header->m_ui64CameraOffset];
+        SceneInfo.m_LocalCamera.m_v3Position = p_CookCamera->m_v3Position;
+        vec3 v3Direction = p_CookCamera->m_v3Direction;
         SceneInfo.m_LocalCamera.m_v3Direction = v3Direction;
-        vec3 v3Up = normalize(mat3(m4Ret) * vec3(p_AICamera->mUp.x,
-                                                 p_AICamera->mUp.y,
-                                                 p_AICamera->mUp.z));
-          // Assimp doesn't store a right vector so we calculate from up and direction
-        SceneInfo.m_LocalCamera.m_v3Right = cross(v3Direction, v3Up);
+        SceneInfo.m_LocalCamera.m_v3Right = p_CookCamera->m_v3Right;
         // Use orientation vectors to calculate corresponding axis angles
         SceneInfo.m_LocalCamera.m_fAngleX = atan2(v3Direction.x, v3Direction.z);
         SceneInfo.m_LocalCamera.m_fAngleY = asin(-v3Direction.y);
         SceneInfo.m_LocalCamera.m_fMoveZ = 0.0f;
         SceneInfo.m_LocalCamera.m_fMoveX = 0.0f;
-        SceneInfo.m_LocalCamera.m_fFOV = p_AICamera->mHorizontalFOV;
+        SceneInfo.m_LocalCamera.m_fFOV = p_CookCamera->m_fFOV;
         SceneInfo.m_LocalCamera.m_fAspect = (float)g_iWindowWidth / (float)g_iWindowHeight;
-        SceneInfo.m_LocalCamera.m_fNear = p_AICamera->mClipPlaneNear;
-        SceneInfo.m_LocalCamera.m_fFar = p_AICamera->mClipPlaneFar;
+        SceneInfo.m_LocalCamera.m_fNear = p_CookCamera->m_fNear;
+        SceneInfo.m_LocalCamera.m_fFar = p_CookCamera->m_fFar;
     } else if (SceneInfo.m_uiCameraUBO == 0) {
         // Initialise camera with default values
         SceneInfo.m_LocalCamera.m_fAngleX = (float)M_PI;
@@ -425,41 +1311,108 @@ bool GL_LoadScene(const char * p_cSceneFile, SceneData & SceneInfo)
     // Create camera UBO
     if (SceneInfo.m_uiCameraUBO == 0)
         glGenBuffers(1, &SceneInfo.m_uiCameraUBO);
-
-    // Destroy the scene
-    aiReleaseImport(p_Scene);
     free(p_cPath);
+}
+
+bool GL_LoadScene(const char * p_cSceneFile, SceneData & SceneInfo)
+{
+    GL_TRACE_ZONE("GL_LoadScene");
+    // Hash the source scene so any changes invalidate the cooked version
+    MappedFileData SourceFile;
+    if (!GL_MapFile(p_cSceneFile, SourceFile)) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to open scene file: %s\n", p_cSceneFile);
+        return false;
+    }
+    const Uint64 ui64SourceHash = GL_HashData(SourceFile.mp_Data, SourceFile.m_uiSize);
+    const Uint64 ui64SourceSize = SourceFile.m_uiSize;
+    GL_UnmapFile(SourceFile);
+
+    // Try and use existing cooked scene
+    char * p_cCookFile = (char *)malloc(strlen(p_cSceneFile) + strlen(gp_cSceneCookExtension) + 1);
+    strcpy(p_cCookFile, p_cSceneFile);
+    strcat(p_cCookFile, gp_cSceneCookExtension);
+    const unsigned char * p_Cooked = NULL;
+    unsigned char * p_CookBuffer = NULL;
+    MappedFileData CookFile;
+    if (GL_MapFile(p_cCookFile, CookFile)) {
+        if (GL_CheckCookedScene(CookFile.mp_Data, CookFile.m_uiSize, ui64SourceHash, ui64SourceSize))
+            p_Cooked = CookFile.mp_Data;
+        else {
+            SDL_Log("Cooked scene is out of date: %s\n", p_cCookFile);
+            GL_UnmapFile(CookFile);
+        }
+    }
+
+    // Regenerate cooked scene from source
+    if (p_Cooked == NULL) {
+        p_CookBuffer = GL_CookScene(p_cSceneFile, ui64SourceHash, ui64SourceSize);
+        if (p_CookBuffer == NULL) {
+            free(p_cCookFile);
+            return false;
+        }
+        p_Cooked = p_CookBuffer;
+
+        // Save for next time, failure just means cooking again
+        SDL_RWops * p_File = SDL_RWFromFile(p_cCookFile, "wb");
+        const size_t uiCookSize = (size_t)((const SceneCookHeader *)p_Cooked)->m_ui64FileSize;
+        if ((p_File == NULL) || (SDL_RWwrite(p_File, p_Cooked, uiCookSize, 1) != 1))
+            SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to write cooked scene file: %s\n", p_cCookFile);
+        if (p_File != NULL)
+            SDL_RWclose(p_File);
+    }
+
+    // Create GL resources from cooked data
+    GL_LoadCookedScene(p_Cooked, p_cSceneFile, SceneInfo);
+
+    // Cleanup cooked data
+    GL_UnmapFile(CookFile);
+    free(p_CookBuffer);
+    free(p_cCookFile);
     return true;
 }
 
+void GL_UpdateObjectTransform(SceneData & SceneInfo, unsigned uiObject, const mat4 & m4Transform)
+{
+    // Update the objects streams and its range of the shared transform buffer, shadows need its bounds from before the move
+    GL_InvalidateShadowCaster(uiObject, SceneInfo.mp_ObjectBounds[uiObject]);
+    GL_SetObjectTransform(SceneInfo, uiObject, m4Transform);
+    GL_InvalidateObjectBVH();
+    const unsigned uiOffset = SceneInfo.mp_ObjectDraws[uiObject].m_uiTransformOffset;
+    glBindBuffer(GL_UNIFORM_BUFFER, SceneInfo.m_uiTransformUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, uiOffset, sizeof(mat4), &m4Transform);
+}
+
 void GL_UnloadScene(SceneData & SceneInfo)
 {
-    // Delete VBOs/IBOs and VAOs
-    for (unsigned i = 0; i < SceneInfo.m_uiNumMeshes; i++) {
-        glDeleteBuffers(1, &SceneInfo.mp_Meshes[i].m_uiVBO);
-        glDeleteBuffers(1, &SceneInfo.mp_Meshes[i].m_uiIBO);
-        glDeleteVertexArrays(1, &SceneInfo.mp_Meshes[i].m_uiVAO);
-    }
+    // Delete shared VBO/IBO and VAO
+    glDeleteBuffers(1, &SceneInfo.m_uiVBO);
+    glDeleteBuffers(1, &SceneInfo.m_uiIBO);
+    glDeleteVertexArrays(1, &SceneInfo.m_uiVAO);
     free(SceneInfo.mp_Meshes);
+    // Delete meshlet SSBO
+    glDeleteBuffers(1, &SceneInfo.m_uiMeshletSSBO);
+    free(SceneInfo.mp_Meshlets);
 
-    // Delete materials
-    for (unsigned i = 0; i < SceneInfo.m_uiNumMaterials; i++) {
-        glDeleteTextures(5, &SceneInfo.mp_Materials[i].m_uiDiffuse);
-    }
+    // Delete materials and the textures they share, stopping any streaming first
+    GL_QuitTextureStream();
+    glDeleteTextures(SceneInfo.m_uiNumTextures, SceneInfo.mp_Textures);
+    free(SceneInfo.mp_Textures);
     free(SceneInfo.mp_Materials);
 
-    // Delete objects
-    for (unsigned i = 0; i < SceneInfo.m_uiNumObjects; i++) {
-        glDeleteBuffers(1, &SceneInfo.mp_Objects[i].m_uiTransformUBO);
-    }
-    free(SceneInfo.mp_Objects);
-    free(SceneInfo.mp_TransObjects);
+    // Delete objects and their transforms
+    glDeleteBuffers(1, &SceneInfo.m_uiTransformUBO);
+    free(SceneInfo.mp_Transforms);
+    free(SceneInfo.mp_ObjectDraws);
+    free(SceneInfo.mp_ObjectTransforms);
+    free(SceneInfo.mp_ObjectBounds);
+    free(SceneInfo.mp_ObjectAABBs);
+    free(SceneInfo.mp_uiObjectMaterials);
+    free(SceneInfo.mp_ucObjectFlags);
+    free(SceneInfo.mp_uiObjectReflects);
+    free(SceneInfo.mp_uiOpaqueObjects);
+    free(SceneInfo.mp_uiTransObjects);
     for (unsigned i = 0; i < SceneInfo.m_uiNumReflecObjects; i++) {
-        const ReflectObjectData * p_RObject = &SceneInfo.mp_ReflecObjects[i];
-        const ObjectData * p_Object = &SceneInfo.mp_Objects[p_RObject->m_uiObjectPos];
-        glDeleteTextures(1, &p_Object->m_uiReflect);
-        if (p_Object->m_uiReflective == 1)
-            glDeleteBuffers(1, &p_Object->m_uiReflectVPUBO);
+        glDeleteTextures(1, &SceneInfo.mp_ReflecObjects[i].m_uiReflect);
     }
     free(SceneInfo.mp_ReflecObjects);
 
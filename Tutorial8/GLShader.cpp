@@ -1,5 +1,6 @@
 // Using SDL, GLEW
 #include <math.h>
+#include <string.h>
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
 #ifdef _WIN32
@@ -7,11 +8,20 @@
 #include <Windows.h>
 #endif
 
-bool GL_LoadShader(GLuint & uiShader, GLenum ShaderType, const GLchar * p_cShader)
+#include "GLTrace.h"
+
+bool GL_LoadShader(GLuint & uiShader, GLenum ShaderType, const GLchar * p_cShader, const GLchar * p_cDefines)
 {
     // Build and link the shader program
     uiShader = glCreateShader(ShaderType);
-    glShaderSource(uiShader, 1, &p_cShader, NULL);
+    const GLchar * p_cVersionEnd = (p_cDefines != NULL) ? strchr(p_cShader, '\n') : NULL;
+    if (p_cVersionEnd != NULL) {
+        // Insert defines straight after the version line
+        const GLchar * p_cSources[] = {p_cShader, p_cDefines, p_cVersionEnd + 1};
+        const GLint iLengths[] = {(GLint)(p_cVersionEnd + 1 - p_cShader), -1, -1};
+        glShaderSource(uiShader, 3, p_cSources, iLengths);
+    } else
+        glShaderSource(uiShader, 1, &p_cShader, NULL);
     glCompileShader(uiShader);
 
     // Check for errors
@@ -57,8 +67,9 @@ bool GL_LoadShaders(GLuint & uiShader, GLuint uiVertexShader, GLuint uiFragmentS
     return true;
 }
 
-bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char * p_cFileName, int iFileID)
+bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char * p_cFileName, int iFileID, const GLchar * p_cDefines)
 {
+    GL_TRACE_ZONE(p_cFileName);
 #ifdef _WIN32
     // Can load directly from windows resource file
     HINSTANCE hInst = GetModuleHandle(NULL);
@@ -68,7 +79,7 @@ bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char * p_cFil
     char * resText = (char *)LockResource(hMem);
 
     // Load in the shader
-    bool bReturn = GL_LoadShader(uiShader, ShaderType, resText);
+    bool bReturn = GL_LoadShader(uiShader, ShaderType, resText, p_cDefines);
 
     // Print the shader name to assist debugging
     if (!bReturn)
@@ -93,7 +104,7 @@ bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char * p_cFil
     p_cFileContents[lFileSize] = '\0'; // Add terminating character
 
     // Load in the shader
-    bool bReturn = GL_LoadShader(uiShader, ShaderType, p_cFileContents);
+    bool bReturn = GL_LoadShader(uiShader, ShaderType, p_cFileContents, p_cDefines);
 
     // Print the shader name to assist debugging
     if (!bReturn)
@@ -104,4 +115,31 @@ bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char * p_cFil
 
     return bReturn;
 #endif
+}
+
+bool GL_LoadComputeProgram(GLuint & uiProgram, const char * p_cFileName, int iFileID)
+{
+    // Compile the single compute stage
+    GLuint uiShader;
+    if (!GL_LoadShaderFile(uiShader, GL_COMPUTE_SHADER, p_cFileName, iFileID, NULL))
+        return false;
+
+    // Link the program
+    uiProgram = glCreateProgram();
+    glAttachShader(uiProgram, uiShader);
+    glLinkProgram(uiProgram);
+    glDeleteShader(uiShader);
+
+    //Check for error in link
+    GLint iTestReturn;
+    glGetProgramiv(uiProgram, GL_LINK_STATUS, &iTestReturn);
+    if (iTestReturn == GL_FALSE) {
+        GLchar p_cInfoLog[1024];
+        int32_t iErrorLength;
+        glGetProgramInfoLog(uiProgram, 1024, &iErrorLength, p_cInfoLog);
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to link compute shader %s: %s\n", p_cFileName, p_cInfoLog);
+        glDeleteProgram(uiProgram);
+        return false;
+    }
+    return true;
 }
\ No newline at end of file
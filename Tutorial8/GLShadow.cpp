@@ -0,0 +1,1076 @@
+// Using GLM and math headers
+#include <math.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
+
+//Main.cpp
+extern int g_iWindowWidth;
+extern int g_iWindowHeight;
+extern GLuint g_uiMainProgram;
+extern GLuint g_uiShadowProgram;
+extern GLuint g_uiShadowTransProgram;
+extern SceneData g_SceneData;
+//Reflection.cpp
+void GL_CalculateCubeMapVP(const vec3 & v3Position, mat4 * p_m4CubeViewProjections, float fNear, float fFar);
+//Cluster.cpp
+extern void GL_BeginClusterViews(const char * p_cPass, GLenum CullFace, float fLODBias);
+extern void GL_AddClusterLightView(const mat4 & m4ViewProjection, const vec3 & v3Position, unsigned uiHeight, float fFalloff);
+extern void GL_EndClusterViews();
+extern bool GL_CullObjectClusters(unsigned uiObject);
+extern void GL_DrawObjectClusters(GLenum Mode, unsigned uiObject);
+extern unsigned GL_GetNumClusterRanges();
+extern unsigned GL_WriteObjectClusterCommands(DrawIndirectData * p_Commands, unsigned uiBaseInstance);
+extern unsigned GL_GetClusterViewMask(unsigned uiObject);
+extern unsigned GL_WriteClusterViews(vec4 * p_v4Views);
+//BVH.cpp
+extern const unsigned * GL_CullObjectBVH(unsigned char ucFlagMask, unsigned char ucFlags, unsigned & uiNumVisible);
+//TextureStream.cpp
+extern GLuint GL_GetStreamTexture(GLuint uiTexture);
+//GPUCulling.cpp
+extern bool g_bGPUCulling;
+extern void GL_CullObjectsGPU(unsigned uiSection, GLuint uiLayerMask);
+extern void GL_DrawCulledObjectsGPU(GLenum Mode, unsigned uiSection);
+extern void GL_GetGPUCullLayers(unsigned uiSection, Uint64 & ui64Drawn, Uint64 & ui64Total);
+//UniformRing.cpp
+extern GLuint g_uiUniformRing;
+extern void GL_ReserveUniformRing(unsigned uiSize, unsigned uiCount);
+extern GLintptr GL_WriteUniformRing(const void * p_Data, unsigned uiSize);
+
+// Spot Shadows
+GLuint g_uiFBOShadow;
+GLuint g_uiShadowAtlas;
+GLintptr g_iShadowRingOffset = 0;
+GLintptr g_iShadowPosRingOffset = 0;
+// Point Shadows
+GLuint g_uiShadowCubeAtlas;
+bool g_bShadowPointRefit = false;
+// Spot Transparency
+GLuint g_uiFBOTransparency;
+GLuint g_uiTransparencyAtlas;
+// Shadow map depth format, 16 bit relies on near and far planes fitted to the casters
+bool g_bShadowDepth16 = false;
+// Indirect depth draws, one section each for point and spot shadows
+enum ShadowDrawSection
+{
+    SHADOW_DRAW_POINT,
+    SHADOW_DRAW_SPOT,
+    SHADOW_DRAW_SECTIONS
+};
+GLuint g_uiShadowIndirectBuffer = 0;
+GLuint g_uiShadowDrawIndexBuffer = 0;
+DrawIndirectData * gp_ShadowIndirectData = NULL;
+GLuint * gp_uiShadowDrawIndexData = NULL;
+GLsync g_ShadowDrawFences[SHADOW_DRAW_SECTIONS];
+unsigned g_uiShadowDrawCapacity = 0;
+// Indirect depth draws built each pass before upload, each with its transform index and mask of light layers
+DrawIndirectData * gp_ShadowCommands = NULL;
+GLuint * gp_uiShadowDrawIndices = NULL;
+unsigned g_uiMaxShadowCommands = 0;
+// Light layers reached by shadow casters out of all layers they could be drawn to
+Uint64 g_ui64ShadowLayersDrawn = 0;
+Uint64 g_ui64ShadowLayersTotal = 0;
+
+struct ShadowPosData
+{
+    // This is required to ensure the compiler respects the alignment of elements in an array
+    aligned_vec3 m_v3Position;
+    // Layers tile in the atlas as offset and size in texture coordinates
+    aligned_vec4 m_v4Tile;
+};
+
+// Area of a lights shadow maps in its atlas, point lights lay their 6 faces out 3 across and 2 down
+struct ShadowTileData
+{
+    unsigned m_uiX;
+    unsigned m_uiY;
+    unsigned m_uiSize;
+};
+
+// Light values that shape its shadow layers, the direction is where the shadow view looks
+struct ShadowLightCache
+{
+    vec3 m_v3Position;
+    vec3 m_v3Direction;
+    float m_fAngle;
+    float m_fFalloff;
+};
+
+// Shadow cache, layers are only re-rendered once their light or a caster they reach changes
+const unsigned g_uiMaxShadowLayers = 32;
+const unsigned g_uiShadowLightLayers[SHADOW_DRAW_SECTIONS] = {6, 1};
+unsigned g_uiShadowLayerBudget = 4;
+ShadowLightCache * gp_ShadowLights[SHADOW_DRAW_SECTIONS] = {NULL, NULL};
+mat4 * gp_m4ShadowViewProjections[SHADOW_DRAW_SECTIONS] = {NULL, NULL};
+ShadowPosData * gp_ShadowPositions[SHADOW_DRAW_SECTIONS] = {NULL, NULL};
+unsigned g_uiShadowDirtyLayers[SHADOW_DRAW_SECTIONS] = {0, 0};
+unsigned g_uiShadowUpdateLayers[SHADOW_DRAW_SECTIONS] = {0, 0};
+unsigned g_uiShadowDirtyFrames[SHADOW_DRAW_SECTIONS][g_uiMaxShadowLayers];
+// Shadow atlases, each light gets a tile sized from its screen coverage with depth planes fitted to its casters
+const unsigned g_uiMinShadowTile = 128;
+const float g_fShadowMinNear = 0.1f;
+ShadowTileData * gp_ShadowTiles[SHADOW_DRAW_SECTIONS] = {NULL, NULL};
+vec2 * gp_v2ShadowNearFar[SHADOW_DRAW_SECTIONS] = {NULL, NULL};
+unsigned g_uiShadowAtlasWidth[SHADOW_DRAW_SECTIONS] = {0, 0};
+unsigned g_uiShadowAtlasHeight[SHADOW_DRAW_SECTIONS] = {0, 0};
+// Casters moved since the last update with their bounds before moving
+vec4 * gp_v4ShadowMovedBounds = NULL;
+unsigned * gp_uiShadowMovedObjects = NULL;
+unsigned g_uiNumShadowMoved = 0;
+unsigned g_uiMaxShadowMoved = 0;
+// Cache statistics
+Uint64 g_ui64ShadowLayersUpdated = 0;
+unsigned g_uiShadowFrames = 0;
+
+bool GL_ShadowLayerUpdating(ShadowDrawSection Section, unsigned uiLayer)
+{
+    return (uiLayer < g_uiMaxShadowLayers) && ((g_uiShadowUpdateLayers[Section] & (1u << uiLayer)) != 0);
+}
+
+uvec4 GL_GetShadowLayerRect(ShadowDrawSection Section, unsigned uiLayer)
+{
+    // Point light faces are offset within their lights tile
+    const unsigned uiLayers = g_uiShadowLightLayers[Section];
+    const ShadowTileData * p_Tile = &gp_ShadowTiles[Section][uiLayer / uiLayers];
+    const unsigned uiFace = uiLayer % uiLayers;
+    return uvec4(p_Tile->m_uiX + ((uiFace % 3) * p_Tile->m_uiSize), p_Tile->m_uiY + ((uiFace / 3) * p_Tile->m_uiSize), p_Tile->m_uiSize, p_Tile->m_uiSize);
+}
+
+vec4 GL_GetShadowAtlasTile(ShadowDrawSection Section, const uvec4 & u4Rect)
+{
+    // Convert texels into texture coordinates of the atlas
+    const vec2 v2Size = vec2((float)g_uiShadowAtlasWidth[Section], (float)g_uiShadowAtlasHeight[Section]);
+    return vec4(u4Rect) / vec4(v2Size, v2Size);
+}
+
+void GL_QuitShadowDraws()
+{
+    // Release fences and the indirect buffers
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        if (g_ShadowDrawFences[i] != NULL)
+            glDeleteSync(g_ShadowDrawFences[i]);
+        g_ShadowDrawFences[i] = NULL;
+    }
+    if (gp_ShadowIndirectData != NULL) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_uiShadowIndirectBuffer);
+        glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+    }
+    if (gp_uiShadowDrawIndexData != NULL) {
+        glBindBuffer(GL_ARRAY_BUFFER, g_uiShadowDrawIndexBuffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glDeleteBuffers(1, &g_uiShadowIndirectBuffer);
+    glDeleteBuffers(1, &g_uiShadowDrawIndexBuffer);
+    g_uiShadowIndirectBuffer = 0;
+    g_uiShadowDrawIndexBuffer = 0;
+    gp_ShadowIndirectData = NULL;
+    gp_uiShadowDrawIndexData = NULL;
+    g_uiShadowDrawCapacity = 0;
+}
+
+bool GL_InitShadowDraws(unsigned uiCapacity)
+{
+    // Release any previous buffers
+    GL_QuitShadowDraws();
+    g_uiShadowDrawCapacity = uiCapacity;
+    const GLsizeiptr iCommandSize = SHADOW_DRAW_SECTIONS * uiCapacity * sizeof(DrawIndirectData);
+    const GLsizeiptr iIndexSize = SHADOW_DRAW_SECTIONS * uiCapacity * 2 * sizeof(GLuint);
+
+    // Create buffers that stay mapped, without buffer storage each pass is uploaded instead
+    glGenBuffers(1, &g_uiShadowIndirectBuffer);
+    glGenBuffers(1, &g_uiShadowDrawIndexBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_uiShadowIndirectBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, g_uiShadowDrawIndexBuffer);
+    if (GLEW_ARB_buffer_storage) {
+        const GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_DRAW_INDIRECT_BUFFER, iCommandSize, NULL, Flags);
+        gp_ShadowIndirectData = (DrawIndirectData *)glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, iCommandSize, Flags);
+        glBufferStorage(GL_ARRAY_BUFFER, iIndexSize, NULL, Flags);
+        gp_uiShadowDrawIndexData = (GLuint *)glMapBufferRange(GL_ARRAY_BUFFER, 0, iIndexSize, Flags);
+        if ((gp_ShadowIndirectData == NULL) || (gp_uiShadowDrawIndexData == NULL)) {
+            SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to map shadow indirect draw buffers\n");
+            return false;
+        }
+    } else {
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, iCommandSize, NULL, GL_DYNAMIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, iIndexSize, NULL, GL_DYNAMIC_DRAW);
+    }
+
+    // Feed each draws transform index and layer mask through its base instance, other passes only draw instance 0 of it
+    glBindVertexArray(g_SceneData.m_uiVAO);
+    glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, 2 * sizeof(GLuint), (const GLvoid *)0);
+    glVertexAttribDivisor(4, 1);
+    glEnableVertexAttribArray(4);
+    glVertexAttribIFormat(5, 1, GL_UNSIGNED_INT, sizeof(GLuint));
+    glVertexAttribBinding(5, 4);
+    glEnableVertexAttribArray(5);
+    return true;
+}
+
+void GL_RenderObjectsDepth(ShadowDrawSection Section)
+{
+    // Attach the sections atlas and render to all of it
+    const GLuint uiShadowTexture = (Section == SHADOW_DRAW_POINT) ? g_uiShadowCubeAtlas : g_uiShadowAtlas;
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, uiShadowTexture, 0);
+    glViewport(0, 0, g_uiShadowAtlasWidth[Section], g_uiShadowAtlasHeight[Section]);
+
+    // Clear only the tiles being updated so the rest of the cached maps are kept
+    glEnable(GL_SCISSOR_TEST);
+    for (unsigned i = 0; i < g_uiMaxShadowLayers; i++) {
+        if (GL_ShadowLayerUpdating(Section, i)) {
+            const uvec4 u4Rect = GL_GetShadowLayerRect(Section, i);
+            glScissor(u4Rect.x, u4Rect.y, u4Rect.z, u4Rect.w);
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+    }
+    glDisable(GL_SCISSOR_TEST);
+
+    // The geometry shader moves each layer into its tile and skips layers not being updated
+    glProgramUniform1ui(g_uiShadowProgram, 1, g_uiShadowUpdateLayers[Section]);
+
+    // Let the GPU cull and write the draws, then restore the depth program
+    if (g_bGPUCulling) {
+        GL_CullObjectsGPU(Section, g_uiShadowUpdateLayers[Section]);
+        glUseProgram(g_uiShadowProgram);
+        GL_DrawCulledObjectsGPU(GL_TRIANGLES, Section);
+        return;
+    }
+
+    // Build an indirect draw for each visible cluster range of every opaque object inside the light views
+    unsigned uiNumVisible;
+    const unsigned * p_uiVisible = GL_CullObjectBVH(g_ucObjectTransparent, 0, uiNumVisible);
+    unsigned uiNumLayers = 0;
+    for (unsigned i = g_uiShadowUpdateLayers[Section]; i != 0; i &= i - 1) {
+        ++uiNumLayers;
+    }
+    unsigned uiNumDraws = 0;
+    for (unsigned i = 0; i < uiNumVisible; i++) {
+        const unsigned uiObject = p_uiVisible[i];
+
+        // Skip if the object is outside the falloff of every layer being updated or no clusters are visible
+        const unsigned uiLayerMask = GL_GetClusterViewMask(uiObject) & g_uiShadowUpdateLayers[Section];
+        if ((uiLayerMask == 0) || !GL_CullObjectClusters(uiObject))
+            continue;
+        for (unsigned j = uiLayerMask; j != 0; j &= j - 1) {
+            ++g_ui64ShadowLayersDrawn;
+        }
+        g_ui64ShadowLayersTotal += uiNumLayers;
+
+        // Increase command storage as needed
+        const unsigned uiNumRanges = GL_GetNumClusterRanges();
+        if (uiNumDraws + uiNumRanges > g_uiMaxShadowCommands) {
+            g_uiMaxShadowCommands = SDL_max(g_uiMaxShadowCommands * 2, uiNumDraws + uiNumRanges);
+            gp_ShadowCommands = (DrawIndirectData *)realloc(gp_ShadowCommands, g_uiMaxShadowCommands * sizeof(DrawIndirectData));
+            gp_uiShadowDrawIndices = (GLuint *)realloc(gp_uiShadowDrawIndices, g_uiMaxShadowCommands * 2 * sizeof(GLuint));
+        }
+
+        // Each range reads the objects transform from its slot in the Transform UBO and is only sent to the layers it reaches
+        const GLuint uiTransformIndex = g_SceneData.mp_ObjectDraws[uiObject].m_uiTransformOffset / sizeof(mat4);
+        GL_WriteObjectClusterCommands(&gp_ShadowCommands[uiNumDraws], uiNumDraws);
+        for (unsigned j = 0; j < uiNumRanges; j++) {
+            gp_uiShadowDrawIndices[(uiNumDraws + j) * 2] = uiTransformIndex;
+            gp_uiShadowDrawIndices[((uiNumDraws + j) * 2) + 1] = uiLayerMask;
+        }
+        uiNumDraws += uiNumRanges;
+    }
+    if (uiNumDraws == 0)
+        return;
+
+    // Grow the indirect buffers if this pass no longer fits
+    if (uiNumDraws > g_uiShadowDrawCapacity) {
+        if (!GL_InitShadowDraws(SDL_max(g_uiShadowDrawCapacity * 2, uiNumDraws)))
+            return;
+    }
+
+    // Wait until the GPU has finished with this sections previous draws
+    if (g_ShadowDrawFences[Section] != NULL) {
+        GLbitfield Flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(g_ShadowDrawFences[Section], Flags, 1000000) == GL_TIMEOUT_EXPIRED)
+            Flags = 0;
+        glDeleteSync(g_ShadowDrawFences[Section]);
+        g_ShadowDrawFences[Section] = NULL;
+    }
+
+    // Offset base instances so draws index into this section of the transform index buffer
+    const unsigned uiFirstDraw = Section * g_uiShadowDrawCapacity;
+    for (unsigned i = 0; i < uiNumDraws; i++) {
+        gp_ShadowCommands[i].m_uiBaseInstance += uiFirstDraw;
+    }
+
+    // Copy draws into the sections of the indirect buffers
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_uiShadowIndirectBuffer);
+    if (gp_ShadowIndirectData != NULL) {
+        memcpy(&gp_ShadowIndirectData[uiFirstDraw], gp_ShadowCommands, uiNumDraws * sizeof(DrawIndirectData));
+        memcpy(&gp_uiShadowDrawIndexData[uiFirstDraw * 2], gp_uiShadowDrawIndices, uiNumDraws * 2 * sizeof(GLuint));
+    } else {
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, uiFirstDraw * sizeof(DrawIndirectData), uiNumDraws * sizeof(DrawIndirectData), gp_ShadowCommands);
+        glBindBuffer(GL_ARRAY_BUFFER, g_uiShadowDrawIndexBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, uiFirstDraw * 2 * sizeof(GLuint), uiNumDraws * 2 * sizeof(GLuint), gp_uiShadowDrawIndices);
+    }
+
+    // Bind the shared scene VAO with the CPU built draw indices and layer masks and all object transforms
+    glBindVertexArray(g_SceneData.m_uiVAO);
+    glBindVertexBuffer(4, g_uiShadowDrawIndexBuffer, 0, 2 * sizeof(GLuint));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_SceneData.m_uiTransformUBO);
+
+    // Draw every object in a single call
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const GLvoid *)(uiFirstDraw * sizeof(DrawIndirectData)), uiNumDraws, 0);
+
+    // Protect the section until the GPU has consumed it
+    g_ShadowDrawFences[Section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+float GL_CalculateFalloffDistance(const vec3 & v3Falloff)
+{
+    // Calculate falloff size
+    const float fFalloffThreshold = 256.0f;
+    float fK0 = v3Falloff.x;
+    float fK1 = v3Falloff.y;
+    float fK2 = v3Falloff.z;
+    float fFalloff = FLT_MAX;
+    if (fK2 != 0.0f) {
+        // Use Quadratic falloff
+        fFalloff = -fK1 + sqrt((fK1 * fK1) - (4.0f * fK2 * (fK0 - fFalloffThreshold)));
+        fFalloff /= 2.0f * fK2;
+    } else if (fK1 != 0.0f) {
+        // Use linear falloff
+        fFalloff = (fFalloffThreshold - fK0) / fK1;
+    }
+    return fFalloff;
+}
+
+unsigned GL_GetNumShadowLights(ShadowDrawSection Section)
+{
+    return (Section == SHADOW_DRAW_POINT) ? g_SceneData.m_uiNumPointLights : g_SceneData.m_uiNumSpotLights;
+}
+
+unsigned GL_GetShadowLightLayers(ShadowDrawSection Section, unsigned uiLight)
+{
+    // Geometry shader invocations limit each section to 32 layers
+    const unsigned uiLayers = g_uiShadowLightLayers[Section];
+    const unsigned uiFirst = uiLight * uiLayers;
+    return (uiFirst + uiLayers <= g_uiMaxShadowLayers) ? (((1u << uiLayers) - 1) << uiFirst) : 0;
+}
+
+void GL_GetShadowLight(ShadowDrawSection Section, unsigned uiLight, ShadowLightCache & Light)
+{
+    // Falloff is clamped to scene bounds the same as when rendering
+    if (Section == SHADOW_DRAW_POINT) {
+        const PointLightData * p_PointLight = &g_SceneData.mp_PointLights[uiLight];
+        Light.m_v3Position = p_PointLight->m_v3Position;
+        Light.m_v3Direction = vec3(0.0f);
+        Light.m_fAngle = 0.0f;
+        Light.m_fFalloff = min(GL_CalculateFalloffDistance(p_PointLight->m_v3Falloff), g_SceneData.m_LocalCamera.m_fFar);
+    } else {
+        const SpotLightData * p_SpotLight = &g_SceneData.mp_SpotLights[uiLight];
+        Light.m_v3Position = p_SpotLight->m_v3Position;
+        Light.m_v3Direction = -normalize(vec3(p_SpotLight->m_v3Direction));
+        Light.m_fAngle = p_SpotLight->m_fAngle;
+        Light.m_fFalloff = min(GL_CalculateFalloffDistance(p_SpotLight->m_v3Falloff), g_SceneData.m_LocalCamera.m_fFar * 1.5f);
+    }
+}
+
+unsigned GL_GetShadowLightBoundsLayers(ShadowDrawSection Section, unsigned uiLight, const vec4 & v4Bounds)
+{
+    // Skip if outside the lights falloff, every layer is reached if the light is inside the bounds
+    const ShadowLightCache * p_Light = &gp_ShadowLights[Section][uiLight];
+    const unsigned uiLightLayers = GL_GetShadowLightLayers(Section, uiLight);
+    const vec3 v3Offset = vec3(v4Bounds) - p_Light->m_v3Position;
+    const float fDistance = length(v3Offset);
+    if ((uiLightLayers == 0) || (fDistance - v4Bounds.w > p_Light->m_fFalloff))
+        return 0;
+    if (fDistance <= v4Bounds.w)
+        return uiLightLayers;
+
+    unsigned uiMask = 0;
+    if (Section == SHADOW_DRAW_POINT) {
+        // Each cube face sees where its axis is largest, test against the planes between it and its neighbours
+        const float fEdge = v4Bounds.w * 1.41421356f;
+        for (unsigned j = 0; j < 6; j++) {
+            const unsigned uiAxis = j / 2;
+            const float fAlong = ((j & 1) ? -v3Offset[uiAxis] : v3Offset[uiAxis]) + fEdge;
+            if ((fAlong >= fabsf(v3Offset[(uiAxis + 1) % 3])) && (fAlong >= fabsf(v3Offset[(uiAxis + 2) % 3])))
+                uiMask |= 1u << ((uiLight * 6) + j);
+        }
+    } else {
+        // Check the angle to the bounds less its angular size against the spots cone
+        const float fToCentre = acos(clamp(dot(v3Offset, p_Light->m_v3Direction) / fDistance, -1.0f, 1.0f));
+        if (fToCentre - asin(v4Bounds.w / fDistance) <= acos(p_Light->m_fAngle))
+            uiMask |= uiLightLayers;
+    }
+    return uiMask;
+}
+
+unsigned GL_GetShadowBoundsLayers(ShadowDrawSection Section, const vec4 & v4Bounds)
+{
+    // Find the layers of each light a bounding sphere reaches
+    unsigned uiMask = 0;
+    for (unsigned i = 0; i < GL_GetNumShadowLights(Section); i++) {
+        uiMask |= GL_GetShadowLightBoundsLayers(Section, i, v4Bounds);
+    }
+    return uiMask;
+}
+
+vec2 GL_FitShadowNearFar(ShadowDrawSection Section, unsigned uiLight)
+{
+    // Only the depth range covered by casters the light reaches is needed, which keeps precision at lower bit depths
+    const ShadowLightCache * p_Light = &gp_ShadowLights[Section][uiLight];
+    vec2 v2NearFar = vec2(p_Light->m_fFalloff, g_fShadowMinNear);
+    for (unsigned i = 0; i < g_SceneData.m_uiNumObjects; i++) {
+        const vec4 & v4Bounds = g_SceneData.mp_ObjectBounds[i];
+        if (GL_GetShadowLightBoundsLayers(Section, uiLight, v4Bounds) == 0)
+            continue;
+
+        // Spot depth is along the view direction, cube face depth is at least the distance over root 3
+        const vec3 v3Offset = vec3(v4Bounds) - p_Light->m_v3Position;
+        if (Section == SHADOW_DRAW_POINT) {
+            const float fDistance = length(v3Offset);
+            v2NearFar.x = min(v2NearFar.x, (fDistance - v4Bounds.w) * 0.57735027f);
+            v2NearFar.y = max(v2NearFar.y, fDistance + v4Bounds.w);
+        } else {
+            const float fDepth = dot(v3Offset, p_Light->m_v3Direction);
+            v2NearFar.x = min(v2NearFar.x, fDepth - v4Bounds.w);
+            v2NearFar.y = max(v2NearFar.y, fDepth + v4Bounds.w);
+        }
+    }
+
+    // Keep within the lights falloff, receivers past the far plane are clamped to it when sampled
+    v2NearFar.x = max(v2NearFar.x, g_fShadowMinNear);
+    v2NearFar.y = min(v2NearFar.y, p_Light->m_fFalloff);
+    if (v2NearFar.y <= v2NearFar.x * 1.01f)
+        v2NearFar = vec2(g_fShadowMinNear, max(p_Light->m_fFalloff, g_fShadowMinNear * 2.0f));
+    return v2NearFar;
+}
+
+float GL_GetShadowLightPriority(const ShadowLightCache * p_Light)
+{
+    // Lights covering more of the screen come first, with the camera inside the falloff the most
+    const float fDistance = length(g_SceneData.m_LocalCamera.m_v3Position - p_Light->m_v3Position) - p_Light->m_fFalloff;
+    return p_Light->m_fFalloff / max(fDistance, g_SceneData.m_LocalCamera.m_fNear);
+}
+
+unsigned GL_GetShadowTileSize(const ShadowLightCache * p_Light)
+{
+    // Halve the full resolution tile while it still covers the lights share of the screen
+    const float fCoverage = min(GL_GetShadowLightPriority(p_Light), 1.0f) * (float)g_iWindowWidth;
+    unsigned uiSize = (unsigned)g_iWindowWidth;
+    while ((uiSize / 2 >= g_uiMinShadowTile) && ((float)(uiSize / 2) >= fCoverage))
+        uiSize /= 2;
+    return uiSize;
+}
+
+void GL_PackShadowAtlas(ShadowDrawSection Section, unsigned uiMaxSize)
+{
+    // Size each lights tile, point lights need a block of 3 by 2 faces
+    const unsigned uiNumLights = GL_GetNumShadowLights(Section);
+    const unsigned uiBlockWidth = (Section == SHADOW_DRAW_POINT) ? 3 : 1;
+    const unsigned uiBlockHeight = (Section == SHADOW_DRAW_POINT) ? 2 : 1;
+    ShadowTileData * p_Tiles = gp_ShadowTiles[Section];
+    unsigned * p_uiOrder = (unsigned *)malloc(SDL_max(uiNumLights, 1u) * sizeof(unsigned));
+    for (unsigned i = 0; i < uiNumLights; i++) {
+        p_Tiles[i].m_uiSize = GL_GetShadowTileSize(&gp_ShadowLights[Section][i]);
+        p_uiOrder[i] = i;
+    }
+
+    // Sort largest first so each shelf starts with its tallest tile
+    for (unsigned i = 1; i < uiNumLights; i++) {
+        const unsigned uiLight = p_uiOrder[i];
+        unsigned j = i;
+        for (; (j > 0) && (p_Tiles[p_uiOrder[j - 1]].m_uiSize < p_Tiles[uiLight].m_uiSize); j--) {
+            p_uiOrder[j] = p_uiOrder[j - 1];
+        }
+        p_uiOrder[j] = uiLight;
+    }
+
+    // Pack tiles into shelves, halving every tile until the atlas fits the maximum texture size
+    g_uiShadowAtlasWidth[Section] = 1;
+    g_uiShadowAtlasHeight[Section] = 1;
+    while (uiNumLights > 0) {
+        // Aim for a roughly square atlas that is at least as wide as the largest tile
+        Uint64 ui64Area = 0;
+        for (unsigned i = 0; i < uiNumLights; i++) {
+            ui64Area += (Uint64)p_Tiles[i].m_uiSize * p_Tiles[i].m_uiSize * uiBlockWidth * uiBlockHeight;
+        }
+        const unsigned uiLargest = p_Tiles[p_uiOrder[0]].m_uiSize * uiBlockWidth;
+        unsigned uiWidth = uiLargest;
+        while (((Uint64)uiWidth * uiWidth < ui64Area) && (uiWidth * 2 <= uiMaxSize)) {
+            uiWidth *= 2;
+        }
+
+        // Fill each shelf left to right and start a new one above it once full
+        unsigned uiX = 0;
+        unsigned uiY = 0;
+        unsigned uiShelf = 0;
+        unsigned uiUsedWidth = 0;
+        for (unsigned i = 0; i < uiNumLights; i++) {
+            ShadowTileData * p_Tile = &p_Tiles[p_uiOrder[i]];
+            if (uiX + (p_Tile->m_uiSize * uiBlockWidth) > uiWidth) {
+                uiX = 0;
+                uiY += uiShelf;
+                uiShelf = 0;
+            }
+            p_Tile->m_uiX = uiX;
+            p_Tile->m_uiY = uiY;
+            uiX += p_Tile->m_uiSize * uiBlockWidth;
+            uiShelf = SDL_max(uiShelf, p_Tile->m_uiSize * uiBlockHeight);
+            uiUsedWidth = SDL_max(uiUsedWidth, uiX);
+        }
+        g_uiShadowAtlasWidth[Section] = uiUsedWidth;
+        g_uiShadowAtlasHeight[Section] = uiY + uiShelf;
+        if ((uiLargest <= uiMaxSize) && (g_uiShadowAtlasHeight[Section] <= uiMaxSize))
+            break;
+
+        // Too large so try again with every tile halved
+        bool bShrunk = false;
+        for (unsigned i = 0; i < uiNumLights; i++) {
+            if (p_Tiles[i].m_uiSize > 1) {
+                p_Tiles[i].m_uiSize /= 2;
+                bShrunk = true;
+            }
+        }
+        if (!bShrunk)
+            break;
+    }
+    free(p_uiOrder);
+}
+
+void GL_InvalidateShadowCaster(unsigned uiObject, const vec4 & v4Bounds)
+{
+    // Increase moved caster storage as needed
+    if (g_uiNumShadowMoved >= g_uiMaxShadowMoved) {
+        g_uiMaxShadowMoved = SDL_max(g_uiMaxShadowMoved * 2, 16u);
+        gp_v4ShadowMovedBounds = (vec4 *)realloc(gp_v4ShadowMovedBounds, g_uiMaxShadowMoved * sizeof(vec4));
+        gp_uiShadowMovedObjects = (unsigned *)realloc(gp_uiShadowMovedObjects, g_uiMaxShadowMoved * sizeof(unsigned));
+    }
+
+    // Keep the bounds before the move so layers the caster leaves are updated as well
+    gp_v4ShadowMovedBounds[g_uiNumShadowMoved] = v4Bounds;
+    gp_uiShadowMovedObjects[g_uiNumShadowMoved] = uiObject;
+    ++g_uiNumShadowMoved;
+}
+
+bool GL_SelectShadowLayers(unsigned uiBudget)
+{
+    // Dirty every layer of lights that have changed since they were cached
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        const ShadowDrawSection Section = (ShadowDrawSection)i;
+        for (unsigned j = 0; j < GL_GetNumShadowLights(Section); j++) {
+            ShadowLightCache Light;
+            GL_GetShadowLight(Section, j, Light);
+            ShadowLightCache * p_Cached = &gp_ShadowLights[i][j];
+            if ((Light.m_v3Position != p_Cached->m_v3Position) || (Light.m_v3Direction != p_Cached->m_v3Direction) ||
+                (Light.m_fAngle != p_Cached->m_fAngle) || (Light.m_fFalloff != p_Cached->m_fFalloff)) {
+                *p_Cached = Light;
+                g_uiShadowDirtyLayers[i] |= GL_GetShadowLightLayers(Section, j);
+            }
+        }
+    }
+
+    // Dirty the layers moved casters reached before or after moving
+    for (unsigned i = 0; i < g_uiNumShadowMoved; i++) {
+        const vec4 & v4Before = gp_v4ShadowMovedBounds[i];
+        const vec4 & v4After = g_SceneData.mp_ObjectBounds[gp_uiShadowMovedObjects[i]];
+        for (unsigned j = 0; j < SHADOW_DRAW_SECTIONS; j++) {
+            g_uiShadowDirtyLayers[j] |= GL_GetShadowBoundsLayers((ShadowDrawSection)j, v4Before) | GL_GetShadowBoundsLayers((ShadowDrawSection)j, v4After);
+        }
+    }
+    g_uiNumShadowMoved = 0;
+
+    // Pick the highest priority dirty layers within the budget, layers gain priority for each frame they wait
+    g_uiShadowUpdateLayers[SHADOW_DRAW_POINT] = 0;
+    g_uiShadowUpdateLayers[SHADOW_DRAW_SPOT] = 0;
+    unsigned uiNumUpdated = 0;
+    for (; uiNumUpdated < uiBudget; uiNumUpdated++) {
+        float fBestPriority = -1.0f;
+        unsigned uiBestSection = 0;
+        unsigned uiBestLayer = g_uiMaxShadowLayers;
+        for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+            const unsigned uiWaiting = g_uiShadowDirtyLayers[i] & ~g_uiShadowUpdateLayers[i];
+            for (unsigned j = 0; (j < g_uiMaxShadowLayers) && (uiWaiting != 0); j++) {
+                if ((uiWaiting & (1u << j)) == 0)
+                    continue;
+                const float fPriority = GL_GetShadowLightPriority(&gp_ShadowLights[i][j / g_uiShadowLightLayers[i]]) * (float)(g_uiShadowDirtyFrames[i][j] + 1);
+                if (fPriority > fBestPriority) {
+                    fBestPriority = fPriority;
+                    uiBestSection = i;
+                    uiBestLayer = j;
+                }
+            }
+        }
+        if (uiBestLayer == g_uiMaxShadowLayers)
+            break;
+        g_uiShadowUpdateLayers[uiBestSection] |= 1u << uiBestLayer;
+    }
+
+    // Refit depth planes of lights being updated once their casters leave the range or it becomes too loose
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        const ShadowDrawSection Section = (ShadowDrawSection)i;
+        for (unsigned j = 0; j < GL_GetNumShadowLights(Section); j++) {
+            const unsigned uiLightLayers = GL_GetShadowLightLayers(Section, j);
+            if ((g_uiShadowUpdateLayers[i] & uiLightLayers) == 0)
+                continue;
+            const vec2 v2NearFar = GL_FitShadowNearFar(Section, j);
+            const vec2 & v2Cached = gp_v2ShadowNearFar[i][j];
+            if ((v2NearFar.x >= v2Cached.x) && (v2NearFar.y <= v2Cached.y) && ((v2NearFar.y - v2NearFar.x) * 2.0f > v2Cached.y - v2Cached.x))
+                continue;
+            gp_v2ShadowNearFar[i][j] = v2NearFar;
+            if (Section == SHADOW_DRAW_POINT)
+                g_bShadowPointRefit = true;
+
+            // Every face of a point light shares its planes so all of them are redrawn, even past the budget
+            for (unsigned k = uiLightLayers & ~g_uiShadowUpdateLayers[i]; k != 0; k &= k - 1) {
+                ++uiNumUpdated;
+            }
+            g_uiShadowUpdateLayers[i] |= uiLightLayers;
+        }
+    }
+
+    // Updated layers are clean again, the rest wait another frame
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        g_uiShadowDirtyLayers[i] &= ~g_uiShadowUpdateLayers[i];
+        for (unsigned j = 0; j < g_uiMaxShadowLayers; j++) {
+            g_uiShadowDirtyFrames[i][j] = ((g_uiShadowDirtyLayers[i] & (1u << j)) != 0) ? g_uiShadowDirtyFrames[i][j] + 1 : 0;
+        }
+    }
+    g_ui64ShadowLayersUpdated += uiNumUpdated;
+    return (uiNumUpdated > 0);
+}
+
+void GL_RenderSpotShadows()
+{
+    // Update the program, the viewport covers the atlas
+    glUseProgram(g_uiShadowProgram);
+
+    unsigned uiSizeLights = sizeof(mat4) * g_SceneData.m_uiNumSpotLights;
+    mat4 * p_ViewProjections = gp_m4ShadowViewProjections[SHADOW_DRAW_SPOT];
+    unsigned uiSizeLightsPos = sizeof(ShadowPosData) * g_SceneData.m_uiNumSpotLights;
+    ShadowPosData * p_Positions = gp_ShadowPositions[SHADOW_DRAW_SPOT];
+
+    // Cull clusters against each light at its tile size, shadows render back faces and can use coarser LODs
+    GL_BeginClusterViews("Shadow", GL_FRONT, 4.0f);
+
+    // Generate spot light view projection matrices
+    for (unsigned i = 0; i < g_SceneData.m_uiNumSpotLights; i++) {
+        SpotLightData * p_SpotLight = &g_SceneData.mp_SpotLights[i];
+
+        // Calculate view matrix
+        mat4 m4LightView = lookAt(p_SpotLight->m_v3Position,
+                                  p_SpotLight->m_v3Position - p_SpotLight->m_v3Direction,
+                                  vec3(0.0f, 1.0f, 0.0f));
+
+        // Get falloff distance
+        float fFalloff = GL_CalculateFalloffDistance(p_SpotLight->m_v3Falloff);
+
+        // Clamp falloff to scene bounds
+        fFalloff = min(fFalloff, g_SceneData.m_LocalCamera.m_fFar * 1.5f);
+
+        // Calculate projection matrix with the near and far planes fitted to its casters
+        const vec2 & v2NearFar = gp_v2ShadowNearFar[SHADOW_DRAW_SPOT][i];
+        mat4 m4LightProjection = perspective(
+            acos(p_SpotLight->m_fAngle) * 2.0f,
+            1.0f,
+            v2NearFar.x, v2NearFar.y
+        );
+
+        const mat4 m4ViewProjection = m4LightProjection * m4LightView;
+        GL_AddClusterLightView(m4ViewProjection, p_SpotLight->m_v3Position, gp_ShadowTiles[SHADOW_DRAW_SPOT][i].m_uiSize, fFalloff);
+
+        // Only layers being updated move to the new view, the rest keep matching their cached maps
+        if (GL_ShadowLayerUpdating(SHADOW_DRAW_SPOT, i)) {
+            p_ViewProjections[i] = m4ViewProjection;
+            p_Positions[i].m_v3Position = p_SpotLight->m_v3Position;
+        }
+    }
+
+    // Write shadow view projections and positions into this frames section of the ring buffer
+    g_iShadowRingOffset = GL_WriteUniformRing(p_ViewProjections, uiSizeLights);
+    g_iShadowPosRingOffset = GL_WriteUniformRing(p_Positions, uiSizeLightsPos);
+
+    // Bind shadow map UBO ranges
+    glBindBufferRange(GL_UNIFORM_BUFFER, 6, g_uiUniformRing, g_iShadowRingOffset, uiSizeLights);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 9, g_uiUniformRing, g_iShadowPosRingOffset, uiSizeLightsPos);
+
+    // Update number of valid lights
+    glProgramUniform1i(g_uiShadowProgram, 0, g_SceneData.m_uiNumSpotLights);
+
+    GL_RenderObjectsDepth(SHADOW_DRAW_SPOT);
+}
+
+void GL_RenderPointShadows()
+{
+    // Update the program, the viewport covers the atlas
+    glUseProgram(g_uiShadowProgram);
+
+    unsigned uiSizeLights = sizeof(mat4) * g_SceneData.m_uiNumPointLights * 6;
+    mat4 * p_ViewProjections = gp_m4ShadowViewProjections[SHADOW_DRAW_POINT];
+    unsigned uiSizeLightsPos = sizeof(ShadowPosData) * g_SceneData.m_uiNumPointLights * 6;
+    ShadowPosData * p_Positions = gp_ShadowPositions[SHADOW_DRAW_POINT];
+
+    // Cull clusters against each light at its tile size, shadows render back faces and can use coarser LODs
+    GL_BeginClusterViews("Shadow", GL_FRONT, 4.0f);
+
+    // Generate point light view projection matrices
+    for (unsigned i = 0; i < g_SceneData.m_uiNumPointLights; i++) {
+        PointLightData * p_PointLight = &g_SceneData.mp_PointLights[i];
+
+        // Get falloff distance
+        float fFalloff = GL_CalculateFalloffDistance(p_PointLight->m_v3Falloff);
+
+        // Clamp falloff to scene bounds
+        fFalloff = min(fFalloff, g_SceneData.m_LocalCamera.m_fFar);
+
+        // Update lights near and far plane to those fitted to its casters
+        p_PointLight->m_v2NearFar = gp_v2ShadowNearFar[SHADOW_DRAW_POINT][i];
+
+        // Calculate cube map VPs
+        mat4 m4CubeViewProjections[6];
+        GL_CalculateCubeMapVP(p_PointLight->m_v3Position, m4CubeViewProjections,
+                              p_PointLight->m_v2NearFar.x, p_PointLight->m_v2NearFar.y);
+
+        // Only faces being updated move to the new views, the rest keep matching their cached maps
+        for (unsigned j = 0; j < 6; j++) {
+            GL_AddClusterLightView(m4CubeViewProjections[j], p_PointLight->m_v3Position, gp_ShadowTiles[SHADOW_DRAW_POINT][i].m_uiSize, fFalloff);
+            if (GL_ShadowLayerUpdating(SHADOW_DRAW_POINT, (i * 6) + j)) {
+                p_ViewProjections[(i * 6) + j] = m4CubeViewProjections[j];
+                p_Positions[(i * 6) + j].m_v3Position = p_PointLight->m_v3Position;
+            }
+        }
+    }
+
+    // Update point light UBO only when a lights near/far values were refit
+    if (g_bShadowPointRefit) {
+        glBindBuffer(GL_UNIFORM_BUFFER, g_SceneData.m_uiPointLightUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PointLightData) * g_SceneData.m_uiNumPointLights, g_SceneData.mp_PointLights);
+        g_bShadowPointRefit = false;
+    }
+
+    // Update number of valid lights
+    glProgramUniform1i(g_uiShadowProgram, 0, g_SceneData.m_uiNumPointLights * 6);
+
+    // Write shadow view projections and positions into this frames section of the ring buffer and bind them
+    glBindBufferRange(GL_UNIFORM_BUFFER, 6, g_uiUniformRing, GL_WriteUniformRing(p_ViewProjections, uiSizeLights), uiSizeLights);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 9, g_uiUniformRing, GL_WriteUniformRing(p_Positions, uiSizeLightsPos), uiSizeLightsPos);
+
+    GL_RenderObjectsDepth(SHADOW_DRAW_POINT);
+}
+
+void GL_RenderSpotTransparency()
+{
+    // Bind shadow map frame buffer
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOTransparency);
+
+    // Update the program and viewport to cover the atlas
+    glUseProgram(g_uiShadowTransProgram);
+    glViewport(0, 0, g_uiShadowAtlasWidth[SHADOW_DRAW_SPOT], g_uiShadowAtlasHeight[SHADOW_DRAW_SPOT]);
+
+    // Assumes called after spot shadow so its ranges are already in the ring buffer
+    glBindBufferRange(GL_UNIFORM_BUFFER, 6, g_uiUniformRing, g_iShadowRingOffset, sizeof(mat4) * g_SceneData.m_uiNumSpotLights);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 9, g_uiUniformRing, g_iShadowPosRingOffset, sizeof(ShadowPosData) * g_SceneData.m_uiNumSpotLights);
+
+    // Update number of valid lights
+    glProgramUniform1i(g_uiShadowTransProgram, 0, g_SceneData.m_uiNumSpotLights);
+
+    // Clear the colour buffer only
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Disable depth writing
+    glDepthMask(false);
+
+    // Bind the shared scene VAO
+    glBindVertexArray(g_SceneData.m_uiVAO);
+
+    // Loop through each transparent object
+    for (unsigned i = 0; i < g_SceneData.m_uiNumTransObjects; i++) {
+        const unsigned uiObject = g_SceneData.mp_uiTransObjects[i];
+
+        // Skip if no clusters are visible
+        if (!GL_CullObjectClusters(uiObject))
+            continue;
+
+        // Bind the objects range of the Transform UBO
+        glBindBufferRange(GL_UNIFORM_BUFFER, 0, g_SceneData.m_uiTransformUBO, g_SceneData.mp_ObjectDraws[uiObject].m_uiTransformOffset, g_SceneData.m_uiTransformSize);
+
+        // Bind the diffuse texture
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, GL_GetStreamTexture(g_SceneData.mp_Materials[g_SceneData.mp_uiObjectMaterials[uiObject]].m_uiDiffuse));
+
+        // Draw the Object
+        GL_DrawObjectClusters(GL_TRIANGLES, uiObject);
+    }
+
+    // Reset depth writing
+    glDepthMask(true);
+}
+
+void GL_RenderShadows(unsigned uiBudget)
+{
+    GL_TRACE_ZONE("GL_RenderShadows");
+    // Find which cached layers need to be rendered
+    if (!GL_SelectShadowLayers(uiBudget))
+        return;
+
+    // Bind shadow map frame buffer
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOShadow);
+
+    // Setup culling and depth bias
+    glCullFace(GL_FRONT);
+    glPolygonOffset(0.9f, 0.0f);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+
+    // Clip each layer to the edges of its tile
+    for (unsigned i = 0; i < 4; i++) {
+        glEnable(GL_CLIP_DISTANCE0 + i);
+    }
+
+    if (g_uiShadowUpdateLayers[SHADOW_DRAW_POINT] != 0)
+        GL_RenderPointShadows();
+
+    if (g_uiShadowUpdateLayers[SHADOW_DRAW_SPOT] != 0) {
+        GL_RenderSpotShadows();
+
+        // Transparency is redrawn for every spot layer as it clears them all
+        GL_RenderSpotTransparency();
+    }
+
+    // Reset culling, depth bias and clipping
+    glCullFace(GL_BACK);
+    GL_EndClusterViews();
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    for (unsigned i = 0; i < 4; i++) {
+        glDisable(GL_CLIP_DISTANCE0 + i);
+    }
+
+    // Reset to default program and viewport
+    glUseProgram(g_uiMainProgram);
+    glViewport(0, 0, g_iWindowWidth, g_iWindowHeight);
+}
+
+void GL_BindShadowUniforms()
+{
+    // Lighting reads the cached spot view projections so write them into this frames section of the ring buffer
+    if (g_SceneData.m_uiNumSpotLights > 0) {
+        const unsigned uiSizeLights = sizeof(mat4) * g_SceneData.m_uiNumSpotLights;
+        glBindBufferRange(GL_UNIFORM_BUFFER, 6, g_uiUniformRing, GL_WriteUniformRing(gp_m4ShadowViewProjections[SHADOW_DRAW_SPOT], uiSizeLights),
+                          uiSizeLights);
+    }
+}
+
+void GL_UpdateShadows()
+{
+    // Render changed layers within the per frame budget
+    GL_RenderShadows(g_uiShadowLayerBudget);
+    GL_BindShadowUniforms();
+    ++g_uiShadowFrames;
+}
+
+void GL_ReserveShadowUniforms()
+{
+    // Each update writes the view projections and positions of both light types, lighting then writes the spot view projections again
+    GL_ReserveUniformRing(sizeof(mat4) * g_SceneData.m_uiNumSpotLights, 2);
+    GL_ReserveUniformRing(sizeof(ShadowPosData) * g_SceneData.m_uiNumSpotLights, 1);
+    GL_ReserveUniformRing(sizeof(mat4) * g_SceneData.m_uiNumPointLights * 6, 1);
+    GL_ReserveUniformRing(sizeof(ShadowPosData) * g_SceneData.m_uiNumPointLights * 6, 1);
+}
+
+bool GL_InitShadow()
+{
+    // Create the shadow cache with every layer dirty
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        const ShadowDrawSection Section = (ShadowDrawSection)i;
+        const unsigned uiNumLayers = GL_GetNumShadowLights(Section) * g_uiShadowLightLayers[i];
+        gp_ShadowLights[i] = (ShadowLightCache *)calloc(SDL_max(GL_GetNumShadowLights(Section), 1u), sizeof(ShadowLightCache));
+        gp_m4ShadowViewProjections[i] = (mat4 *)calloc(SDL_max(uiNumLayers, 1u), sizeof(mat4));
+        gp_ShadowPositions[i] = (ShadowPosData *)calloc(SDL_max(uiNumLayers, 1u), sizeof(ShadowPosData));
+        gp_ShadowTiles[i] = (ShadowTileData *)calloc(SDL_max(GL_GetNumShadowLights(Section), 1u), sizeof(ShadowTileData));
+        gp_v2ShadowNearFar[i] = (vec2 *)calloc(SDL_max(GL_GetNumShadowLights(Section), 1u), sizeof(vec2));
+        for (unsigned j = 0; j < GL_GetNumShadowLights(Section); j++) {
+            GL_GetShadowLight(Section, j, gp_ShadowLights[i][j]);
+            g_uiShadowDirtyLayers[i] |= GL_GetShadowLightLayers(Section, j);
+        }
+        for (unsigned j = 0; j < g_uiMaxShadowLayers; j++) {
+            g_uiShadowDirtyFrames[i][j] = 0;
+        }
+    }
+
+    // Give each light a tile in its sections atlas
+    GLint iMaxSize = 4096;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &iMaxSize);
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        const ShadowDrawSection Section = (ShadowDrawSection)i;
+        GL_PackShadowAtlas(Section, (unsigned)iMaxSize);
+
+        // Tell the geometry shader where each layer is drawn
+        for (unsigned j = 0; j < GL_GetNumShadowLights(Section) * g_uiShadowLightLayers[i]; j++) {
+            gp_ShadowPositions[i][j].m_v4Tile = GL_GetShadowAtlasTile(Section, GL_GetShadowLayerRect(Section, j));
+        }
+    }
+
+    // Tell lighting where each lights tile is, point lights give their first face
+    for (unsigned i = 0; i < g_SceneData.m_uiNumPointLights; i++) {
+        g_SceneData.mp_PointLights[i].m_v4ShadowTile = GL_GetShadowAtlasTile(SHADOW_DRAW_POINT, GL_GetShadowLayerRect(SHADOW_DRAW_POINT, i * 6));
+    }
+    for (unsigned i = 0; i < g_SceneData.m_uiNumSpotLights; i++) {
+        g_SceneData.mp_SpotLights[i].m_v4ShadowTile = GL_GetShadowAtlasTile(SHADOW_DRAW_SPOT, GL_GetShadowLayerRect(SHADOW_DRAW_SPOT, i));
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, g_SceneData.m_uiSpotLightUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SpotLightData) * g_SceneData.m_uiNumSpotLights, g_SceneData.mp_SpotLights);
+
+    // Create shadow map frame buffer
+    glGenFramebuffers(1, &g_uiFBOShadow);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_uiFBOShadow);
+
+    // Disable colour buffer output
+    glDrawBuffer(GL_NONE);
+
+    const GLenum DepthFormat = (g_bShadowDepth16) ? GL_DEPTH_COMPONENT16 : GL_DEPTH_COMPONENT32F;
+    if (g_SceneData.m_uiNumPointLights > 0) {
+        // Generate point light shadow map atlas
+        glGenTextures(1, &g_uiShadowCubeAtlas);
+        glBindTexture(GL_TEXTURE_2D, g_uiShadowCubeAtlas);
+        glTexStorage2D(GL_TEXTURE_2D, 1, DepthFormat,
+                       g_uiShadowAtlasWidth[SHADOW_DRAW_POINT], g_uiShadowAtlasHeight[SHADOW_DRAW_POINT]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // Bind the shadow map texture
+        glActiveTexture(GL_TEXTURE7);
+        glBindTexture(GL_TEXTURE_2D, g_uiShadowCubeAtlas);
+    }
+
+    if (g_SceneData.m_uiNumSpotLights > 0) {
+        // Generate spot light shadow map atlas
+        glGenTextures(1, &g_uiShadowAtlas);
+        glBindTexture(GL_TEXTURE_2D, g_uiShadowAtlas);
+        glTexStorage2D(GL_TEXTURE_2D, 1, DepthFormat,
+                       g_uiShadowAtlasWidth[SHADOW_DRAW_SPOT], g_uiShadowAtlasHeight[SHADOW_DRAW_SPOT]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // Bind the shadow map texture
+        glActiveTexture(GL_TEXTURE6);
+        glBindTexture(GL_TEXTURE_2D, g_uiShadowAtlas);
+        glActiveTexture(GL_TEXTURE0);
+
+        // Generate transparency FBO
+        glGenFramebuffers(1, &g_uiFBOTransparency);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBOTransparency);
+
+        // Generate transparency colour buffer matching the shadow atlas
+        glGenTextures(1, &g_uiTransparencyAtlas);
+        glBindTexture(GL_TEXTURE_2D, g_uiTransparencyAtlas);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB8,
+                       g_uiShadowAtlasWidth[SHADOW_DRAW_SPOT], g_uiShadowAtlasHeight[SHADOW_DRAW_SPOT]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // Attach buffers to FBO
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, g_uiShadowAtlas, 0);
+        glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, g_uiTransparencyAtlas, 0);
+
+        // Bind the shadow map transparency texture
+        glActiveTexture(GL_TEXTURE8);
+        glBindTexture(GL_TEXTURE_2D, g_uiTransparencyAtlas);
+    }
+
+    // Reset active texture unit
+    glActiveTexture(GL_TEXTURE0);
+
+    // Output memory used by the atlases against full size 32 bit layers for every light
+    const Uint64 ui64FullSize = (Uint64)g_iWindowWidth * g_iWindowWidth;
+    const Uint64 ui64Before = (ui64FullSize * ((g_SceneData.m_uiNumPointLights * 6) + g_SceneData.m_uiNumSpotLights) * 4) +
+        (ui64FullSize * g_SceneData.m_uiNumSpotLights * 3);
+    Uint64 ui64After = 0;
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        if (GL_GetNumShadowLights((ShadowDrawSection)i) > 0)
+            ui64After += (Uint64)g_uiShadowAtlasWidth[i] * g_uiShadowAtlasHeight[i] * ((g_bShadowDepth16) ? 2 : 4);
+    }
+    if (g_SceneData.m_uiNumSpotLights > 0)
+        ui64After += (Uint64)g_uiShadowAtlasWidth[SHADOW_DRAW_SPOT] * g_uiShadowAtlasHeight[SHADOW_DRAW_SPOT] * 3;
+    SDL_Log("Shadow atlases use %.1f MB (%ux%u point, %ux%u spot) instead of %.1f MB, saving %.1f MB\n", (double)ui64After / (1024.0 * 1024.0),
+            g_uiShadowAtlasWidth[SHADOW_DRAW_POINT], g_uiShadowAtlasHeight[SHADOW_DRAW_POINT], g_uiShadowAtlasWidth[SHADOW_DRAW_SPOT],
+            g_uiShadowAtlasHeight[SHADOW_DRAW_SPOT], (double)ui64Before / (1024.0 * 1024.0), ((double)ui64Before - (double)ui64After) / (1024.0 * 1024.0));
+
+    // Create indirect draw buffers with room for every opaque object
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        g_ShadowDrawFences[i] = NULL;
+    }
+    if (!GL_InitShadowDraws(SDL_max(g_SceneData.m_uiNumOpaqueObjects, 256u)))
+        return false;
+
+    // Generate all shadows and bind them for lighting
+    GL_RenderShadows(g_uiMaxShadowLayers * SHADOW_DRAW_SECTIONS);
+    GL_BindShadowUniforms();
+
+    return true;
+}
+
+void GL_QuitShadow()
+{
+    // Output how many light layers shadow casters were sent to, including those counted by the GPU cull
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        Uint64 ui64Drawn, ui64Total;
+        GL_GetGPUCullLayers(i, ui64Drawn, ui64Total);
+        g_ui64ShadowLayersDrawn += ui64Drawn;
+        g_ui64ShadowLayersTotal += ui64Total;
+    }
+    if (g_ui64ShadowLayersTotal > 0)
+        SDL_Log("Shadow casters were drawn to %.1f%% of light layers\n", (double)g_ui64ShadowLayersDrawn * 100.0 / (double)g_ui64ShadowLayersTotal);
+    g_ui64ShadowLayersDrawn = 0;
+    g_ui64ShadowLayersTotal = 0;
+    if (g_uiShadowFrames > 0)
+        SDL_Log("Shadow cache updated %.2f layers per frame on average over %u frames\n", (double)g_ui64ShadowLayersUpdated / (double)g_uiShadowFrames,
+                g_uiShadowFrames);
+    g_ui64ShadowLayersUpdated = 0;
+    g_uiShadowFrames = 0;
+
+    // Release shadow map FBO data
+    glDeleteFramebuffers(1, &g_uiFBOShadow);
+    glDeleteTextures(1, &g_uiShadowAtlas);
+    glDeleteTextures(1, &g_uiShadowCubeAtlas);
+    glDeleteFramebuffers(1, &g_uiFBOTransparency);
+    glDeleteTextures(1, &g_uiTransparencyAtlas);
+
+    // Release indirect draw data
+    GL_QuitShadowDraws();
+    free(gp_ShadowCommands);
+    free(gp_uiShadowDrawIndices);
+    gp_ShadowCommands = NULL;
+    gp_uiShadowDrawIndices = NULL;
+    g_uiMaxShadowCommands = 0;
+
+    // Release shadow cache data
+    for (unsigned i = 0; i < SHADOW_DRAW_SECTIONS; i++) {
+        free(gp_ShadowLights[i]);
+        free(gp_m4ShadowViewProjections[i]);
+        free(gp_ShadowPositions[i]);
+        free(gp_ShadowTiles[i]);
+        free(gp_v2ShadowNearFar[i]);
+        gp_ShadowLights[i] = NULL;
+        gp_m4ShadowViewProjections[i] = NULL;
+        gp_ShadowPositions[i] = NULL;
+        gp_ShadowTiles[i] = NULL;
+        gp_v2ShadowNearFar[i] = NULL;
+        g_uiShadowAtlasWidth[i] = 0;
+        g_uiShadowAtlasHeight[i] = 0;
+        g_uiShadowDirtyLayers[i] = 0;
+        g_uiShadowUpdateLayers[i] = 0;
+    }
+    free(gp_v4ShadowMovedBounds);
+    free(gp_uiShadowMovedObjects);
+    gp_v4ShadowMovedBounds = NULL;
+    gp_uiShadowMovedObjects = NULL;
+    g_uiNumShadowMoved = 0;
+    g_uiMaxShadowMoved = 0;
+}
\ No newline at end of file
@@ -0,0 +1,1075 @@
+// Using SDL, GLEW
+#include <math.h>
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include "GLTrace.h"
+
+// Streaming limits
+const unsigned g_uiStreamThreads = 2;
+const unsigned g_uiStreamSlices = 3;
+const unsigned g_uiStreamSliceSize = 8 * 1024 * 1024;
+const double g_dStreamFrameBudgetMS = 2.0;
+// Refinement loads in flight at once, bounds the memory held by levels waiting for upload
+const unsigned g_uiStreamMaxLoads = 8;
+const unsigned g_uiStreamMaxLevels = 16;
+// Residency limits, levels up to the coarse size are always resident
+const unsigned g_uiStreamCoarseSize = 128;
+const float g_fStreamLevelBias = -1.0f;
+Uint64 g_ui64TextureBudget = 256 * 1024 * 1024;
+
+struct TextureStreamData
+{
+    GLuint m_uiTexture;
+    char * mp_cFile;
+    // Format and layout from the file header, level data is only held in memory while being uploaded
+    GLenum m_InternalFormat;
+    GLenum m_Format;
+    GLenum m_Type;
+    unsigned m_uiWidth;
+    unsigned m_uiHeight;
+    unsigned m_uiSize;
+    unsigned m_uiNumLevels;
+    Uint64 m_ui64Bytes;
+    Uint64 m_ui64LevelOffsets[g_uiStreamMaxLevels];
+    Uint32 m_ui32LevelSizes[g_uiStreamMaxLevels];
+    bool m_bLoading;
+    // Finest level currently resident, number of levels if none
+    unsigned m_uiResidentLevel;
+    // Coarsest level that is never evicted
+    unsigned m_uiMinLevel;
+    // Finest level needed by the last frame it was used and the current frames requests
+    unsigned m_uiWantedLevel;
+    unsigned m_uiRequestLevel;
+    unsigned m_uiLastUsedFrame;
+    unsigned m_uiNumUploads;
+    // Immutable storage for every level with a view starting at each first resident level, the last view is the placeholder
+    GLuint m_uiStorage;
+    unsigned m_uiStorageLevels;
+    bool m_bSparse;
+    bool m_bTailCommitted;
+    unsigned m_uiNumSparseLevels;
+    GLuint m_uiViews[g_uiStreamMaxLevels + 1];
+    GLuint64 m_ui64Handles[g_uiStreamMaxLevels + 1];
+    unsigned m_uiResidentHandles;
+    unsigned m_uiView;
+    // Texture currently holding the resident levels and its bindless handle
+    GLuint m_uiBacking;
+    GLuint64 m_ui64Handle;
+};
+
+// Levels read from the file by a worker, finer levels come first in the file so each load is one block
+// Header loads instead fill in the request directly while the GL thread waits for them
+struct TextureLoadData
+{
+    unsigned m_uiRequest;
+    const char * mp_cFile;
+    bool m_bHeader;
+    unsigned m_uiFirstLevel;
+    unsigned m_uiLastLevel;
+    Uint64 m_ui64Offset;
+    Uint64 m_ui64Size;
+    Uint64 m_ui64Reserved;
+    Uint64 m_ui64Ticks;
+    unsigned char * mp_Data;
+};
+
+// Replaced views waiting for the GPU to finish with them
+struct TextureRetireData
+{
+    unsigned m_uiRequest;
+    unsigned m_uiView;
+    // Level to release once unused, only if nothing has been uploaded since
+    unsigned m_uiEvictLevel;
+    unsigned m_uiNumUploads;
+    GLsync m_Fence;
+};
+
+// Streamed textures
+TextureStreamData * gp_StreamRequests = NULL;
+unsigned g_uiNumStreamRequests = 0;
+unsigned g_uiMaxStreamRequests = 0;
+int * gp_iStreamTextureRequests = NULL;
+unsigned g_uiMaxStreamTextures = 0;
+unsigned g_uiNumStreamStarted = 0;
+// Textures in priority order each frame for adding and removing detail
+unsigned * gp_uiStreamRefine = NULL;
+unsigned * gp_uiStreamEvict = NULL;
+// Loads queued for the workers and loads handed back to the GL thread, both guarded by the mutex
+SDL_mutex * gp_StreamMutex = NULL;
+SDL_sem * gp_StreamSemaphore = NULL;
+SDL_sem * gp_StreamHeaderSemaphore = NULL;
+bool g_bStreamQuit = false;
+SDL_Thread * gp_StreamThreads[g_uiStreamThreads];
+unsigned g_uiNumStreamThreads = 0;
+TextureLoadData * gp_StreamQueue = NULL;
+unsigned g_uiNumStreamQueue = 0;
+unsigned g_uiStreamQueueRead = 0;
+unsigned g_uiMaxStreamQueue = 0;
+TextureLoadData * gp_StreamLoaded = NULL;
+unsigned g_uiNumStreamLoaded = 0;
+unsigned g_uiMaxStreamLoaded = 0;
+// Loads waiting for upload on the GL thread
+TextureLoadData * gp_StreamUploads = NULL;
+unsigned g_uiNumStreamUploads = 0;
+unsigned g_uiStreamUploadRead = 0;
+unsigned g_uiMaxStreamUploads = 0;
+unsigned g_uiNumStreamPending = 0;
+unsigned g_uiNumStreamRefines = 0;
+// Persistently mapped upload buffer, split into slices used by one frame each
+GLuint g_uiStreamPBO = 0;
+unsigned char * gp_StreamPBOData = NULL;
+GLsync g_StreamFences[g_uiStreamSlices];
+unsigned g_uiStreamSlice = 0;
+// Texture memory currently resident and set aside for loads in flight
+Uint64 g_ui64TextureResident = 0;
+Uint64 g_ui64TextureReserved = 0;
+Uint64 g_ui64TexturePeak = 0;
+unsigned g_uiStreamFrame = 0;
+// Streaming statistics
+unsigned g_uiStreamLevelsIn = 0;
+unsigned g_uiStreamLevelsOut = 0;
+unsigned g_uiStreamedTextures = 0;
+Uint64 g_ui64StreamedBytes = 0;
+Uint64 g_ui64StreamDecodeTicks = 0;
+Uint64 g_ui64StreamUploadTicks = 0;
+Uint64 g_ui64StreamStart = 0;
+// Bindless handles, texture state is immutable once a handle exists so sampling is clamped by switching views
+bool g_bStreamHandles = false;
+unsigned g_uiTextureHandleVersion = 0;
+TextureRetireData * gp_TextureRetires = NULL;
+unsigned g_uiNumTextureRetires = 0;
+unsigned g_uiMaxTextureRetires = 0;
+
+bool GL_TextureFormatHasAlpha(GLenum Format)
+{
+    switch (Format) {
+        case GL_RGBA:
+        case GL_RGBA8:
+        case GL_SRGB8_ALPHA8:
+        case GL_RGBA16F:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool GL_ReadTextureInfoKTX(const char * p_cTextureFile, TextureStreamData * p_Request)
+{
+    // Read the header to get the format and size of the image data
+    SDL_RWops * p_File = SDL_RWFromFile(p_cTextureFile, "rb");
+    if (p_File == NULL) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to open texture file: %s (%s)\n", p_cTextureFile, SDL_GetError());
+        return false;
+    }
+    unsigned char ucHeader[64];
+    bool bRead = (SDL_RWread(p_File, ucHeader, sizeof(ucHeader), 1) == 1);
+    const unsigned char ucIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+    if (!bRead || (memcmp(ucHeader, ucIdentifier, sizeof(ucIdentifier)) != 0)) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Invalid texture file: %s\n", p_cTextureFile);
+        SDL_RWclose(p_File);
+        return false;
+    }
+
+    // Header fields follow the identifier, only native endian 2D textures can be streamed
+    Uint32 ui32Fields[13];
+    memcpy(ui32Fields, &ucHeader[sizeof(ucIdentifier)], sizeof(ui32Fields));
+    const unsigned uiNumLevels = (ui32Fields[11] > 0) ? ui32Fields[11] : 1;
+    if ((ui32Fields[0] != 0x04030201) || (ui32Fields[9] > 0) || (ui32Fields[10] != 1) || (uiNumLevels > g_uiStreamMaxLevels)) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Unsupported texture file: %s\n", p_cTextureFile);
+        SDL_RWclose(p_File);
+        return false;
+    }
+    p_Request->m_Type = (GLenum)ui32Fields[1];
+    p_Request->m_Format = (GLenum)ui32Fields[3];
+    p_Request->m_InternalFormat = (GLenum)ui32Fields[4];
+    p_Request->m_uiWidth = ui32Fields[6];
+    p_Request->m_uiHeight = SDL_max(ui32Fields[7], 1u);
+    p_Request->m_uiSize = SDL_max(p_Request->m_uiWidth, p_Request->m_uiHeight);
+    p_Request->m_uiNumLevels = uiNumLevels;
+
+    // Each level is its size followed by its data padded to 4 bytes, image data starts after the key/value data
+    Sint64 i64Offset = sizeof(ucHeader) + ui32Fields[12];
+    p_Request->m_ui64Bytes = 0;
+    for (unsigned i = 0; (i < uiNumLevels) && bRead; i++) {
+        Uint32 ui32Size;
+        bRead = (SDL_RWseek(p_File, i64Offset, RW_SEEK_SET) >= 0) && (SDL_RWread(p_File, &ui32Size, sizeof(Uint32), 1) == 1);
+        p_Request->m_ui64LevelOffsets[i] = (Uint64)i64Offset + sizeof(Uint32);
+        p_Request->m_ui32LevelSizes[i] = ui32Size;
+        p_Request->m_ui64Bytes += ui32Size;
+        i64Offset += sizeof(Uint32) + ((ui32Size + 3) & ~3u);
+    }
+    SDL_RWclose(p_File);
+    if (!bRead) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Invalid texture file: %s\n", p_cTextureFile);
+        return false;
+    }
+    return true;
+}
+
+void GL_LoadTextureLevels(TextureLoadData * p_Load)
+{
+    GL_TRACE_ZONE("GL_LoadTextureLevels");
+    // Read just the block of the file holding the requested levels
+    const Uint64 ui64Start = SDL_GetPerformanceCounter();
+    SDL_RWops * p_File = SDL_RWFromFile(p_Load->mp_cFile, "rb");
+    p_Load->mp_Data = (p_File != NULL) ? (unsigned char *)malloc((size_t)p_Load->m_ui64Size) : NULL;
+    if ((p_Load->mp_Data != NULL) && ((SDL_RWseek(p_File, (Sint64)p_Load->m_ui64Offset, RW_SEEK_SET) < 0) ||
+                                      (SDL_RWread(p_File, p_Load->mp_Data, (size_t)p_Load->m_ui64Size, 1) != 1))) {
+        free(p_Load->mp_Data);
+        p_Load->mp_Data = NULL;
+    }
+    if (p_File != NULL)
+        SDL_RWclose(p_File);
+    if (p_Load->mp_Data == NULL)
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to read texture file: %s\n", p_Load->mp_cFile);
+    p_Load->m_ui64Ticks = SDL_GetPerformanceCounter() - ui64Start;
+}
+
+int GL_StreamTextureThread(void * p_Data)
+{
+    // Take queued loads in order until streaming stops
+    for (;;) {
+        SDL_SemWait(gp_StreamSemaphore);
+        SDL_LockMutex(gp_StreamMutex);
+        if (g_bStreamQuit) {
+            SDL_UnlockMutex(gp_StreamMutex);
+            break;
+        }
+        if (g_uiStreamQueueRead == g_uiNumStreamQueue) {
+            SDL_UnlockMutex(gp_StreamMutex);
+            continue;
+        }
+        TextureLoadData Load = gp_StreamQueue[g_uiStreamQueueRead++];
+        if (g_uiStreamQueueRead == g_uiNumStreamQueue) {
+            g_uiStreamQueueRead = 0;
+            g_uiNumStreamQueue = 0;
+        }
+        SDL_UnlockMutex(gp_StreamMutex);
+
+        // Requests are not moved while the GL thread waits for headers, failed textures are left without levels
+        if (Load.m_bHeader) {
+            TextureStreamData * p_Request = &gp_StreamRequests[Load.m_uiRequest];
+            if (!GL_ReadTextureInfoKTX(Load.mp_cFile, p_Request))
+                p_Request->m_uiNumLevels = 0;
+            SDL_SemPost(gp_StreamHeaderSemaphore);
+            continue;
+        }
+        GL_LoadTextureLevels(&Load);
+
+        // Hand over to the GL thread
+        SDL_LockMutex(gp_StreamMutex);
+        if (g_uiNumStreamLoaded >= g_uiMaxStreamLoaded) {
+            g_uiMaxStreamLoaded = SDL_max(g_uiMaxStreamLoaded * 2, 64u);
+            gp_StreamLoaded = (TextureLoadData *)realloc(gp_StreamLoaded, g_uiMaxStreamLoaded * sizeof(TextureLoadData));
+        }
+        gp_StreamLoaded[g_uiNumStreamLoaded++] = Load;
+        SDL_UnlockMutex(gp_StreamMutex);
+    }
+    return 0;
+}
+
+void GL_InitTextureStream()
+{
+    if (gp_StreamMutex == NULL) {
+        gp_StreamMutex = SDL_CreateMutex();
+        gp_StreamSemaphore = SDL_CreateSemaphore(0);
+        gp_StreamHeaderSemaphore = SDL_CreateSemaphore(0);
+    }
+    if (g_uiStreamPBO != 0)
+        return;
+
+    // Create upload buffer that stays mapped, without buffer storage levels are uploaded from client memory
+    if (GLEW_ARB_buffer_storage) {
+        const GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &g_uiStreamPBO);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_uiStreamPBO);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, g_uiStreamSlices * g_uiStreamSliceSize, NULL, Flags);
+        gp_StreamPBOData = (unsigned char *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, g_uiStreamSlices * g_uiStreamSliceSize, Flags);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    for (unsigned i = 0; i < g_uiStreamSlices; i++) {
+        g_StreamFences[i] = NULL;
+    }
+}
+
+void GL_StopTextureStreamThreads()
+{
+    // Wake every worker so each sees the quit flag, queued loads are dropped
+    if (g_uiNumStreamThreads == 0)
+        return;
+    SDL_LockMutex(gp_StreamMutex);
+    g_bStreamQuit = true;
+    SDL_UnlockMutex(gp_StreamMutex);
+    for (unsigned i = 0; i < g_uiNumStreamThreads; i++) {
+        SDL_SemPost(gp_StreamSemaphore);
+    }
+    for (unsigned i = 0; i < g_uiNumStreamThreads; i++) {
+        if (gp_StreamThreads[i] != NULL)
+            SDL_WaitThread(gp_StreamThreads[i], NULL);
+    }
+    g_uiNumStreamThreads = 0;
+    g_bStreamQuit = false;
+}
+
+void GL_PushTextureLoad(const TextureLoadData & Load)
+{
+    // Wake a worker
+    SDL_LockMutex(gp_StreamMutex);
+    if (g_uiNumStreamQueue >= g_uiMaxStreamQueue) {
+        g_uiMaxStreamQueue = SDL_max(g_uiMaxStreamQueue * 2, 64u);
+        gp_StreamQueue = (TextureLoadData *)realloc(gp_StreamQueue, g_uiMaxStreamQueue * sizeof(TextureLoadData));
+    }
+    gp_StreamQueue[g_uiNumStreamQueue++] = Load;
+    SDL_UnlockMutex(gp_StreamMutex);
+    SDL_SemPost(gp_StreamSemaphore);
+}
+
+void GL_QueueTextureLoad(TextureStreamData * p_Request, unsigned uiFirstLevel, unsigned uiLastLevel, Uint64 ui64Reserved)
+{
+    // Levels from the first up to but not including the last are read together
+    TextureLoadData Load;
+    Load.m_uiRequest = (unsigned)(p_Request - gp_StreamRequests);
+    Load.mp_cFile = p_Request->mp_cFile;
+    Load.m_bHeader = false;
+    Load.m_uiFirstLevel = uiFirstLevel;
+    Load.m_uiLastLevel = uiLastLevel;
+    Load.m_ui64Offset = p_Request->m_ui64LevelOffsets[uiFirstLevel];
+    Load.m_ui64Size = p_Request->m_ui64LevelOffsets[uiLastLevel - 1] + p_Request->m_ui32LevelSizes[uiLastLevel - 1] - Load.m_ui64Offset;
+    Load.m_ui64Reserved = ui64Reserved;
+    Load.m_ui64Ticks = 0;
+    Load.mp_Data = NULL;
+    p_Request->m_bLoading = true;
+    g_ui64TextureReserved += ui64Reserved;
+    GL_PushTextureLoad(Load);
+}
+
+void GL_StreamTexture(GLuint uiTexture, const char * p_cTextureFile, const GLubyte * p_ucPlaceholder)
+{
+    // Use a single texel placeholder until the real data is resident
+    glBindTexture(GL_TEXTURE_2D, uiTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, p_ucPlaceholder);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4.0f);
+
+    // Workers only write to requests while the GL thread waits so they can be moved at any other time
+    if (g_uiNumStreamRequests >= g_uiMaxStreamRequests) {
+        g_uiMaxStreamRequests = SDL_max(g_uiMaxStreamRequests * 2, 64u);
+        gp_StreamRequests = (TextureStreamData *)realloc(gp_StreamRequests, g_uiMaxStreamRequests * sizeof(TextureStreamData));
+        gp_uiStreamRefine = (unsigned *)realloc(gp_uiStreamRefine, g_uiMaxStreamRequests * sizeof(unsigned));
+        gp_uiStreamEvict = (unsigned *)realloc(gp_uiStreamEvict, g_uiMaxStreamRequests * sizeof(unsigned));
+    }
+    if (uiTexture >= g_uiMaxStreamTextures) {
+        const unsigned uiMaxTextures = SDL_max(uiTexture + 1, g_uiMaxStreamTextures * 2);
+        gp_iStreamTextureRequests = (int *)realloc(gp_iStreamTextureRequests, uiMaxTextures * sizeof(int));
+        for (unsigned i = g_uiMaxStreamTextures; i < uiMaxTextures; i++) {
+            gp_iStreamTextureRequests[i] = -1;
+        }
+        g_uiMaxStreamTextures = uiMaxTextures;
+    }
+    gp_iStreamTextureRequests[uiTexture] = (int)g_uiNumStreamRequests;
+    TextureStreamData * p_Request = &gp_StreamRequests[g_uiNumStreamRequests];
+    p_Request->m_uiTexture = uiTexture;
+    p_Request->mp_cFile = (char *)malloc(strlen(p_cTextureFile) + 1);
+    strcpy(p_Request->mp_cFile, p_cTextureFile);
+    // Nothing can be streamed until the header has been read
+    p_Request->m_InternalFormat = GL_RGBA8;
+    p_Request->m_uiSize = 0;
+    p_Request->m_uiNumLevels = 0;
+    p_Request->m_ui64Bytes = 0;
+    p_Request->m_bLoading = false;
+    p_Request->m_uiResidentLevel = 0;
+    p_Request->m_uiMinLevel = 0;
+    p_Request->m_uiWantedLevel = 0;
+    p_Request->m_uiRequestLevel = 0;
+    p_Request->m_uiLastUsedFrame = 0;
+    p_Request->m_uiNumUploads = 0;
+    p_Request->m_uiStorage = 0;
+    p_Request->m_uiStorageLevels = 0;
+    p_Request->m_bSparse = false;
+    p_Request->m_bTailCommitted = false;
+    p_Request->m_uiNumSparseLevels = 0;
+    for (unsigned i = 0; i <= g_uiStreamMaxLevels; i++) {
+        p_Request->m_uiViews[i] = 0;
+        p_Request->m_ui64Handles[i] = 0;
+    }
+    p_Request->m_uiViews[g_uiStreamMaxLevels] = uiTexture;
+    p_Request->m_uiResidentHandles = 0;
+    p_Request->m_uiView = g_uiStreamMaxLevels;
+    p_Request->m_uiBacking = uiTexture;
+    p_Request->m_ui64Handle = 0;
+    if (g_bStreamHandles) {
+        p_Request->m_ui64Handles[g_uiStreamMaxLevels] = glGetTextureHandleARB(uiTexture);
+        glMakeTextureHandleResidentARB(p_Request->m_ui64Handles[g_uiStreamMaxLevels]);
+        p_Request->m_uiResidentHandles = 1u << g_uiStreamMaxLevels;
+        p_Request->m_ui64Handle = p_Request->m_ui64Handles[g_uiStreamMaxLevels];
+        ++g_uiTextureHandleVersion;
+    }
+    ++g_uiNumStreamRequests;
+}
+
+void GL_StartTextureStream()
+{
+    if (g_uiNumStreamStarted == g_uiNumStreamRequests)
+        return;
+
+    // Workers stay running to load finer levels as they are needed
+    if (g_uiNumStreamThreads == 0) {
+        for (unsigned i = 0; i < g_uiStreamThreads; i++) {
+            gp_StreamThreads[i] = SDL_CreateThread(GL_StreamTextureThread, "StreamTexture", NULL);
+        }
+        g_uiNumStreamThreads = g_uiStreamThreads;
+    }
+    if (g_ui64StreamStart == 0)
+        g_ui64StreamStart = SDL_GetPerformanceCounter();
+
+    // Read every new header on the workers, waiting once for them all as materials need the formats
+    for (unsigned i = g_uiNumStreamStarted; i < g_uiNumStreamRequests; i++) {
+        TextureLoadData Load = {};
+        Load.m_uiRequest = i;
+        Load.mp_cFile = gp_StreamRequests[i].mp_cFile;
+        Load.m_bHeader = true;
+        GL_PushTextureLoad(Load);
+    }
+    for (unsigned i = g_uiNumStreamStarted; i < g_uiNumStreamRequests; i++) {
+        SDL_SemWait(gp_StreamHeaderSemaphore);
+    }
+
+    // Load the coarse levels of every new texture, textures that failed keep their placeholder
+    for (unsigned i = g_uiNumStreamStarted; i < g_uiNumStreamRequests; i++) {
+        TextureStreamData * p_Request = &gp_StreamRequests[i];
+        if (p_Request->m_uiNumLevels == 0)
+            continue;
+
+        // Start with the levels up to the coarse size, or everything if mipmaps need generating
+        p_Request->m_uiResidentLevel = p_Request->m_uiNumLevels;
+        while ((p_Request->m_uiNumLevels > 1) && (p_Request->m_uiMinLevel < p_Request->m_uiNumLevels - 1) &&
+               ((p_Request->m_uiSize >> p_Request->m_uiMinLevel) > g_uiStreamCoarseSize))
+            ++p_Request->m_uiMinLevel;
+        p_Request->m_uiWantedLevel = p_Request->m_uiMinLevel;
+        p_Request->m_uiRequestLevel = p_Request->m_uiMinLevel;
+        GL_QueueTextureLoad(p_Request, p_Request->m_uiMinLevel, p_Request->m_uiNumLevels, 0);
+        ++g_uiNumStreamPending;
+    }
+    g_uiNumStreamStarted = g_uiNumStreamRequests;
+}
+
+bool GL_GetStreamTextureInfo(GLuint uiTexture, bool & bAlpha, Uint64 & ui64Bytes)
+{
+    // Format and size are known once streaming has started
+    bAlpha = false;
+    ui64Bytes = 0;
+    if ((uiTexture >= g_uiMaxStreamTextures) || (gp_iStreamTextureRequests[uiTexture] < 0))
+        return false;
+    const TextureStreamData * p_Request = &gp_StreamRequests[gp_iStreamTextureRequests[uiTexture]];
+    if (p_Request->m_uiNumLevels == 0)
+        return false;
+    bAlpha = GL_TextureFormatHasAlpha(p_Request->m_InternalFormat);
+    ui64Bytes = p_Request->m_ui64Bytes;
+    return true;
+}
+
+bool GL_IsTextureStreamPending()
+{
+    // New textures are still waiting for their coarse levels
+    return (g_uiNumStreamPending > 0);
+}
+
+Uint64 GL_GetTextureLevelBytes(const TextureStreamData * p_Request, unsigned uiLevel)
+{
+    // Generated mipmaps add a third to the base level
+    const Uint64 ui64Bytes = p_Request->m_ui32LevelSizes[uiLevel];
+    return (p_Request->m_uiNumLevels == 1) ? (ui64Bytes * 4) / 3 : ui64Bytes;
+}
+
+Uint64 GL_GetTextureLevelCost(const TextureStreamData * p_Request, unsigned uiLevel)
+{
+    // Storage that is not sparse already holds every level
+    if ((p_Request->m_uiStorage != 0) && !p_Request->m_bSparse)
+        return 0;
+    return GL_GetTextureLevelBytes(p_Request, uiLevel);
+}
+
+void GL_CreateTextureStorage(TextureStreamData * p_Request)
+{
+    // Allocate immutable storage for the full chain, sparse storage only backs the levels that are resident
+    const unsigned uiWidth = p_Request->m_uiWidth;
+    const unsigned uiHeight = p_Request->m_uiHeight;
+    p_Request->m_uiStorageLevels = p_Request->m_uiNumLevels;
+    if (p_Request->m_uiNumLevels == 1)
+        p_Request->m_uiStorageLevels = (unsigned)floorf(log2f((float)p_Request->m_uiSize)) + 1;
+    GLint iPageX = 0, iPageY = 0;
+    if (GLEW_ARB_sparse_texture) {
+        glGetInternalformativ(GL_TEXTURE_2D, p_Request->m_InternalFormat, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &iPageX);
+        glGetInternalformativ(GL_TEXTURE_2D, p_Request->m_InternalFormat, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &iPageY);
+    }
+    p_Request->m_bSparse = (iPageX > 0) && (iPageY > 0) && (uiWidth % (unsigned)iPageX == 0) && (uiHeight % (unsigned)iPageY == 0);
+    glGenTextures(1, &p_Request->m_uiStorage);
+    glBindTexture(GL_TEXTURE_2D, p_Request->m_uiStorage);
+    if (p_Request->m_bSparse)
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+    glTexStorage2D(GL_TEXTURE_2D, (GLsizei)p_Request->m_uiStorageLevels, p_Request->m_InternalFormat, (GLsizei)uiWidth, (GLsizei)uiHeight);
+    if (p_Request->m_bSparse) {
+        GLint iNumSparseLevels;
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_NUM_SPARSE_LEVELS_ARB, &iNumSparseLevels);
+        p_Request->m_uiNumSparseLevels = (unsigned)iNumSparseLevels;
+        return;
+    }
+
+    // Every level is allocated up front
+    for (unsigned i = 0; i < p_Request->m_uiNumLevels; i++) {
+        g_ui64TextureResident += GL_GetTextureLevelBytes(p_Request, i);
+    }
+    g_ui64TexturePeak = SDL_max(g_ui64TexturePeak, g_ui64TextureResident);
+}
+
+void GL_CommitTextureLevel(TextureStreamData * p_Request, unsigned uiLevel, GLboolean bCommit)
+{
+    // Only sparse storage backs levels individually, levels in the mip tail are backed together and kept
+    if (!p_Request->m_bSparse)
+        return;
+    glBindTexture(GL_TEXTURE_2D, p_Request->m_uiStorage);
+    const unsigned uiLastLevel = (p_Request->m_uiNumLevels == 1) ? p_Request->m_uiStorageLevels : uiLevel + 1;
+    for (unsigned i = uiLevel; i < uiLastLevel; i++) {
+        const GLsizei iWidth = (GLsizei)SDL_max(p_Request->m_uiWidth >> i, 1u);
+        const GLsizei iHeight = (GLsizei)SDL_max(p_Request->m_uiHeight >> i, 1u);
+        if (i < p_Request->m_uiNumSparseLevels) {
+            glTexPageCommitmentARB(GL_TEXTURE_2D, (GLint)i, 0, 0, 0, iWidth, iHeight, 1, bCommit);
+            continue;
+        }
+        if (bCommit && !p_Request->m_bTailCommitted) {
+            glTexPageCommitmentARB(GL_TEXTURE_2D, (GLint)i, 0, 0, 0, iWidth, iHeight, 1, GL_TRUE);
+            p_Request->m_bTailCommitted = true;
+        }
+        break;
+    }
+}
+
+void GL_SetTextureView(TextureStreamData * p_Request, unsigned uiLevel, unsigned uiEvictLevel)
+{
+    // Each first level gets a view of the storage which is kept along with its handle for when the level is next used
+    if (p_Request->m_uiViews[uiLevel] == 0) {
+        glGenTextures(1, &p_Request->m_uiViews[uiLevel]);
+        glTextureView(p_Request->m_uiViews[uiLevel], GL_TEXTURE_2D, p_Request->m_uiStorage, p_Request->m_InternalFormat,
+                      uiLevel, p_Request->m_uiStorageLevels - uiLevel, 0, 1);
+        glBindTexture(GL_TEXTURE_2D, p_Request->m_uiViews[uiLevel]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4.0f);
+        p_Request->m_ui64Handles[uiLevel] = glGetTextureHandleARB(p_Request->m_uiViews[uiLevel]);
+    }
+
+    // Keep the old view until the GPU has finished with it
+    if (g_uiNumTextureRetires >= g_uiMaxTextureRetires) {
+        g_uiMaxTextureRetires = SDL_max(g_uiMaxTextureRetires * 2, 64u);
+        gp_TextureRetires = (TextureRetireData *)realloc(gp_TextureRetires, g_uiMaxTextureRetires * sizeof(TextureRetireData));
+    }
+    TextureRetireData * p_Retire = &gp_TextureRetires[g_uiNumTextureRetires++];
+    p_Retire->m_uiRequest = (unsigned)(p_Request - gp_StreamRequests);
+    p_Retire->m_uiView = p_Request->m_uiView;
+    p_Retire->m_uiEvictLevel = uiEvictLevel;
+    p_Retire->m_uiNumUploads = p_Request->m_uiNumUploads;
+    p_Retire->m_Fence = NULL;
+
+    // Make the new view visible to shaders
+    p_Request->m_uiView = uiLevel;
+    p_Request->m_uiBacking = p_Request->m_uiViews[uiLevel];
+    p_Request->m_ui64Handle = p_Request->m_ui64Handles[uiLevel];
+    if ((p_Request->m_uiResidentHandles & (1u << uiLevel)) == 0) {
+        glMakeTextureHandleResidentARB(p_Request->m_ui64Handle);
+        p_Request->m_uiResidentHandles |= 1u << uiLevel;
+    }
+    ++g_uiTextureHandleVersion;
+}
+
+void GL_ReleaseTextureRetires(bool bWait)
+{
+    // Release replaced views once the frame that last used them has completed
+    // Fences are shared by everything retired in the same frame so each is only checked once
+    unsigned uiKept = 0;
+    GLsync LastFence = NULL;
+    bool bLastDone = bWait;
+    for (unsigned i = 0; i < g_uiNumTextureRetires; i++) {
+        TextureRetireData * p_Retire = &gp_TextureRetires[i];
+        if ((i == 0) || (p_Retire->m_Fence != LastFence)) {
+            LastFence = p_Retire->m_Fence;
+            bLastDone = bWait || ((LastFence != NULL) && (glClientWaitSync(LastFence, 0, 0) != GL_TIMEOUT_EXPIRED));
+        }
+        if (!bLastDone) {
+            gp_TextureRetires[uiKept++] = *p_Retire;
+            continue;
+        }
+        if ((LastFence != NULL) && ((i + 1 == g_uiNumTextureRetires) || (gp_TextureRetires[i + 1].m_Fence != LastFence)))
+            glDeleteSync(LastFence);
+
+        // Views may have been switched back to since they were retired
+        TextureStreamData * p_Request = &gp_StreamRequests[p_Retire->m_uiRequest];
+        if ((p_Retire->m_uiView != p_Request->m_uiView) && (p_Request->m_uiResidentHandles & (1u << p_Retire->m_uiView))) {
+            glMakeTextureHandleNonResidentARB(p_Request->m_ui64Handles[p_Retire->m_uiView]);
+            p_Request->m_uiResidentHandles &= ~(1u << p_Retire->m_uiView);
+        }
+        if ((p_Retire->m_uiEvictLevel < g_uiStreamMaxLevels) && (p_Retire->m_uiNumUploads == p_Request->m_uiNumUploads))
+            GL_CommitTextureLevel(p_Request, p_Retire->m_uiEvictLevel, GL_FALSE);
+    }
+    g_uiNumTextureRetires = uiKept;
+}
+
+void GL_UploadTextureLevel(TextureStreamData * p_Request, unsigned uiLevel, const GLvoid * p_Data, GLsizei iSize)
+{
+    // Replace the texture level, sampling is limited to the levels resident so far
+    const GLsizei iWidth = (GLsizei)SDL_max(p_Request->m_uiWidth >> uiLevel, 1u);
+    const GLsizei iHeight = (GLsizei)SDL_max(p_Request->m_uiHeight >> uiLevel, 1u);
+    const bool bCompressed = (p_Request->m_Type == 0);
+    if (g_bStreamHandles) {
+        // Fill the level of the immutable storage then move to the view starting at it
+        if (p_Request->m_uiStorage == 0)
+            GL_CreateTextureStorage(p_Request);
+        GL_CommitTextureLevel(p_Request, uiLevel, GL_TRUE);
+        glBindTexture(GL_TEXTURE_2D, p_Request->m_uiStorage);
+        if (bCompressed)
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, uiLevel, 0, 0, iWidth, iHeight, p_Request->m_InternalFormat, iSize, p_Data);
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, uiLevel, 0, 0, iWidth, iHeight, p_Request->m_Format, p_Request->m_Type, p_Data);
+        if ((uiLevel == 0) && (p_Request->m_uiNumLevels == 1))
+            glGenerateMipmap(GL_TEXTURE_2D);
+        GL_SetTextureView(p_Request, uiLevel, g_uiStreamMaxLevels);
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, p_Request->m_uiTexture);
+    if (bCompressed)
+        glCompressedTexImage2D(GL_TEXTURE_2D, uiLevel, p_Request->m_InternalFormat, iWidth, iHeight, 0, iSize, p_Data);
+    else
+        glTexImage2D(GL_TEXTURE_2D, uiLevel, p_Request->m_InternalFormat, iWidth, iHeight, 0, p_Request->m_Format, p_Request->m_Type, p_Data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, uiLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, p_Request->m_uiNumLevels - 1);
+
+    // Generate mipmaps once the full image is resident if the file has none
+    if ((uiLevel == 0) && (p_Request->m_uiNumLevels == 1)) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+bool GL_StreamTextureLevel(TextureStreamData * p_Request, TextureLoadData * p_Load, size_t uiSliceOffset, size_t & uiSliceUsed)
+{
+    // Get the next finer level from the loaded block
+    const unsigned uiLevel = p_Request->m_uiResidentLevel - 1;
+    const size_t uiSize = p_Request->m_ui32LevelSizes[uiLevel];
+    const GLvoid * p_Source = &p_Load->mp_Data[p_Request->m_ui64LevelOffsets[uiLevel] - p_Load->m_ui64Offset];
+    if ((gp_StreamPBOData != NULL) && (uiSize <= g_uiStreamSliceSize)) {
+        // Leave the rest for the next frame once the slice is full
+        if (uiSliceUsed + uiSize > g_uiStreamSliceSize)
+            return false;
+        memcpy(&gp_StreamPBOData[uiSliceOffset + uiSliceUsed], p_Source, uiSize);
+        GL_UploadTextureLevel(p_Request, uiLevel, (const GLvoid *)(uiSliceOffset + uiSliceUsed), (GLsizei)uiSize);
+        uiSliceUsed += (uiSize + 15) & ~(size_t)15;
+    } else {
+        // Levels too large for the upload buffer come straight from client memory
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        GL_UploadTextureLevel(p_Request, uiLevel, p_Source, (GLsizei)uiSize);
+        if (gp_StreamPBOData != NULL)
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_uiStreamPBO);
+    }
+
+    // Update residency, moving any memory set aside for the level
+    p_Request->m_uiResidentLevel = uiLevel;
+    ++p_Request->m_uiNumUploads;
+    const Uint64 ui64Bytes = GL_GetTextureLevelCost(p_Request, uiLevel);
+    const Uint64 ui64Reserved = SDL_min(ui64Bytes, p_Load->m_ui64Reserved);
+    p_Load->m_ui64Reserved -= ui64Reserved;
+    g_ui64TextureReserved -= ui64Reserved;
+    g_ui64TextureResident += ui64Bytes;
+    g_ui64TexturePeak = SDL_max(g_ui64TexturePeak, g_ui64TextureResident);
+    g_ui64StreamedBytes += uiSize;
+    ++g_uiStreamLevelsIn;
+    return true;
+}
+
+void GL_FinishTextureLoad(TextureLoadData * p_Load)
+{
+    // Release the loaded levels, evicted levels are read from the file again when next needed
+    TextureStreamData * p_Request = &gp_StreamRequests[p_Load->m_uiRequest];
+    free(p_Load->mp_Data);
+    p_Load->mp_Data = NULL;
+    g_ui64TextureReserved -= p_Load->m_ui64Reserved;
+    p_Load->m_ui64Reserved = 0;
+    p_Request->m_bLoading = false;
+
+    // Loads of new textures cover every level, failed textures keep their placeholder
+    if (p_Load->m_uiLastLevel == p_Request->m_uiNumLevels) {
+        if (p_Request->m_uiResidentLevel == p_Load->m_uiFirstLevel)
+            ++g_uiStreamedTextures;
+        --g_uiNumStreamPending;
+    } else
+        --g_uiNumStreamRefines;
+}
+
+void GL_EvictTextureLevel(TextureStreamData * p_Request)
+{
+    // Clamp sampling to the next coarser level then release the finest level
+    const unsigned uiLevel = p_Request->m_uiResidentLevel;
+    if (g_bStreamHandles)
+        GL_SetTextureView(p_Request, uiLevel + 1, uiLevel);
+    else {
+        glBindTexture(GL_TEXTURE_2D, p_Request->m_uiTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, uiLevel + 1);
+        if (p_Request->m_Type == 0)
+            glCompressedTexImage2D(GL_TEXTURE_2D, uiLevel, p_Request->m_InternalFormat, 0, 0, 0, 0, NULL);
+        else
+            glTexImage2D(GL_TEXTURE_2D, uiLevel, p_Request->m_InternalFormat, 0, 0, 0, p_Request->m_Format, p_Request->m_Type, NULL);
+    }
+
+    // Update residency
+    p_Request->m_uiResidentLevel = uiLevel + 1;
+    g_ui64TextureResident -= GL_GetTextureLevelCost(p_Request, uiLevel);
+    ++g_uiStreamLevelsOut;
+}
+
+void GL_RequestTextureLevels(const GLuint * p_uiTextures, unsigned uiNumTextures, float fPixels)
+{
+    if (fPixels <= 0.0f)
+        return;
+
+    // Find the finest level needed for the size on screen, assuming the texture spans the object
+    for (unsigned i = 0; i < uiNumTextures; i++) {
+        if ((p_uiTextures[i] >= g_uiMaxStreamTextures) || (gp_iStreamTextureRequests[p_uiTextures[i]] < 0))
+            continue;
+        TextureStreamData * p_Request = &gp_StreamRequests[gp_iStreamTextureRequests[p_uiTextures[i]]];
+        const float fLevel = log2f((float)p_Request->m_uiSize / fPixels) + g_fStreamLevelBias;
+        const unsigned uiLevel = (fLevel <= 0.0f) ? 0 : SDL_min((unsigned)fLevel, p_Request->m_uiMinLevel);
+        p_Request->m_uiRequestLevel = SDL_min(p_Request->m_uiRequestLevel, uiLevel);
+        p_Request->m_uiLastUsedFrame = g_uiStreamFrame;
+    }
+}
+
+int GL_CompareTextureRefine(const void * p_A, const void * p_B)
+{
+    // Most recently used first, then furthest from the detail it needs
+    const TextureStreamData * p_RequestA = &gp_StreamRequests[*(const unsigned *)p_A];
+    const TextureStreamData * p_RequestB = &gp_StreamRequests[*(const unsigned *)p_B];
+    if (p_RequestA->m_uiLastUsedFrame != p_RequestB->m_uiLastUsedFrame)
+        return (p_RequestA->m_uiLastUsedFrame > p_RequestB->m_uiLastUsedFrame) ? -1 : 1;
+    const unsigned uiMissingA = p_RequestA->m_uiResidentLevel - p_RequestA->m_uiWantedLevel;
+    const unsigned uiMissingB = p_RequestB->m_uiResidentLevel - p_RequestB->m_uiWantedLevel;
+    return (uiMissingA > uiMissingB) ? -1 : ((uiMissingA < uiMissingB) ? 1 : 0);
+}
+
+int GL_CompareTextureEvict(const void * p_A, const void * p_B)
+{
+    // Textures with more detail than they need first, then the least recently used
+    const TextureStreamData * p_RequestA = &gp_StreamRequests[*(const unsigned *)p_A];
+    const TextureStreamData * p_RequestB = &gp_StreamRequests[*(const unsigned *)p_B];
+    const bool bSurplusA = (p_RequestA->m_uiResidentLevel < p_RequestA->m_uiWantedLevel);
+    const bool bSurplusB = (p_RequestB->m_uiResidentLevel < p_RequestB->m_uiWantedLevel);
+    if (bSurplusA != bSurplusB)
+        return bSurplusA ? -1 : 1;
+    if (p_RequestA->m_uiLastUsedFrame != p_RequestB->m_uiLastUsedFrame)
+        return (p_RequestA->m_uiLastUsedFrame < p_RequestB->m_uiLastUsedFrame) ? -1 : 1;
+    return 0;
+}
+
+void GL_QueueTextureRefines()
+{
+    // Take the levels requested during the last frame, only textures with their coarse levels resident and nothing loading can change
+    unsigned uiNumRefine = 0, uiNumEvict = 0;
+    for (unsigned i = 0; i < g_uiNumStreamRequests; i++) {
+        TextureStreamData * p_Request = &gp_StreamRequests[i];
+        if (p_Request->m_uiLastUsedFrame + 1 == g_uiStreamFrame)
+            p_Request->m_uiWantedLevel = p_Request->m_uiRequestLevel;
+        p_Request->m_uiRequestLevel = p_Request->m_uiMinLevel;
+        if (p_Request->m_bLoading || (p_Request->m_uiResidentLevel > p_Request->m_uiMinLevel))
+            continue;
+        if (p_Request->m_uiResidentLevel > p_Request->m_uiWantedLevel)
+            gp_uiStreamRefine[uiNumRefine++] = i;
+        // Storage that is not sparse gains nothing from eviction
+        if ((p_Request->m_uiResidentLevel < p_Request->m_uiMinLevel) && (GL_GetTextureLevelCost(p_Request, p_Request->m_uiResidentLevel) > 0))
+            gp_uiStreamEvict[uiNumEvict++] = i;
+    }
+
+    // Order both once so each is then taken from the front
+    qsort(gp_uiStreamRefine, uiNumRefine, sizeof(unsigned), GL_CompareTextureRefine);
+    qsort(gp_uiStreamEvict, uiNumEvict, sizeof(unsigned), GL_CompareTextureEvict);
+
+    // Load finer levels where needed, evicting unneeded detail to stay within budget
+    unsigned uiEvict = 0;
+    for (unsigned i = 0; (i < uiNumRefine) && (g_uiNumStreamRefines < g_uiStreamMaxLoads); i++) {
+        TextureStreamData * p_Request = &gp_StreamRequests[gp_uiStreamRefine[i]];
+        unsigned uiLevel = p_Request->m_uiResidentLevel;
+        Uint64 ui64Reserved = 0;
+        while (uiLevel > p_Request->m_uiWantedLevel) {
+            const Uint64 ui64Bytes = GL_GetTextureLevelCost(p_Request, uiLevel - 1);
+            while ((g_ui64TextureResident + g_ui64TextureReserved + ui64Reserved + ui64Bytes > g_ui64TextureBudget) && (uiEvict < uiNumEvict)) {
+                // Only evict from textures that have a surplus or were used less recently than this one
+                TextureStreamData * p_Evict = &gp_StreamRequests[gp_uiStreamEvict[uiEvict]];
+                if ((p_Evict != p_Request) && !p_Evict->m_bLoading && (p_Evict->m_uiResidentLevel < p_Evict->m_uiMinLevel) &&
+                    ((p_Evict->m_uiResidentLevel < p_Evict->m_uiWantedLevel) || (p_Evict->m_uiLastUsedFrame < p_Request->m_uiLastUsedFrame)))
+                    GL_EvictTextureLevel(p_Evict);
+                else
+                    ++uiEvict;
+            }
+            if (g_ui64TextureResident + g_ui64TextureReserved + ui64Reserved + ui64Bytes > g_ui64TextureBudget)
+                break;
+            ui64Reserved += ui64Bytes;
+            --uiLevel;
+        }
+
+        // Lower priority textures cannot be given memory either
+        if (uiLevel == p_Request->m_uiResidentLevel)
+            break;
+        GL_QueueTextureLoad(p_Request, uiLevel, p_Request->m_uiResidentLevel, ui64Reserved);
+        ++g_uiNumStreamRefines;
+    }
+}
+
+void GL_UpdateTextureStream()
+{
+    if (g_uiNumStreamRequests == 0)
+        return;
+    GL_TRACE_ZONE("GL_UpdateTextureStream");
+
+    // Start loads for the levels requested during the last frame
+    ++g_uiStreamFrame;
+    GL_QueueTextureRefines();
+    GL_ReleaseTextureRetires(false);
+
+    // Take the loads the workers have finished
+    SDL_LockMutex(gp_StreamMutex);
+    if (g_uiNumStreamUploads + g_uiNumStreamLoaded > g_uiMaxStreamUploads) {
+        g_uiMaxStreamUploads = SDL_max(g_uiMaxStreamUploads * 2, g_uiNumStreamUploads + g_uiNumStreamLoaded);
+        gp_StreamUploads = (TextureLoadData *)realloc(gp_StreamUploads, g_uiMaxStreamUploads * sizeof(TextureLoadData));
+    }
+    if (g_uiNumStreamLoaded > 0)
+        memcpy(&gp_StreamUploads[g_uiNumStreamUploads], gp_StreamLoaded, g_uiNumStreamLoaded * sizeof(TextureLoadData));
+    for (unsigned i = 0; i < g_uiNumStreamLoaded; i++) {
+        g_ui64StreamDecodeTicks += gp_StreamLoaded[i].m_ui64Ticks;
+    }
+    g_uiNumStreamUploads += g_uiNumStreamLoaded;
+    g_uiNumStreamLoaded = 0;
+    SDL_UnlockMutex(gp_StreamMutex);
+
+    // Wait until the GPU has finished with this frames slice of the upload buffer
+    if (g_StreamFences[g_uiStreamSlice] != NULL) {
+        if (glClientWaitSync(g_StreamFences[g_uiStreamSlice], 0, 0) == GL_TIMEOUT_EXPIRED)
+            return;
+        glDeleteSync(g_StreamFences[g_uiStreamSlice]);
+        g_StreamFences[g_uiStreamSlice] = NULL;
+    }
+    const size_t uiSliceOffset = (size_t)g_uiStreamSlice * g_uiStreamSliceSize;
+    size_t uiSliceUsed = 0;
+    if (gp_StreamPBOData != NULL)
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_uiStreamPBO);
+
+    // Upload levels until out of time or upload buffer space, coarsest first so something usable is resident as early as possible
+    const bool bLoading = (g_uiNumStreamPending > 0);
+    const Uint64 ui64Start = SDL_GetPerformanceCounter();
+    const Uint64 ui64Budget = (Uint64)(g_dStreamFrameBudgetMS * (double)SDL_GetPerformanceFrequency() / 1000.0);
+    while ((g_uiStreamUploadRead < g_uiNumStreamUploads) && (SDL_GetPerformanceCounter() - ui64Start < ui64Budget)) {
+        TextureLoadData * p_Load = &gp_StreamUploads[g_uiStreamUploadRead];
+        TextureStreamData * p_Request = &gp_StreamRequests[p_Load->m_uiRequest];
+        if ((p_Load->mp_Data != NULL) && (p_Request->m_uiResidentLevel > p_Load->m_uiFirstLevel)) {
+            if (!GL_StreamTextureLevel(p_Request, p_Load, uiSliceOffset, uiSliceUsed))
+                break;
+            if (p_Request->m_uiResidentLevel > p_Load->m_uiFirstLevel)
+                continue;
+        }
+        GL_FinishTextureLoad(p_Load);
+        ++g_uiStreamUploadRead;
+    }
+    if (g_uiStreamUploadRead == g_uiNumStreamUploads) {
+        g_uiStreamUploadRead = 0;
+        g_uiNumStreamUploads = 0;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Protect the slice until the GPU has consumed it and move on to the next
+    if (uiSliceUsed > 0) {
+        g_StreamFences[g_uiStreamSlice] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        g_uiStreamSlice = (g_uiStreamSlice + 1) % g_uiStreamSlices;
+    }
+
+    // Views replaced this frame may still be used by the frames already submitted
+    if ((g_uiNumTextureRetires > 0) && (gp_TextureRetires[g_uiNumTextureRetires - 1].m_Fence == NULL)) {
+        const GLsync Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        for (unsigned i = g_uiNumTextureRetires; (i > 0) && (gp_TextureRetires[i - 1].m_Fence == NULL); i--) {
+            gp_TextureRetires[i - 1].m_Fence = Fence;
+        }
+    }
+    g_ui64StreamUploadTicks += SDL_GetPerformanceCounter() - ui64Start;
+
+    // Report once every texture has its coarse levels resident
+    if (bLoading && (g_uiNumStreamPending == 0)) {
+        const double dTicksToMS = 1000.0 / (double)SDL_GetPerformanceFrequency();
+        SDL_Log("Streamed %u textures (%.2f MB) in %.2f ms, decode %.2f ms on %u threads, upload %.2f ms on GL thread\n",
+                g_uiStreamedTextures, (double)g_ui64StreamedBytes / (1024.0 * 1024.0),
+                (double)(SDL_GetPerformanceCounter() - g_ui64StreamStart) * dTicksToMS, (double)g_ui64StreamDecodeTicks * dTicksToMS,
+                g_uiStreamThreads, (double)g_ui64StreamUploadTicks * dTicksToMS);
+    }
+}
+
+bool GL_EnableTextureHandles()
+{
+    // Only possible before any level has been streamed in as the textures must be switched over together
+    if (!GLEW_ARB_bindless_texture || (g_uiStreamLevelsIn > 0))
+        return false;
+    g_bStreamHandles = true;
+    for (unsigned i = 0; i < g_uiNumStreamRequests; i++) {
+        TextureStreamData * p_Request = &gp_StreamRequests[i];
+        p_Request->m_ui64Handles[g_uiStreamMaxLevels] = glGetTextureHandleARB(p_Request->m_uiTexture);
+        glMakeTextureHandleResidentARB(p_Request->m_ui64Handles[g_uiStreamMaxLevels]);
+        p_Request->m_uiResidentHandles = 1u << g_uiStreamMaxLevels;
+        p_Request->m_ui64Handle = p_Request->m_ui64Handles[g_uiStreamMaxLevels];
+    }
+    ++g_uiTextureHandleVersion;
+    if (!GLEW_ARB_sparse_texture)
+        SDL_Log("Sparse textures unavailable, streamed textures allocate every level up front\n");
+    return true;
+}
+
+unsigned GL_GetTextureHandleVersion()
+{
+    return g_uiTextureHandleVersion;
+}
+
+GLuint64 GL_GetTextureHandle(GLuint uiTexture)
+{
+    // Textures that are not streamed have no handle
+    if ((uiTexture >= g_uiMaxStreamTextures) || (gp_iStreamTextureRequests[uiTexture] < 0))
+        return 0;
+    return gp_StreamRequests[gp_iStreamTextureRequests[uiTexture]].m_ui64Handle;
+}
+
+GLuint GL_GetStreamTexture(GLuint uiTexture)
+{
+    // Get the texture currently holding a streamed textures data
+    if ((uiTexture >= g_uiMaxStreamTextures) || (gp_iStreamTextureRequests[uiTexture] < 0))
+        return uiTexture;
+    return gp_StreamRequests[gp_iStreamTextureRequests[uiTexture]].m_uiBacking;
+}
+
+void GL_GetTextureResidency(Uint64 & ui64Resident, Uint64 & ui64Wanted, Uint64 & ui64Budget)
+{
+    // Sum the memory needed for every level the last frame wanted
+    ui64Wanted = 0;
+    for (unsigned i = 0; i < g_uiNumStreamRequests; i++) {
+        const TextureStreamData * p_Request = &gp_StreamRequests[i];
+        if (p_Request->m_uiResidentLevel > p_Request->m_uiMinLevel)
+            continue;
+        for (unsigned j = p_Request->m_uiWantedLevel; j < p_Request->m_uiNumLevels; j++) {
+            ui64Wanted += GL_GetTextureLevelBytes(p_Request, j);
+        }
+    }
+    ui64Resident = g_ui64TextureResident;
+    ui64Budget = g_ui64TextureBudget;
+}
+
+void GL_FinishTextureStream()
+{
+    // Upload every outstanding texture and every level the last frame needed that fits in the budget
+    unsigned uiNumChanges;
+    do {
+        uiNumChanges = g_uiStreamLevelsIn + g_uiStreamLevelsOut;
+        GL_UpdateTextureStream();
+        glFinish();
+    } while ((g_uiNumStreamPending > 0) || (g_uiNumStreamRefines > 0) || (uiNumChanges != g_uiStreamLevelsIn + g_uiStreamLevelsOut));
+}
+
+void GL_QuitTextureStream()
+{
+    // Stop workers and release any loaded levels not yet uploaded
+    GL_StopTextureStreamThreads();
+    if (g_uiNumStreamRequests > 0) {
+        Uint64 ui64Resident, ui64Wanted, ui64Budget;
+        GL_GetTextureResidency(ui64Resident, ui64Wanted, ui64Budget);
+        SDL_Log("Texture residency %.2f MB of %.2f MB budget (%.2f MB wanted, %.2f MB peak), %u levels streamed in and %u evicted\n",
+                (double)ui64Resident / (1024.0 * 1024.0), (double)ui64Budget / (1024.0 * 1024.0), (double)ui64Wanted / (1024.0 * 1024.0),
+                (double)g_ui64TexturePeak / (1024.0 * 1024.0), g_uiStreamLevelsIn, g_uiStreamLevelsOut);
+    }
+    for (unsigned i = 0; i < g_uiNumStreamLoaded; i++) {
+        free(gp_StreamLoaded[i].mp_Data);
+    }
+    for (unsigned i = g_uiStreamUploadRead; i < g_uiNumStreamUploads; i++) {
+        free(gp_StreamUploads[i].mp_Data);
+    }
+    free(gp_StreamQueue);
+    free(gp_StreamLoaded);
+    free(gp_StreamUploads);
+    gp_StreamQueue = NULL;
+    gp_StreamLoaded = NULL;
+    gp_StreamUploads = NULL;
+    g_uiNumStreamQueue = 0;
+    g_uiStreamQueueRead = 0;
+    g_uiMaxStreamQueue = 0;
+    g_uiNumStreamLoaded = 0;
+    g_uiMaxStreamLoaded = 0;
+    g_uiNumStreamUploads = 0;
+    g_uiStreamUploadRead = 0;
+    g_uiMaxStreamUploads = 0;
+    g_uiNumStreamPending = 0;
+    g_uiNumStreamRefines = 0;
+    if (gp_StreamMutex != NULL) {
+        SDL_DestroyMutex(gp_StreamMutex);
+        SDL_DestroySemaphore(gp_StreamSemaphore);
+        SDL_DestroySemaphore(gp_StreamHeaderSemaphore);
+    }
+    gp_StreamMutex = NULL;
+    gp_StreamSemaphore = NULL;
+    gp_StreamHeaderSemaphore = NULL;
+
+    // Release every view and its storage, the original is released with the scene
+    GL_ReleaseTextureRetires(true);
+    for (unsigned i = 0; i < g_uiNumStreamRequests; i++) {
+        TextureStreamData * p_Request = &gp_StreamRequests[i];
+        free(p_Request->mp_cFile);
+        for (unsigned j = 0; j <= g_uiStreamMaxLevels; j++) {
+            if (p_Request->m_uiResidentHandles & (1u << j))
+                glMakeTextureHandleNonResidentARB(p_Request->m_ui64Handles[j]);
+            if ((j < g_uiStreamMaxLevels) && (p_Request->m_uiViews[j] != 0))
+                glDeleteTextures(1, &p_Request->m_uiViews[j]);
+        }
+        if (p_Request->m_uiStorage != 0)
+            glDeleteTextures(1, &p_Request->m_uiStorage);
+    }
+    free(gp_TextureRetires);
+    gp_TextureRetires = NULL;
+    g_uiMaxTextureRetires = 0;
+    g_bStreamHandles = false;
+    free(gp_StreamRequests);
+    free(gp_uiStreamRefine);
+    free(gp_uiStreamEvict);
+    free(gp_iStreamTextureRequests);
+    gp_StreamRequests = NULL;
+    gp_uiStreamRefine = NULL;
+    gp_uiStreamEvict = NULL;
+    gp_iStreamTextureRequests = NULL;
+    g_uiMaxStreamTextures = 0;
+    g_ui64TextureResident = 0;
+    g_ui64TextureReserved = 0;
+    g_uiNumStreamRequests = 0;
+    g_uiMaxStreamRequests = 0;
+    g_uiNumStreamStarted = 0;
+
+    // Release the upload buffer
+    for (unsigned i = 0; i < g_uiStreamSlices; i++) {
+        if (g_StreamFences[i] != NULL)
+            glDeleteSync(g_StreamFences[i]);
+        g_StreamFences[i] = NULL;
+    }
+    if (g_uiStreamPBO != 0) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_uiStreamPBO);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &g_uiStreamPBO);
+    }
+    g_uiStreamPBO = 0;
+    gp_StreamPBOData = NULL;
+}
\ No newline at end of file
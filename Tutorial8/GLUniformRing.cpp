@@ -0,0 +1,114 @@
+// Using SDL, GLEW
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include "GLTrace.h"
+
+// Ring is split into one section per frame in flight, each sized for every block reserved for a frame
+const unsigned g_uiUniformRingFrames = 3;
+unsigned g_uiUniformRingFrameSize = 0;
+
+// Per-frame uniform ring buffer
+GLuint g_uiUniformRing = 0;
+unsigned char * gp_UniformRingData = NULL;
+GLsync g_UniformRingFences[g_uiUniformRingFrames];
+unsigned g_uiUniformRingAlignment = 256;
+unsigned g_uiUniformRingFrame = 0;
+unsigned g_uiUniformRingUsed = 0;
+
+void GL_ReserveUniformRing(unsigned uiSize, unsigned uiCount)
+{
+    // Get alignment needed to bind ranges as uniform blocks
+    GLint iAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &iAlignment);
+    g_uiUniformRingAlignment = (unsigned)SDL_max(iAlignment, 1);
+
+    // Add room for the blocks to each frames section
+    g_uiUniformRingFrameSize += ((uiSize + g_uiUniformRingAlignment - 1) / g_uiUniformRingAlignment) * g_uiUniformRingAlignment * uiCount;
+}
+
+bool GL_InitUniformRing()
+{
+    // Size each section for every block reserved before the ring is created
+    g_uiUniformRingFrameSize = SDL_max(g_uiUniformRingFrameSize, g_uiUniformRingAlignment);
+    SDL_Log("Uniform ring buffer uses %u bytes per frame\n", g_uiUniformRingFrameSize);
+
+    // Create ring that stays mapped, without buffer storage each write is uploaded into the ring instead
+    glGenBuffers(1, &g_uiUniformRing);
+    glBindBuffer(GL_UNIFORM_BUFFER, g_uiUniformRing);
+    if (GLEW_ARB_buffer_storage) {
+        const GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, g_uiUniformRingFrames * g_uiUniformRingFrameSize, NULL, Flags);
+        gp_UniformRingData = (unsigned char *)glMapBufferRange(GL_UNIFORM_BUFFER, 0, g_uiUniformRingFrames * g_uiUniformRingFrameSize, Flags);
+        if (gp_UniformRingData == NULL) {
+            SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to map uniform ring buffer\n");
+            return false;
+        }
+    } else
+        glBufferData(GL_UNIFORM_BUFFER, g_uiUniformRingFrames * g_uiUniformRingFrameSize, NULL, GL_DYNAMIC_DRAW);
+    for (unsigned i = 0; i < g_uiUniformRingFrames; i++) {
+        g_UniformRingFences[i] = NULL;
+    }
+    g_uiUniformRingFrame = 0;
+    g_uiUniformRingUsed = 0;
+    return true;
+}
+
+void GL_QuitUniformRing()
+{
+    // Release fences and the ring
+    for (unsigned i = 0; i < g_uiUniformRingFrames; i++) {
+        if (g_UniformRingFences[i] != NULL)
+            glDeleteSync(g_UniformRingFences[i]);
+        g_UniformRingFences[i] = NULL;
+    }
+    if (gp_UniformRingData != NULL) {
+        glBindBuffer(GL_UNIFORM_BUFFER, g_uiUniformRing);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    glDeleteBuffers(1, &g_uiUniformRing);
+    g_uiUniformRing = 0;
+    gp_UniformRingData = NULL;
+    g_uiUniformRingFrameSize = 0;
+}
+
+void GL_BeginUniformRingFrame()
+{
+    GL_TRACE_ZONE("GL_BeginUniformRingFrame");
+    // Protect the last frames section until the GPU has consumed it
+    if (g_UniformRingFences[g_uiUniformRingFrame] != NULL)
+        glDeleteSync(g_UniformRingFences[g_uiUniformRingFrame]);
+    g_UniformRingFences[g_uiUniformRingFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // Move to the next section and wait until the GPU has finished with it
+    g_uiUniformRingFrame = (g_uiUniformRingFrame + 1) % g_uiUniformRingFrames;
+    g_uiUniformRingUsed = 0;
+    if (g_UniformRingFences[g_uiUniformRingFrame] != NULL) {
+        GLbitfield Flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(g_UniformRingFences[g_uiUniformRingFrame], Flags, 1000000) == GL_TIMEOUT_EXPIRED)
+            Flags = 0;
+        glDeleteSync(g_UniformRingFences[g_uiUniformRingFrame]);
+        g_UniformRingFences[g_uiUniformRingFrame] = NULL;
+    }
+}
+
+GLintptr GL_WriteUniformRing(const void * p_Data, unsigned uiSize)
+{
+    // Out of space means a block was written without being reserved, wrapping would overwrite ranges this frame still uses
+    if (g_uiUniformRingUsed + uiSize > g_uiUniformRingFrameSize) {
+        SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Uniform ring buffer frame size of %u bytes exceeded, blocks must be reserved with GL_ReserveUniformRing\n",
+                        g_uiUniformRingFrameSize);
+        abort();
+    }
+
+    // Copy into the current frames section
+    const GLintptr iOffset = (GLintptr)(g_uiUniformRingFrame * g_uiUniformRingFrameSize + g_uiUniformRingUsed);
+    if (gp_UniformRingData != NULL)
+        memcpy(&gp_UniformRingData[iOffset], p_Data, uiSize);
+    else {
+        glBindBuffer(GL_UNIFORM_BUFFER, g_uiUniformRing);
+        glBufferSubData(GL_UNIFORM_BUFFER, iOffset, uiSize, p_Data);
+    }
+    g_uiUniformRingUsed += ((uiSize + g_uiUniformRingAlignment - 1) / g_uiUniformRingAlignment) * g_uiUniformRingAlignment;
+    return iOffset;
+}
\ No newline at end of file
@@ -11,25 +11,79 @@
 #endif
 
 #include "GLScene.h"
+#include "GLTrace.h"
 
 //Debug.cpp
 extern void GLDebug_Init();
 //Shaders.cpp
-extern bool GL_LoadShader(GLuint & uiShader, GLenum ShaderType, const GLchar * p_cShader);
+extern bool GL_LoadShader(GLuint & uiShader, GLenum ShaderType, const GLchar * p_cShader, const GLchar * p_cDefines = NULL);
 extern bool GL_LoadShaders(GLuint & uiShader, GLuint uiVertexShader, GLuint uiFragmentShader, GLuint uiGeometryShader = -1, GLuint uiTessControlShader = -1, GLuint uiTessEvalShader = -1);
-extern bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char * p_cFileName, int iFileID);
+extern bool GL_LoadShaderFile(GLuint & uiShader, GLenum ShaderType, const char * p_cFileName, int iFileID, const GLchar * p_cDefines = NULL);
 //Textures.cpp
 extern bool GL_LoadTextureKTX(GLuint uiTexture, const char * p_cTextureFile);
 //Reflection.cpp
+extern void GL_ReserveReflectionUniforms();
 extern bool GL_InitReflection();
 extern void GL_QuitReflection();
-extern void GL_RenderPlanarReflection(ReflectObjectData * p_RObject, ObjectData * p_Object, const vec3 & v3Direction, const vec3 & v3Up,
+extern void GL_RenderPlanarReflection(ReflectObjectData * p_RObject, const vec3 & v3Direction, const vec3 & v3Up,
                                       const vec3 & v3Position, float fFOV, float fAspect, const vec2 & v2NearFar);
-extern void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject, ObjectData * p_Object);
+extern void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject);
+extern bool GL_UpdateEnvironmentReflections();
 //Shadow.cpp
+extern void GL_ReserveShadowUniforms();
 extern bool GL_InitShadow();
 extern void GL_QuitShadow();
-extern void GL_RenderShadows();
+extern void GL_UpdateShadows();
+//Cluster.cpp
+extern void GL_BeginClusterViews(const char * p_cPass, GLenum CullFace, float fLODBias);
+extern void GL_AddClusterView(const mat4 & m4ViewProjection, const vec3 & v3Position, unsigned uiHeight);
+extern void GL_EndClusterViews();
+extern bool GL_CullObjectClusters(unsigned uiObject);
+extern void GL_DrawObjectClusters(GLenum Mode, unsigned uiObject);
+extern float GL_GetObjectPixelSize(unsigned uiObject);
+extern vec3 GL_GetClusterViewPosition();
+extern void GL_QuitClusters();
+//BVH.cpp
+extern bool GL_InitObjectBVH();
+extern const unsigned * GL_CullObjectBVH(unsigned char ucFlagMask, unsigned char ucFlags, unsigned & uiNumVisible);
+extern void GL_QuitObjectBVH();
+//RenderQueue.cpp
+extern Uint64 GL_MakeRenderKey(unsigned uiPass, unsigned uiSubroutines, unsigned uiMaterial, unsigned uiVAO, float fDepth);
+extern void GL_ClearRenderQueue();
+extern void GL_PushRenderQueue(Uint64 ui64Key, unsigned uiObject);
+extern const unsigned * GL_SortRenderQueue(unsigned & uiNumObjects);
+extern void GL_BindQueueTexture(unsigned uiUnit, GLenum Target, GLuint uiTexture);
+extern void GL_BindQueueBufferRange(GLuint uiIndex, GLuint uiBuffer, GLintptr iOffset, GLsizeiptr iSize);
+extern void GL_SetQueueSubroutines(const GLuint * p_uiSubroutines, unsigned uiNumSubroutines);
+extern void GL_SetQueueUniform1f(GLint iLocation, float fValue);
+extern void GL_SetQueueUniform1ui(GLint iLocation, GLuint uiValue);
+extern void GL_BindQueueVertexArray(GLuint uiVAO);
+extern void GL_QuitRenderQueue();
+//Material.cpp
+extern bool g_bBindlessMaterials;
+extern bool GL_InitMaterials();
+extern void GL_UpdateMaterials();
+extern void GL_QuitMaterials();
+//GPUCulling.cpp
+extern bool g_bGPUCulling;
+extern bool GL_InitGPUCulling();
+extern void GL_QuitGPUCulling();
+extern bool GL_BeginObjectBucketsGPU();
+extern void GL_AddObjectBucketGPU(unsigned uiObject, bool bNewBucket);
+extern void GL_CullCameraObjectsGPU();
+extern bool GL_HasObjectDrawGPU(unsigned uiObject);
+extern bool GL_IsObjectBucketStartGPU(unsigned uiObject);
+extern void GL_DrawObjectBucketGPU(GLenum Mode, unsigned uiObject);
+//UniformRing.cpp
+extern GLuint g_uiUniformRing;
+extern void GL_ReserveUniformRing(unsigned uiSize, unsigned uiCount);
+extern bool GL_InitUniformRing();
+extern void GL_QuitUniformRing();
+extern void GL_BeginUniformRingFrame();
+extern GLintptr GL_WriteUniformRing(const void * p_Data, unsigned uiSize);
+//TextureStream.cpp
+extern void GL_UpdateTextureStream();
+extern void GL_RequestTextureLevels(const GLuint * p_uiTextures, unsigned uiNumTextures, float fPixels);
 
 // Declare window variables
 int g_iWindowWidth = 1280;
@@ -42,15 +96,21 @@ GLuint g_uiShadowProgram;
 GLuint g_uiShadowTransProgram;
 SceneData g_SceneData = {}; // Init to 0
 GLuint g_uiSkyBox;
+mat4 g_m4CameraViewProjection;
+// Offset of this frames camera data in the uniform ring buffer
+GLintptr g_iCameraRingOffset = 0;
 
 struct CameraData
 {
     aligned_mat4 m_m4ViewProjection;
     aligned_vec3 m_v3Position;
 };
+// Kept so the camera can be written again if the frame restarts its ring section
+CameraData g_CameraData;
 
 bool GL_Init()
 {
+    GL_TRACE_ZONE("GL_Init");
     // Initialize GLEW
     glewExperimental = GL_TRUE; // Allow experimental or pre-release drivers to return all supported extensions
     GLenum GlewError = glewInit();
@@ -76,6 +136,13 @@ bool GL_Init()
         return false;
     }
 
+    // Build object hierarchy used for culling
+    GL_InitObjectBVH();
+
+    // Use bindless material textures where supported, before any texture data has been streamed in
+    GL_InitMaterials();
+    const GLchar * p_cMaterialDefines = g_bBindlessMaterials ? "#define BINDLESS_MATERIALS\n" : NULL;
+
     // Create vertex shader
     GLuint uiVertexShader;
     if (!GL_LoadShaderFile(uiVertexShader, GL_VERTEX_SHADER, "MainPNUTVert.glsl", 100))
@@ -83,7 +150,7 @@ bool GL_Init()
 
     // Create fragment shader
     GLuint uiFragmentShader;
-    if (!GL_LoadShaderFile(uiFragmentShader, GL_FRAGMENT_SHADER, "Tutorial8Frag.glsl", 200))
+    if (!GL_LoadShaderFile(uiFragmentShader, GL_FRAGMENT_SHADER, "Tutorial8Frag.glsl", 200, p_cMaterialDefines))
         return false;
 
     // Create tessellation shader
@@ -123,7 +190,7 @@ bool GL_Init()
     // Load in shadow map shader
     if (!GL_LoadShaderFile(uiVertexShader, GL_VERTEX_SHADER, "ShadowVert.glsl", 500))
         return false;
-    if (!GL_LoadShaderFile(uiGeometryShader, GL_GEOMETRY_SHADER, "ShadowGeom.glsl", 600))
+    if (!GL_LoadShaderFile(uiGeometryShader, GL_GEOMETRY_SHADER, "ShadowGeom2.glsl", 600))
         return false;
     if (!GL_LoadShaderFile(uiFragmentShader, GL_FRAGMENT_SHADER, "ShadowFrag.glsl", 700))
         return false;
@@ -138,7 +205,7 @@ bool GL_Init()
     // Load in shadow map transparency shader
     if (!GL_LoadShaderFile(uiVertexShader, GL_VERTEX_SHADER, "ShadowTransVert.glsl", 800))
         return false;
-    if (!GL_LoadShaderFile(uiGeometryShader, GL_GEOMETRY_SHADER, "ShadowTransGeom.glsl", 900))
+    if (!GL_LoadShaderFile(uiGeometryShader, GL_GEOMETRY_SHADER, "ShadowTransGeom2.glsl", 900))
         return false;
     if (!GL_LoadShaderFile(uiFragmentShader, GL_FRAGMENT_SHADER, "ShadowTransFrag.glsl", 1000))
         return false;
@@ -178,6 +245,16 @@ bool GL_Init()
     // Specify program to use
     glUseProgram(g_uiMainProgram);
 
+    // Initialise per-frame uniform ring buffer sized for the camera, shadows and reflections along with the passes above
+    GL_ReserveUniformRing(sizeof(CameraData), 1);
+    GL_ReserveShadowUniforms();
+    GL_ReserveReflectionUniforms();
+    if (!GL_InitUniformRing())
+        return false;
+
+    // Initialise GPU culling used by the main and shadow passes
+    GL_InitGPUCulling();
+
     // Initialise shadows
     GL_InitShadow();
 
@@ -202,15 +279,32 @@ void GL_Quit()
     // Release shadow data
     GL_QuitShadow();
 
+    // Release GPU culling data
+    GL_QuitGPUCulling();
+
     // Release reflection data
     GL_QuitReflection();
 
+    // Release cluster culling data
+    GL_QuitClusters();
+    GL_QuitObjectBVH();
+
+    // Release render queue
+    GL_QuitRenderQueue();
+
+    // Release uniform ring buffer
+    GL_QuitUniformRing();
+
+    // Release material data
+    GL_QuitMaterials();
+
     // Release Scene data
     GL_UnloadScene(g_SceneData);
 }
 
-void GL_RenderObjects(ObjectData * p_SkipObject = NULL)
+void GL_RenderObjects(unsigned uiSkipObject = -1)
 {
+    GL_TRACE_ZONE("GL_RenderObjects");
     // Clear the render output and depth buffer
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -219,92 +313,161 @@ void GL_RenderObjects(ObjectData * p_SkipObject = NULL)
     const GLuint uiRefractSubs[] = {2, 3};
     const GLuint uiReflectSubs[] = {4, 5, 6};
 
-    // Loop through each object
-    for (unsigned i = 0; i < g_SceneData.m_uiNumObjects; i++) {
-        const ObjectData * p_Object = &g_SceneData.mp_Objects[i];
+    // Queue each visible object keyed by the state it needs, nearest first within matching state
+    GL_ClearRenderQueue();
+    const vec3 v3ViewPosition = GL_GetClusterViewPosition();
+    unsigned uiNumVisible;
+    const unsigned * p_uiVisible = GL_CullObjectBVH(0, 0, uiNumVisible);
+    for (unsigned j = 0; j < uiNumVisible; j++) {
+        const unsigned i = p_uiVisible[j];
 
         // Check if this object should be rendered
-        if (p_Object == p_SkipObject)
+        if (i == uiSkipObject)
             continue;
 
+        // Request the texture detail needed for the objects size on screen
+        const unsigned uiMaterial = g_SceneData.mp_uiObjectMaterials[i];
+        const MaterialData * p_Material = &g_SceneData.mp_Materials[uiMaterial];
+        const GLuint uiTextures[] = {p_Material->m_uiDiffuse, p_Material->m_uiSpecular, p_Material->m_uiRough, p_Material->m_uiNormal, p_Material->m_uiBump};
+        GL_RequestTextureLevels(uiTextures, 5, GL_GetObjectPixelSize(i));
+
+        // Subroutine set is packed as emissive, transparent then reflection type
+        const unsigned char ucFlags = g_SceneData.mp_ucObjectFlags[i];
+        const bool bTransparent = (ucFlags & g_ucObjectTransparent) != 0;
+        const unsigned uiSubroutines = (p_Material->m_fEmissive != 0.0f) | (bTransparent << 1) | ((ucFlags & g_ucObjectReflectMask) << 2);
+        const float fDepth = length(vec3(g_SceneData.mp_ObjectBounds[i]) - v3ViewPosition);
+        GL_PushRenderQueue(GL_MakeRenderKey(bTransparent, uiSubroutines, uiMaterial, 0, fDepth), i);
+    }
+
+    // Sort so matching state is adjacent
+    unsigned uiNumQueued;
+    const unsigned * p_uiQueued = GL_SortRenderQueue(uiNumQueued);
+
+    // Group runs of opaque objects sharing state into buckets, reflective objects bind their own reflection so are drawn alone
+    const bool bGPUCull = GL_BeginObjectBucketsGPU();
+    if (bGPUCull) {
+        unsigned uiLastMaterial = -1;
+        unsigned char ucLastFlags = 0;
+        for (unsigned j = 0; j < uiNumQueued; j++) {
+            const unsigned i = p_uiQueued[j];
+            if (!GL_HasObjectDrawGPU(i)) {
+                uiLastMaterial = -1;
+                continue;
+            }
+            const unsigned uiMaterial = g_SceneData.mp_uiObjectMaterials[i];
+            const unsigned char ucFlags = g_SceneData.mp_ucObjectFlags[i];
+            GL_AddObjectBucketGPU(i, (uiMaterial != uiLastMaterial) || (ucFlags != ucLastFlags) || ((ucFlags & g_ucObjectReflectMask) != 0));
+            uiLastMaterial = uiMaterial;
+            ucLastFlags = ucFlags;
+        }
+
+        // Cull the bucketed objects against the camera on the GPU, this changes program so must come before any queued state
+        GL_CullCameraObjectsGPU();
+    }
+
+    // Draw in sorted order only changing state that differs from the previous object
+    for (unsigned j = 0; j < uiNumQueued; j++) {
+        const unsigned i = p_uiQueued[j];
+
+        // Skip if no clusters are visible, objects with GPU draws are skipped by the GPU instead and drawn with the rest of their bucket
+        const bool bGPUDraw = bGPUCull && GL_HasObjectDrawGPU(i);
+        if (bGPUDraw ? !GL_IsObjectBucketStartGPU(i) : !GL_CullObjectClusters(i))
+            continue;
+
+        // Get the objects material and flags
+        const MaterialData * p_Material = &g_SceneData.mp_Materials[g_SceneData.mp_uiObjectMaterials[i]];
+        const unsigned uiReflective = g_SceneData.mp_ucObjectFlags[i] & g_ucObjectReflectMask;
+        const bool bTransparent = (g_SceneData.mp_ucObjectFlags[i] & g_ucObjectTransparent) != 0;
+
         // Set subroutines
-        GLuint uiSubRoutines[3] = {uiEmissiveSubs[p_Object->m_fEmissive != 0.0f],
-            uiRefractSubs[p_Object->m_bTransparent],
-            uiReflectSubs[p_Object->m_uiReflective]};
-        glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 3, uiSubRoutines);
-
-        // Bind VAO
-        glBindVertexArray(p_Object->m_uiVAO);
-
-        // Bind the Transform UBO
-        glBindBufferBase(GL_UNIFORM_BUFFER, 0, p_Object->m_uiTransformUBO);
-
-        // Bind the textures to texture units
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiDiffuse);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiSpecular);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiRough);
-        glActiveTexture(GL_TEXTURE9);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiNormal);
-        glActiveTexture(GL_TEXTURE10);
-        glBindTexture(GL_TEXTURE_2D, p_Object->m_uiBump);
-
-        // If emissive then update uniform
-        if (p_Object->m_fEmissive != 0.0f) {
-            glUniform1f(1, p_Object->m_fEmissive);
+        GLuint uiSubRoutines[3] = {uiEmissiveSubs[p_Material->m_fEmissive != 0.0f],
+            uiRefractSubs[bTransparent],
+            uiReflectSubs[uiReflective]};
+        GL_SetQueueSubroutines(uiSubRoutines, 3);
+
+        // Bind the shared scene VAO and the objects range of the Transform UBO, buckets read each draws transform instead
+        GL_BindQueueVertexArray(g_SceneData.m_uiVAO);
+        GL_SetQueueUniform1ui(6, bGPUDraw);
+        if (!bGPUDraw)
+            GL_BindQueueBufferRange(0, g_SceneData.m_uiTransformUBO, g_SceneData.mp_ObjectDraws[i].m_uiTransformOffset, g_SceneData.m_uiTransformSize);
+
+        if (g_bBindlessMaterials) {
+            // Material textures and values are read from the material SSBO
+            GL_SetQueueUniform1ui(5, g_SceneData.mp_uiObjectMaterials[i]);
+        } else {
+            // Bind the textures to texture units
+            GL_BindQueueTexture(0, GL_TEXTURE_2D, p_Material->m_uiDiffuse);
+            GL_BindQueueTexture(1, GL_TEXTURE_2D, p_Material->m_uiSpecular);
+            GL_BindQueueTexture(2, GL_TEXTURE_2D, p_Material->m_uiRough);
+            GL_BindQueueTexture(9, GL_TEXTURE_2D, p_Material->m_uiNormal);
+            GL_BindQueueTexture(10, GL_TEXTURE_2D, p_Material->m_uiBump);
+
+            // If emissive then update uniform
+            if (p_Material->m_fEmissive != 0.0f) {
+                GL_SetQueueUniform1f(1, p_Material->m_fEmissive);
+            }
+
+            //Set the parallax map scaling
+            GL_SetQueueUniform1f(3, p_Material->m_fBumpScale);
         }
 
         // If transparent then update texture
-        if (p_Object->m_bTransparent) {
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, g_uiSkyBox);
+        if (bTransparent) {
+            GL_BindQueueTexture(3, GL_TEXTURE_CUBE_MAP, g_uiSkyBox);
         }
 
         // If reflective then update texture and uniform
-        if (p_Object->m_uiReflective == 1) {
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, p_Object->m_uiReflect);
-
-            glBindBufferBase(GL_UNIFORM_BUFFER, 3, p_Object->m_uiReflectVPUBO);
-        } else if (p_Object->m_uiReflective == 2) {
-            glActiveTexture(GL_TEXTURE5);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, p_Object->m_uiReflect);
+        if (uiReflective == g_ucObjectPlanarReflect) {
+            const ReflectObjectData * p_RObject = &g_SceneData.mp_ReflecObjects[g_SceneData.mp_uiObjectReflects[i]];
+            GL_BindQueueTexture(4, GL_TEXTURE_2D, p_RObject->m_uiReflect);
+
+            GL_BindQueueBufferRange(3, g_uiUniformRing, p_RObject->m_iReflectVPOffset, sizeof(mat4));
+        } else if (uiReflective == g_ucObjectCubeReflect) {
+            const ReflectObjectData * p_RObject = &g_SceneData.mp_ReflecObjects[g_SceneData.mp_uiObjectReflects[i]];
+            GL_BindQueueTexture(5, GL_TEXTURE_CUBE_MAP, p_RObject->m_uiReflect);
         }
 
-        //Set the parallax map scaling
-        glUniform1f(3, p_Object->m_fBumpScale);
-
         // Draw the Object
-        //glDrawElements(GL_TRIANGLES, p_Object->m_uiNumIndices, GL_UNSIGNED_INT, 0);
-        glDrawElements(GL_PATCHES, p_Object->m_uiNumIndices, GL_UNSIGNED_INT, 0);
+        //glDrawElements(GL_TRIANGLES, g_SceneData.mp_ObjectDraws[i].m_uiNumIndices, GL_UNSIGNED_INT, 0);
+        if (bGPUDraw)
+            GL_DrawObjectBucketGPU(GL_PATCHES, i);
+        else
+            GL_DrawObjectClusters(GL_PATCHES, i);
     }
 }
 
 void GL_Render()
 {
-    // Generate shadows
-    //GL_RenderShadows();
+    GL_TRACE_ZONE("GL_Render");
+    // Upload any streamed textures that are ready
+    GL_UpdateTextureStream();
+    GL_UpdateMaterials();
+
+    // Redraw environment maps once streamed textures are resident, they use their own sections of the uniform ring so the camera is written again after
+    if (GL_UpdateEnvironmentReflections()) {
+        GL_BeginUniformRingFrame();
+        g_iCameraRingOffset = GL_WriteUniformRing(&g_CameraData, sizeof(CameraData));
+    }
+
+    // Update shadow layers whose light or casters have changed
+    GL_UpdateShadows();
 
     // Generate reflection maps
     //for (unsigned i = 0; i < g_SceneData.m_uiNumReflecObjects; i++) {
     //    ReflectObjectData * p_RObject = &g_SceneData.mp_ReflecObjects[i];
-    //    ObjectData * p_Object = &g_SceneData.mp_Objects[p_RObject->m_uiObjectPos];
     //
     //    // Check if cube reflection
-    //    if (p_Object->m_uiReflective == 2) {
+    //    if ((g_SceneData.mp_ucObjectFlags[p_RObject->m_uiObjectPos] & g_ucObjectReflectMask) == g_ucObjectCubeReflect) {
     //        // Calculate cube maps first as they recalculate planar reflections as well
-    //        GL_RenderEnvironmentReflection(p_RObject, p_Object);
+    //        GL_RenderEnvironmentReflection(p_RObject);
     //    }
     //}
     for (unsigned i = 0; i < g_SceneData.m_uiNumReflecObjects; i++) {
         ReflectObjectData * p_RObject = &g_SceneData.mp_ReflecObjects[i];
-        ObjectData * p_Object = &g_SceneData.mp_Objects[p_RObject->m_uiObjectPos];
 
         // Check if planar or cube reflection
-        if (p_Object->m_uiReflective == 1) {
-            GL_RenderPlanarReflection(p_RObject, p_Object,
+        if ((g_SceneData.mp_ucObjectFlags[p_RObject->m_uiObjectPos] & g_ucObjectReflectMask) == g_ucObjectPlanarReflect) {
+            GL_RenderPlanarReflection(p_RObject,
                                       g_SceneData.m_LocalCamera.m_v3Direction, cross(g_SceneData.m_LocalCamera.m_v3Right, g_SceneData.m_LocalCamera.m_v3Direction),
                                       g_SceneData.m_LocalCamera.m_v3Position, g_SceneData.m_LocalCamera.m_fFOV, g_SceneData.m_LocalCamera.m_fAspect,
                                       vec2(g_SceneData.m_LocalCamera.m_fNear, g_SceneData.m_LocalCamera.m_fFar));
@@ -313,14 +476,23 @@ void GL_Render()
 
     // Bind default frame buffer and camera
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 1, g_SceneData.m_uiCameraUBO);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 1, g_uiUniformRing, g_iCameraRingOffset, sizeof(CameraData));
+
+    // Cull clusters and select LODs against the camera
+    GL_BeginClusterViews("Main", GL_BACK, 1.0f);
+    GL_AddClusterView(g_m4CameraViewProjection, g_SceneData.m_LocalCamera.m_v3Position, g_iWindowHeight);
 
     // Render objects as normal
     GL_RenderObjects();
+    GL_EndClusterViews();
 }
 
 void GL_Update(float fElapsedTime)
 {
+    GL_TRACE_ZONE("GL_Update");
+    // Start a new frame in the uniform ring buffer
+    GL_BeginUniformRingFrame();
+
     // Update the cameras position
     g_SceneData.m_LocalCamera.m_v3Position += g_SceneData.m_LocalCamera.m_fMoveZ * fElapsedTime * g_SceneData.m_LocalCamera.m_v3Direction;
     g_SceneData.m_LocalCamera.m_v3Position += g_SceneData.m_LocalCamera.m_fMoveX * fElapsedTime * g_SceneData.m_LocalCamera.m_v3Right;
@@ -349,15 +521,16 @@ void GL_Update(float fElapsedTime)
 
     // Create updated ViewProjection matrix
     mat4 m4ViewProjection = m4Projection * m4View;
+    g_m4CameraViewProjection = m4ViewProjection;
 
     // Create updated camera data
     CameraData Camera = {
         m4ViewProjection,
         g_SceneData.m_LocalCamera.m_v3Position};
 
-    // Update the camera buffer
-    glBindBuffer(GL_UNIFORM_BUFFER, g_SceneData.m_uiCameraUBO);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraData), &Camera, GL_DYNAMIC_DRAW);
+    // Write the camera data into this frames section of the ring buffer
+    g_CameraData = Camera;
+    g_iCameraRingOffset = GL_WriteUniformRing(&g_CameraData, sizeof(CameraData));
 }
 
 #ifdef _WIN32
@@ -366,6 +539,9 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 int main(int argc, char **argv)
 #endif
 {
+    // Start CPU tracing if GL_TRACE_FILE is set
+    GL_InitTrace(NULL);
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL: %s\n", SDL_GetError());
@@ -422,13 +598,19 @@ int main(int argc, char **argv)
         // Start the program message pump
         SDL_Event Event;
         bool bQuit = false;
+        unsigned uiFrame = 0;
         while (!bQuit) {
+            // Time the whole frame
+            GL_TRACE_FRAME(uiFrame);
+            ++uiFrame;
+
             // Update elapsed frame time
             uiOldTime = uiCurrentTime;
             uiCurrentTime = SDL_GetTicks();
             float fElapsedTime = (float)(uiCurrentTime - uiOldTime) / 1000.0f;
 
             // Poll SDL for buffered events
+            GL_TRACE_BEGIN("Events");
             while (SDL_PollEvent(&Event)) {
                 if (Event.type == SDL_QUIT)
                     bQuit = true;
@@ -478,6 +660,7 @@ int main(int argc, char **argv)
                         g_SceneData.m_LocalCamera.m_fFOV = ((float)M_PI * 0.9f);
                 }
             }
+            GL_TRACE_END("Events");
 
             // Update the Scene
             GL_Update(fElapsedTime);
@@ -486,13 +669,18 @@ int main(int argc, char **argv)
             GL_Render();
 
             // Swap the back-buffer and present the render
+            GL_TRACE_BEGIN("Swap");
             SDL_GL_SwapWindow(Window);
+            GL_TRACE_END("Swap");
         }
 
         // Delete any created GL resources
         GL_Quit();
     }
 
+    // Write out any CPU trace
+    GL_QuitTrace();
+
     // Delete the OpenGL context, SDL window and shutdown SDL
     SDL_GL_DeleteContext(Context);
     SDL_DestroyWindow(Window);
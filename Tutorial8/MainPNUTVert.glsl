@@ -3,6 +3,10 @@
 layout(binding = 0) uniform TransformData {
     mat4 m4Transform;
 };
+// Transforms of every object, read through the draw index when drawing GPU culled buckets
+layout(std430, binding = 0) readonly buffer TransformDrawData {
+    mat4 m4Transforms[];
+};
 layout(binding = 1) uniform CameraData {
     mat4 m4ViewProjection;
     vec3 v3CameraPosition;
@@ -12,6 +16,10 @@ layout(location = 0) in vec3 v3VertexPos;
 layout(location = 1) in vec3 v3VertexNormal;
 layout(location = 2) in vec2 v2VertexUV;
 layout(location = 3) in vec3 v3VertexTangent;
+// Per draw index of the objects transform, sourced through the draws base instance
+layout(location = 4) in uint uiTransformIndex;
+// Read the transform through the draw index instead of the transform block
+layout(location = 6) uniform bool bDrawTransforms;
 
 layout(location = 0) smooth out vec3 v3PositionOut;
 layout(location = 1) smooth out vec3 v3NormalOut;
@@ -21,18 +29,19 @@ layout(location = 3) smooth out vec3 v3TangentOut;
 void main()
 {
     // Transform vertex
-    vec4 v4Position = m4Transform * vec4(v3VertexPos, 1.0f);
+    mat4 m4Object = (bDrawTransforms) ? m4Transforms[uiTransformIndex] : m4Transform;
+    vec4 v4Position = m4Object * vec4(v3VertexPos, 1.0f);
     gl_Position = m4ViewProjection * v4Position;
     v3PositionOut = v4Position.xyz;
 
     // Transform normal
-    vec4 v4Normal = m4Transform * vec4(v3VertexNormal, 0.0f);
+    vec4 v4Normal = m4Object * vec4(v3VertexNormal, 0.0f);
     v3NormalOut = v4Normal.xyz;
 
     //Pass-through UV coordinates
     v2UVOut = v2VertexUV;
 
     // Transform tangent
-    vec4 v4Tangent = m4Transform * vec4(v3VertexTangent, 0.0f);
+    vec4 v4Tangent = m4Object * vec4(v3VertexTangent, 0.0f);
     v3TangentOut = v4Tangent.xyz;
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#version 430 core
+
+#define MAX_LIGHTS 32
+layout(binding = 6) uniform CameraShadowData {
+    mat4 m4ViewProjectionShadow[MAX_LIGHTS];
+};
+struct ShadowLayer {
+    vec3 v3Position;
+    // Layers tile in the atlas as offset and size in texture coordinates
+    vec4 v4Tile;
+};
+layout(std140, binding = 9) uniform CameraShadowData2 {
+    ShadowLayer ShadowLayers[MAX_LIGHTS];
+};
+
+layout(location = 0) uniform int iNumLights;
+// Layers being re-rendered, the rest keep their cached maps
+layout(location = 1) uniform uint uiUpdateMask;
+
+layout(triangles, invocations = MAX_LIGHTS) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+layout(location = 0) in vec3 v3VertexPos[];
+// Layers the triangles object can cast into, one bit per light or cube face
+layout(location = 1) flat in uint uiLayerMask[];
+
+void main()
+{
+    // Check if valid invocation and the object reaches this layer while it is being updated
+    if ((gl_InvocationID < iNumLights) && ((uiLayerMask[0] & uiUpdateMask & (1u << gl_InvocationID)) != 0u)) {
+        vec4 v4PositionVPTemp[3];
+        int iOutOfBound[6] = int[6](0, 0, 0, 0, 0, 0);
+        // Loop over each vertex and get clip space position
+        for (int i = 0; i < 3; ++i) {
+            // Transform position
+            v4PositionVPTemp[i] = m4ViewProjectionShadow[gl_InvocationID] * vec4(v3VertexPos[i], 1.0f);
+
+            // Check if any value is outside clip planes
+            if (v4PositionVPTemp[i].x >  v4PositionVPTemp[i].w)
+                iOutOfBound[0] = iOutOfBound[0] + 1;
+            if (v4PositionVPTemp[i].x < -v4PositionVPTemp[i].w)
+                iOutOfBound[1] = iOutOfBound[1] + 1;
+            if (v4PositionVPTemp[i].y >  v4PositionVPTemp[i].w)
+                iOutOfBound[2] = iOutOfBound[2] + 1;
+            if (v4PositionVPTemp[i].y < -v4PositionVPTemp[i].w)
+                iOutOfBound[3] = iOutOfBound[3] + 1;
+            if (v4PositionVPTemp[i].z >  v4PositionVPTemp[i].w)
+                iOutOfBound[4] = iOutOfBound[4] + 1;
+            if (v4PositionVPTemp[i].z < -v4PositionVPTemp[i].w)
+                iOutOfBound[5] = iOutOfBound[5] + 1;
+        }
+
+        // Loop over each clip face and check if triangle is entirely outside
+        bool bInFrustum = true;
+        for (int i = 0; i < 6; ++i)
+            if (iOutOfBound[i] == 3)
+                bInFrustum = false;
+
+        // Check front face culling
+        vec3 v3Normal = cross(v3VertexPos[2] - v3VertexPos[0],
+            v3VertexPos[0] - v3VertexPos[1]);
+        vec3 v3ViewDirection = ShadowLayers[gl_InvocationID].v3Position - v3VertexPos[0];
+
+        // If visible output triangle data
+        if (bInFrustum && (dot(v3Normal, v3ViewDirection) < 0.0f)) {
+            // Loop over each vertex in the face and output
+            vec4 v4Tile = ShadowLayers[gl_InvocationID].v4Tile;
+            for (int i = 0; i < 3; ++i) {
+                // Output position moved into the layers tile of the atlas
+                vec4 v4Position = v4PositionVPTemp[i];
+                gl_Position = vec4((v4Position.xy * v4Tile.zw) + (((v4Tile.xy * 2.0f) + v4Tile.zw - 1.0f) * v4Position.w), v4Position.zw);
+
+                // Clip to the tile edges so nothing spills into neighbouring tiles
+                gl_ClipDistance[0] = v4Position.w + v4Position.x;
+                gl_ClipDistance[1] = v4Position.w - v4Position.x;
+                gl_ClipDistance[2] = v4Position.w + v4Position.y;
+                gl_ClipDistance[3] = v4Position.w - v4Position.y;
+                EmitVertex();
+            }
+            EndPrimitive();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 430 core
+
+layout(std430, binding = 0) readonly buffer TransformData {
+    mat4 m4Transforms[];
+};
+
+layout(location = 0) in vec3 v3VertexPos;
+// Per draw index of the objects transform, sourced through the draws base instance
+layout(location = 4) in uint uiTransformIndex;
+// Layers the object can cast into, passed through for the geometry shader
+layout(location = 5) in uint uiLayerMask;
+
+layout(location = 0) smooth out vec3 v3PositionOut;
+layout(location = 1) flat out uint uiLayerMaskOut;
+
+void main()
+{
+    // Transform vertex
+    vec4 v4Position = m4Transforms[uiTransformIndex] * vec4(v3VertexPos, 1.0f);
+    v3PositionOut = v4Position.xyz;
+    uiLayerMaskOut = uiLayerMask;
+}
\ No newline at end of file
@@ -1,4 +1,7 @@
 #version 430 core
+#ifdef BINDLESS_MATERIALS
+#extension GL_ARB_bindless_texture : require
+#endif
 
 layout(binding = 1) uniform CameraData {
     mat4 m4ViewProjection;
@@ -8,17 +11,38 @@ layout(binding = 3) uniform ReflectPlaneData {
     mat4 m4ReflectVP;
 };
 
+#ifdef BINDLESS_MATERIALS
+struct Material {
+    uvec2 u2Textures[5];
+    float fEmissivePower;
+    float fBumpScale;
+};
+layout(std430, binding = 1) readonly buffer MaterialData {
+    Material Materials[];
+};
+layout(location = 5) uniform uint uiMaterial;
+
+// Material textures and values come from the draws entry in the material buffer
+#define fEmissivePower Materials[uiMaterial].fEmissivePower
+#define fBumpScale Materials[uiMaterial].fBumpScale
+#define s2DiffuseTexture sampler2D(Materials[uiMaterial].u2Textures[0])
+#define s2SpecularTexture sampler2D(Materials[uiMaterial].u2Textures[1])
+#define s2RoughnessTexture sampler2D(Materials[uiMaterial].u2Textures[2])
+#define s2NormalTexture sampler2D(Materials[uiMaterial].u2Textures[3])
+#define s2BumpTexture sampler2D(Materials[uiMaterial].u2Textures[4])
+#else
 layout(location = 1) uniform float fEmissivePower;
 layout(location = 3) uniform float fBumpScale;
 
 layout(binding = 0) uniform sampler2D s2DiffuseTexture;
 layout(binding = 1) uniform sampler2D s2SpecularTexture;
 layout(binding = 2) uniform sampler2D s2RoughnessTexture;
+layout(binding = 9) uniform sampler2D s2NormalTexture;
+layout(binding = 10) uniform sampler2D s2BumpTexture;
+#endif
 layout(binding = 3) uniform samplerCube scRefractMapTexture;
 layout(binding = 4) uniform sampler2D s2ReflectTexture;
 layout(binding = 5) uniform samplerCube scReflectMapTexture;
-layout(binding = 9) uniform sampler2D s2NormalTexture;
-layout(binding = 10) uniform sampler2D s2BumpTexture;
 
 #define M_RCPPI 0.31830988618379067153776752674503f
 #define M_PI 3.1415926535897932384626433832795f
@@ -5,6 +5,7 @@ struct PointLight {
     vec3 v3LightIntensity;
     vec3 v3Falloff;
     vec2 v2NearFar;
+    vec4 v4ShadowTile;
 };
 struct SpotLight {
     vec3 v3LightPosition;
@@ -12,6 +13,7 @@ struct SpotLight {
     float fCosAngle;
     vec3 v3LightIntensity;
     vec3 v3Falloff;
+    vec4 v4ShadowTile;
 };
 #define MAX_LIGHTS 16
 layout(std140, binding = 1) uniform CameraData {
@@ -35,9 +37,9 @@ layout(binding = 7) uniform InvResolution {
 layout(location = 0) uniform int iNumPointLights;
 layout(location = 2) uniform int iNumSpotLights;
 
-layout(binding = 6) uniform sampler2DArrayShadow s2aShadowTexture;
-layout(binding = 7) uniform samplerCubeArrayShadow scaPointShadowTexture;
-layout(binding = 8) uniform sampler2DArray s2aTransparencyTexture;
+layout(binding = 6) uniform sampler2DShadow s2ShadowTexture;
+layout(binding = 7) uniform sampler2DShadow s2PointShadowTexture;
+layout(binding = 8) uniform sampler2D s2TransparencyTexture;
 layout(binding = 11) uniform sampler2D s2DepthTexture;
 layout(binding = 12) uniform sampler2D s2NormalTexture;
 layout(binding = 13) uniform sampler2D s2DiffuseTexture;
@@ -70,6 +72,47 @@ vec3 lightFalloff(in vec3 v3LightIntensity, in vec3 v3Falloff, in vec3 v3LightPo
     return v3LightIntensity / fFalloff;
 }
 
+vec2 shadowTileUV(in vec2 v2UV, in vec4 v4Tile, in vec2 v2AtlasSize)
+{
+    // Move into the lights tile and keep filtering from reading neighbouring tiles
+    vec2 v2HalfTexel = 0.5f / v2AtlasSize;
+    return clamp(v4Tile.xy + (v2UV * v4Tile.zw), v4Tile.xy + v2HalfTexel, v4Tile.xy + v4Tile.zw - v2HalfTexel);
+}
+
+// Cube face directions matching the point shadow views
+const vec3 v3CubeNormals[6] = vec3[](
+    vec3( 1.0f,  0.0f,  0.0f),
+    vec3(-1.0f,  0.0f,  0.0f),
+    vec3( 0.0f,  1.0f,  0.0f),
+    vec3( 0.0f, -1.0f,  0.0f),
+    vec3( 0.0f,  0.0f,  1.0f),
+    vec3( 0.0f,  0.0f, -1.0f));
+const vec3 v3CubeUps[6] = vec3[](
+    vec3( 0.0f, -1.0f,  0.0f),
+    vec3( 0.0f, -1.0f,  0.0f),
+    vec3( 0.0f,  0.0f,  1.0f),
+    vec3( 0.0f,  0.0f, -1.0f),
+    vec3( 0.0f, -1.0f,  0.0f),
+    vec3( 0.0f, -1.0f,  0.0f));
+
+vec2 pointShadowTileUV(in vec3 v3Direction, in vec4 v4Tile, in vec2 v2AtlasSize)
+{
+    // Find the cube face the direction falls in
+    vec3 v3AbsDirection = abs(v3Direction);
+    int iFace = (v3AbsDirection.x >= max(v3AbsDirection.y, v3AbsDirection.z)) ? ((v3Direction.x >= 0.0f) ? 0 : 1) :
+        ((v3AbsDirection.y >= v3AbsDirection.z) ? ((v3Direction.y >= 0.0f) ? 2 : 3) : ((v3Direction.z >= 0.0f) ? 4 : 5));
+
+    // Project onto the face the same way as its view projection
+    vec3 v3Side = cross(v3CubeNormals[iFace], v3CubeUps[iFace]);
+    vec3 v3Up = cross(v3Side, v3CubeNormals[iFace]);
+    vec2 v2UV = vec2(dot(v3Side, v3Direction), dot(v3Up, v3Direction)) / dot(v3CubeNormals[iFace], v3Direction);
+    v2UV = (v2UV + 1.0f) * 0.5f;
+
+    // Faces are laid out 3 across and 2 down in the lights tile
+    vec4 v4FaceTile = vec4(v4Tile.xy + (vec2(iFace % 3, iFace / 3) * v4Tile.zw), v4Tile.zw);
+    return shadowTileUV(v2UV, v4FaceTile, v2AtlasSize);
+}
+
 vec3 lightSpotShadow(in int iLight, in vec3 v3Position)
 {
     // Get position in shadow texture
@@ -97,21 +140,22 @@ vec3 lightSpotShadow(in int iLight, in vec3 v3Position)
     float fShadowRegion = fLightSize * v3SVPPosition.z;
     float fShadowSize = fShadowRegion / 9.0f;
 
-    // Perform additional filtering
+    // Perform additional filtering within the lights tile of the atlas
+    vec2 v2AtlasSize = vec2(textureSize(s2ShadowTexture, 0));
     float fShadowing = 0.0f;
     for (int i = 0 ; i <= 9 ; i++) {
         vec2 v2RotatedPoisson = (v2PoissonDisk[i].x * v2Rotate.yx) +
             (v2PoissonDisk[i].y * v2Rotate * vec2(-1.0f, 1.0f));
         vec2 v2Offset = v2RotatedPoisson * fShadowSize;
         vec3 v3UVC = v3SVPPosition + vec3(v2Offset, 0.0f);
-        float fText = texture(s2aShadowTexture, vec4(v3UVC.xy, iLight, v3UVC.z));
+        float fText = texture(s2ShadowTexture, vec3(shadowTileUV(v3UVC.xy, SpotLights[iLight].v4ShadowTile, v2AtlasSize), min(v3UVC.z, 1.0f)));
         fShadowing += fText;
     }
 
     fShadowing /= 9.0f;
 
     // Get transparency information
-    vec3 v3Trans = texture(s2aTransparencyTexture, vec3(v3SVPPosition.xy, iLight)).xyz;
+    vec3 v3Trans = texture(s2TransparencyTexture, shadowTileUV(v3SVPPosition.xy, SpotLights[iLight].v4ShadowTile, v2AtlasSize)).xyz;
     return v3Trans * fShadowing;
 }
 
@@ -145,7 +189,9 @@ float lightPointShadow(in int iLight, in vec3 v3LightDirection, in vec3 v3LightD
     float fShadowRegion = fLightSize * fDepth;
     float fShadowSize = fShadowRegion / 9.0f;
 
-    // Perform additional filtering
+    // Perform additional filtering within the lights tile of the atlas, receivers past the far plane compare against it
+    vec2 v2AtlasSize = vec2(textureSize(s2PointShadowTexture, 0));
+    fDepth = min(fDepth, 1.0f);
     float fShadowing = 0.0f;
     for (int i = 0 ; i <= 9 ; i++) {
         vec3 v3RotatedPoisson = (v3PoissonDisk[i].x * v3Rotate.yyz * v3Rotate.zxx) +
@@ -153,7 +199,7 @@ float lightPointShadow(in int iLight, in vec3 v3LightDirection, in vec3 v3LightD
             (v3PoissonDisk[i].z * v3Rotate.zxy * vec3(0.0f, -1.0f, 1.0f)));
         vec3 v3Offset = v3RotatedPoisson * fShadowSize;
         vec3 v3UVC = -v3LightDirection + v3Offset;
-        float fText = texture(scaPointShadowTexture, vec4(v3UVC, iLight), fDepth);
+        float fText = texture(s2PointShadowTexture, vec3(pointShadowTileUV(v3UVC, PointLights[iLight].v4ShadowTile, v2AtlasSize), fDepth));
         fShadowing += fText;
     }
 
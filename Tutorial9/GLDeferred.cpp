@@ -4,6 +4,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
 
 //Main.cpp
 extern int g_iWindowWidth;
@@ -12,7 +13,7 @@ extern GLuint g_uiMainProgram;
 extern GLuint g_uiDeferredProgram2;
 extern GLuint g_uiPostProcProgram;
 extern SceneData g_SceneData;
-extern void GL_RenderObjects(ObjectData * p_Object = NULL);
+extern void GL_RenderObjects(unsigned uiSkipObject = -1);
 // Subroutine index for GBuffer display
 extern unsigned g_uiOutputSubroutine;
 
@@ -33,8 +34,9 @@ GLuint g_uiQuadIBO;
 // Inverse resolution UBO
 GLuint g_uiInverseResUBO;
 
-void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTextureTarget)
+void GL_RenderDeferred(unsigned uiSkipObject, GLuint uiAccumBuffer, GLenum uiTextureTarget)
 {
+    GL_TRACE_ZONE("GL_RenderDeferred");
     // Bind deferred frame buffer
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_uiFBODeferred);
 
@@ -46,7 +48,7 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
     glUseProgram(g_uiMainProgram);
 
     // Render all objects
-    GL_RenderObjects(p_Object);
+    GL_RenderObjects(uiSkipObject);
 
     // Disable depth checks
     glDisable(GL_DEPTH_TEST);
@@ -88,6 +90,7 @@ void GL_RenderDeferred(ObjectData * p_Object, GLuint uiAccumBuffer, GLenum uiTex
 
 void GL_RenderPostProcess()
 {
+    GL_TRACE_ZONE("GL_RenderPostProcess");
     // Bind final program
     glUseProgram(g_uiPostProcProgram);
 
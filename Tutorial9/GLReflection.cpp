@@ -4,16 +4,32 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <GLScene.h> //Need '<' to enforce loading of project local header
+#include "GLTrace.h"
 
 //Main.cpp
 extern int g_iWindowWidth;
 extern int g_iWindowHeight;
 extern GLuint g_uiDeferredProgram2;
 extern SceneData g_SceneData;
-extern void GL_RenderObjects(ObjectData * p_Object = NULL);
+extern void GL_RenderObjects(unsigned uiSkipObject = -1);
 //Deferred.cpp
-extern void GL_RenderDeferred(ObjectData * p_Object = NULL, GLuint uiAccumBuffer = 0, GLenum uiTextureTarget = GL_TEXTURE_2D);
+extern void GL_RenderDeferred(unsigned uiSkipObject = -1, GLuint uiAccumBuffer = 0, GLenum uiTextureTarget = GL_TEXTURE_2D);
 extern void GL_RenderPostProcess();
+//UniformRing.cpp
+extern GLuint g_uiUniformRing;
+extern void GL_ReserveUniformRing(unsigned uiSize, unsigned uiCount);
+extern void GL_BeginUniformRingFrame();
+extern GLintptr GL_WriteUniformRing(const void * p_Data, unsigned uiSize);
+//Cluster.cpp
+extern void GL_BeginClusterViews(const char * p_cPass, GLenum CullFace, float fLODBias);
+extern void GL_AddClusterView(const mat4 & m4ViewProjection, const vec3 & v3Position, unsigned uiHeight);
+extern void GL_EndClusterViews();
+//TextureStream.cpp
+extern bool GL_IsTextureStreamPending();
+//Material.cpp
+extern void GL_UpdateMaterials();
+//Shadow.cpp
+extern void GL_BindShadowUniforms();
 
 GLuint g_uiReflectCameraUBO;
 
@@ -24,13 +40,15 @@ struct CameraData
     mat4 m_m4InvViewProjection;
 };
 
-void GL_RenderPlanarReflection(ReflectObjectData * p_RObject, ObjectData * p_Object, const vec3 & v3Direction, const vec3 & v3Up,
+void GL_RenderPlanarReflection(ReflectObjectData * p_RObject, const vec3 & v3Direction, const vec3 & v3Up,
                                const vec3 & v3Position, float fFOV, float fAspect, const vec2 & v2NearFar)
 {
+    GL_TRACE_ZONE("GL_RenderPlanarReflection");
     // Transform plane to world space
+    const mat4 & m4Transform = g_SceneData.mp_ObjectTransforms[p_RObject->m_uiObjectPos];
     vec3 v3PlanePosition = vec3(p_RObject->m_v4PlaneOrPosition) * p_RObject->m_v4PlaneOrPosition.w;
-    v3PlanePosition = vec3(p_Object->m_4Transform * vec4(v3PlanePosition, 1.0f));
-    vec4 v4Plane = p_Object->m_4Transform * p_RObject->m_v4PlaneOrPosition;
+    v3PlanePosition = vec3(m4Transform * vec4(v3PlanePosition, 1.0f));
+    vec4 v4Plane = m4Transform * p_RObject->m_v4PlaneOrPosition;
     v4Plane.w = dot(vec3(v4Plane), -v3PlanePosition);
 
     // Calculate reflection view position and direction
@@ -74,20 +92,20 @@ void GL_RenderPlanarReflection(ReflectObjectData * p_RObject, ObjectData * p_Obj
         v3ReflectPosition,
         m4InvViewProjection};
 
-    // Update the camera buffer
-    glBindBuffer(GL_UNIFORM_BUFFER, g_uiReflectCameraUBO);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraData), &Camera, GL_STATIC_DRAW);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 1, g_uiReflectCameraUBO);
+    // Write the camera data and the objects projection into this frames section of the ring buffer
+    glBindBufferRange(GL_UNIFORM_BUFFER, 1, g_uiUniformRing, GL_WriteUniformRing(&Camera, sizeof(CameraData)), sizeof(CameraData));
+    p_RObject->m_iReflectVPOffset = GL_WriteUniformRing(&Camera.m_m4ViewProjection, sizeof(mat4));
 
-    // Update the objects projection UBO
-    glBindBuffer(GL_UNIFORM_BUFFER, p_Object->m_uiReflectVPUBO);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(mat4), &Camera.m_m4ViewProjection, GL_STATIC_DRAW);
+    // Cull clusters against the reflected view, reflections can use coarser LODs
+    GL_BeginClusterViews("Reflection", GL_NONE, 4.0f);
+    GL_AddClusterView(m4ViewProjection, v3ReflectPosition, g_iWindowHeight);
 
     // Perform deferred render pass
-    GL_RenderDeferred(p_Object, p_Object->m_uiReflect);
+    GL_RenderDeferred(p_RObject->m_uiObjectPos, p_RObject->m_uiReflect);
+    GL_EndClusterViews();
 
     // Generate mipmaps for texture
-    glBindTexture(GL_TEXTURE_2D, p_Object->m_uiReflect);
+    glBindTexture(GL_TEXTURE_2D, p_RObject->m_uiReflect);
     glGenerateMipmap(GL_TEXTURE_2D);
 }
 
@@ -134,10 +152,11 @@ void GL_CalculateCubeMapVP(const vec3 & v3Position, mat4 * p_m4CubeViewProjectio
     }
 }
 
-void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject, ObjectData * p_Object)
+void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject)
 {
+    GL_TRACE_ZONE("GL_RenderEnvironmentReflection");
     // Calculate position in world space
-    vec3 v3Position = vec3(p_Object->m_4Transform * p_RObject->m_v4PlaneOrPosition);
+    vec3 v3Position = vec3(g_SceneData.mp_ObjectTransforms[p_RObject->m_uiObjectPos] * p_RObject->m_v4PlaneOrPosition);
 
     // Calculate cube map VPs
     mat4 m4CubeViewProjections[6];
@@ -146,12 +165,12 @@ void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject, ObjectData *
     // Generate planar reflection maps so they will be visible in environment map
     for (unsigned i = 0; i < g_SceneData.m_uiNumReflecObjects; i++) {
         ReflectObjectData * p_RObject2 = &g_SceneData.mp_ReflecObjects[i];
-        ObjectData * p_Object2 = &g_SceneData.mp_Objects[p_RObject2->m_uiObjectPos];
+        const unsigned uiObject2 = p_RObject2->m_uiObjectPos;
 
         // Check if planar or cube reflection
-        if (p_Object2->m_uiReflective == 1) {
+        if ((g_SceneData.mp_ucObjectFlags[uiObject2] & g_ucObjectReflectMask) == g_ucObjectPlanarReflect) {
             // Only 1 face can be used to generate the planar reflection so find the closest one
-            const vec3 v3Dir = normalize(vec3(p_Object2->m_4Transform[3]) - v3Position); //This should use the centre of the AABB instead of transform
+            const vec3 v3Dir = normalize(vec3(g_SceneData.mp_ObjectTransforms[uiObject2][3]) - v3Position); //This should use the centre of the AABB instead of transform
             float fClosest = -1;
             unsigned uiClosestIndex;
             for (unsigned j = 0; j < 6; j++) {
@@ -161,7 +180,7 @@ void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject, ObjectData *
                     uiClosestIndex = j;
                 }
             }
-            GL_RenderPlanarReflection(p_RObject2, p_Object2, v3CubeNormals[uiClosestIndex], v3CubeUps[uiClosestIndex], v3Position, radians(90.0f),
+            GL_RenderPlanarReflection(p_RObject2, v3CubeNormals[uiClosestIndex], v3CubeUps[uiClosestIndex], v3Position, radians(90.0f),
                                       1.0f, vec2(g_SceneData.m_LocalCamera.m_fNear, g_SceneData.m_LocalCamera.m_fFar));
             // This could in theory be added into the below per-face loop however for performance reasons we will just generate a single reflection
         }
@@ -185,33 +204,70 @@ void GL_RenderEnvironmentReflection(ReflectObjectData * p_RObject, ObjectData *
         glBindBuffer(GL_UNIFORM_BUFFER, g_uiReflectCameraUBO);
         glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraData), &Camera, GL_STATIC_DRAW);
 
+        // Cull clusters against this face, reflections can use coarser LODs
+        GL_BeginClusterViews("Reflection", GL_NONE, 4.0f);
+        GL_AddClusterView(m4CubeViewProjections[i], v3Position, g_iWindowHeight);
+
         // Perform deferred render pass
-        GL_RenderDeferred(p_Object, p_Object->m_uiReflect, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
+        GL_RenderDeferred(p_RObject->m_uiObjectPos, p_RObject->m_uiReflect, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
+        GL_EndClusterViews();
     }
 
     // Generate mipmaps for texture
-    glBindTexture(GL_TEXTURE_CUBE_MAP, p_Object->m_uiReflect);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, p_RObject->m_uiReflect);
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
     // Reset to default viewport
     glViewport(0, 0, g_iWindowWidth, g_iWindowHeight);
 }
 
-bool GL_InitReflection()
+void GL_ReserveReflectionUniforms()
 {
-    // Generate FBO camera data
-    glGenBuffers(1, &g_uiReflectCameraUBO);
+    // Each planar reflection writes its camera and projection into the ring once a frame
+    GL_ReserveUniformRing(sizeof(CameraData), g_SceneData.m_uiNumReflecObjects);
+    GL_ReserveUniformRing(sizeof(mat4), g_SceneData.m_uiNumReflecObjects);
+}
+
+bool g_bReflectStreamPending = false;
 
-    // Pre-Generate environment reflection maps
+void GL_RenderEnvironmentReflections()
+{
+    // Bindless materials must point at the current texture handles
+    GL_UpdateMaterials();
+    bool bRendered = false;
     for (unsigned i = 0; i < g_SceneData.m_uiNumReflecObjects; i++) {
         ReflectObjectData * p_RObject = &g_SceneData.mp_ReflecObjects[i];
-        ObjectData * p_Object = &g_SceneData.mp_Objects[p_RObject->m_uiObjectPos];
 
         // Check if planar or cube reflection
-        if (p_Object->m_uiReflective == 2) {
-            GL_RenderEnvironmentReflection(p_RObject, p_Object);
+        if ((g_SceneData.mp_ucObjectFlags[p_RObject->m_uiObjectPos] & g_ucObjectReflectMask) == g_ucObjectCubeReflect) {
+            // Each environment map redraws the planar reflections so starts a new section of the uniform ring
+            GL_BeginUniformRingFrame();
+            GL_BindShadowUniforms();
+            GL_RenderEnvironmentReflection(p_RObject);
+            bRendered = true;
         }
     }
+
+    // Maps drawn before streamed textures arrive need to be drawn again
+    g_bReflectStreamPending = bRendered && GL_IsTextureStreamPending();
+}
+
+bool GL_UpdateEnvironmentReflections()
+{
+    // Only redraw once all new textures have their coarse levels
+    if (!g_bReflectStreamPending || GL_IsTextureStreamPending())
+        return false;
+    GL_RenderEnvironmentReflections();
+    return true;
+}
+
+bool GL_InitReflection()
+{
+    // Generate FBO camera data
+    glGenBuffers(1, &g_uiReflectCameraUBO);
+
+    // Pre-Generate environment reflection maps, they are redrawn once streamed textures are resident
+    GL_RenderEnvironmentReflections();
     return true;
 }
 